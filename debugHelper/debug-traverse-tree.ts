@@ -1,7 +1,7 @@
 import * as fs from "node:fs";
 import Parser = require("tree-sitter");
 import { type TreeCursor } from "tree-sitter";
-import { type Language, languageToGrammar } from "../src/helper/language.js";
+import { getGrammar, type Language } from "../src/helper/language.js";
 
 /**
  * Traverses the syntax tree of a file depth-first and prints all encountered nodes.
@@ -13,7 +13,7 @@ export function traverseTree(filePath: string, language: Language): void {
     const text: string = fs.readFileSync(filePath, { encoding: "utf8" });
 
     const parser = new Parser();
-    parser.setLanguage(languageToGrammar.get(language));
+    parser.setLanguage(getGrammar(language));
 
     const tree = parser.parse(text);
 
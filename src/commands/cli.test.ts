@@ -1,16 +1,26 @@
-import fs from "node:fs/promises";
+import fs, { type FileHandle } from "node:fs/promises";
+import process from "node:process";
 import { afterAll, describe, expect, it, vi } from "vitest";
 import { mockConsole } from "../../test/metric-end-results/test-helper.js";
 import * as ImportNodeTypes from "../import-grammars/import-node-types.js";
+import { FileType } from "../helper/language.js";
 import { Configuration } from "../parser/configuration.js";
-import { type CouplingResult, type FileMetricResults } from "../parser/metrics/metric.js";
+import {
+    type CouplingResult,
+    type FileMetricResults,
+    type FileResult,
+} from "../parser/metrics/metric.js";
+import { type FileMetricsConsumer } from "../parser/result-aggregator.js";
+import { type CommitMetrics } from "../parser/metrics-history.js";
+import { type PartialResultConsumer } from "../parser/generic-parser.js";
+import { type PartialResultsFile, type PartialResultsHeader } from "./partial-results.js";
+import { type ColumnarOutputReader } from "./columnar-output.js";
 import { parser } from "./cli.js";
-import * as outputMetrics from "./output-metrics.js";
 
 const parserConstructor = vi.hoisted(() => vi.fn<[Configuration]>());
 const parserCalculateMetrics = vi.hoisted(() =>
     vi.fn<
-        [], // eslint-disable-line @typescript-eslint/ban-types
+        [FileMetricsConsumer | undefined],
         Promise<{
             couplingMetrics: CouplingResult;
             fileMetrics: Map<string, FileMetricResults>;
@@ -19,15 +29,103 @@ const parserCalculateMetrics = vi.hoisted(() =>
         }>
     >(),
 );
+const parserCalculatePartialResults = vi.hoisted(() =>
+    vi.fn<[PartialResultConsumer], Promise<number>>(),
+);
 vi.mock("../parser/generic-parser.js", () => ({
     GenericParser: class GenericParser {
         calculateMetrics = parserCalculateMetrics;
+        calculatePartialResults = parserCalculatePartialResults;
         constructor(config: Configuration) {
             parserConstructor(config);
         }
     },
 }));
 
+const writerConstructor = vi.hoisted(() => vi.fn<[unknown]>());
+const writerAddFileMetrics = vi.hoisted(() =>
+    vi.fn<[string, FileMetricResults], Promise<void>>(),
+);
+const writerFinish = vi.hoisted(() => vi.fn<[unknown], Promise<void>>());
+const writerWriteOutput = vi.hoisted(() => vi.fn<[unknown], Promise<void>>());
+const writerAbort = vi.hoisted(() => vi.fn<[], Promise<void>>()); // eslint-disable-line @typescript-eslint/ban-types
+vi.mock("./output-metrics.js", () => ({
+    MetricsWriter: class MetricsWriter {
+        addFileMetrics = writerAddFileMetrics;
+        finish = writerFinish;
+        writeOutput = writerWriteOutput;
+        abort = writerAbort;
+        constructor(options: unknown) {
+            writerConstructor(options);
+        }
+    },
+}));
+
+const partialWriterConstructor = vi.hoisted(() => vi.fn<[string, Configuration]>());
+const partialWriterAddFile = vi.hoisted(() => vi.fn<[number, unknown], Promise<void>>());
+const partialWriterFinish = vi.hoisted(() => vi.fn<[number], Promise<void>>());
+const partialWriterAbort = vi.hoisted(() => vi.fn<[], Promise<void>>()); // eslint-disable-line @typescript-eslint/ban-types
+const openPartialResults = vi.hoisted(() =>
+    vi.fn<
+        [string[]],
+        Promise<{ header: PartialResultsHeader; files: AsyncGenerator<PartialResultsFile> }>
+    >(),
+);
+vi.mock("./partial-results.js", () => ({
+    PartialResultsWriter: class PartialResultsWriter {
+        addFile = partialWriterAddFile;
+        finish = partialWriterFinish;
+        abort = partialWriterAbort;
+        constructor(outputFilePath: string, config: Configuration) {
+            partialWriterConstructor(outputFilePath, config);
+        }
+    },
+    openPartialResults,
+}));
+
+const readColumnarOutputFile = vi.hoisted(() =>
+    vi.fn<[string], Promise<Partial<ColumnarOutputReader>>>(),
+);
+vi.mock("./columnar-output.js", () => ({ readColumnarOutputFile }));
+
+const analysisConstructor = vi.hoisted(() => vi.fn<[Configuration]>());
+const analysisAnalyzeAll = vi.hoisted(() => vi.fn<[], Promise<void>>());
+const analysisWatch = vi.hoisted(() => vi.fn<[unknown], () => void>());
+vi.mock("../parser/incremental-analysis.js", () => ({
+    IncrementalAnalysis: class IncrementalAnalysis {
+        analyzeAll = analysisAnalyzeAll;
+        watch = analysisWatch;
+        fileCount = 2;
+        constructor(config: Configuration) {
+            analysisConstructor(config);
+        }
+    },
+}));
+
+const serverListen = vi.hoisted(() => vi.fn<[unknown], Promise<string>>());
+vi.mock("./metrics-server.js", () => ({
+    MetricsServer: class MetricsServer {
+        listen = serverListen;
+    },
+}));
+
+const storeOpen = vi.hoisted(() => vi.fn<[string], Promise<unknown>>());
+const storeClose = vi.hoisted(() => vi.fn<[], Promise<void>>()); // eslint-disable-line @typescript-eslint/ban-types
+vi.mock("../helper/git-object-store.js", () => ({
+    GitObjectStore: { open: storeOpen },
+}));
+
+const historyConstructor = vi.hoisted(() => vi.fn<[Configuration, unknown]>());
+const historyAnalyze = vi.hoisted(() => vi.fn<[string, number], AsyncGenerator<CommitMetrics>>());
+vi.mock("../parser/metrics-history.js", () => ({
+    MetricsHistory: class MetricsHistory {
+        analyze = historyAnalyze;
+        constructor(config: Configuration, store: unknown) {
+            historyConstructor(config, store);
+        }
+    },
+}));
+
 describe("cli", () => {
     afterAll(() => {
         vi.resetModules();
@@ -40,11 +138,22 @@ describe("cli", () => {
             sourcesPath: ".",
             outputPath: "metrics.json",
             parseDependencies: false,
+            directoryCoupling: false,
             exclusions: "node_modules,.idea,dist,build,out,vendor",
             parseAllHAsC: false,
             parseSomeHAsC: "",
             compress: false,
             relativePaths: false,
+            threads: 1,
+            maxMemory: 0,
+            cacheDir: "",
+            outputFormat: "json",
+            profile: "",
+            skipUnsupportedFiles: false,
+            parseTimeout: 0,
+            maxUnsupportedFileSize: 0,
+            commentKeywords: "",
+            shard: "",
         });
         const expectedMetrics = {
             couplingMetrics: { relationships: [], metrics: new Map() },
@@ -59,7 +168,7 @@ describe("cli", () => {
             mockConsole();
             vi.spyOn(fs, "realpath").mockImplementation(async (path) => path.toString());
             parserCalculateMetrics.mockResolvedValue(expectedMetrics);
-            vi.spyOn(outputMetrics, "outputAsJson").mockReset();
+            writerFinish.mockResolvedValue();
 
             await parser.parse("parse . -o metrics.json");
 
@@ -69,21 +178,43 @@ describe("cli", () => {
             expect(console.log).toHaveBeenCalledWith("#####################################");
             expect(console.log).toHaveBeenCalledWith("Metrics calculation finished.");
             expect(console.timeEnd).toHaveBeenCalledWith("Time to complete");
-            expect(outputMetrics.outputAsJson).toHaveBeenCalledWith({
-                fileMetrics: expectedMetrics.fileMetrics,
+            expect(writerConstructor).toHaveBeenCalledWith({
+                outputFilePath: expectedConfig.outputPath,
+                compress: expectedConfig.compress,
+                format: expectedConfig.outputFormat,
+                mergeCouplingMetrics: expectedConfig.parseDependencies,
+            });
+            expect(writerFinish).toHaveBeenCalledWith({
                 unsupportedFiles: expectedMetrics.unsupportedFiles,
                 errorFiles: expectedMetrics.errorFiles,
                 relationshipMetrics: expectedMetrics.couplingMetrics,
-                outputFilePath: expectedConfig.outputPath,
-                compress: expectedConfig.compress,
             });
+            expect(writerAbort).not.toHaveBeenCalled();
+        });
+
+        it("should pass the metrics of each file on to the output while they are calculated", async () => {
+            mockConsole();
+            vi.spyOn(fs, "realpath").mockImplementation(async (path) => path.toString());
+            const fileMetricResults: FileMetricResults = {
+                fileType: FileType.SourceCode,
+                metricResults: [{ metricName: "lines_of_code", metricValue: 3 }],
+                metricErrors: [],
+            };
+            parserCalculateMetrics.mockImplementation(async (consumer) => {
+                await consumer?.("file.java", fileMetricResults);
+                return expectedMetrics;
+            });
+
+            await parser.parse("parse . -o metrics.json");
+
+            expect(writerAddFileMetrics).toHaveBeenCalledWith("file.java", fileMetricResults);
+            expect(writerFinish).toHaveBeenCalled();
         });
 
         it("should configure the parser with the correct options", async () => {
             mockConsole();
             vi.spyOn(fs, "realpath").mockImplementation(async (path) => path.toString());
             parserCalculateMetrics.mockResolvedValue(expectedMetrics);
-            vi.spyOn(outputMetrics, "outputAsJson").mockReset();
 
             await parser.parse("parse . -o metrics.json -r");
             expect(parserConstructor).toHaveBeenNthCalledWith(1, {
@@ -120,13 +251,109 @@ describe("cli", () => {
                 ...expectedConfig,
                 parseDependencies: true,
             });
+
+            await parser.parse("parse . -o metrics.json -t 4");
+            expect(parserConstructor).toHaveBeenNthCalledWith(7, {
+                ...expectedConfig,
+                threads: 4,
+            });
+
+            await parser.parse("parse . -o metrics.json --max-memory 2048");
+            expect(parserConstructor).toHaveBeenNthCalledWith(8, {
+                ...expectedConfig,
+                maxMemory: 2048,
+            });
+
+            await parser.parse("parse . -o metrics.json --cache-dir /tmp/metrics-cache");
+            expect(parserConstructor).toHaveBeenNthCalledWith(9, {
+                ...expectedConfig,
+                cacheDir: "/tmp/metrics-cache",
+            });
+
+            await parser.parse("parse . -o metrics.json --output-format ndjson");
+            expect(parserConstructor).toHaveBeenNthCalledWith(10, {
+                ...expectedConfig,
+                outputFormat: "ndjson",
+            });
+
+            await parser.parse("parse . -o metrics.json --profile profile.json");
+            expect(parserConstructor).toHaveBeenNthCalledWith(11, {
+                ...expectedConfig,
+                profilePath: "profile.json",
+            });
+
+            await parser.parse("parse . -o metrics.json --skip-unsupported-files");
+            expect(parserConstructor).toHaveBeenNthCalledWith(12, {
+                ...expectedConfig,
+                skipUnsupportedFiles: true,
+            });
+
+            await parser.parse("parse . -o metrics.json --parse-timeout 500");
+            expect(parserConstructor).toHaveBeenNthCalledWith(13, {
+                ...expectedConfig,
+                parseTimeout: 500,
+            });
+
+            await parser.parse("parse . -o metrics.json --max-unsupported-file-size 100");
+            expect(parserConstructor).toHaveBeenNthCalledWith(14, {
+                ...expectedConfig,
+                maxUnsupportedFileSize: 100,
+            });
+
+            await parser.parse("parse . -o metrics.json --shard 2/3");
+            expect(parserConstructor).toHaveBeenNthCalledWith(15, {
+                ...expectedConfig,
+                shard: { index: 2, count: 3 },
+            });
+
+            await parser.parse("parse . -o metrics.json --parse-dependencies --directory-coupling");
+            expect(parserConstructor).toHaveBeenNthCalledWith(16, {
+                ...expectedConfig,
+                parseDependencies: true,
+                directoryCoupling: true,
+            });
+
+            await parser.parse("parse . -o metrics.json --comment-keywords debt=fixme,xxx");
+            expect(parserConstructor).toHaveBeenNthCalledWith(17, {
+                ...expectedConfig,
+                commentKeywords: new Map([["debt", ["fixme", "xxx"]]]),
+            });
+        });
+
+        it("should write partial results for a shard", async () => {
+            mockConsole();
+            vi.spyOn(fs, "realpath").mockImplementation(async (path) => path.toString());
+            const processedFile = {
+                fileResult: {
+                    filePath: "file.java",
+                    fileType: FileType.SourceCode,
+                    fileMetricResults: { metricResults: [], metricErrors: [] },
+                },
+            };
+            parserCalculatePartialResults.mockImplementation(async (consumer) => {
+                await consumer(4, processedFile);
+                return 10;
+            });
+            partialWriterFinish.mockResolvedValue();
+
+            await parser.parse("parse . -o shard-1.ndjson --shard 1/2");
+
+            expect(partialWriterConstructor).toHaveBeenCalledWith("shard-1.ndjson", {
+                ...expectedConfig,
+                outputPath: "shard-1.ndjson",
+                shard: { index: 1, count: 2 },
+            });
+            expect(parserCalculateMetrics).not.toHaveBeenCalled();
+            expect(partialWriterAddFile).toHaveBeenCalledWith(4, processedFile);
+            expect(partialWriterFinish).toHaveBeenCalledWith(10);
+            expect(writerConstructor).not.toHaveBeenCalled();
+            expect(partialWriterAbort).not.toHaveBeenCalled();
         });
 
         it("should log error if metrics calculation fails", async () => {
             mockConsole();
             const error = new Error("Error");
             parserCalculateMetrics.mockRejectedValue(error);
-            vi.spyOn(outputMetrics, "outputAsJson").mockReset();
 
             await parser.parse("parse . -o metrics.json");
 
@@ -137,16 +364,15 @@ describe("cli", () => {
                 "Metrics calculation failed with the following error:",
             );
             expect(console.error).toHaveBeenCalledWith(error);
-            expect(outputMetrics.outputAsJson).not.toHaveBeenCalled();
+            expect(writerFinish).not.toHaveBeenCalled();
+            expect(writerAbort).toHaveBeenCalled();
         });
 
         it("should log error if output of metrics fails", async () => {
             mockConsole();
             parserCalculateMetrics.mockResolvedValue(expectedMetrics);
             const error = new Error("Error");
-            vi.spyOn(outputMetrics, "outputAsJson").mockImplementation(() => {
-                throw error;
-            });
+            writerFinish.mockRejectedValue(error);
 
             await parser.parse("parse . -o metrics.json");
 
@@ -157,6 +383,249 @@ describe("cli", () => {
                 "Metrics calculation failed with the following error:",
             );
             expect(console.error).toHaveBeenCalledWith(error);
+            expect(writerAbort).toHaveBeenCalled();
+        });
+    });
+
+    describe("merge command", () => {
+        itShouldOfferHelp("merge");
+
+        it("should write the metrics of the merged partial results in the order of the files", async () => {
+            mockConsole();
+            const fileResult = (
+                filePath: string,
+                fileType: FileType,
+                linesOfCode: number,
+            ): FileResult => ({
+                filePath,
+                fileType,
+                fileMetricResults: {
+                    fileType,
+                    metricResults: [{ metricName: "lines_of_code", metricValue: linesOfCode }],
+                    metricErrors: [],
+                },
+            });
+            async function* files(): AsyncGenerator<PartialResultsFile> {
+                yield {
+                    index: 0,
+                    processedFile: {
+                        fileResult: fileResult("/sources/a.java", FileType.SourceCode, 1),
+                    },
+                };
+                yield {
+                    index: 1,
+                    processedFile: {
+                        fileResult: fileResult("/sources/b.txt", FileType.Unsupported, 2),
+                    },
+                };
+            }
+
+            openPartialResults.mockResolvedValue({
+                header: {
+                    version: 1,
+                    shard: { index: 1, count: 2 },
+                    sourcesPath: "/sources",
+                    relativePaths: true,
+                    parseDependencies: false,
+                    settings: "",
+                },
+                files: files(),
+            });
+            writerAddFileMetrics.mockResolvedValue();
+            writerFinish.mockResolvedValue();
+
+            await parser.parse("merge shard-1.ndjson shard-2.ndjson -o metrics.json --compress");
+
+            expect(openPartialResults).toHaveBeenCalledWith(["shard-1.ndjson", "shard-2.ndjson"]);
+            expect(writerConstructor).toHaveBeenCalledWith({
+                outputFilePath: "metrics.json",
+                compress: true,
+                format: "json",
+                mergeCouplingMetrics: false,
+            });
+            expect(writerAddFileMetrics.mock.calls).toEqual([
+                ["a.java", fileResult("/sources/a.java", FileType.SourceCode, 1).fileMetricResults],
+                ["b.txt", fileResult("/sources/b.txt", FileType.Unsupported, 2).fileMetricResults],
+            ]);
+            expect(writerFinish).toHaveBeenCalledWith({
+                unsupportedFiles: ["b.txt"],
+                errorFiles: [],
+                relationshipMetrics: { relationships: [], metrics: new Map() },
+            });
+            expect(writerAbort).not.toHaveBeenCalled();
+        });
+
+        it("should log error if the partial results cannot be merged", async () => {
+            mockConsole();
+            const error = new Error("Error");
+            openPartialResults.mockRejectedValue(error);
+
+            await parser.parse("merge shard-1.ndjson -o metrics.json");
+
+            expect(console.error).toHaveBeenCalledWith(
+                "Merging the partial results failed with the following error:",
+            );
+            expect(console.error).toHaveBeenCalledWith(error);
+            expect(writerConstructor).not.toHaveBeenCalled();
+        });
+    });
+
+    describe("convert command", () => {
+        itShouldOfferHelp("convert");
+
+        it("should write the contents of the columnar output in the specified format", async () => {
+            mockConsole();
+            const nodes = [{ name: "a.java", type: "source_code", metrics: { classes: 1 } }];
+            const info = [{ name: "b.txt", type: "unsupported_file", message: "Unknown" }];
+            readColumnarOutputFile.mockResolvedValue({
+                *nodes() {
+                    yield* nodes;
+                },
+                *info() {
+                    yield* info;
+                },
+                *relationships() {
+                    // No relationships
+                },
+            });
+            let written: Record<string, unknown[]> | undefined;
+            writerWriteOutput.mockImplementation(async (output) => {
+                const iterables = output as Record<string, Iterable<unknown>>;
+                written = {
+                    nodes: [...iterables.nodes],
+                    info: [...iterables.info],
+                    relationships: [...iterables.relationships],
+                };
+            });
+
+            await parser.parse("convert metrics.columnar -o metrics.ndjson --output-format ndjson");
+
+            expect(readColumnarOutputFile).toHaveBeenCalledWith("metrics.columnar");
+            expect(writerConstructor).toHaveBeenCalledWith({
+                outputFilePath: "metrics.ndjson",
+                compress: false,
+                format: "ndjson",
+                mergeCouplingMetrics: false,
+            });
+            expect(written).toEqual({ nodes, info, relationships: [] });
+            expect(writerAbort).not.toHaveBeenCalled();
+        });
+
+        it("should log error if the columnar output cannot be read", async () => {
+            mockConsole();
+            const error = new Error("The data is not in the columnar output format.");
+            readColumnarOutputFile.mockRejectedValue(error);
+
+            await parser.parse("convert metrics.json -o converted.json");
+
+            expect(console.error).toHaveBeenCalledWith(
+                "Converting the output failed with the following error:",
+            );
+            expect(console.error).toHaveBeenCalledWith(error);
+            expect(writerConstructor).not.toHaveBeenCalled();
+        });
+    });
+
+    describe("serve command", () => {
+        itShouldOfferHelp("serve");
+
+        it("should analyze all files, watch them and serve the metrics", async () => {
+            mockConsole();
+            vi.spyOn(fs, "realpath").mockImplementation(async (path) => path.toString());
+            vi.spyOn(process, "once").mockReturnValue(process);
+            analysisAnalyzeAll.mockResolvedValue();
+            serverListen.mockResolvedValue("http://127.0.0.1:8080");
+
+            await parser.parse("serve . -r --parse-dependencies");
+
+            expect(analysisConstructor).toHaveBeenCalledWith(
+                expect.objectContaining({
+                    sourcesPath: ".",
+                    relativePaths: true,
+                    parseDependencies: true,
+                    outputFormat: "json",
+                }),
+            );
+            expect(analysisAnalyzeAll).toHaveBeenCalled();
+            expect(analysisWatch).toHaveBeenCalled();
+            expect(serverListen).toHaveBeenCalledWith({ port: 8080 });
+            expect(console.log).toHaveBeenCalledWith("Serving metrics on http://127.0.0.1:8080");
+            expect(process.once).toHaveBeenCalledWith("SIGINT", expect.any(Function));
+        });
+
+        it("should serve the metrics on a Unix socket if specified", async () => {
+            mockConsole();
+            vi.spyOn(fs, "realpath").mockImplementation(async (path) => path.toString());
+            vi.spyOn(process, "once").mockReturnValue(process);
+            analysisAnalyzeAll.mockResolvedValue();
+            serverListen.mockResolvedValue("/tmp/metrics.sock");
+
+            await parser.parse("serve . --socket /tmp/metrics.sock");
+
+            expect(serverListen).toHaveBeenCalledWith({ socketPath: "/tmp/metrics.sock" });
+        });
+    });
+
+    describe("history command", () => {
+        itShouldOfferHelp("history");
+
+        it("should write the metrics of each commit as one line of JSON", async () => {
+            mockConsole();
+            vi.spyOn(fs, "realpath").mockImplementation(async (path) => path.toString());
+            const write = vi.fn<[string], Promise<void>>();
+            const close = vi.fn<[], Promise<void>>(); // eslint-disable-line @typescript-eslint/ban-types
+            vi.spyOn(fs, "open").mockResolvedValue({ write, close } as unknown as FileHandle);
+            const store = { close: storeClose };
+            storeOpen.mockResolvedValue(store);
+            const commits: CommitMetrics[] = ["a", "b"].map((commit, index) => ({
+                commit,
+                time: index,
+                subject: "Version " + commit,
+                files: 1,
+                unsupportedFiles: 0,
+                errorFiles: 0,
+                analyzedFiles: 1,
+                metrics: { functions: index },
+            }));
+            historyAnalyze.mockImplementation(async function* () {
+                yield* commits;
+            });
+
+            await parser.parse(
+                "history repository -o history.ndjson --ref main --max-commits 2 --skip-unsupported-files",
+            );
+
+            expect(storeOpen).toHaveBeenCalledWith("repository");
+            expect(historyConstructor).toHaveBeenCalledWith(
+                expect.objectContaining({
+                    sourcesPath: "repository",
+                    outputPath: "history.ndjson",
+                    skipUnsupportedFiles: true,
+                }),
+                store,
+            );
+            expect(historyAnalyze).toHaveBeenCalledWith("main", 2);
+            expect(fs.open).toHaveBeenCalledWith("history.ndjson", "w");
+            expect(write.mock.calls).toEqual(commits.map((commit) => [JSON.stringify(commit) + "\n"]));
+            expect(close).toHaveBeenCalled();
+            expect(storeClose).toHaveBeenCalled();
+            expect(console.log).toHaveBeenCalledWith(
+                "Analyzed 2 commits with 2 distinct file versions.",
+            );
+        });
+
+        it("should log error if the repository cannot be read", async () => {
+            mockConsole();
+            vi.spyOn(fs, "realpath").mockImplementation(async (path) => path.toString());
+            const error = new Error("No git repository found at repository");
+            storeOpen.mockRejectedValue(error);
+
+            await parser.parse("history repository -o history.ndjson");
+
+            expect(console.error).toHaveBeenCalledWith(
+                "Calculating the metrics history failed with the following error:",
+            );
+            expect(console.error).toHaveBeenCalledWith(error);
         });
     });
 
@@ -1,8 +1,134 @@
-import fs from "node:fs/promises";
-import yargs from "yargs";
+import fs, { type FileHandle } from "node:fs/promises";
+import process from "node:process";
+import yargs, { type InferredOptionTypes, type Options } from "yargs";
 import { GenericParser } from "../parser/generic-parser.js";
-import { Configuration } from "../parser/configuration.js";
-import { outputAsJson } from "./output-metrics.js";
+import { Configuration, type ConfigurationParameters } from "../parser/configuration.js";
+import { CouplingCalculator } from "../parser/coupling-calculator.js";
+import { ResultAggregator } from "../parser/result-aggregator.js";
+import { IncrementalAnalysis } from "../parser/incremental-analysis.js";
+import { MetricsHistory } from "../parser/metrics-history.js";
+import { GitObjectStore } from "../helper/git-object-store.js";
+import { profiler } from "../helper/profiler.js";
+import { MetricsWriter } from "./output-metrics.js";
+import { readColumnarOutputFile } from "./columnar-output.js";
+import { openPartialResults, PartialResultsWriter } from "./partial-results.js";
+import { MetricsServer, type ServerAddress } from "./metrics-server.js";
+
+/**
+ * Options that several commands offer, defined once so that their descriptions, defaults and choices are the same
+ * for all of them.
+ */
+const outputPathOption = {
+    alias: "o",
+    type: "string",
+    description: "Output file path (required)",
+} satisfies Options;
+
+const compressOption = {
+    alias: "c",
+    type: "boolean",
+    description: "output .gz-zipped file",
+    default: false,
+} satisfies Options;
+
+const outputFormatOption = {
+    type: "string",
+    choices: ["json", "ndjson", "columnar"] as const,
+    default: "json" as const,
+    description:
+        "Format of the output file, ndjson writes one node, info or relationship per line, " +
+        "columnar a binary file with a column of values per metric",
+} satisfies Options;
+
+const relativePathsOption = {
+    alias: "r",
+    type: "boolean",
+    default: false,
+    description: "Write relative instead of absolute paths to the analyzed files in the output",
+} satisfies Options;
+
+const parseDependenciesOption = {
+    type: "boolean",
+    default: false,
+    description:
+        "EXPERIMENTAL: flag to enable dependency parsing (dependencies will be appended to the output file)",
+} satisfies Options;
+
+/**
+ * Options that affect which files are analyzed and how, offered by all commands that analyze files.
+ */
+const analysisOptions = {
+    exclusions: {
+        alias: "e",
+        type: "string",
+        description:
+            "Exclude folders from scanning for files (comma separated list of folder names or .gitignore-style patterns)",
+        default: "node_modules,.idea,dist,build,out,vendor",
+    },
+    "parse-h-as-c": {
+        alias: "hc",
+        type: "boolean",
+        description: "Parse all .h files as C instead of C++ (defaults to C++)",
+        default: false,
+    },
+    "parse-some-h-as-c": {
+        alias: "shc",
+        type: "string",
+        description:
+            "For the specified folders/files (comma separated list), parse .h files as C instead of C++. " +
+            "Ignored if parse-h-as-c is set.",
+        default: "",
+    },
+    "skip-unsupported-files": {
+        type: "boolean",
+        default: false,
+        description:
+            "Skip files with unsupported file extensions instead of reporting them in the output",
+    },
+    "parse-timeout": {
+        type: "number",
+        default: 0,
+        description:
+            "Maximum time in ms to parse a single file, slower files are reported as errors (0 for no limit)",
+    },
+    "max-unsupported-file-size": {
+        type: "number",
+        default: 0,
+        description:
+            "Maximum size in MB of files with unsupported languages whose lines are counted (0 for no limit)",
+    },
+    "comment-keywords": {
+        type: "string",
+        default: "",
+        description:
+            "Additional keywords to count in comments as name=keyword,keyword;name=keyword, " +
+            "each set is reported as metric keywords_in_comments_<name>",
+    },
+} satisfies Record<string, Options>;
+
+/**
+ * Parameters for the options that a command does not offer, which turn off what the options would enable.
+ */
+const disabledParameters: Omit<ConfigurationParameters, "sourcesPath"> = {
+    outputPath: "",
+    parseDependencies: false,
+    directoryCoupling: false,
+    exclusions: "",
+    parseAllHAsC: false,
+    parseSomeHAsC: "",
+    compress: false,
+    relativePaths: false,
+    threads: 1,
+    maxMemory: 0,
+    cacheDir: "",
+    outputFormat: "json",
+    profile: "",
+    skipUnsupportedFiles: false,
+    parseTimeout: 0,
+    maxUnsupportedFileSize: 0,
+    commentKeywords: "",
+    shard: "",
+};
 
 export const parser = yargs()
     .command(
@@ -14,95 +140,517 @@ export const parser = yargs()
                     describe: "path to sources",
                     type: "string",
                 })
-                .option("output-path", {
-                    alias: "o",
-                    type: "string",
-                    description: "Output file path (required)",
-                })
-                .option("relative-paths", {
-                    alias: "r",
+                .option("output-path", outputPathOption)
+                .option("relative-paths", relativePathsOption)
+                .options(analysisOptions)
+                .option("compress", compressOption)
+                .option("parse-dependencies", parseDependenciesOption)
+                .option("directory-coupling", {
                     type: "boolean",
                     default: false,
                     description:
-                        "Write relative instead of absolute paths to the analyzed files in the output",
+                        "Add the coupling metrics of each directory to the output, requires parse-dependencies",
+                })
+                .option("threads", {
+                    alias: "t",
+                    type: "number",
+                    default: 1,
+                    description:
+                        "Number of worker threads to parse files and calculate metrics on (0 for one per CPU core)",
+                })
+                .option("max-memory", {
+                    type: "number",
+                    default: 0,
+                    description:
+                        "Memory budget in MB, delays taking in new files while more memory is used (0 for no limit)",
+                })
+                .option("cache-dir", {
+                    type: "string",
+                    default: "",
+                    description:
+                        "Directory for caching the results of unchanged files between runs (no cache if empty)",
+                })
+                .option("output-format", outputFormatOption)
+                .option("profile", {
+                    type: "string",
+                    default: "",
+                    description:
+                        "Write a profiling report to this file and a Chrome trace next to it (no profiling if empty)",
+                })
+                .option("shard", {
+                    type: "string",
+                    default: "",
+                    description:
+                        "Only analyze the files of this shard (index/count, e.g. 2/4) and write partial results to be merged",
                 })
-                .option("exclusions", {
-                    alias: "e",
+                .demandOption(["sources-path", "output-path"]);
+        },
+        async (argv) => {
+            const configuration = createConfiguration({
+                /* eslint-disable @typescript-eslint/dot-notation */
+                ...getAnalysisParameters(argv),
+                sourcesPath: await fs.realpath(argv["sources-path"]),
+                outputPath: argv["output-path"],
+                parseDependencies: argv["parse-dependencies"],
+                directoryCoupling: argv["directory-coupling"],
+                compress: argv["compress"],
+                relativePaths: argv["relative-paths"],
+                threads: argv["threads"],
+                maxMemory: argv["max-memory"],
+                cacheDir: argv["cache-dir"],
+                outputFormat: argv["output-format"],
+                profile: argv["profile"],
+                shard: argv["shard"],
+                /* eslint-enable @typescript-eslint/dot-notation */
+            });
+            await (configuration.shard === undefined
+                ? parseSourceCode(configuration)
+                : parseShard(configuration));
+        },
+    )
+    .command(
+        "merge <partial-results..>",
+        "merge the partial results of all shards into a single output file",
+        (cmdYargs) => {
+            return cmdYargs
+                .positional("partial-results", {
+                    describe: "paths to the partial results of all shards",
                     type: "string",
-                    description: "Exclude folders from scanning for files (comma separated list)",
-                    default: "node_modules,.idea,dist,build,out,vendor",
+                    array: true,
                 })
-                .option("parse-h-as-c", {
-                    alias: "hc",
+                .option("output-path", outputPathOption)
+                .option("compress", compressOption)
+                .option("output-format", outputFormatOption)
+                .option("directory-coupling", {
                     type: "boolean",
-                    description: "Parse all .h files as C instead of C++ (defaults to C++)",
                     default: false,
+                    description:
+                        "Add the coupling metrics of each directory to the output, if the shards parsed dependencies",
                 })
-                .option("parse-some-h-as-c", {
-                    alias: "shc",
+                .demandOption(["partial-results", "output-path"]);
+        },
+        async (argv) => {
+            /* eslint-disable @typescript-eslint/dot-notation */
+            await mergePartialResults(argv["partial-results"], {
+                outputPath: argv["output-path"],
+                compress: argv["compress"],
+                outputFormat: argv["output-format"],
+                directoryCoupling: argv["directory-coupling"],
+            });
+            /* eslint-enable @typescript-eslint/dot-notation */
+        },
+    )
+    .command(
+        "convert <columnar-output>",
+        "convert an output file in the columnar format to the json or ndjson format",
+        (cmdYargs) => {
+            return cmdYargs
+                .positional("columnar-output", {
+                    describe: "path to the output file in the columnar format",
                     type: "string",
+                })
+                .option("output-path", outputPathOption)
+                .option("compress", compressOption)
+                .option("output-format", {
+                    type: "string",
+                    choices: ["json", "ndjson"] as const,
+                    default: "json" as const,
                     description:
-                        "For the specified folders/files (comma separated list), parse .h files as C instead of C++. " +
-                        "Ignored if parse-h-as-c is set.",
+                        "Format of the output file, ndjson writes one node, info or relationship per line",
+                })
+                .demandOption(["columnar-output", "output-path"]);
+        },
+        async (argv) => {
+            /* eslint-disable @typescript-eslint/dot-notation */
+            await convertColumnarOutput(argv["columnar-output"], {
+                outputPath: argv["output-path"],
+                compress: argv["compress"],
+                outputFormat: argv["output-format"],
+            });
+            /* eslint-enable @typescript-eslint/dot-notation */
+        },
+    )
+    .command(
+        "serve [sources-path]",
+        "serve the metrics of files by given path over HTTP, updated when they change",
+        (cmdYargs) => {
+            return cmdYargs
+                .positional("sources-path", {
+                    describe: "path to sources",
+                    type: "string",
+                })
+                .option("port", {
+                    alias: "p",
+                    type: "number",
+                    default: 8080,
+                    description: "Port to serve the metrics on, only to the local machine",
+                })
+                .option("socket", {
+                    type: "string",
                     default: "",
+                    description: "Serve the metrics on this Unix socket instead of a port",
                 })
-                .option("compress", {
-                    alias: "c",
-                    type: "boolean",
-                    description: "output .gz-zipped file",
-                    default: false,
+                .option("relative-paths", relativePathsOption)
+                .options(analysisOptions)
+                .option("parse-dependencies", parseDependenciesOption)
+                .option("output-format", outputFormatOption)
+                .demandOption(["sources-path"]);
+        },
+        async (argv) => {
+            // Options that only apply to the output file or to a complete run are not offered:
+            const configuration = createConfiguration({
+                /* eslint-disable @typescript-eslint/dot-notation */
+                ...getAnalysisParameters(argv),
+                sourcesPath: await fs.realpath(argv["sources-path"]),
+                parseDependencies: argv["parse-dependencies"],
+                relativePaths: argv["relative-paths"],
+                outputFormat: argv["output-format"],
+                /* eslint-enable @typescript-eslint/dot-notation */
+            });
+            /* eslint-disable @typescript-eslint/dot-notation */
+            await serveMetrics(
+                configuration,
+                argv["socket"].length > 0 ? { socketPath: argv["socket"] } : { port: argv["port"] },
+            );
+            /* eslint-enable @typescript-eslint/dot-notation */
+        },
+    )
+    .command(
+        "history [sources-path]",
+        "calculate the metrics of each commit of a git repository without checking the commits out",
+        (cmdYargs) => {
+            return cmdYargs
+                .positional("sources-path", {
+                    describe: "path to the git repository",
+                    type: "string",
                 })
-                .option("parse-dependencies", {
-                    type: "boolean",
-                    default: false,
+                .option("output-path", outputPathOption)
+                .option("ref", {
+                    type: "string",
+                    default: "HEAD",
+                    description: "Newest commit to analyze, e.g. a branch or tag name or a commit hash",
+                })
+                .option("max-commits", {
+                    type: "number",
+                    default: 0,
                     description:
-                        "EXPERIMENTAL: flag to enable dependency parsing (dependencies will be appended to the output file)",
+                        "Maximum number of commits to analyze, counted back from the newest one along the first parents (0 for all)",
                 })
+                .options(analysisOptions)
                 .demandOption(["sources-path", "output-path"]);
         },
         async (argv) => {
-            const configuration = new Configuration({
+            // Only the options that affect the metrics of single files are offered:
+            const configuration = createConfiguration({
                 /* eslint-disable @typescript-eslint/dot-notation */
+                ...getAnalysisParameters(argv),
                 sourcesPath: await fs.realpath(argv["sources-path"]),
                 outputPath: argv["output-path"],
-                parseDependencies: argv["parse-dependencies"],
-                exclusions: argv["exclusions"],
-                parseAllHAsC: argv["parse-h-as-c"],
-                parseSomeHAsC: argv["parse-some-h-as-c"],
-                compress: argv["compress"],
-                relativePaths: argv["relative-paths"],
+                relativePaths: true,
+                outputFormat: "ndjson",
                 /* eslint-enable @typescript-eslint/dot-notation */
             });
-            await parseSourceCode(configuration);
+            /* eslint-disable @typescript-eslint/dot-notation */
+            await calculateMetricsHistory(configuration, argv["ref"], argv["max-commits"]);
+            /* eslint-enable @typescript-eslint/dot-notation */
         },
     )
     .demandCommand()
     .strictCommands()
     .strictOptions();
 
+/**
+ * Creates the configuration of a command from the parameters of the options it offers.
+ * The options it does not offer are turned off, so that they cannot affect its results.
+ */
+function createConfiguration(
+    parameters: Pick<ConfigurationParameters, "sourcesPath"> & Partial<ConfigurationParameters>,
+): Configuration {
+    return new Configuration({ ...disabledParameters, ...parameters });
+}
+
+/**
+ * Returns the parameters of the {@link analysisOptions}.
+ */
+function getAnalysisParameters(
+    argv: InferredOptionTypes<typeof analysisOptions>,
+): Partial<ConfigurationParameters> {
+    return {
+        /* eslint-disable @typescript-eslint/dot-notation */
+        exclusions: argv["exclusions"],
+        parseAllHAsC: argv["parse-h-as-c"],
+        parseSomeHAsC: argv["parse-some-h-as-c"],
+        skipUnsupportedFiles: argv["skip-unsupported-files"],
+        parseTimeout: argv["parse-timeout"],
+        maxUnsupportedFileSize: argv["max-unsupported-file-size"],
+        commentKeywords: argv["comment-keywords"],
+        /* eslint-enable @typescript-eslint/dot-notation */
+    };
+}
+
 async function parseSourceCode(configuration: Configuration): Promise<void> {
+    let writer: MetricsWriter | undefined;
     try {
         console.time("Time to complete");
 
+        if (configuration.profilePath !== undefined) {
+            profiler.enable();
+            profiler.measureStartup();
+        }
+
+        writer = new MetricsWriter({
+            outputFilePath: configuration.outputPath,
+            compress: configuration.compress,
+            format: configuration.outputFormat,
+            // Coupling metrics are only known at the end, so they can only be merged into nodes kept until then:
+            mergeCouplingMetrics: configuration.parseDependencies,
+        });
+        const metricsWriter = writer;
+
+        // Write the metrics of each file while the metrics of further files are calculated:
         const parser = new GenericParser(configuration);
-        const results = await parser.calculateMetrics();
+        const results = await parser.calculateMetrics(async (filePath, fileMetricResults) =>
+            profiler.measureAsync("output", async () =>
+                metricsWriter.addFileMetrics(filePath, fileMetricResults),
+            ),
+        );
 
         console.log("#####################################");
         console.log("Metrics calculation finished.");
         console.timeEnd("Time to complete");
 
-        outputAsJson({
-            fileMetrics: results.fileMetrics,
-            unsupportedFiles: results.unsupportedFiles,
-            errorFiles: results.errorFiles,
-            relationshipMetrics: results.couplingMetrics,
+        await profiler.measureAsync("output", async () =>
+            metricsWriter.finish({
+                unsupportedFiles: results.unsupportedFiles,
+                errorFiles: results.errorFiles,
+                relationshipMetrics: results.couplingMetrics,
+            }),
+        );
+
+        if (configuration.profilePath !== undefined) {
+            const tracePath = await profiler.write(configuration.profilePath);
+            console.log(
+                "Profile saved to " + configuration.profilePath + ", trace saved to " + tracePath,
+            );
+        }
+    } catch (error) {
+        await writer?.abort();
+
+        console.error("#####################################");
+        console.error("#####################################");
+        console.error("Metrics calculation failed with the following error:");
+        console.error(error);
+    }
+}
+
+/**
+ * Calculates the metrics of the files of a single shard and writes them as partial results,
+ * which are merged with those of the other shards by the merge command.
+ */
+async function parseShard(configuration: Configuration): Promise<void> {
+    let writer: PartialResultsWriter | undefined;
+    try {
+        console.time("Time to complete");
+
+        if (configuration.profilePath !== undefined) {
+            profiler.enable();
+            profiler.measureStartup();
+        }
+
+        writer = new PartialResultsWriter(configuration.outputPath, configuration);
+        const partialResultsWriter = writer;
+
+        const parser = new GenericParser(configuration);
+        const fileCount = await parser.calculatePartialResults(async (index, processedFile) =>
+            profiler.measureAsync("output", async () =>
+                partialResultsWriter.addFile(index, processedFile),
+            ),
+        );
+
+        console.log("#####################################");
+        console.log("Metrics calculation of the shard finished.");
+        console.timeEnd("Time to complete");
+
+        await profiler.measureAsync("output", async () => partialResultsWriter.finish(fileCount));
+
+        if (configuration.profilePath !== undefined) {
+            const tracePath = await profiler.write(configuration.profilePath);
+            console.log(
+                "Profile saved to " + configuration.profilePath + ", trace saved to " + tracePath,
+            );
+        }
+    } catch (error) {
+        await writer?.abort();
+
+        console.error("#####################################");
+        console.error("#####################################");
+        console.error("Metrics calculation failed with the following error:");
+        console.error(error);
+    }
+}
+
+/**
+ * Merges the partial results of all shards and writes the same output as if all files had been analyzed
+ * in a single run: the files are handled in the order in which they were found
+ * and the coupling metrics are calculated once on the data extracted from all files.
+ */
+async function mergePartialResults(
+    partialResultsPaths: string[],
+    output: Pick<
+        ConfigurationParameters,
+        "outputPath" | "compress" | "outputFormat" | "directoryCoupling"
+    >,
+): Promise<void> {
+    let writer: MetricsWriter | undefined;
+    try {
+        const { header, files } = await openPartialResults(partialResultsPaths);
+
+        // Only the options that affect the merge are relevant, the files have already been analyzed:
+        const configuration = createConfiguration({
+            ...output,
+            sourcesPath: header.sourcesPath,
+            relativePaths: header.relativePaths,
+            parseDependencies: header.parseDependencies,
+        });
+
+        writer = new MetricsWriter({
             outputFilePath: configuration.outputPath,
             compress: configuration.compress,
+            format: configuration.outputFormat,
+            mergeCouplingMetrics: configuration.parseDependencies,
+        });
+        const metricsWriter = writer;
+
+        const couplingParser = new CouplingCalculator(configuration);
+        const aggregator = new ResultAggregator(
+            configuration,
+            couplingParser,
+            async (filePath, fileMetricResults) =>
+                metricsWriter.addFileMetrics(filePath, fileMetricResults),
+        );
+        for await (const { index, processedFile } of files) {
+            await aggregator.add(index, processedFile);
+        }
+
+        await metricsWriter.finish({
+            unsupportedFiles: aggregator.unsupportedFiles,
+            errorFiles: aggregator.errorFiles,
+            relationshipMetrics: couplingParser.calculateMetrics(),
         });
     } catch (error) {
+        await writer?.abort();
+
         console.error("#####################################");
         console.error("#####################################");
-        console.error("Metrics calculation failed with the following error:");
+        console.error("Merging the partial results failed with the following error:");
+        console.error(error);
+    }
+}
+
+/**
+ * Converts an output file in the columnar format back to the JSON or NDJSON format.
+ */
+async function convertColumnarOutput(
+    columnarOutputPath: string,
+    output: Pick<ConfigurationParameters, "outputPath" | "compress" | "outputFormat">,
+): Promise<void> {
+    let writer: MetricsWriter | undefined;
+    try {
+        const columnarOutput = await readColumnarOutputFile(columnarOutputPath);
+
+        writer = new MetricsWriter({
+            outputFilePath: output.outputPath,
+            compress: output.compress,
+            format: output.outputFormat,
+            mergeCouplingMetrics: false,
+        });
+        await writer.writeOutput({
+            nodes: columnarOutput.nodes(),
+            info: columnarOutput.info(),
+            relationships: columnarOutput.relationships(),
+        });
+    } catch (error) {
+        await writer?.abort();
+
+        console.error("#####################################");
+        console.error("#####################################");
+        console.error("Converting the output failed with the following error:");
+        console.error(error);
+    }
+}
+
+/**
+ * Analyzes all files once, then keeps the metrics up to date while files change and serves them,
+ * until the process is interrupted.
+ */
+async function serveMetrics(configuration: Configuration, address: ServerAddress): Promise<void> {
+    try {
+        console.time("Time to complete");
+        const analysis = new IncrementalAnalysis(configuration);
+        await analysis.analyzeAll();
+        console.log("Analyzed " + analysis.fileCount.toString() + " files.");
+        console.timeEnd("Time to complete");
+
+        const stopWatching = analysis.watch((filePaths) => {
+            console.log("Updated the metrics after changes to " + filePaths.join(", "));
+        });
+        const server = new MetricsServer(configuration, analysis);
+        console.log("Serving metrics on " + (await server.listen(address)));
+
+        // Stop watching and serving, so that the process ends and the Unix socket (if any) is removed:
+        process.once("SIGINT", () => {
+            stopWatching();
+            server.close().catch(() => undefined);
+        });
+    } catch (error) {
+        console.error("#####################################");
+        console.error("#####################################");
+        console.error("Serving the metrics failed with the following error:");
+        console.error(error);
+    }
+}
+
+/**
+ * Calculates the metrics of each commit in the history of a git repository
+ * and writes them to the output file as a time series, one JSON object per commit and line, oldest first.
+ */
+async function calculateMetricsHistory(
+    configuration: Configuration,
+    reference: string,
+    maxCommits: number,
+): Promise<void> {
+    let store: GitObjectStore | undefined;
+    let output: FileHandle | undefined;
+    try {
+        console.time("Time to complete");
+        store = await GitObjectStore.open(configuration.sourcesPath);
+        output = await fs.open(configuration.outputPath, "w");
+
+        let commitCount = 0;
+        let analyzedFiles = 0;
+        const history = new MetricsHistory(configuration, store);
+        for await (const commitMetrics of history.analyze(reference, maxCommits)) {
+            await output.write(JSON.stringify(commitMetrics) + "\n");
+            commitCount++;
+            analyzedFiles += commitMetrics.analyzedFiles;
+        }
+
+        console.log(
+            "Analyzed " +
+                commitCount.toString() +
+                " commits with " +
+                analyzedFiles.toString() +
+                " distinct file versions.",
+        );
+        console.log("Metrics history saved to " + configuration.outputPath);
+        console.timeEnd("Time to complete");
+    } catch (error) {
+        console.error("#####################################");
+        console.error("#####################################");
+        console.error("Calculating the metrics history failed with the following error:");
         console.error(error);
+    } finally {
+        await output?.close();
+        await store?.close();
     }
 }
@@ -0,0 +1,94 @@
+import { Buffer } from "node:buffer";
+import { describe, expect, it } from "vitest";
+import { ColumnarOutputBuilder, ColumnarOutputReader } from "./columnar-output.js";
+
+describe("columnar output", () => {
+    function buildOutput(): Buffer {
+        const builder = new ColumnarOutputBuilder();
+        builder.addNode({
+            name: "src/a.cs",
+            type: "source_code",
+            metrics: { complexity: 3, lines_of_code: 20 },
+        });
+        builder.addNode({ name: "README.md", type: "unsupported_file", metrics: { lines_of_code: 7 } });
+        builder.addNode({
+            name: "src/b.cs",
+            type: "source_code",
+            metrics: { complexity: 1, lines_of_code: 5, instability: 0.5 },
+        });
+        builder.addInfo({
+            name: "README.md",
+            type: "unsupported_file",
+            message: "Unknown language or file extension",
+        });
+        builder.addRelationship({ from: "src/b.cs", to: "src/a.cs", metrics: { coupling: 100 } });
+        return builder.toBuffer();
+    }
+
+    it("should restore the nodes, info nodes and relationships", () => {
+        const reader = new ColumnarOutputReader(buildOutput());
+
+        expect([...reader.nodes()]).toEqual([
+            { name: "src/a.cs", type: "source_code", metrics: { complexity: 3, lines_of_code: 20 } },
+            { name: "README.md", type: "unsupported_file", metrics: { lines_of_code: 7 } },
+            {
+                name: "src/b.cs",
+                type: "source_code",
+                metrics: { complexity: 1, lines_of_code: 5, instability: 0.5 },
+            },
+        ]);
+        expect([...reader.info()]).toEqual([
+            {
+                name: "README.md",
+                type: "unsupported_file",
+                message: "Unknown language or file extension",
+            },
+        ]);
+        expect([...reader.relationships()]).toEqual([
+            { from: "src/b.cs", to: "src/a.cs", metrics: { coupling: 100 } },
+        ]);
+    });
+
+    it("should store the values of each metric in a column, with NaN for nodes without a value", () => {
+        const reader = new ColumnarOutputReader(buildOutput());
+
+        expect(reader.nodeCount).toBe(3);
+        expect(reader.metricNames).toEqual(["complexity", "lines_of_code", "instability"]);
+        expect([...reader.getMetricColumn("complexity")!]).toEqual([3, Number.NaN, 1]);
+        expect([...reader.getMetricColumn("lines_of_code")!]).toEqual([20, 7, 5]);
+        expect([...reader.getMetricColumn("instability")!]).toEqual([
+            Number.NaN,
+            Number.NaN,
+            0.5,
+        ]);
+        expect(reader.getMetricColumn("classes")).toBeUndefined();
+    });
+
+    it("should store each string only once", () => {
+        const output = buildOutput();
+
+        expect(output.toString("latin1").split("src/a.cs")).toHaveLength(2);
+        expect(output.toString("latin1").split("lines_of_code")).toHaveLength(2);
+    });
+
+    it("should read data that is not aligned in memory", () => {
+        const output = buildOutput();
+        const unaligned = Buffer.alloc(output.length + 1);
+        output.copy(unaligned, 1);
+
+        const reader = new ColumnarOutputReader(unaligned.subarray(1));
+
+        expect([...reader.getMetricColumn("lines_of_code")!]).toEqual([20, 7, 5]);
+    });
+
+    it("should reject data in other formats and incomplete data", () => {
+        expect(() => new ColumnarOutputReader(Buffer.from('{"nodes":[]}'))).toThrowError(
+            /not in the columnar output format/,
+        );
+
+        const output = buildOutput();
+        expect(() => new ColumnarOutputReader(output.subarray(0, output.length - 16))).toThrowError(
+            /incomplete/,
+        );
+    });
+});
@@ -0,0 +1,402 @@
+import { Buffer } from "node:buffer";
+import fs from "node:fs/promises";
+import os from "node:os";
+import { promisify } from "node:util";
+import zlib from "node:zlib";
+import { type OutputInfoNode, type OutputNode, type OutputRelationship } from "./output-metrics.js";
+
+/*
+ * Binary output format with one column of numbers per metric, for tools that load the output of large code bases.
+ * Every string (paths, node types, metric names and messages) is stored only once and referenced by its index,
+ * and all arrays have a fixed width and position, so that the file can be memory-mapped and read
+ * without parsing it.
+ *
+ * Layout, with all numbers in little-endian byte order and all arrays starting at a multiple of 8 bytes:
+ * - Header: the magic bytes "MGCOLUMN", followed by uint32 values: the version, the number of nodes, metrics,
+ *   info nodes, relationships and strings, and the byte offsets of the following arrays, in this order.
+ * - String offsets: uint32[strings + 1], the start of each string in the string data and the end of the last one.
+ * - String data: all strings, encoded as UTF-8.
+ * - Metric names: uint32[metrics], string indices.
+ * - Node names and node types: uint32[nodes] each, string indices.
+ * - Metric values: float64[nodes] for each metric, in the order of the metric names.
+ *   NaN if there is no value of the metric for the node.
+ * - Info node names, types and messages: uint32[info nodes] each, string indices.
+ * - Relationship sources and targets: uint32[relationships] each, string indices.
+ *   All relationships have the coupling value 100.
+ */
+
+const magic = "MGCOLUMN";
+const version = 1;
+
+/**
+ * Arrays following the header, in the order in which they are stored.
+ */
+const arrayNames = [
+    "stringOffsets",
+    "stringData",
+    "metricNames",
+    "nodeNames",
+    "nodeTypes",
+    "metricValues",
+    "infoNames",
+    "infoTypes",
+    "infoMessages",
+    "relationshipFrom",
+    "relationshipTo",
+] as const;
+type ArrayName = (typeof arrayNames)[number];
+
+const countNames = ["nodes", "metrics", "info", "relationships", "strings"] as const;
+type Counts = Record<(typeof countNames)[number], number>;
+
+const headerSize = align(magic.length + 4 * (1 + countNames.length + arrayNames.length));
+
+/**
+ * Collects the output of a run in columns and encodes it in the columnar format.
+ * Only the columns are kept in memory, instead of an object per node.
+ */
+export class ColumnarOutputBuilder {
+    readonly #stringIndices = new Map<string, number>();
+    readonly #strings: string[] = [];
+
+    readonly #nodeNames: number[] = [];
+    readonly #nodeTypes: number[] = [];
+    readonly #metricColumns = new Map<string, number[]>();
+
+    readonly #infoNames: number[] = [];
+    readonly #infoTypes: number[] = [];
+    readonly #infoMessages: number[] = [];
+
+    readonly #relationshipFrom: number[] = [];
+    readonly #relationshipTo: number[] = [];
+
+    addNode(node: OutputNode): void {
+        const nodeIndex = this.#nodeNames.length;
+        this.#nodeNames.push(this.#intern(node.name));
+        this.#nodeTypes.push(this.#intern(node.type));
+
+        for (const [metricName, value] of Object.entries(node.metrics)) {
+            let column = this.#metricColumns.get(metricName);
+            if (column === undefined) {
+                column = [];
+                this.#metricColumns.set(metricName, column);
+            }
+
+            // Fill in the nodes without a value of the metric since the last one with a value:
+            while (column.length < nodeIndex) {
+                column.push(Number.NaN);
+            }
+
+            column.push(value);
+        }
+    }
+
+    addInfo(info: OutputInfoNode): void {
+        this.#infoNames.push(this.#intern(info.name));
+        this.#infoTypes.push(this.#intern(info.type));
+        this.#infoMessages.push(this.#intern(info.message));
+    }
+
+    addRelationship(relationship: OutputRelationship): void {
+        this.#relationshipFrom.push(this.#intern(relationship.from));
+        this.#relationshipTo.push(this.#intern(relationship.to));
+    }
+
+    /**
+     * Encodes the collected output.
+     */
+    toBuffer(): Buffer {
+        const metricNames = [...this.#metricColumns.keys()].map((name) => this.#intern(name));
+        const encodedStrings = this.#strings.map((string) => Buffer.from(string, "utf8"));
+        const stringDataLength = encodedStrings.reduce((sum, encoded) => sum + encoded.length, 0);
+
+        const counts: Counts = {
+            nodes: this.#nodeNames.length,
+            metrics: metricNames.length,
+            info: this.#infoNames.length,
+            relationships: this.#relationshipFrom.length,
+            strings: this.#strings.length,
+        };
+        const lengths = getArrayLengths(counts, stringDataLength);
+        const offsets = {} as Record<ArrayName, number>;
+        let size = headerSize;
+        for (const name of arrayNames) {
+            offsets[name] = size;
+            size = align(size + lengths[name]);
+        }
+
+        if (size > 0xff_ff_ff_ff) {
+            throw new Error("The output is too large for the columnar format (more than 4 GiB).");
+        }
+
+        const buffer = Buffer.alloc(size);
+        buffer.write(magic, 0, "latin1");
+        let headerOffset = magic.length;
+        for (const value of [version, ...countNames.map((name) => counts[name])]) {
+            headerOffset = buffer.writeUInt32LE(value, headerOffset);
+        }
+
+        for (const name of arrayNames) {
+            headerOffset = buffer.writeUInt32LE(offsets[name], headerOffset);
+        }
+
+        let stringOffset = 0;
+        let dataOffset = offsets.stringData;
+        for (const [index, encoded] of encodedStrings.entries()) {
+            buffer.writeUInt32LE(stringOffset, offsets.stringOffsets + 4 * index);
+            dataOffset += encoded.copy(buffer, dataOffset);
+            stringOffset += encoded.length;
+        }
+
+        buffer.writeUInt32LE(stringOffset, offsets.stringOffsets + 4 * encodedStrings.length);
+
+        writeUint32Array(buffer, offsets.metricNames, metricNames);
+        writeUint32Array(buffer, offsets.nodeNames, this.#nodeNames);
+        writeUint32Array(buffer, offsets.nodeTypes, this.#nodeTypes);
+        let columnOffset = offsets.metricValues;
+        for (const column of this.#metricColumns.values()) {
+            for (let index = 0; index < counts.nodes; index++) {
+                buffer.writeDoubleLE(column[index] ?? Number.NaN, columnOffset + 8 * index);
+            }
+
+            columnOffset += 8 * counts.nodes;
+        }
+
+        writeUint32Array(buffer, offsets.infoNames, this.#infoNames);
+        writeUint32Array(buffer, offsets.infoTypes, this.#infoTypes);
+        writeUint32Array(buffer, offsets.infoMessages, this.#infoMessages);
+        writeUint32Array(buffer, offsets.relationshipFrom, this.#relationshipFrom);
+        writeUint32Array(buffer, offsets.relationshipTo, this.#relationshipTo);
+
+        return buffer;
+    }
+
+    #intern(string: string): number {
+        let index = this.#stringIndices.get(string);
+        if (index === undefined) {
+            index = this.#strings.length;
+            this.#stringIndices.set(string, index);
+            this.#strings.push(string);
+        }
+
+        return index;
+    }
+}
+
+/**
+ * Reads an output file in the columnar format, with views on its arrays instead of copies of them.
+ */
+export class ColumnarOutputReader {
+    readonly #data: Uint8Array;
+    readonly #counts: Counts;
+    readonly #offsets: Record<ArrayName, number>;
+    readonly #stringOffsets: Uint32Array;
+    readonly #decoder = new TextDecoder();
+
+    /**
+     * Constructs a new {@link ColumnarOutputReader}.
+     * @param data Contents of the file.
+     * @throws Error If the data is not in the columnar format or has been truncated.
+     */
+    constructor(data: Uint8Array) {
+        if (
+            data.length < headerSize ||
+            Buffer.from(data.buffer, data.byteOffset, magic.length).toString("latin1") !== magic
+        ) {
+            throw new Error("The data is not in the columnar output format.");
+        }
+
+        // The arrays are read through typed arrays, which use the byte order of the machine:
+        if (os.endianness() !== "LE") {
+            throw new Error("Reading the columnar output format requires a little-endian machine.");
+        }
+
+        // Typed arrays can only be created on memory that is aligned to the size of their elements:
+        this.#data = data.byteOffset % 8 === 0 ? data : new Uint8Array(data);
+
+        const header = new DataView(this.#data.buffer, this.#data.byteOffset, headerSize);
+        let headerOffset = magic.length;
+        const readUint32 = (): number => {
+            const value = header.getUint32(headerOffset, true);
+            headerOffset += 4;
+            return value;
+        };
+
+        const fileVersion = readUint32();
+        if (fileVersion !== version) {
+            throw new Error(
+                "Unsupported version " +
+                    fileVersion.toString() +
+                    " of the columnar output format, expected " +
+                    version.toString() +
+                    ".",
+            );
+        }
+
+        this.#counts = {} as Counts;
+        for (const name of countNames) {
+            this.#counts[name] = readUint32();
+        }
+
+        this.#offsets = {} as Record<ArrayName, number>;
+        const lengths = getArrayLengths(this.#counts, 0);
+        for (const name of arrayNames) {
+            this.#offsets[name] = readUint32();
+            if (this.#offsets[name] + lengths[name] > this.#data.length) {
+                throw new Error("The columnar output is incomplete.");
+            }
+        }
+
+        this.#stringOffsets = this.#uint32Array("stringOffsets", this.#counts.strings + 1);
+        if (
+            this.#offsets.stringData + this.#stringOffsets[this.#counts.strings] >
+            this.#data.length
+        ) {
+            throw new Error("The columnar output is incomplete.");
+        }
+    }
+
+    get nodeCount(): number {
+        return this.#counts.nodes;
+    }
+
+    /**
+     * Names of the metrics, in the order of their columns.
+     */
+    get metricNames(): string[] {
+        return [...this.#uint32Array("metricNames", this.#counts.metrics)].map((index) =>
+            this.getString(index),
+        );
+    }
+
+    getString(index: number): string {
+        const start = this.#offsets.stringData + this.#stringOffsets[index];
+        const end = this.#offsets.stringData + this.#stringOffsets[index + 1];
+        return this.#decoder.decode(this.#data.subarray(start, end));
+    }
+
+    /**
+     * Returns the values of the specified metric for all nodes, in the order of the nodes.
+     * @param metricName Name of the metric.
+     * @return The values, NaN for nodes without a value of the metric,
+     * or undefined if no node has a value of the metric.
+     */
+    getMetricColumn(metricName: string): Float64Array | undefined {
+        const metricIndex = this.metricNames.indexOf(metricName);
+        if (metricIndex === -1) {
+            return undefined;
+        }
+
+        return new Float64Array(
+            this.#data.buffer,
+            this.#data.byteOffset + this.#offsets.metricValues + 8 * this.#counts.nodes * metricIndex,
+            this.#counts.nodes,
+        );
+    }
+
+    /**
+     * Yields the nodes as they are written in the JSON output format.
+     */
+    *nodes(): Generator<OutputNode> {
+        const names = this.#uint32Array("nodeNames", this.#counts.nodes);
+        const types = this.#uint32Array("nodeTypes", this.#counts.nodes);
+        const columns = this.metricNames.map(
+            (metricName) => [metricName, this.getMetricColumn(metricName)!] as const,
+        );
+
+        for (let index = 0; index < this.#counts.nodes; index++) {
+            const metrics: Record<string, number> = {};
+            for (const [metricName, column] of columns) {
+                if (!Number.isNaN(column[index])) {
+                    metrics[metricName] = column[index];
+                }
+            }
+
+            yield {
+                name: this.getString(names[index]),
+                type: this.getString(types[index]),
+                metrics,
+            };
+        }
+    }
+
+    /**
+     * Yields the info nodes as they are written in the JSON output format.
+     */
+    *info(): Generator<OutputInfoNode> {
+        const names = this.#uint32Array("infoNames", this.#counts.info);
+        const types = this.#uint32Array("infoTypes", this.#counts.info);
+        const messages = this.#uint32Array("infoMessages", this.#counts.info);
+
+        for (let index = 0; index < this.#counts.info; index++) {
+            yield {
+                name: this.getString(names[index]),
+                type: this.getString(types[index]),
+                message: this.getString(messages[index]),
+            };
+        }
+    }
+
+    /**
+     * Yields the relationships as they are written in the JSON output format.
+     */
+    *relationships(): Generator<OutputRelationship> {
+        const from = this.#uint32Array("relationshipFrom", this.#counts.relationships);
+        const to = this.#uint32Array("relationshipTo", this.#counts.relationships);
+
+        for (let index = 0; index < this.#counts.relationships; index++) {
+            yield {
+                from: this.getString(from[index]),
+                to: this.getString(to[index]),
+                metrics: { coupling: 100 },
+            };
+        }
+    }
+
+    #uint32Array(name: ArrayName, length: number): Uint32Array {
+        return new Uint32Array(
+            this.#data.buffer,
+            this.#data.byteOffset + this.#offsets[name],
+            length,
+        );
+    }
+}
+
+/**
+ * Reads an output file in the columnar format, which may be compressed.
+ * @param filePath Path of the file. Files with the extension .gz are decompressed.
+ */
+export async function readColumnarOutputFile(filePath: string): Promise<ColumnarOutputReader> {
+    let data = await fs.readFile(filePath);
+    if (filePath.endsWith(".gz")) {
+        data = await promisify(zlib.gunzip)(data);
+    }
+
+    return new ColumnarOutputReader(data);
+}
+
+function getArrayLengths(counts: Counts, stringDataLength: number): Record<ArrayName, number> {
+    return {
+        stringOffsets: 4 * (counts.strings + 1),
+        stringData: stringDataLength,
+        metricNames: 4 * counts.metrics,
+        nodeNames: 4 * counts.nodes,
+        nodeTypes: 4 * counts.nodes,
+        metricValues: 8 * counts.nodes * counts.metrics,
+        infoNames: 4 * counts.info,
+        infoTypes: 4 * counts.info,
+        infoMessages: 4 * counts.info,
+        relationshipFrom: 4 * counts.relationships,
+        relationshipTo: 4 * counts.relationships,
+    };
+}
+
+function writeUint32Array(buffer: Buffer, offset: number, values: number[]): void {
+    for (const [index, value] of values.entries()) {
+        buffer.writeUInt32LE(value, offset + 4 * index);
+    }
+}
+
+function align(offset: number): number {
+    return Math.ceil(offset / 8) * 8;
+}
@@ -0,0 +1,109 @@
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, beforeEach, describe, expect, it } from "vitest";
+import { getTestConfiguration } from "../../test/metric-end-results/test-helper.js";
+import { type Configuration } from "../parser/configuration.js";
+import { IncrementalAnalysis } from "../parser/incremental-analysis.js";
+import { MetricsServer } from "./metrics-server.js";
+
+describe("MetricsServer", () => {
+    let temporaryDir: string;
+    let server: MetricsServer | undefined;
+
+    beforeEach(async () => {
+        temporaryDir = await fs.realpath(
+            await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-")),
+        );
+        await fs.writeFile(path.join(temporaryDir, "A.java"), "class A {\n}\n");
+        await fs.writeFile(path.join(temporaryDir, "notes.txt"), "some\nnotes\n");
+    });
+
+    afterEach(async () => {
+        await server?.close();
+        server = undefined;
+        await fs.rm(temporaryDir, { recursive: true, force: true });
+    });
+
+    async function startServer(config: Configuration): Promise<string> {
+        const analysis = new IncrementalAnalysis(config);
+        await analysis.analyzeAll();
+        server = new MetricsServer(config, analysis);
+        return server.listen({ port: 0 });
+    }
+
+    it("should serve the output of all files", async () => {
+        const url = await startServer(getTestConfiguration(temporaryDir, { relativePaths: true }));
+
+        const response = await fetch(url + "/metrics");
+
+        expect(response.status).toBe(200);
+        expect(response.headers.get("Content-Type")).toBe("application/json");
+        const output = (await response.json()) as {
+            nodes: Array<{ name: string; type: string }>;
+            info: Array<{ name: string; type: string }>;
+            relationships: unknown[];
+        };
+        expect(output.nodes.map(({ name, type }) => ({ name, type }))).toEqual([
+            { name: "A.java", type: "source_code" },
+            { name: "notes.txt", type: "unsupported_file" },
+        ]);
+        expect(output.info.map(({ name }) => name)).toEqual(["notes.txt"]);
+        expect(output.relationships).toEqual([]);
+    });
+
+    it("should serve the output as NDJSON if configured", async () => {
+        const url = await startServer(
+            getTestConfiguration(temporaryDir, { relativePaths: true, outputFormat: "ndjson" }),
+        );
+
+        const response = await fetch(url + "/metrics");
+
+        expect(response.headers.get("Content-Type")).toBe("application/x-ndjson");
+        const lines = (await response.text()).trimEnd().split("\n");
+        expect(lines).toHaveLength(3);
+        expect(JSON.parse(lines[0])).toMatchObject({ node: { name: "A.java" } });
+    });
+
+    it("should serve the current metrics of a single file, analyzing it again if it has changed", async () => {
+        const url = await startServer(getTestConfiguration(temporaryDir, { relativePaths: true }));
+        await fs.writeFile(path.join(temporaryDir, "A.java"), "class A {\n}\nclass B {\n}\n");
+
+        const response = await fetch(url + "/metrics/file?path=A.java");
+
+        expect(response.status).toBe(200);
+        expect(await response.json()).toMatchObject({
+            name: "A.java",
+            type: "source_code",
+            metrics: { classes: 2, lines_of_code: 5 },
+        });
+    });
+
+    it("should respond with an error for unknown files and endpoints", async () => {
+        const url = await startServer(getTestConfiguration(temporaryDir));
+
+        expect((await fetch(url + "/metrics/file?path=Missing.java")).status).toBe(404);
+        expect((await fetch(url + "/metrics/file")).status).toBe(400);
+        expect((await fetch(url + "/unknown")).status).toBe(404);
+        expect((await fetch(url + "/metrics", { method: "POST" })).status).toBe(405);
+    });
+
+    it("should reject folders and paths outside the sources path without searching for files again", async () => {
+        const url = await startServer(getTestConfiguration(temporaryDir, { relativePaths: true }));
+        await fs.mkdir(path.join(temporaryDir, "src"));
+        await fs.writeFile(path.join(temporaryDir, "src", "B.java"), "class B {\n}\n");
+        const outsideFile = path.join(path.dirname(temporaryDir), "Outside.java");
+
+        expect((await fetch(url + "/metrics/file?path=.")).status).toBe(400);
+        expect((await fetch(url + "/metrics/file?path=src")).status).toBe(400);
+        expect((await fetch(url + "/metrics/file?path=..")).status).toBe(404);
+        expect(
+            (await fetch(url + "/metrics/file?path=" + encodeURIComponent(outsideFile))).status,
+        ).toBe(404);
+
+        const output = (await (await fetch(url + "/metrics")).json()) as {
+            nodes: Array<{ name: string }>;
+        };
+        expect(output.nodes.map(({ name }) => name)).toEqual(["A.java", "notes.txt"]);
+    });
+});
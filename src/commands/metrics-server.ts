@@ -0,0 +1,181 @@
+import fs from "node:fs/promises";
+import http from "node:http";
+import { type AddressInfo } from "node:net";
+import path from "node:path";
+import { formatPrintPath } from "../helper/helper.js";
+import { type Configuration, type OutputFormat } from "../parser/configuration.js";
+import { type IncrementalAnalysis } from "../parser/incremental-analysis.js";
+import { MetricsWriter, toOutputNode } from "./output-metrics.js";
+
+/**
+ * Where the server listens for requests: a TCP port on the loopback interface or a Unix socket.
+ */
+export type ServerAddress = { port: number } | { socketPath: string };
+
+/**
+ * Content type of the output of all files in each output format.
+ */
+const contentTypes: Record<OutputFormat, string> = {
+    json: "application/json",
+    ndjson: "application/x-ndjson",
+    columnar: "application/octet-stream",
+};
+
+/**
+ * Serves the results of an {@link IncrementalAnalysis} over HTTP, to the local machine only:
+ * - GET /metrics returns the output of all files in the configured output format,
+ *   like the output file of the parse command.
+ * - GET /metrics/file?path=... returns the node of a single file, after analyzing it again if it has changed,
+ *   so that clients get the current metrics of a file right after saving it.
+ *   The path may be absolute or relative to the sources path. Folders and paths outside the sources path are rejected.
+ */
+export class MetricsServer {
+    readonly #config: Configuration;
+    readonly #analysis: IncrementalAnalysis;
+    readonly #server: http.Server;
+
+    constructor(config: Configuration, analysis: IncrementalAnalysis) {
+        this.#config = config;
+        this.#analysis = analysis;
+        this.#server = http.createServer((request, response) => {
+            this.#handle(request, response).catch((error: unknown) => {
+                console.error("Error while handling the request " + (request.url ?? "") + ":");
+                console.error(error);
+                if (response.headersSent) {
+                    response.destroy();
+                } else {
+                    respond(response, 500, { error: String(error) });
+                }
+            });
+        });
+    }
+
+    /**
+     * Starts listening for requests.
+     * @param address The port or Unix socket to listen on. Port 0 selects a free port.
+     * @return Description of where the server is listening, e.g. for logging it.
+     */
+    async listen(address: ServerAddress): Promise<string> {
+        if ("socketPath" in address) {
+            // Remove the socket of a previous server that has not been shut down properly:
+            await fs.rm(address.socketPath, { force: true });
+        }
+
+        await new Promise<void>((resolve, reject) => {
+            this.#server.once("error", reject);
+            if ("socketPath" in address) {
+                this.#server.listen(address.socketPath, resolve);
+            } else {
+                this.#server.listen(address.port, "127.0.0.1", resolve);
+            }
+        });
+
+        const serverAddress = this.#server.address();
+        return typeof serverAddress === "string"
+            ? serverAddress
+            : "http://127.0.0.1:" + (serverAddress as AddressInfo).port.toString();
+    }
+
+    /**
+     * Stops listening and closes all connections.
+     */
+    async close(): Promise<void> {
+        this.#server.closeAllConnections();
+        await new Promise<void>((resolve, reject) => {
+            this.#server.close((error) => {
+                if (error === undefined) {
+                    resolve();
+                } else {
+                    reject(error);
+                }
+            });
+        });
+    }
+
+    async #handle(request: http.IncomingMessage, response: http.ServerResponse): Promise<void> {
+        const url = new URL(request.url ?? "/", "http://localhost");
+        if (request.method !== "GET") {
+            respond(response, 405, { error: "Only GET requests are supported" });
+        } else if (url.pathname === "/metrics") {
+            await this.#writeAllMetrics(response);
+        } else if (url.pathname === "/metrics/file") {
+            await this.#writeFileMetrics(url.searchParams.get("path"), response);
+        } else {
+            respond(response, 404, { error: "Unknown endpoint " + url.pathname });
+        }
+    }
+
+    async #writeAllMetrics(response: http.ServerResponse): Promise<void> {
+        const { outputFormat, parseDependencies } = this.#config;
+        response.writeHead(200, { "Content-Type": contentTypes[outputFormat] });
+
+        const writer = new MetricsWriter({
+            stream: response,
+            compress: false,
+            format: outputFormat,
+            mergeCouplingMetrics: parseDependencies,
+        });
+        try {
+            const results = await this.#analysis.getResults(async (filePath, fileMetricResults) =>
+                writer.addFileMetrics(filePath, fileMetricResults),
+            );
+            await writer.finish({
+                unsupportedFiles: results.unsupportedFiles,
+                errorFiles: results.errorFiles,
+                relationshipMetrics: results.couplingMetrics,
+            });
+        } catch (error) {
+            await writer.abort();
+            throw error;
+        }
+    }
+
+    async #writeFileMetrics(
+        requestedPath: string | null,
+        response: http.ServerResponse,
+    ): Promise<void> {
+        if (requestedPath === null || requestedPath.length === 0) {
+            respond(response, 400, { error: "The query parameter path is required" });
+            return;
+        }
+
+        const filePath = path.resolve(this.#config.sourcesPath, requestedPath);
+        if (!isInSourcesPath(filePath, this.#config.sourcesPath)) {
+            respond(response, 404, { error: "The file " + requestedPath + " is not analyzed" });
+            return;
+        }
+
+        // Updating a folder would search for all files again, which a single request must not trigger:
+        const stats = await fs.stat(filePath).catch(() => undefined);
+        if (stats?.isDirectory()) {
+            respond(response, 400, { error: "The path " + requestedPath + " is a folder" });
+            return;
+        }
+
+        const fileMetricResults = await this.#analysis.getFileMetrics(filePath);
+        if (fileMetricResults === undefined) {
+            respond(response, 404, { error: "The file " + requestedPath + " is not analyzed" });
+            return;
+        }
+
+        respond(
+            response,
+            200,
+            toOutputNode(formatPrintPath(filePath, this.#config), fileMetricResults),
+        );
+    }
+}
+
+/**
+ * Whether the file is the sources path itself, if that is a single file, or inside the sources path.
+ */
+function isInSourcesPath(filePath: string, sourcesPath: string): boolean {
+    const relativePath = path.relative(sourcesPath, filePath);
+    const isOutside = relativePath === ".." || relativePath.startsWith(".." + path.sep);
+    return !isOutside && !path.isAbsolute(relativePath);
+}
+
+function respond(response: http.ServerResponse, status: number, body: unknown): void {
+    response.writeHead(status, { "Content-Type": "application/json" });
+    response.end(JSON.stringify(body));
+}
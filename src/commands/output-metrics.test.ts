@@ -1,129 +1,355 @@
-import * as fs from "node:fs";
-import { afterAll, beforeEach, describe, expect, it, vi } from "vitest";
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import { PassThrough } from "node:stream";
+import { text } from "node:stream/consumers";
+import zlib from "node:zlib";
+import { afterEach, beforeEach, describe, expect, it } from "vitest";
 import {
     type MetricResult,
     type CouplingResult,
     type MetricError,
+    type FileMetricResults,
 } from "../parser/metrics/metric.js";
 import { FileType } from "../helper/language.js";
 import { mockConsole } from "../../test/metric-end-results/test-helper.js";
-import { outputAsJson } from "./output-metrics.js";
-
-vi.mock("fs", async (importOriginal) => {
-    const actual = await importOriginal<typeof fs>();
-    return { ...actual, writeFileSync: vi.fn() };
-});
+import { MetricsWriter } from "./output-metrics.js";
+import { readColumnarOutputFile } from "./columnar-output.js";
 
 describe("outputMetrics", () => {
-    describe("writes json into file ", () => {
-        beforeEach(mockConsole);
+    let temporaryDir: string;
+    let outputFilePath: string;
+
+    beforeEach(async () => {
+        mockConsole();
+        temporaryDir = await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-"));
+        outputFilePath = path.join(temporaryDir, "metrics.json");
+    });
+
+    afterEach(async () => {
+        await fs.rm(temporaryDir, { recursive: true, force: true });
+    });
+
+    function getFileMetrics(): Map<string, FileMetricResults> {
+        const file1MetricResults: MetricResult[] = [];
+        file1MetricResults.push(
+            { metricName: "real_lines_of_code", metricValue: 42 },
+            { metricName: "lines_of_code", metricValue: 43 },
+        );
+
+        const file2MetricResults: MetricResult[] = [];
+        file2MetricResults.push({ metricName: "real_lines_of_code", metricValue: 44 });
+        const file2MetricErrors: MetricError[] = [];
+        file2MetricErrors.push({ metricName: "lines_of_code", error: new Error("Buh!") });
+
+        return new Map([
+            [
+                "/file/path1.test",
+                {
+                    fileType: FileType.SourceCode,
+                    metricResults: file1MetricResults,
+                    metricErrors: [],
+                },
+            ],
+            [
+                "/file/path2.test",
+                {
+                    fileType: FileType.SourceCode,
+                    metricResults: file2MetricResults,
+                    metricErrors: file2MetricErrors,
+                },
+            ],
+        ]);
+    }
+
+    const unsupportedFiles = ["/file/path3.unknown", "/file/noExtension"];
+    const errorFiles = ["/file/path4.error"];
 
-        afterAll(() => {
-            vi.resetModules();
+    const relationshipMetrics: CouplingResult = {
+        relationships: [
+            {
+                fromFQTN: "fromNamespace",
+                toFQTN: "toNamespace",
+                usageType: "usage",
+                fromFile: "/file/path2.test",
+                toFile: "/file/path1.test",
+                fromTypeName: "ClassA",
+                toTypeName: "ClassB",
+            },
+        ],
+        metrics: new Map([
+            [
+                "/file/path2.test",
+                {
+                    outgoing_dependencies: 3,
+                    incoming_dependencies: 2,
+                    instability: 0.6,
+                    coupling_between_objects: 2,
+                    dependency_cycle_size: 0,
+                },
+            ],
+        ]),
+    };
+
+    const noRelationshipMetrics: CouplingResult = {
+        relationships: [],
+        metrics: new Map(),
+    };
+
+    async function writeMetrics(
+        writer: MetricsWriter,
+        fileMetrics: Map<string, FileMetricResults>,
+        couplingResult: CouplingResult,
+    ): Promise<void> {
+        for (const [filePath, fileMetricResults] of fileMetrics) {
+            await writer.addFileMetrics(filePath, fileMetricResults); // eslint-disable-line no-await-in-loop
+        }
+
+        await writer.finish({
+            unsupportedFiles,
+            errorFiles,
+            relationshipMetrics: couplingResult,
         });
+    }
 
-        it("when metrics are present", () => {
-            const file1MetricResults: MetricResult[] = [];
-            file1MetricResults.push(
-                { metricName: "real_lines_of_code", metricValue: 42 },
-                { metricName: "lines_of_code", metricValue: 43 },
-            );
+    describe("writes json into file ", () => {
+        it("when metrics are present", async () => {
+            const writer = new MetricsWriter({
+                outputFilePath,
+                compress: false,
+                format: "json",
+                mergeCouplingMetrics: true,
+            });
 
-            const file2MetricResults: MetricResult[] = [];
-            file2MetricResults.push({ metricName: "real_lines_of_code", metricValue: 44 });
-            const file2MetricErrors: MetricError[] = [];
-            file2MetricErrors.push({ metricName: "lines_of_code", error: new Error("Buh!") });
-
-            const fileMetrics = new Map([
-                [
-                    "/file/path1.test",
-                    {
-                        fileType: FileType.SourceCode,
-                        metricResults: file1MetricResults,
-                        metricErrors: [],
-                    },
-                ],
-                [
-                    "/file/path2.test",
-                    {
-                        fileType: FileType.SourceCode,
-                        metricResults: file2MetricResults,
-                        metricErrors: file2MetricErrors,
-                    },
-                ],
-            ]);
+            await writeMetrics(writer, getFileMetrics(), relationshipMetrics);
 
-            const unsupportedFiles = ["/file/path3.unknown", "/file/noExtension"];
-            const errorFiles = ["/file/path4.error"];
-
-            const relationshipMetrics: CouplingResult = {
-                relationships: [
-                    {
-                        fromFQTN: "fromNamespace",
-                        toFQTN: "toNamespace",
-                        usageType: "usage",
-                        fromFile: "/file/path2.test",
-                        toFile: "/file/path1.test",
-                        fromTypeName: "ClassA",
-                        toTypeName: "ClassB",
-                    },
-                ],
-                metrics: new Map([
-                    [
-                        "/file/path2.test",
-                        {
-                            outgoing_dependencies: 3,
-                            incoming_dependencies: 2,
-                            instability: 0.6,
-                            coupling_between_objects: 2,
-                        },
-                    ],
-                ]),
-            };
+            expect(console.log).toHaveBeenCalledTimes(1);
+            expect(console.log).toHaveBeenCalledWith("Results saved to " + outputFilePath);
+
+            expect(await fs.readFile(outputFilePath, "utf8")).toMatchSnapshot();
+        });
 
-            outputAsJson({
-                fileMetrics,
-                unsupportedFiles,
-                errorFiles,
-                relationshipMetrics,
-                outputFilePath: "mocked-file.json",
+        it("when no metrics are present", async () => {
+            const writer = new MetricsWriter({
+                outputFilePath,
                 compress: false,
+                format: "json",
+                mergeCouplingMetrics: false,
+            });
+
+            await writer.finish({
+                unsupportedFiles: [],
+                errorFiles: [],
+                relationshipMetrics: noRelationshipMetrics,
             });
 
             expect(console.log).toHaveBeenCalledTimes(1);
-            expect(console.log).toHaveBeenCalledWith("Results saved to mocked-file.json");
+            expect(console.log).toHaveBeenCalledWith("Results saved to " + outputFilePath);
+
+            expect(await fs.readFile(outputFilePath, "utf8")).toBe(
+                '{"nodes":[],"info":[],"relationships":[]}',
+            );
+        });
+
+        it("when the metrics of files are written before the end", async () => {
+            const writer = new MetricsWriter({
+                outputFilePath,
+                compress: false,
+                format: "json",
+                mergeCouplingMetrics: false,
+            });
 
-            expect(fs.writeFileSync).toHaveBeenCalledTimes(1);
-            const [file, data, options] = vi.mocked(fs.writeFileSync).mock.lastCall!;
+            await writeMetrics(writer, getFileMetrics(), noRelationshipMetrics);
 
-            expect(file).toBe("mocked-file.json");
-            expect(data).toMatchSnapshot();
-            expect(options).toBeUndefined();
+            const output = JSON.parse(await fs.readFile(outputFilePath, "utf8")) as {
+                nodes: Array<{ name: string }>;
+                info: unknown[];
+                relationships: unknown[];
+            };
+            expect(output.nodes.map(({ name }) => name)).toEqual([
+                "/file/path1.test",
+                "/file/path2.test",
+            ]);
+            expect(output.info).toHaveLength(4);
+            expect(output.relationships).toEqual([]);
         });
 
-        it("when no metrics are present", () => {
-            const relationshipMetrics: CouplingResult = {
-                relationships: [],
-                metrics: new Map(),
+        it("with the coupling metrics of directories as directory nodes after the file nodes", async () => {
+            const writer = new MetricsWriter({
+                outputFilePath,
+                compress: false,
+                format: "json",
+                mergeCouplingMetrics: true,
+            });
+            const directoryMetrics = {
+                outgoing_dependencies: 0,
+                incoming_dependencies: 0,
+                coupling_between_objects: 0,
+                instability: 1,
+                dependency_cycle_size: 0,
             };
 
-            outputAsJson({
-                fileMetrics: new Map(),
+            await writeMetrics(writer, getFileMetrics(), {
+                ...relationshipMetrics,
+                directoryMetrics: new Map([["/file", directoryMetrics]]),
+            });
+
+            const output = JSON.parse(await fs.readFile(outputFilePath, "utf8")) as {
+                nodes: Array<{ name: string; type: string; metrics: Record<string, number> }>;
+            };
+            expect(output.nodes.map(({ name, type }) => [name, type])).toEqual([
+                ["/file/path1.test", "source_code"],
+                ["/file/path2.test", "source_code"],
+                ["/file", "directory"],
+            ]);
+            expect(output.nodes[2].metrics).toEqual(directoryMetrics);
+        });
+
+        it("compressed with gzip", async () => {
+            const writer = new MetricsWriter({
+                outputFilePath,
+                compress: true,
+                format: "json",
+                mergeCouplingMetrics: false,
+            });
+
+            await writer.finish({
                 unsupportedFiles: [],
                 errorFiles: [],
-                relationshipMetrics,
-                outputFilePath: "mocked-file.json",
-                compress: false,
+                relationshipMetrics: noRelationshipMetrics,
             });
 
-            expect(console.log).toHaveBeenCalledTimes(1);
-            expect(console.log).toHaveBeenCalledWith("Results saved to mocked-file.json");
+            expect(writer.outputFilePath).toBe(outputFilePath + ".gz");
+            expect(console.log).toHaveBeenCalledWith("Results saved to " + outputFilePath + ".gz");
 
-            expect(fs.writeFileSync).toHaveBeenCalledTimes(1);
-            expect(fs.writeFileSync).toHaveBeenCalledWith(
-                "mocked-file.json",
+            const compressed = await fs.readFile(outputFilePath + ".gz");
+            expect(zlib.gunzipSync(compressed).toString()).toBe(
                 '{"nodes":[],"info":[],"relationships":[]}',
             );
         });
     });
+
+    describe("writes ndjson into file", () => {
+        it("with one node, info or relationship per line", async () => {
+            const writer = new MetricsWriter({
+                outputFilePath,
+                compress: false,
+                format: "ndjson",
+                mergeCouplingMetrics: true,
+            });
+
+            await writeMetrics(writer, getFileMetrics(), relationshipMetrics);
+
+            const lines = (await fs.readFile(outputFilePath, "utf8")).split("\n");
+            expect(lines.pop()).toBe("");
+            expect(lines.map((line) => Object.keys(JSON.parse(line) as object))).toEqual([
+                ["node"],
+                ["node"],
+                ["info"],
+                ["info"],
+                ["info"],
+                ["info"],
+                ["relationship"],
+            ]);
+            expect(JSON.parse(lines[1])).toEqual({
+                node: {
+                    name: "/file/path2.test",
+                    type: "source_code",
+                    metrics: {
+                        real_lines_of_code: 44,
+                        outgoing_dependencies: 3,
+                        incoming_dependencies: 2,
+                        instability: 0.6,
+                        coupling_between_objects: 2,
+                        dependency_cycle_size: 0,
+                    },
+                },
+            });
+        });
+    });
+
+    describe("writes columnar output into file", () => {
+        it("that can be converted to the same output as the json format", async () => {
+            const jsonWriter = new MetricsWriter({
+                outputFilePath,
+                compress: false,
+                format: "json",
+                mergeCouplingMetrics: true,
+            });
+            await writeMetrics(jsonWriter, getFileMetrics(), relationshipMetrics);
+            const columnarFilePath = path.join(temporaryDir, "metrics.columnar.gz");
+            const columnarWriter = new MetricsWriter({
+                outputFilePath: columnarFilePath,
+                compress: true,
+                format: "columnar",
+                mergeCouplingMetrics: true,
+            });
+            await writeMetrics(columnarWriter, getFileMetrics(), relationshipMetrics);
+
+            const columnarOutput = await readColumnarOutputFile(columnarFilePath);
+            const convertedFilePath = path.join(temporaryDir, "converted.json");
+            const convertedWriter = new MetricsWriter({
+                outputFilePath: convertedFilePath,
+                compress: false,
+                format: "json",
+                mergeCouplingMetrics: false,
+            });
+            await convertedWriter.writeOutput({
+                nodes: columnarOutput.nodes(),
+                info: columnarOutput.info(),
+                relationships: columnarOutput.relationships(),
+            });
+
+            expect(JSON.parse(await fs.readFile(convertedFilePath, "utf8"))).toEqual(
+                JSON.parse(await fs.readFile(outputFilePath, "utf8")),
+            );
+        });
+    });
+
+    it("writes to a stream instead of a file", async () => {
+        const stream = new PassThrough();
+        const output = text(stream);
+        const writer = new MetricsWriter({
+            stream,
+            compress: false,
+            format: "json",
+            mergeCouplingMetrics: true,
+        });
+
+        await writeMetrics(writer, getFileMetrics(), relationshipMetrics);
+
+        expect(writer.outputFilePath).toBeUndefined();
+        expect(console.log).not.toHaveBeenCalled();
+        const parsedOutput = JSON.parse(await output) as { nodes: unknown[] };
+        expect(parsedOutput.nodes).toHaveLength(2);
+        await expect(fs.access(outputFilePath)).rejects.toThrow();
+    });
+
+    it("rejects coupling metrics when the nodes are not kept until the end", async () => {
+        const writer = new MetricsWriter({
+            outputFilePath,
+            compress: false,
+            format: "json",
+            mergeCouplingMetrics: false,
+        });
+
+        await expect(writeMetrics(writer, getFileMetrics(), relationshipMetrics)).rejects.toThrow(
+            "Coupling metrics cannot be merged into nodes that are already written.",
+        );
+        await writer.abort();
+    });
+
+    it("removes the output file when aborted", async () => {
+        const writer = new MetricsWriter({
+            outputFilePath,
+            compress: false,
+            format: "json",
+            mergeCouplingMetrics: false,
+        });
+        await writer.addFileMetrics("/file/path1.test", getFileMetrics().get("/file/path1.test")!);
+
+        await writer.abort();
+
+        await expect(fs.access(outputFilePath)).rejects.toThrow();
+    });
 });
@@ -1,26 +1,30 @@
 import * as fs from "node:fs";
-import { Readable } from "node:stream";
+import { once } from "node:events";
+import { type Writable } from "node:stream";
+import { finished, pipeline } from "node:stream/promises";
 import zlib from "node:zlib";
 import {
     type CouplingResult,
     type FileMetricResults,
-    type MetricError,
+    type MetricName,
 } from "../parser/metrics/metric.js";
 import { FileType } from "../helper/language.js";
+import { type OutputFormat } from "../parser/configuration.js";
+import { ColumnarOutputBuilder } from "./columnar-output.js";
 
-type OutputNode = {
+export type OutputNode = {
     name: string;
     type: string;
     metrics: Record<string, number>;
 };
 
-type OutputInfoNode = {
+export type OutputInfoNode = {
     name: string;
     type: string;
     message: string;
 };
 
-type OutputRelationship = {
+export type OutputRelationship = {
     from: string;
     to: string;
     metrics: {
@@ -28,164 +32,389 @@ type OutputRelationship = {
     };
 };
 
+type Section = "nodes" | "info" | "relationships";
+
+/**
+ * Keys of the objects written for the elements of each section in the NDJSON format.
+ */
+const ndjsonKeys: Record<Section, string> = {
+    nodes: "node",
+    info: "info",
+    relationships: "relationship",
+};
+
+/**
+ * Type of the nodes with the coupling metrics of a directory.
+ */
+const directoryNodeType = "directory";
+
 /**
- * Writes the passed metrics into a json file.
- * @param fileMetrics Metrics calculated on single files.
- * @param unsupportedFiles List of files that cannot be analyzed.
- * @param errorFiles List of files that could not be parsed at all.
- * @param relationshipMetrics Relationship metrics.
- * @param outputFilePath Path to write the file to
- * @param compress Whether the file should be compressed
+ * Writes the calculated metrics incrementally to the output file, while they are being calculated.
+ * Respects the backpressure of the file (and compression) stream, so that the output is never held
+ * completely in memory. If compression is enabled, the output is compressed while further metrics are calculated.
+ *
+ * The metrics of files are written as soon as they are added, unless coupling metrics are to be merged into them.
+ * These are only known at the end, so the nodes need to be kept until then.
+ * The columnar format can only be written at the end as well, so its columns are collected until then.
  */
-export function outputAsJson({
-    fileMetrics,
-    unsupportedFiles,
-    errorFiles,
-    relationshipMetrics,
-    outputFilePath,
-    compress,
-}: {
-    fileMetrics: Map<string, FileMetricResults>;
-    unsupportedFiles: string[];
-    errorFiles: string[];
-    relationshipMetrics: CouplingResult;
-    outputFilePath: string;
-    compress: boolean;
-}): void {
-    const output = buildOutputObject(
-        fileMetrics,
+export class MetricsWriter {
+    /**
+     * Path of the output file, with the extension .gz if the output is compressed.
+     * Undefined if the output is written to a stream.
+     */
+    readonly outputFilePath: string | undefined;
+
+    readonly #format: OutputFormat;
+    readonly #mergeCouplingMetrics: boolean;
+
+    readonly #sink: Writable;
+    readonly #done: Promise<void>;
+
+    /**
+     * Collects the output in the columnar format, which can only be written once it is complete.
+     */
+    readonly #columnar: ColumnarOutputBuilder | undefined;
+
+    readonly #bufferedNodes = new Map<string, OutputNode>();
+    readonly #metricErrorsPerFile = new Map<string, MetricName[]>();
+
+    #section: Section | undefined;
+    #isFirstInSection = true;
+
+    /**
+     * Opens the output file.
+     * @param outputFilePath Path to write the file to.
+     * @param stream Stream to write the output to instead of a file, e.g. the response to a request.
+     * It is ended when the output is finished.
+     * @param compress Whether the file should be compressed.
+     * @param format Format of the output file.
+     * @param mergeCouplingMetrics Whether coupling metrics are passed to {@link finish}.
+     * If set, the metrics of all files are kept until then.
+     */
+    constructor({
+        outputFilePath,
+        stream,
+        compress,
+        format,
+        mergeCouplingMetrics,
+    }: {
+        outputFilePath?: string;
+        stream?: Writable;
+        compress: boolean;
+        format: OutputFormat;
+        mergeCouplingMetrics: boolean;
+    }) {
+        this.#format = format;
+        this.#mergeCouplingMetrics = mergeCouplingMetrics;
+        this.#columnar = format === "columnar" ? new ColumnarOutputBuilder() : undefined;
+
+        let destination: Writable;
+        if (stream === undefined) {
+            if (outputFilePath === undefined) {
+                throw new Error("Either an output file path or a stream is required.");
+            }
+
+            this.outputFilePath =
+                compress && !outputFilePath.endsWith(".gz") ? outputFilePath + ".gz" : outputFilePath;
+            destination = fs.createWriteStream(this.outputFilePath);
+        } else {
+            destination = stream;
+        }
+
+        if (compress) {
+            const gzip = zlib.createGzip();
+            this.#sink = gzip;
+            this.#done = pipeline(gzip, destination);
+        } else {
+            this.#sink = destination;
+            this.#done = finished(destination);
+        }
+
+        // Errors are reported when writing or finishing, avoid that they are considered unhandled before:
+        this.#done.catch(() => undefined);
+    }
+
+    /**
+     * Adds the metrics calculated on a single file.
+     * @param filePath Path of the file, as it should appear in the output.
+     * @param fileMetricResults The metrics calculated on the file.
+     * @return Promise that resolves as soon as further metrics can be added.
+     */
+    async addFileMetrics(filePath: string, fileMetricResults: FileMetricResults): Promise<void> {
+        if (fileMetricResults.metricErrors.length > 0) {
+            this.#metricErrorsPerFile.set(
+                filePath,
+                fileMetricResults.metricErrors.map(({ metricName }) => metricName),
+            );
+        }
+
+        const outputNode = toOutputNode(filePath, fileMetricResults);
+        if (this.#mergeCouplingMetrics) {
+            this.#bufferedNodes.set(filePath, outputNode);
+        } else {
+            await this.#writeElement("nodes", outputNode);
+        }
+    }
+
+    /**
+     * Writes the remaining output and closes the output file.
+     * @param unsupportedFiles List of files that cannot be analyzed.
+     * @param errorFiles List of files that could not be parsed at all.
+     * @param relationshipMetrics Relationship metrics.
+     */
+    async finish({
         unsupportedFiles,
         errorFiles,
         relationshipMetrics,
-    );
-    const outputString = JSON.stringify(output).toString();
-
-    if (compress) {
-        outputFilePath = outputFilePath.endsWith(".gz") ? outputFilePath : outputFilePath + ".gz";
-        dumpCompressed(outputString, outputFilePath);
-    } else {
-        fs.writeFileSync(outputFilePath, outputString);
+    }: {
+        unsupportedFiles: string[];
+        errorFiles: string[];
+        relationshipMetrics: CouplingResult;
+    }): Promise<void> {
+        if (!this.#mergeCouplingMetrics && relationshipMetrics.metrics.size > 0) {
+            throw new Error("Coupling metrics cannot be merged into nodes that are already written.");
+        }
+
+        // Merge relationship metrics with existing nodes or add new node
+        const additionalNodes: OutputNode[] = [];
+        for (const [filePath, metricsMap] of relationshipMetrics.metrics) {
+            const existingOutputNode = this.#bufferedNodes.get(filePath);
+            if (existingOutputNode === undefined) {
+                additionalNodes.push({
+                    name: filePath,
+                    type: FileType.SourceCode,
+                    metrics: { ...metricsMap },
+                });
+            } else {
+                existingOutputNode.metrics = { ...existingOutputNode.metrics, ...metricsMap };
+            }
+        }
+
+        // Directories have no metrics of their own, so their coupling metrics are written as separate nodes:
+        for (const [directoryPath, metricsMap] of relationshipMetrics.directoryMetrics ?? []) {
+            additionalNodes.push({
+                name: directoryPath,
+                type: directoryNodeType,
+                metrics: { ...metricsMap },
+            });
+        }
+
+        await this.#writeElements("nodes", [...this.#bufferedNodes.values(), ...additionalNodes]);
+        await this.#writeElements(
+            "info",
+            getInfoNodes(unsupportedFiles, errorFiles, this.#metricErrorsPerFile),
+        );
+        await this.#writeElements(
+            "relationships",
+            relationshipMetrics.relationships.map(
+                (relationship): OutputRelationship => ({
+                    from: relationship.fromFile,
+                    to: relationship.toFile,
+                    metrics: { coupling: 100 },
+                }),
+            ),
+        );
+
+        await this.#end();
     }
 
-    console.log("Results saved to " + outputFilePath);
-}
+    /**
+     * Writes nodes, info nodes and relationships that are already in the form of the output,
+     * e.g. read from an output file in another format, and closes the output file.
+     */
+    async writeOutput({
+        nodes,
+        info,
+        relationships,
+    }: {
+        nodes: Iterable<OutputNode>;
+        info: Iterable<OutputInfoNode>;
+        relationships: Iterable<OutputRelationship>;
+    }): Promise<void> {
+        for (const node of nodes) {
+            await this.#writeElement("nodes", node); // eslint-disable-line no-await-in-loop
+        }
 
-function buildOutputObject(
-    fileMetrics: Map<string, FileMetricResults>,
-    unknownFiles: string[],
-    errorFiles: string[],
-    relationshipMetrics: CouplingResult,
-): {
-    nodes: OutputNode[];
-    info: OutputInfoNode[];
-    relationships: OutputRelationship[];
-} {
-    const output: {
-        nodes: OutputNode[];
-        info: OutputInfoNode[];
-        relationships: OutputRelationship[];
-    } = {
-        nodes: [],
-        info: [],
-        relationships: [],
-    };
+        for (const infoNode of info) {
+            await this.#writeElement("info", infoNode); // eslint-disable-line no-await-in-loop
+        }
 
-    const outputNodeReferenceLookUp = new Map<string, OutputNode>();
+        for (const relationship of relationships) {
+            await this.#writeElement("relationships", relationship); // eslint-disable-line no-await-in-loop
+        }
 
-    const metricErrorsPerFile = new Map<string, Iterable<MetricError>>();
+        await this.#end();
+    }
 
-    for (const [filePath, fileMetricResults] of fileMetrics.entries()) {
-        const metrics: Record<string, number> = {};
-        if (fileMetricResults.metricErrors.length > 0) {
-            metricErrorsPerFile.set(filePath, fileMetricResults.metricErrors);
+    /**
+     * Closes the output file after the calculation of the metrics failed, and removes it.
+     */
+    async abort(): Promise<void> {
+        this.#sink.destroy();
+        await this.#done.catch(() => undefined);
+        if (this.outputFilePath !== undefined) {
+            await fs.promises.rm(this.outputFilePath, { force: true });
         }
+    }
 
-        for (const metricResult of fileMetricResults.metricResults) {
-            metrics[metricResult.metricName] = metricResult.metricValue;
+    async #writeElements(
+        section: Section,
+        elements: Array<OutputNode | OutputInfoNode | OutputRelationship>,
+    ): Promise<void> {
+        for (const element of elements) {
+            await this.#writeElement(section, element); // eslint-disable-line no-await-in-loop
         }
+    }
 
-        const outputNode: OutputNode = {
-            name: filePath,
-            type: fileMetricResults.fileType,
-            metrics,
-        };
+    async #writeElement(
+        section: Section,
+        element: OutputNode | OutputInfoNode | OutputRelationship,
+    ): Promise<void> {
+        if (this.#columnar !== undefined) {
+            addColumnarElement(this.#columnar, section, element);
+            return;
+        }
+
+        await this.#startSection(section);
+
+        if (this.#format === "ndjson") {
+            await this.#write(JSON.stringify({ [ndjsonKeys[section]]: element }) + "\n");
+        } else {
+            await this.#write((this.#isFirstInSection ? "" : ",") + JSON.stringify(element));
+        }
+
+        this.#isFirstInSection = false;
+    }
+
+    /**
+     * Writes everything up to the start of the specified section, including all previous sections
+     * that had no elements. Pass undefined to write everything up to the end of the output.
+     */
+    async #startSection(section: Section | undefined): Promise<void> {
+        if (this.#format !== "json" || (section !== undefined && section === this.#section)) {
+            return;
+        }
+
+        const sections: Section[] = ["nodes", "info", "relationships"];
+        const from = this.#section === undefined ? 0 : sections.indexOf(this.#section) + 1;
+        const to = section === undefined ? sections.length : sections.indexOf(section) + 1;
+
+        let output = "";
+        for (let i = from; i < to; i++) {
+            output += (i === 0 ? "{" : "],") + JSON.stringify(sections[i]) + ":[";
+        }
+
+        if (section === undefined) {
+            output += "]}";
+        }
+
+        this.#section = section;
+        this.#isFirstInSection = true;
+        await this.#write(output);
+    }
+
+    async #end(): Promise<void> {
+        if (this.#columnar === undefined) {
+            await this.#startSection(undefined);
+        } else {
+            await this.#write(this.#columnar.toBuffer());
+        }
+
+        this.#sink.end();
+        await this.#done;
+
+        if (this.outputFilePath !== undefined) {
+            console.log("Results saved to " + this.outputFilePath);
+        }
+    }
+
+    async #write(chunk: string | Uint8Array): Promise<void> {
+        if (!this.#sink.write(chunk)) {
+            // Wait until the buffered output has been written, unless writing fails:
+            await Promise.race([once(this.#sink, "drain"), this.#done]);
+        }
+    }
+}
 
-        outputNodeReferenceLookUp.set(filePath, outputNode);
-        output.nodes.push(outputNode);
+/**
+ * Converts the metrics calculated on a single file to the node that represents the file in the output.
+ * @param filePath Path of the file, as it should appear in the output.
+ * @param fileMetricResults The metrics calculated on the file.
+ */
+export function toOutputNode(filePath: string, fileMetricResults: FileMetricResults): OutputNode {
+    const metrics: Record<string, number> = {};
+    for (const metricResult of fileMetricResults.metricResults) {
+        metrics[metricResult.metricName] = metricResult.metricValue;
     }
 
+    return {
+        name: filePath,
+        type: fileMetricResults.fileType,
+        metrics,
+    };
+}
+
+function addColumnarElement(
+    columnar: ColumnarOutputBuilder,
+    section: Section,
+    element: OutputNode | OutputInfoNode | OutputRelationship,
+): void {
+    switch (section) {
+        case "nodes": {
+            columnar.addNode(element as OutputNode);
+            break;
+        }
+
+        case "info": {
+            columnar.addInfo(element as OutputInfoNode);
+            break;
+        }
+
+        case "relationships": {
+            columnar.addRelationship(element as OutputRelationship);
+            break;
+        }
+    }
+}
+
+function getInfoNodes(
+    unknownFiles: string[],
+    errorFiles: string[],
+    metricErrorsPerFile: Map<string, MetricName[]>,
+): OutputInfoNode[] {
+    const infoNodes: OutputInfoNode[] = [];
+
     // Info for unknown file types
     for (const filePath of unknownFiles) {
-        const outputNode: OutputInfoNode = {
+        infoNodes.push({
             name: filePath,
             type: FileType.Unsupported,
             message: "Unknown language or file extension",
-        };
-
-        output.info.push(outputNode);
+        });
     }
 
     // Info when parsing the syntax tree failed
     for (const filePath of errorFiles) {
-        const outputNode: OutputInfoNode = {
+        infoNodes.push({
             name: filePath,
             type: FileType.Error,
             message: "Error while parsing a syntax tree for the file",
-        };
-
-        output.info.push(outputNode);
+        });
     }
 
     // Info when the calculation of (some) metrics failed
-    for (const [filePath, metricErrors] of metricErrorsPerFile) {
+    for (const [filePath, metricNames] of metricErrorsPerFile) {
         let message = "Error while calculating the following metric(s) for the file:";
-        for (const metricError of metricErrors) {
-            message += " " + metricError.metricName;
+        for (const metricName of metricNames) {
+            message += " " + metricName;
         }
 
-        const outputNode: OutputInfoNode = {
+        infoNodes.push({
             name: filePath,
             type: FileType.Error,
             message,
-        };
-
-        output.info.push(outputNode);
-    }
-
-    // Merge relationship metrics with existing nodes or add new node
-    const couplingMetrics = relationshipMetrics.metrics.entries();
-    for (const [filePath, metricsMap] of couplingMetrics) {
-        const existingOutputNode = outputNodeReferenceLookUp.get(filePath);
-        if (existingOutputNode === undefined) {
-            const newOutputNode: OutputNode = {
-                name: filePath,
-                type: FileType.SourceCode,
-                metrics: { ...metricsMap },
-            };
-            output.nodes.push(newOutputNode);
-        } else {
-            existingOutputNode.metrics = { ...existingOutputNode.metrics, ...metricsMap };
-        }
-    }
-
-    const couplingMetricResults = relationshipMetrics.relationships;
-
-    for (const couplingMetricResult of couplingMetricResults) {
-        output.relationships.push({
-            from: couplingMetricResult.fromFile,
-            to: couplingMetricResult.toFile,
-            metrics: { coupling: 100 },
         });
     }
 
-    return output;
-}
-
-function dumpCompressed(outputString: string, outputFilePath: string): void {
-    const readableStream = new Readable();
-    readableStream.push(outputString);
-
-    const gzip = zlib.createGzip();
-    const writeStream = fs.createWriteStream(outputFilePath);
-    readableStream.pipe(gzip).pipe(writeStream);
+    return infoNodes;
 }
@@ -0,0 +1,238 @@
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, beforeEach, describe, expect, it } from "vitest";
+import { getTestConfiguration, mockConsole } from "../../test/metric-end-results/test-helper.js";
+import { FileType } from "../helper/language.js";
+import { type Configuration } from "../parser/configuration.js";
+import { CouplingCalculator } from "../parser/coupling-calculator.js";
+import { GenericParser } from "../parser/generic-parser.js";
+import { type ProcessedFile } from "../parser/result-cache.js";
+import { ResultAggregator } from "../parser/result-aggregator.js";
+import {
+    type PartialResultsFile,
+    PartialResultsWriter,
+    openPartialResults,
+} from "./partial-results.js";
+
+describe("partial results", () => {
+    let temporaryDir: string;
+
+    beforeEach(async () => {
+        temporaryDir = await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-"));
+    });
+
+    afterEach(async () => {
+        await fs.rm(temporaryDir, { recursive: true, force: true });
+    });
+
+    const processedFile = (fileName: string): ProcessedFile => ({
+        fileResult: {
+            filePath: path.join("/sources", fileName),
+            fileType: FileType.SourceCode,
+            fileMetricResults: {
+                fileType: FileType.SourceCode,
+                metricResults: [{ metricName: "lines_of_code", metricValue: fileName.length }],
+                metricErrors: [],
+            },
+        },
+    });
+
+    const shardConfiguration = (
+        shard: string,
+        overrides: Parameters<typeof getTestConfiguration>[1] = {},
+    ): Configuration => getTestConfiguration("/sources", { shard, ...overrides });
+
+    async function writePartialResults(
+        config: Configuration,
+        files: Array<[number, ProcessedFile]>,
+        fileCount: number | undefined,
+    ): Promise<string> {
+        const filePath = path.join(temporaryDir, `shard-${config.shard!.index.toString()}.ndjson`);
+        const writer = new PartialResultsWriter(filePath, config);
+        for (const [index, file] of files) {
+            await writer.addFile(index, file); // eslint-disable-line no-await-in-loop
+        }
+
+        await writer.finish(fileCount ?? 0);
+        if (fileCount === undefined) {
+            // Remove the end, as if the run had been aborted before it finished:
+            const lines = (await fs.readFile(filePath, "utf8")).split("\n");
+            await fs.writeFile(filePath, lines.slice(0, -2).join("\n") + "\n");
+        }
+
+        return filePath;
+    }
+
+    async function collect(files: AsyncIterable<PartialResultsFile>): Promise<PartialResultsFile[]> {
+        const collected: PartialResultsFile[] = [];
+        for await (const file of files) {
+            collected.push(file);
+        }
+
+        return collected;
+    }
+
+    it("should merge the files of all shards in the order in which they were found", async () => {
+        mockConsole();
+        const first = await writePartialResults(
+            shardConfiguration("1/2"),
+            [
+                [0, processedFile("a.java")],
+                [3, processedFile("d.java")],
+            ],
+            4,
+        );
+        const second = await writePartialResults(
+            shardConfiguration("2/2"),
+            [
+                [1, processedFile("b.java")],
+                [2, processedFile("c.java")],
+            ],
+            4,
+        );
+
+        const { header, files } = await openPartialResults([second, first]);
+
+        expect(header).toMatchObject({ sourcesPath: "/sources", parseDependencies: false });
+        expect(await collect(files)).toEqual([
+            { index: 0, processedFile: processedFile("a.java") },
+            { index: 1, processedFile: processedFile("b.java") },
+            { index: 2, processedFile: processedFile("c.java") },
+            { index: 3, processedFile: processedFile("d.java") },
+        ]);
+    });
+
+    it("should restore errors and coupling data", async () => {
+        mockConsole();
+        const parseError = new Error("Unable to parse");
+        const metricError = new TypeError("Unable to calculate");
+        const file: ProcessedFile = {
+            fileResult: {
+                filePath: "/sources/a.cs",
+                fileType: FileType.Error,
+                fileMetricResults: {
+                    fileType: FileType.Error,
+                    metricResults: [],
+                    metricErrors: [{ metricName: "complexity", error: metricError }],
+                },
+                parseError,
+            },
+            couplingData: {
+                filePath: "/sources/a.cs",
+                types: new Map(),
+                accessors: new Map(),
+                usageCandidates: [],
+                callExpressions: [],
+            },
+        };
+        const partialResults = await writePartialResults(shardConfiguration("1/1"), [[0, file]], 1);
+
+        const [{ processedFile: restored }] = await collect(
+            (await openPartialResults([partialResults])).files,
+        );
+
+        expect(restored.couplingData).toEqual(file.couplingData);
+        expect(restored.fileResult.parseError).toBeInstanceOf(Error);
+        expect(restored.fileResult.parseError?.message).toBe("Unable to parse");
+        const [restoredMetricError] = restored.fileResult.fileMetricResults.metricErrors;
+        expect(restoredMetricError.metricName).toBe("complexity");
+        expect(restoredMetricError.error.name).toBe("TypeError");
+        expect(restoredMetricError.error.message).toBe("Unable to calculate");
+    });
+
+    it("should reject partial results if a shard is missing", async () => {
+        mockConsole();
+        const first = await writePartialResults(shardConfiguration("1/2"), [], 0);
+
+        await expect(openPartialResults([first])).rejects.toThrowError(
+            /Expected the partial results of all 2 shards exactly once/,
+        );
+    });
+
+    it("should reject partial results that were calculated with different options", async () => {
+        mockConsole();
+        const first = await writePartialResults(shardConfiguration("1/2"), [], 0);
+        const second = await writePartialResults(
+            shardConfiguration("2/2", { exclusions: "generated" }),
+            [],
+            0,
+        );
+
+        await expect(openPartialResults([first, second])).rejects.toThrowError(
+            /calculated with different options/,
+        );
+    });
+
+    it("should reject incomplete partial results", async () => {
+        mockConsole();
+        const first = await writePartialResults(
+            shardConfiguration("1/2"),
+            [[0, processedFile("a.java")]],
+            2,
+        );
+        const second = await writePartialResults(
+            shardConfiguration("2/2"),
+            [[1, processedFile("b.java")]],
+            undefined,
+        );
+
+        const { files } = await openPartialResults([first, second]);
+
+        await expect(collect(files)).rejects.toThrowError(/are incomplete/);
+    });
+
+    it("should reject partial results with missing files", async () => {
+        mockConsole();
+        const first = await writePartialResults(
+            shardConfiguration("1/2"),
+            [[0, processedFile("a.java")]],
+            3,
+        );
+        const second = await writePartialResults(
+            shardConfiguration("2/2"),
+            [[2, processedFile("c.java")]],
+            3,
+        );
+
+        const { files } = await openPartialResults([first, second]);
+
+        await expect(collect(files)).rejects.toThrowError(/results of file 1 are missing/);
+    });
+
+    it("should result in the same metrics as a single run when merging the results of all shards", async () => {
+        mockConsole();
+        const sourcesPath = await fs.realpath("./resources/c-sharp/coupling-examples/");
+        const parameters = { parseDependencies: true, relativePaths: true };
+
+        const singleRun = await new GenericParser(
+            getTestConfiguration(sourcesPath, parameters),
+        ).calculateMetrics();
+
+        const partialResultsPaths: string[] = [];
+        for (const shard of ["1/3", "2/3", "3/3"]) {
+            const config = getTestConfiguration(sourcesPath, { ...parameters, shard });
+            const filePath = path.join(temporaryDir, `shard-${config.shard!.index.toString()}.ndjson`);
+            const writer = new PartialResultsWriter(filePath, config);
+            // eslint-disable-next-line no-await-in-loop
+            const fileCount = await new GenericParser(config).calculatePartialResults(
+                async (index, file) => writer.addFile(index, file),
+            );
+            await writer.finish(fileCount); // eslint-disable-line no-await-in-loop
+            partialResultsPaths.push(filePath);
+        }
+
+        const { header, files } = await openPartialResults(partialResultsPaths);
+        const mergeConfig = getTestConfiguration(header.sourcesPath, parameters);
+        const couplingParser = new CouplingCalculator(mergeConfig);
+        const aggregator = new ResultAggregator(mergeConfig, couplingParser, undefined);
+        for await (const { index, processedFile } of files) {
+            await aggregator.add(index, processedFile);
+        }
+
+        expect([...aggregator.fileMetrics]).toEqual([...singleRun.fileMetrics]);
+        expect(aggregator.unsupportedFiles).toEqual(singleRun.unsupportedFiles);
+        expect(aggregator.errorFiles).toEqual(singleRun.errorFiles);
+        expect(couplingParser.calculateMetrics()).toEqual(singleRun.couplingMetrics);
+    });
+});
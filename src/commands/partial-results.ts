@@ -0,0 +1,301 @@
+import * as fs from "node:fs";
+import { createHash } from "node:crypto";
+import { once } from "node:events";
+import readline from "node:readline";
+import { finished } from "node:stream/promises";
+import { type Configuration } from "../parser/configuration.js";
+import {
+    deserializeProcessedFile,
+    type ProcessedFile,
+    type SerializedProcessedFile,
+    serializeProcessedFile,
+} from "../parser/result-cache.js";
+import { type Shard } from "../helper/shard.js";
+
+/**
+ * Version of the format of partial results. Increase it when the format changes.
+ */
+const partialResultsVersion = 1;
+
+/**
+ * Settings of a sharded run that the partial results depend on.
+ * Partial results can only be merged if they were calculated with the same settings.
+ */
+export type PartialResultsHeader = {
+    version: number;
+    shard: Shard;
+    sourcesPath: string;
+    relativePaths: boolean;
+    parseDependencies: boolean;
+    /**
+     * Hash of all other settings that affect which files are found and which metrics are calculated for them.
+     */
+    settings: string;
+};
+
+/**
+ * Results of a single file in partial results.
+ */
+export type PartialResultsFile = {
+    /**
+     * Index of the file among the files found in all shards.
+     */
+    index: number;
+    processedFile: ProcessedFile;
+};
+
+/**
+ * Line of a partial results file: the header first, then the results of each file of the shard
+ * in the order in which they were found, then the number of files found in all shards.
+ */
+type PartialResultsLine =
+    | { header: PartialResultsHeader }
+    | { file: { index: number } & SerializedProcessedFile }
+    | { end: { fileCount: number } };
+
+/**
+ * Writes the results of the files of a shard incrementally to a partial results file, one JSON object per line.
+ * Unlike the output file, it contains everything needed to calculate the output of all shards,
+ * including the data extracted for the coupling metrics and the errors that occurred.
+ */
+export class PartialResultsWriter {
+    readonly outputFilePath: string;
+
+    readonly #sink: fs.WriteStream;
+    readonly #done: Promise<void>;
+
+    /**
+     * Opens the partial results file and writes the header.
+     * @param outputFilePath Path to write the file to.
+     * @param config Configuration of the sharded run.
+     */
+    constructor(outputFilePath: string, config: Configuration) {
+        if (config.shard === undefined) {
+            throw new Error("Partial results can only be written for a shard of the files.");
+        }
+
+        this.outputFilePath = outputFilePath;
+        this.#sink = fs.createWriteStream(outputFilePath);
+        this.#done = finished(this.#sink);
+        // Errors are reported when writing or finishing, avoid that they are considered unhandled before:
+        this.#done.catch(() => undefined);
+
+        this.#sink.write(
+            toLine({
+                header: {
+                    version: partialResultsVersion,
+                    shard: config.shard,
+                    sourcesPath: config.sourcesPath,
+                    relativePaths: config.relativePaths,
+                    parseDependencies: config.parseDependencies,
+                    settings: getSettingsHash(config),
+                },
+            }),
+        );
+    }
+
+    /**
+     * Adds the results of a file.
+     * @param index Index of the file among the files found in all shards.
+     * @param processedFile The results of the file.
+     * @return Promise that resolves as soon as further results can be added.
+     */
+    async addFile(index: number, processedFile: ProcessedFile): Promise<void> {
+        await this.#write(toLine({ file: { index, ...serializeProcessedFile(processedFile) } }));
+    }
+
+    /**
+     * Writes the end of the partial results and closes the file.
+     * @param fileCount Number of files found in all shards.
+     */
+    async finish(fileCount: number): Promise<void> {
+        this.#sink.end(toLine({ end: { fileCount } }));
+        await this.#done;
+
+        console.log("Partial results saved to " + this.outputFilePath);
+    }
+
+    /**
+     * Closes the partial results file after the calculation of the metrics failed, and removes it.
+     */
+    async abort(): Promise<void> {
+        this.#sink.destroy();
+        await this.#done.catch(() => undefined);
+        await fs.promises.rm(this.outputFilePath, { force: true });
+    }
+
+    async #write(line: string): Promise<void> {
+        if (!this.#sink.write(line)) {
+            // Wait until the buffered output has been written, unless writing fails:
+            await Promise.race([once(this.#sink, "drain"), this.#done]);
+        }
+    }
+}
+
+/**
+ * Opens the partial results of all shards of a run and checks that they belong together.
+ * @param filePaths Paths of the partial results files, one per shard, in any order.
+ * @return The common header of the partial results, and the results of all files in the order in which they
+ * were found, as if all files had been analyzed in a single run. Iterating over the files throws an error
+ * if the results of a file are missing, e.g. because a partial results file is incomplete.
+ */
+export async function openPartialResults(filePaths: string[]): Promise<{
+    header: PartialResultsHeader;
+    files: AsyncGenerator<PartialResultsFile>;
+}> {
+    const readers = await Promise.all(filePaths.map(async (filePath) => openReader(filePath)));
+
+    const { header } = readers[0];
+    const shardCount = header.shard.count;
+    const shardIndices = new Set(readers.map((reader) => reader.header.shard.index));
+    if (readers.some((reader) => reader.header.shard.count !== shardCount)) {
+        throw new Error("The partial results were calculated for different numbers of shards.");
+    }
+
+    if (shardIndices.size !== readers.length || readers.length !== shardCount) {
+        throw new Error(
+            `Expected the partial results of all ${shardCount.toString()} shards exactly once, ` +
+                `but got the shards ${readers.map((reader) => reader.header.shard.index).join(", ")}.`,
+        );
+    }
+
+    for (const reader of readers) {
+        const { sourcesPath, relativePaths, parseDependencies, settings } = reader.header;
+        if (
+            sourcesPath !== header.sourcesPath ||
+            relativePaths !== header.relativePaths ||
+            parseDependencies !== header.parseDependencies ||
+            settings !== header.settings
+        ) {
+            throw new Error(
+                "The partial results in " +
+                    reader.filePath +
+                    " were calculated with different options than those in " +
+                    readers[0].filePath +
+                    ".",
+            );
+        }
+    }
+
+    return { header, files: mergeFiles(readers) };
+}
+
+type PartialResultsReader = {
+    filePath: string;
+    header: PartialResultsHeader;
+    lines: AsyncIterator<string>;
+};
+
+async function openReader(filePath: string): Promise<PartialResultsReader> {
+    const input = fs.createReadStream(filePath);
+    const lines = readline
+        .createInterface({ input, crlfDelay: Number.POSITIVE_INFINITY })
+        [Symbol.asyncIterator]();
+
+    const firstLine = await lines.next();
+    const first = firstLine.done ? undefined : (JSON.parse(firstLine.value) as PartialResultsLine);
+    if (first === undefined || !("header" in first)) {
+        throw new Error(filePath + " does not contain partial results.");
+    }
+
+    if (first.header.version !== partialResultsVersion) {
+        throw new Error(
+            filePath +
+                " contains partial results of an incompatible version of metric-gardener.",
+        );
+    }
+
+    return { filePath, header: first.header, lines };
+}
+
+/**
+ * Merges the files of all partial results by their index, reading only one file of each at a time.
+ */
+async function* mergeFiles(readers: PartialResultsReader[]): AsyncGenerator<PartialResultsFile> {
+    const fileCounts = new Set<number>();
+    const heads: Array<PartialResultsFile | undefined> = await Promise.all(
+        readers.map(async (reader) => readNextFile(reader, fileCounts)),
+    );
+
+    let expectedIndex = 0;
+    for (;;) {
+        let next: number | undefined;
+        for (const [i, head] of heads.entries()) {
+            if (head !== undefined && (next === undefined || head.index < heads[next]!.index)) {
+                next = i;
+            }
+        }
+
+        if (next === undefined) {
+            break;
+        }
+
+        const file = heads[next]!;
+        if (file.index !== expectedIndex) {
+            throw new Error(
+                `The results of file ${expectedIndex.toString()} are missing in the partial results.`,
+            );
+        }
+
+        expectedIndex++;
+        yield file;
+        heads[next] = await readNextFile(readers[next], fileCounts); // eslint-disable-line no-await-in-loop
+    }
+
+    if (fileCounts.size !== 1 || !fileCounts.has(expectedIndex)) {
+        throw new Error(
+            "The shards found different files, the partial results have to be calculated on the same sources.",
+        );
+    }
+}
+
+/**
+ * Reads the next file of the specified partial results, or records the number of files found in all shards
+ * and returns undefined at the end.
+ */
+async function readNextFile(
+    reader: PartialResultsReader,
+    fileCounts: Set<number>,
+): Promise<PartialResultsFile | undefined> {
+    const { done, value } = await reader.lines.next();
+    if (done) {
+        throw new Error("The partial results in " + reader.filePath + " are incomplete.");
+    }
+
+    const line = JSON.parse(value) as PartialResultsLine;
+    if ("end" in line) {
+        fileCounts.add(line.end.fileCount);
+        return undefined;
+    }
+
+    if (!("file" in line)) {
+        throw new Error("Unexpected line in the partial results in " + reader.filePath + ".");
+    }
+
+    const { index, ...serializedFile } = line.file;
+    return { index, processedFile: deserializeProcessedFile(serializedFile) };
+}
+
+function toLine(line: PartialResultsLine): string {
+    return JSON.stringify(line) + "\n";
+}
+
+/**
+ * Hashes the settings that affect which files are found and which metrics are calculated for them,
+ * apart from those stored in the header of partial results.
+ */
+function getSettingsHash(config: Configuration): string {
+    return createHash("sha256")
+        .update(
+            JSON.stringify({
+                exclusions: [...config.exclusions].sort(),
+                parseAllHAsC: config.parseAllHAsC,
+                parseSomeHAsC: [...config.parseSomeHAsC].sort(),
+                skipUnsupportedFiles: config.skipUnsupportedFiles,
+                parseTimeout: config.parseTimeout,
+                maxUnsupportedFileSize: config.maxUnsupportedFileSize,
+                commentKeywords: [...config.commentKeywords],
+            }),
+        )
+        .digest("hex");
+}
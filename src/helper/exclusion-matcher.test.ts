@@ -0,0 +1,62 @@
+import { describe, expect, it } from "vitest";
+import { ExclusionMatcher } from "./exclusion-matcher.js";
+
+describe("ExclusionMatcher", () => {
+    it("should match plain names of folders on any level, but not of files", () => {
+        const matcher = new ExclusionMatcher(["node_modules"]);
+
+        expect(matcher.isExcluded("node_modules", true)).toBe(true);
+        expect(matcher.isExcluded("app/node_modules", true)).toBe(true);
+        expect(matcher.isExcluded("app/node_modules", false)).toBe(false);
+        expect(matcher.isExcluded("app/node_modules_old", true)).toBe(false);
+    });
+
+    it("should match glob patterns without a slash against the names of files and folders", () => {
+        const matcher = new ExclusionMatcher(["*.min.js", "test?", "[Bb]uild"]);
+
+        expect(matcher.isExcluded("lib/jquery.min.js", false)).toBe(true);
+        expect(matcher.isExcluded("lib/jquery.js", false)).toBe(false);
+        expect(matcher.isExcluded("src/test1", true)).toBe(true);
+        expect(matcher.isExcluded("src/test12", true)).toBe(false);
+        expect(matcher.isExcluded("Build", true)).toBe(true);
+        expect(matcher.isExcluded("build", false)).toBe(true);
+    });
+
+    it("should match patterns with a slash against the path relative to the sources path", () => {
+        const matcher = new ExclusionMatcher(["/generated", "src/*/fixtures", "docs/**/*.md"]);
+
+        expect(matcher.isExcluded("generated", true)).toBe(true);
+        expect(matcher.isExcluded("src/generated", true)).toBe(false);
+        expect(matcher.isExcluded("src/app/fixtures", true)).toBe(true);
+        expect(matcher.isExcluded("src/app/nested/fixtures", true)).toBe(false);
+        expect(matcher.isExcluded("docs/index.md", false)).toBe(true);
+        expect(matcher.isExcluded("docs/guide/setup/index.md", false)).toBe(true);
+        expect(matcher.isExcluded("index.md", false)).toBe(false);
+    });
+
+    it("should only match folders with patterns ending with a slash", () => {
+        const matcher = new ExclusionMatcher(["out*/", "dist/"]);
+
+        expect(matcher.isExcluded("output", true)).toBe(true);
+        expect(matcher.isExcluded("output", false)).toBe(false);
+        expect(matcher.isExcluded("dist", true)).toBe(true);
+        expect(matcher.isExcluded("dist", false)).toBe(false);
+    });
+
+    it("should support negated character classes and escape other special characters", () => {
+        const matcher = new ExclusionMatcher(["[!a]*.c", "a+b(c).h"]);
+
+        expect(matcher.isExcluded("bar.c", false)).toBe(true);
+        expect(matcher.isExcluded("abc.c", false)).toBe(true);
+        expect(matcher.isExcluded("a.c", false)).toBe(false);
+        expect(matcher.isExcluded("a+b(c).h", false)).toBe(true);
+        expect(matcher.isExcluded("aab(c).h", false)).toBe(false);
+    });
+
+    it("should ignore empty patterns", () => {
+        const matcher = new ExclusionMatcher(["", "/"]);
+
+        expect(matcher.isExcluded("src", true)).toBe(false);
+        expect(matcher.isExcluded("file.ts", false)).toBe(false);
+    });
+});
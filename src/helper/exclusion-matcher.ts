@@ -0,0 +1,123 @@
+/**
+ * Matches paths against exclusion patterns in the style of .gitignore files:
+ * - A plain name without wildcards or slashes, like "node_modules", matches folders with that name on any level.
+ *   Unlike in .gitignore files, it does not match files, so that the names of folders can be excluded
+ *   without accidentally excluding files with the same name.
+ * - A pattern with wildcards but without a slash, like "*.min.js", matches files and folders on any level.
+ * - A pattern with a slash at the beginning or in the middle, like "/build" or "src/generated",
+ *   matches paths relative to the sources path.
+ * - A pattern with a slash at the end, like "out/", matches only folders.
+ * - "*" matches anything except a slash, "?" matches any single character except a slash,
+ *   "[...]" matches one of the characters in the brackets ("[!...]" one of the characters not in the brackets)
+ *   and "**" matches any number of folders.
+ *
+ * Negated patterns starting with "!" are not supported.
+ */
+export class ExclusionMatcher {
+    readonly #directoryNames = new Set<string>();
+    readonly #namePatterns: Array<{ regex: RegExp; directoriesOnly: boolean }> = [];
+    readonly #pathPatterns: Array<{ regex: RegExp; directoriesOnly: boolean }> = [];
+
+    /**
+     * Constructs a new {@link ExclusionMatcher}.
+     * @param patterns The exclusion patterns. Empty patterns are ignored.
+     */
+    constructor(patterns: Iterable<string>) {
+        for (let pattern of patterns) {
+            const directoriesOnly = pattern.endsWith("/");
+            if (directoriesOnly) {
+                pattern = pattern.slice(0, -1);
+            }
+
+            if (pattern.length === 0) {
+                continue;
+            }
+
+            if (pattern.includes("/")) {
+                this.#pathPatterns.push({
+                    regex: globToRegex(pattern.startsWith("/") ? pattern.slice(1) : pattern),
+                    directoriesOnly,
+                });
+            } else if (isGlob(pattern)) {
+                this.#namePatterns.push({ regex: globToRegex(pattern), directoriesOnly });
+            } else {
+                // Plain names are by far the most common exclusions, so look them up directly:
+                this.#directoryNames.add(pattern);
+            }
+        }
+    }
+
+    /**
+     * Whether the specified file or folder is excluded.
+     * Files and folders in excluded folders are not checked, as they are not searched at all.
+     * @param relativePath Path of the file or folder relative to the sources path, with "/" as separator.
+     * @param isDirectory Whether the path points to a folder.
+     */
+    isExcluded(relativePath: string, isDirectory: boolean): boolean {
+        const name = relativePath.slice(relativePath.lastIndexOf("/") + 1);
+        if (isDirectory && this.#directoryNames.has(name)) {
+            return true;
+        }
+
+        for (const { regex, directoriesOnly } of this.#namePatterns) {
+            if ((isDirectory || !directoriesOnly) && regex.test(name)) {
+                return true;
+            }
+        }
+
+        for (const { regex, directoriesOnly } of this.#pathPatterns) {
+            if ((isDirectory || !directoriesOnly) && regex.test(relativePath)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+function isGlob(pattern: string): boolean {
+    return /[*?[]/.test(pattern);
+}
+
+/**
+ * Converts a glob pattern to a regular expression that matches the whole path.
+ */
+function globToRegex(pattern: string): RegExp {
+    let regex = "";
+    let index = 0;
+
+    while (index < pattern.length) {
+        const char = pattern[index];
+
+        if (char === "*" && pattern[index + 1] === "*") {
+            if (pattern[index + 2] === "/") {
+                // "**/" matches any number of folders, including none:
+                regex += "(?:.*/)?";
+                index += 3;
+            } else {
+                regex += ".*";
+                index += 2;
+            }
+        } else if (char === "*") {
+            regex += "[^/]*";
+            index++;
+        } else if (char === "?") {
+            regex += "[^/]";
+            index++;
+        } else if (char === "[" && pattern.includes("]", index + 1)) {
+            const end = pattern.indexOf("]", index + 1);
+            let characters = pattern.slice(index + 1, end).replaceAll("\\", "\\\\");
+            if (characters.startsWith("!")) {
+                characters = "^" + characters.slice(1);
+            }
+
+            regex += "[" + characters + "]";
+            index = end + 1;
+        } else {
+            regex += char.replaceAll(/[$()*+.?[\\\]^{|}]/g, "\\$&");
+            index++;
+        }
+    }
+
+    return new RegExp("^" + regex + "$");
+}
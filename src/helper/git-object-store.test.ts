@@ -0,0 +1,182 @@
+import { Buffer } from "node:buffer";
+import { createHash } from "node:crypto";
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import zlib from "node:zlib";
+import { afterEach, beforeEach, describe, expect, it } from "vitest";
+import { createGitRepository } from "./git-repository.test-helper.js";
+import { applyDelta, GitObjectStore } from "./git-object-store.js";
+
+function hashObject(type: string, data: Buffer): string {
+    return createHash("sha1")
+        .update(`${type} ${data.length.toString()}\0`)
+        .update(data)
+        .digest("hex");
+}
+
+/**
+ * Encodes a delta that copies the specified range of the base and appends the inserted bytes.
+ */
+function encodeDelta(baseSize: number, copyLength: number, insert: string): Buffer {
+    const inserted = Buffer.from(insert);
+    return Buffer.from([
+        baseSize,
+        copyLength + inserted.length,
+        // Copy from offset 0 with a one-byte size:
+        0x80 | 0x10,
+        copyLength,
+        inserted.length,
+        ...inserted,
+    ]);
+}
+
+/**
+ * Writes a pack with a blob, a delta of it referenced by offset and a delta of that referenced by name.
+ * @return The names and contents of the blobs.
+ */
+async function writePack(gitDirectory: string): Promise<Map<string, string>> {
+    const base = Buffer.from("public class Example {}\n");
+    const first = Buffer.from("public class Example {}\n// first\n");
+    const second = Buffer.from("public class Example {}\n// first\n// second\n");
+    const names = [hashObject("blob", base), hashObject("blob", first), hashObject("blob", second)];
+
+    const entry = (typeNumber: number, size: number, extra: number[], data: Buffer): Buffer => {
+        const header = [(typeNumber << 4) | (size & 15) | (size > 15 ? 0x80 : 0)];
+        for (let rest = size >> 4; rest > 0; rest >>= 7) {
+            header.push((rest & 0x7f) | (rest > 0x7f ? 0x80 : 0));
+        }
+
+        return Buffer.concat([Buffer.from([...header, ...extra]), zlib.deflateSync(data)]);
+    };
+
+    const firstDelta = encodeDelta(base.length, base.length, "// first\n");
+    const secondDelta = encodeDelta(first.length, first.length, "// second\n");
+    const entries = [entry(3, base.length, [], base)];
+    const baseDistance = entries[0].length;
+    entries.push(entry(6, firstDelta.length, [baseDistance], firstDelta));
+    entries.push(entry(7, secondDelta.length, [...Buffer.from(names[1], "hex")], secondDelta));
+
+    const header = Buffer.from([0x50, 0x41, 0x43, 0x4b, 0, 0, 0, 2, 0, 0, 0, 3]);
+    const pack = Buffer.concat([header, ...entries]);
+    const offsets = [12, 12 + entries[0].length, 12 + entries[0].length + entries[1].length];
+
+    const sorted = [0, 1, 2].sort((first, second) => names[first].localeCompare(names[second]));
+    const fanout = Buffer.alloc(256 * 4);
+    for (let byte = 0; byte < 256; byte++) {
+        const count = names.filter((name) => Number.parseInt(name.slice(0, 2), 16) <= byte).length;
+        fanout.writeUInt32BE(count, byte * 4);
+    }
+
+    const offsetTable = Buffer.alloc(3 * 4);
+    for (const [position, index] of sorted.entries()) {
+        offsetTable.writeUInt32BE(offsets[index], position * 4);
+    }
+
+    const index = Buffer.concat([
+        Buffer.from([0xff, 0x74, 0x4f, 0x63, 0, 0, 0, 2]),
+        fanout,
+        ...sorted.map((index) => Buffer.from(names[index], "hex")),
+        Buffer.alloc(3 * 4),
+        offsetTable,
+    ]);
+
+    const packDirectory = path.join(gitDirectory, "objects", "pack");
+    await fs.mkdir(packDirectory, { recursive: true });
+    // The checksums of the pack and the index are not verified when reading:
+    await fs.writeFile(
+        path.join(packDirectory, "pack-test.pack"),
+        Buffer.concat([pack, Buffer.alloc(20)]),
+    );
+    await fs.writeFile(path.join(packDirectory, "pack-test.idx"), index);
+
+    return new Map([
+        [names[0], base.toString()],
+        [names[1], first.toString()],
+        [names[2], second.toString()],
+    ]);
+}
+
+describe("GitObjectStore", () => {
+    let repositoryPath: string;
+
+    beforeEach(async () => {
+        repositoryPath = await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-"));
+    });
+
+    afterEach(async () => {
+        await fs.rm(repositoryPath, { recursive: true, force: true });
+    });
+
+    it("should read commits, trees and blobs from loose objects", async () => {
+        const commits = createGitRepository(repositoryPath, [
+            { "README.md": "# Example\n" },
+            { "README.md": "# Example\n", "src/Example.java": "class Example {}\n" },
+        ]);
+        const store = await GitObjectStore.open(repositoryPath);
+
+        expect(await store.resolveCommit("HEAD")).toBe(commits[1]);
+        expect(await store.resolveCommit("main")).toBe(commits[1]);
+        expect(await store.resolveCommit(commits[0])).toBe(commits[0]);
+
+        const commit = await store.readCommit(commits[1]);
+        expect(commit).toEqual({
+            hash: commits[1],
+            tree: expect.stringMatching(/^[\da-f]{40}$/) as string,
+            parents: [commits[0]],
+            time: 1_700_000_060,
+            subject: "Version 2",
+        });
+
+        const entries = await store.readTree(commit.tree);
+        expect(entries.map(({ mode, name }) => [mode, name])).toEqual([
+            ["100644", "README.md"],
+            ["40000", "src"],
+        ]);
+        const [sourceFile] = await store.readTree(entries[1].hash);
+        expect((await store.readBlob(sourceFile.hash)).toString()).toBe("class Example {}\n");
+        expect(await store.readObjectSize(sourceFile.hash)).toBe(17);
+
+        await store.close();
+    });
+
+    it("should read objects from pack files, applying deltas referenced by offset and by name", async () => {
+        createGitRepository(repositoryPath, [{ "README.md": "# Example\n" }]);
+        const blobs = await writePack(path.join(repositoryPath, ".git"));
+        const store = await GitObjectStore.open(repositoryPath);
+
+        for (const [hash, contents] of blobs) {
+            expect(await store.readObjectSize(hash)).toBe(contents.length);
+            expect((await store.readBlob(hash)).toString()).toBe(contents);
+        }
+
+        await store.close();
+    });
+
+    it("should report unknown references and objects and repositories that do not exist", async () => {
+        createGitRepository(repositoryPath, [{ "README.md": "# Example\n" }]);
+        const store = await GitObjectStore.open(repositoryPath);
+
+        await expect(store.resolveCommit("unknown")).rejects.toThrowError(/Unknown git reference/);
+        await expect(store.readObject("0".repeat(40))).rejects.toThrowError(/not found/);
+        await expect(GitObjectStore.open(path.join(repositoryPath, "src"))).rejects.toThrowError(
+            /No git repository/,
+        );
+    });
+});
+
+describe("applyDelta(...)", () => {
+    it("should copy ranges of the base and insert new bytes", () => {
+        const base = Buffer.from("Hello, world");
+
+        expect(applyDelta(base, encodeDelta(base.length, 7, "delta")).toString()).toBe(
+            "Hello, delta",
+        );
+    });
+
+    it("should reject deltas of another base", () => {
+        expect(() => applyDelta(Buffer.from("abc"), encodeDelta(4, 2, ""))).toThrowError(
+            /size of its base/,
+        );
+    });
+});
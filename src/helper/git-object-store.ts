@@ -0,0 +1,691 @@
+import fs, { type FileHandle } from "node:fs/promises";
+import path from "node:path";
+import zlib from "node:zlib";
+
+/**
+ * Types of the objects in a git repository.
+ */
+export type GitObjectType = "commit" | "tree" | "blob" | "tag";
+
+export type GitObject = {
+    type: GitObjectType;
+    data: Buffer;
+};
+
+export type GitCommit = {
+    hash: string;
+    tree: string;
+    parents: string[];
+    /**
+     * Time of the commit in seconds since the epoch, from the committer line.
+     */
+    time: number;
+    /**
+     * First line of the commit message.
+     */
+    subject: string;
+};
+
+export type GitTreeEntry = {
+    /**
+     * File mode in octal, e.g. "100644" for a file, "40000" for a folder or "160000" for a submodule.
+     */
+    mode: string;
+    name: string;
+    hash: string;
+};
+
+/**
+ * Length of the SHA-1 object names in bytes. Repositories with SHA-256 object names are not supported.
+ */
+const hashLength = 20;
+
+/**
+ * Types of the objects in pack files, by their type number.
+ */
+const packObjectTypes: Array<GitObjectType | undefined> = [
+    undefined,
+    "commit",
+    "tree",
+    "blob",
+    "tag",
+];
+const offsetDeltaType = 6;
+const referenceDeltaType = 7;
+
+/**
+ * Number of compressed bytes to inflate for reading the size of an object from its header,
+ * which is far more than the header needs even if the start of the object is not compressed at all.
+ */
+const sizeProbeLength = 1024;
+
+/**
+ * Maximum total size of the recently read packed objects that are kept as bases for deltas.
+ */
+const deltaBaseCacheSize = 32 * 1024 * 1024;
+
+/**
+ * Index of a pack file, which stores the names of its objects in sorted order and the offsets of the objects.
+ */
+type PackIndex = {
+    packPath: string;
+    /**
+     * Number of objects whose name starts with a byte up to each value, as in the fanout table of the index file.
+     */
+    fanout: Uint32Array;
+    /**
+     * Sorted names of the objects, 20 bytes each.
+     */
+    names: Buffer;
+    /**
+     * Offset of each object in the pack file, by its position in {@link names}.
+     */
+    offsets: Float64Array;
+    /**
+     * Offsets of all objects in ascending order, to find the end of an object.
+     */
+    sortedOffsets: Float64Array;
+    /**
+     * Size of the pack file in bytes.
+     */
+    size: number;
+    file?: FileHandle;
+};
+
+/**
+ * Header of an object in a pack file, with the bytes read from the pack file, which start with the header.
+ */
+type PackEntry = {
+    /**
+     * Size of the inflated data, which is the size of the delta instructions for deltas.
+     */
+    size: number;
+    buffer: Buffer;
+    /**
+     * Position of the compressed data in {@link buffer}.
+     */
+    dataStart: number;
+} & (
+    | { type: GitObjectType; base: undefined }
+    /**
+     * A delta with the offset of its base object in the same pack or the name of its base object.
+     */
+    | { type: undefined; base: number | string }
+);
+
+/**
+ * Reads objects directly from the object store of a local git repository, without a checkout and without running git.
+ * Supports loose objects and pack files with version 2 indexes, including deltas. Packed objects are read
+ * on demand instead of loading whole pack files, and recently read objects are cached as bases for further deltas,
+ * as trees and blobs of consecutive commits are mostly stored as deltas of each other.
+ */
+export class GitObjectStore {
+    readonly gitDirectory: string;
+
+    readonly #objectsDirectory: string;
+    readonly #packs: PackIndex[];
+    readonly #deltaBases = new Map<string, GitObject>();
+    #deltaBasesSize = 0;
+
+    private constructor(gitDirectory: string, packs: PackIndex[]) {
+        this.gitDirectory = gitDirectory;
+        this.#objectsDirectory = path.join(gitDirectory, "objects");
+        this.#packs = packs;
+    }
+
+    /**
+     * Opens the object store of the repository at the specified path.
+     * @param repositoryPath Path of the working tree of the repository, or of a bare repository.
+     * @throws Error If there is no git repository at the path.
+     */
+    static async open(repositoryPath: string): Promise<GitObjectStore> {
+        const gitDirectory = await findGitDirectory(repositoryPath);
+        const packDirectory = path.join(gitDirectory, "objects", "pack");
+        const indexFiles = (await fs.readdir(packDirectory).catch(() => [])).filter((name) =>
+            name.endsWith(".idx"),
+        );
+        const packs = await Promise.all(
+            indexFiles.map(async (name) => readPackIndex(path.join(packDirectory, name))),
+        );
+        return new GitObjectStore(gitDirectory, packs);
+    }
+
+    /**
+     * Resolves a reference like "HEAD", a branch or tag name or a full object name to the name of a commit.
+     * Annotated tags are resolved to the commit they point to.
+     * @throws Error If the reference does not exist.
+     */
+    async resolveCommit(reference: string): Promise<string> {
+        let hash = await this.#resolveReference(reference);
+        let object = await this.readObject(hash);
+        while (object.type === "tag") {
+            hash = /^object ([\da-f]{40})$/m.exec(object.data.toString("utf8"))?.[1] ?? "";
+            object = await this.readObject(hash); // eslint-disable-line no-await-in-loop
+        }
+
+        if (object.type !== "commit") {
+            throw new Error(`"${reference}" does not point to a commit`);
+        }
+
+        return hash;
+    }
+
+    /**
+     * Reads the commit with the specified name.
+     */
+    async readCommit(hash: string): Promise<GitCommit> {
+        const text = (await this.#readObjectOfType(hash, "commit")).toString("utf8");
+        const headerEnd = text.indexOf("\n\n");
+        const headers = headerEnd === -1 ? text : text.slice(0, headerEnd);
+        const message = headerEnd === -1 ? "" : text.slice(headerEnd + 2);
+        return {
+            hash,
+            tree: /^tree ([\da-f]{40})$/m.exec(headers)?.[1] ?? "",
+            parents: [...headers.matchAll(/^parent ([\da-f]{40})$/gm)].map((match) => match[1]),
+            time: Number(/^committer .* (\d+) [+-]\d{4}$/m.exec(headers)?.[1] ?? 0),
+            subject: message.slice(0, Math.max(0, message.indexOf("\n"))) || message,
+        };
+    }
+
+    /**
+     * Reads the entries of the tree with the specified name.
+     */
+    async readTree(hash: string): Promise<GitTreeEntry[]> {
+        const data = await this.#readObjectOfType(hash, "tree");
+        const entries: GitTreeEntry[] = [];
+        let position = 0;
+        while (position < data.length) {
+            const modeEnd = data.indexOf(0x20, position);
+            const nameEnd = data.indexOf(0, modeEnd);
+            entries.push({
+                mode: data.toString("latin1", position, modeEnd),
+                name: data.toString("utf8", modeEnd + 1, nameEnd),
+                hash: data.toString("hex", nameEnd + 1, nameEnd + 1 + hashLength),
+            });
+            position = nameEnd + 1 + hashLength;
+        }
+
+        return entries;
+    }
+
+    /**
+     * Reads the contents of the blob with the specified name.
+     */
+    async readBlob(hash: string): Promise<Buffer> {
+        return this.#readObjectOfType(hash, "blob");
+    }
+
+    /**
+     * Reads the object with the specified name from the loose objects or the pack files.
+     * @throws Error If the object does not exist.
+     */
+    async readObject(hash: string): Promise<GitObject> {
+        const packed = this.#findPackedObject(hash);
+        return packed === undefined
+            ? this.#readLooseObject(hash)
+            : this.#readPackedObject(packed.pack, packed.offset);
+    }
+
+    /**
+     * Reads the size of the object with the specified name in bytes, inflating only the start of it,
+     * so that large objects can be skipped without reading them completely.
+     * @throws Error If the object does not exist.
+     */
+    async readObjectSize(hash: string): Promise<number> {
+        const packed = this.#findPackedObject(hash);
+        return packed === undefined
+            ? this.#readLooseObjectSize(hash)
+            : this.#readPackedObjectSize(packed.pack, packed.offset);
+    }
+
+    /**
+     * Closes the pack files.
+     */
+    async close(): Promise<void> {
+        await Promise.all(
+            this.#packs.map(async (pack) => {
+                const { file } = pack;
+                pack.file = undefined;
+                await file?.close();
+            }),
+        );
+        this.#deltaBases.clear();
+        this.#deltaBasesSize = 0;
+    }
+
+    async #readObjectOfType(hash: string, type: GitObjectType): Promise<Buffer> {
+        const object = await this.readObject(hash);
+        if (object.type !== type) {
+            throw new Error(`Git object ${hash} is a ${object.type}, not a ${type}`);
+        }
+
+        return object.data;
+    }
+
+    async #resolveReference(reference: string): Promise<string> {
+        if (/^[\da-f]{40}$/.test(reference)) {
+            return reference;
+        }
+
+        const candidates =
+            reference === "HEAD"
+                ? ["HEAD"]
+                : [reference, `refs/${reference}`, `refs/tags/${reference}`, `refs/heads/${reference}`];
+        for (const candidate of candidates) {
+            const hash = await this.#readReference(candidate, 0); // eslint-disable-line no-await-in-loop
+            if (hash !== undefined) {
+                return hash;
+            }
+        }
+
+        throw new Error(`Unknown git reference "${reference}"`);
+    }
+
+    /**
+     * Reads a reference from its file or from the packed references, following symbolic references.
+     * @return The object name, or undefined if the reference does not exist.
+     */
+    async #readReference(reference: string, depth: number): Promise<string | undefined> {
+        if (depth > 10) {
+            throw new Error(`Too many levels of symbolic git references at "${reference}"`);
+        }
+
+        const content = await fs
+            .readFile(path.join(this.gitDirectory, reference), { encoding: "utf8" })
+            .catch(() => undefined);
+        const value = content?.trim();
+        if (value?.startsWith("ref: ")) {
+            return this.#readReference(value.slice(5), depth + 1);
+        }
+
+        if (value !== undefined && /^[\da-f]{40}$/.test(value)) {
+            return value;
+        }
+
+        const packedReferences = await fs
+            .readFile(path.join(this.gitDirectory, "packed-refs"), { encoding: "utf8" })
+            .catch(() => "");
+        for (const line of packedReferences.split("\n")) {
+            if (line.endsWith(" " + reference) && /^[\da-f]{40} /.test(line)) {
+                return line.slice(0, 40);
+            }
+        }
+
+        return undefined;
+    }
+
+    /**
+     * Finds the pack file and offset of the object with the specified name.
+     * @return The pack and offset, or undefined if the object is not packed.
+     */
+    #findPackedObject(hash: string): { pack: PackIndex; offset: number } | undefined {
+        if (!/^[\da-f]{40}$/.test(hash)) {
+            throw new Error(`Invalid git object name "${hash}"`);
+        }
+
+        const name = Buffer.from(hash, "hex");
+        for (const pack of this.#packs) {
+            const position = findInPackIndex(pack, name);
+            if (position !== -1) {
+                return { pack, offset: pack.offsets[position] };
+            }
+        }
+
+        return undefined;
+    }
+
+    async #readLooseObject(hash: string): Promise<GitObject> {
+        let compressed: Buffer;
+        try {
+            compressed = await fs.readFile(this.#getLooseObjectPath(hash));
+        } catch {
+            throw new Error(`Git object ${hash} not found in ${this.gitDirectory}`);
+        }
+
+        const content = zlib.inflateSync(compressed);
+        const headerEnd = content.indexOf(0);
+        const [type] = content.toString("latin1", 0, headerEnd).split(" ");
+        if (!isObjectType(type)) {
+            throw new Error(`Git object ${hash} has the unknown type "${type}"`);
+        }
+
+        return { type, data: content.subarray(headerEnd + 1) };
+    }
+
+    async #readLooseObjectSize(hash: string): Promise<number> {
+        let file: FileHandle;
+        try {
+            file = await fs.open(this.#getLooseObjectPath(hash), "r");
+        } catch {
+            throw new Error(`Git object ${hash} not found in ${this.gitDirectory}`);
+        }
+
+        try {
+            const buffer = Buffer.alloc(sizeProbeLength);
+            const { bytesRead } = await file.read(buffer, 0, sizeProbeLength, 0);
+            // The header is the type and the size in decimal, followed by a null byte:
+            const header = inflatePrefix(buffer.subarray(0, bytesRead));
+            return Number(header.toString("latin1", 0, header.indexOf(0)).split(" ")[1]);
+        } finally {
+            await file.close();
+        }
+    }
+
+    #getLooseObjectPath(hash: string): string {
+        return path.join(this.#objectsDirectory, hash.slice(0, 2), hash.slice(2));
+    }
+
+    /**
+     * Reads the object at the specified offset of a pack file, applying deltas to their base objects.
+     */
+    async #readPackedObject(pack: PackIndex, offset: number): Promise<GitObject> {
+        const cacheKey = pack.packPath + ":" + offset.toString();
+        const cached = this.#deltaBases.get(cacheKey);
+        if (cached !== undefined) {
+            // Move it to the end, so that the least recently used objects are evicted first:
+            this.#deltaBases.delete(cacheKey);
+            this.#deltaBases.set(cacheKey, cached);
+            return cached;
+        }
+
+        const entry = await this.#readPackEntry(pack, offset);
+        const compressed = entry.buffer.subarray(entry.dataStart);
+        let object: GitObject;
+        if (entry.base === undefined) {
+            object = { type: entry.type, data: zlib.inflateSync(compressed) };
+        } else {
+            const base =
+                typeof entry.base === "number"
+                    ? await this.#readPackedObject(pack, entry.base)
+                    : await this.readObject(entry.base);
+            object = { type: base.type, data: applyDelta(base.data, zlib.inflateSync(compressed)) };
+        }
+
+        this.#cacheDeltaBase(cacheKey, object);
+        return object;
+    }
+
+    async #readPackedObjectSize(pack: PackIndex, offset: number): Promise<number> {
+        const cached = this.#deltaBases.get(pack.packPath + ":" + offset.toString());
+        if (cached !== undefined) {
+            return cached.data.length;
+        }
+
+        const entry = await this.#readPackEntry(pack, offset, sizeProbeLength);
+        if (entry.base === undefined) {
+            return entry.size;
+        }
+
+        // A delta starts with the sizes of its base and of its result:
+        const delta = inflatePrefix(entry.buffer.subarray(entry.dataStart));
+        const [, resultSizeStart] = readDeltaSize(delta, 0);
+        return readDeltaSize(delta, resultSizeStart)[0];
+    }
+
+    /**
+     * Reads the header and the compressed data of the object at the specified offset of a pack file.
+     * @param maxLength Maximum number of bytes to read, e.g. if only the start of the data is needed.
+     */
+    async #readPackEntry(
+        pack: PackIndex,
+        offset: number,
+        maxLength = Number.POSITIVE_INFINITY,
+    ): Promise<PackEntry> {
+        pack.file ??= await fs.open(pack.packPath, "r");
+        // Each object ends where the next one starts, the last one before the checksum at the end of the pack:
+        const next = upperBound(pack.sortedOffsets, offset);
+        const end =
+            next < pack.sortedOffsets.length ? pack.sortedOffsets[next] : pack.size - hashLength;
+        const buffer = Buffer.alloc(Math.min(end - offset, maxLength));
+        await pack.file.read(buffer, 0, buffer.length, offset);
+
+        // Header: type in bits 4-6 of the first byte, size in bits 0-3 and in variable-length encoding:
+        let position = 0;
+        let byte = buffer[position++];
+        const typeNumber = (byte >> 4) & 7;
+        let size = byte & 0x0f;
+        for (let shift = 4; byte & 0x80; shift += 7) {
+            byte = buffer[position++];
+            size += (byte & 0x7f) * 2 ** shift;
+        }
+
+        if (typeNumber === offsetDeltaType) {
+            byte = buffer[position++];
+            let distance = byte & 0x7f;
+            while (byte & 0x80) {
+                byte = buffer[position++];
+                distance = (distance + 1) * 128 + (byte & 0x7f);
+            }
+
+            return { type: undefined, size, base: offset - distance, buffer, dataStart: position };
+        }
+
+        if (typeNumber === referenceDeltaType) {
+            const base = buffer.toString("hex", position, position + hashLength);
+            return { type: undefined, size, base, buffer, dataStart: position + hashLength };
+        }
+
+        const type = packObjectTypes[typeNumber];
+        if (type === undefined) {
+            throw new Error(
+                `Unknown object type ${typeNumber.toString()} in ${pack.packPath} at offset ${offset.toString()}`,
+            );
+        }
+
+        return { type, size, base: undefined, buffer, dataStart: position };
+    }
+
+    #cacheDeltaBase(cacheKey: string, object: GitObject): void {
+        if (object.data.length > deltaBaseCacheSize / 4) {
+            return;
+        }
+
+        this.#deltaBases.set(cacheKey, object);
+        this.#deltaBasesSize += object.data.length;
+        for (const [key, { data }] of this.#deltaBases) {
+            if (this.#deltaBasesSize <= deltaBaseCacheSize) {
+                break;
+            }
+
+            this.#deltaBases.delete(key);
+            this.#deltaBasesSize -= data.length;
+        }
+    }
+}
+
+/**
+ * Finds the git directory of a repository: the .git folder of a working tree, the folder referenced by a .git file
+ * of a linked working tree or submodule, or the path itself if it is a bare repository.
+ */
+async function findGitDirectory(repositoryPath: string): Promise<string> {
+    const dotGit = path.join(repositoryPath, ".git");
+    const stats = await fs.stat(dotGit).catch(() => undefined);
+    if (stats?.isDirectory()) {
+        return dotGit;
+    }
+
+    if (stats?.isFile()) {
+        const gitDirectory = /^gitdir: (.*)$/m.exec(await fs.readFile(dotGit, "utf8"))?.[1];
+        if (gitDirectory !== undefined) {
+            return path.resolve(repositoryPath, gitDirectory.trim());
+        }
+    }
+
+    const isBare = await fs
+        .stat(path.join(repositoryPath, "objects"))
+        .then((objects) => objects.isDirectory())
+        .catch(() => false);
+    if (isBare && (await fs.stat(path.join(repositoryPath, "HEAD")).catch(() => undefined))) {
+        return repositoryPath;
+    }
+
+    throw new Error(`No git repository found at ${repositoryPath}`);
+}
+
+/**
+ * Reads a pack index file in version 2, which is the only version written by git since 2008.
+ */
+async function readPackIndex(indexPath: string): Promise<PackIndex> {
+    const data = await fs.readFile(indexPath);
+    if (data.readUInt32BE(0) !== 0xff_74_4f_63 || data.readUInt32BE(4) !== 2) {
+        throw new Error(`Unsupported pack index ${indexPath}, only version 2 is supported`);
+    }
+
+    const fanout = new Uint32Array(256);
+    for (let byte = 0; byte < 256; byte++) {
+        fanout[byte] = data.readUInt32BE(8 + byte * 4);
+    }
+
+    const objectCount = fanout[255];
+    const namesStart = 8 + 256 * 4;
+    const names = data.subarray(namesStart, namesStart + objectCount * hashLength);
+    // The names are followed by a CRC32 checksum of each object, then the offsets:
+    const offsetsStart = namesStart + objectCount * (hashLength + 4);
+    const largeOffsetsStart = offsetsStart + objectCount * 4;
+    const offsets = new Float64Array(objectCount);
+    for (let position = 0; position < objectCount; position++) {
+        const offset = data.readUInt32BE(offsetsStart + position * 4);
+        // Offsets of 2 GB and more are stored in a separate table of 64-bit offsets:
+        offsets[position] =
+            offset & 0x80_00_00_00
+                ? Number(data.readBigUInt64BE(largeOffsetsStart + (offset & 0x7f_ff_ff_ff) * 8))
+                : offset;
+    }
+
+    const packPath = indexPath.slice(0, -".idx".length) + ".pack";
+    return {
+        packPath,
+        fanout,
+        names,
+        offsets,
+        sortedOffsets: Float64Array.from(offsets).sort(),
+        size: (await fs.stat(packPath)).size,
+    };
+}
+
+/**
+ * Returns the position of the object with the specified name in the pack index, or -1 if it is not in the pack.
+ */
+function findInPackIndex(pack: PackIndex, name: Buffer): number {
+    let low = name[0] === 0 ? 0 : pack.fanout[name[0] - 1];
+    let high = pack.fanout[name[0]];
+    while (low < high) {
+        const middle = (low + high) >>> 1;
+        const comparison = pack.names.compare(
+            name,
+            0,
+            hashLength,
+            middle * hashLength,
+            (middle + 1) * hashLength,
+        );
+        if (comparison === 0) {
+            return middle;
+        }
+
+        if (comparison < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the position of the first value in the sorted array that is greater than the specified value.
+ */
+function upperBound(sorted: Float64Array, value: number): number {
+    let low = 0;
+    let high = sorted.length;
+    while (low < high) {
+        const middle = (low + high) >>> 1;
+        if (sorted[middle] <= value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Applies a git delta to its base object: the delta starts with the sizes of the base and the result,
+ * followed by instructions to copy a range of the base or to insert the bytes that follow the instruction.
+ */
+export function applyDelta(base: Buffer, delta: Buffer): Buffer {
+    const [baseSize, resultSizeStart] = readDeltaSize(delta, 0);
+    if (baseSize !== base.length) {
+        throw new Error("Git delta does not match the size of its base object");
+    }
+
+    const [resultSize, instructionsStart] = readDeltaSize(delta, resultSizeStart);
+    const result = Buffer.allocUnsafe(resultSize);
+    let position = instructionsStart;
+    let resultPosition = 0;
+    while (position < delta.length) {
+        const instruction = delta[position++];
+        if (instruction & 0x80) {
+            let copyOffset = 0;
+            let copySize = 0;
+            for (let byte = 0; byte < 4; byte++) {
+                if (instruction & (1 << byte)) {
+                    copyOffset += delta[position++] * 2 ** (8 * byte);
+                }
+            }
+
+            for (let byte = 0; byte < 3; byte++) {
+                if (instruction & (1 << (4 + byte))) {
+                    copySize += delta[position++] * 2 ** (8 * byte);
+                }
+            }
+
+            resultPosition += base.copy(
+                result,
+                resultPosition,
+                copyOffset,
+                copyOffset + (copySize || 0x1_00_00),
+            );
+        } else if (instruction > 0) {
+            resultPosition += delta.copy(result, resultPosition, position, position + instruction);
+            position += instruction;
+        } else {
+            throw new Error("Invalid instruction in git delta");
+        }
+    }
+
+    if (resultPosition !== result.length) {
+        throw new Error("Git delta does not match the size of its result");
+    }
+
+    return result;
+}
+
+/**
+ * Reads a size in the variable-length encoding of the header of a delta.
+ * @return The size and the position after it.
+ */
+function readDeltaSize(delta: Buffer, start: number): [size: number, end: number] {
+    let position = start;
+    let size = 0;
+    let shift = 1;
+    let byte: number;
+    do {
+        byte = delta[position++];
+        size += (byte & 0x7f) * shift;
+        shift *= 128;
+    } while (byte & 0x80);
+    return [size, position];
+}
+
+/**
+ * Inflates as much as possible of the start of compressed data, without requiring the rest of it.
+ */
+function inflatePrefix(compressed: Buffer): Buffer {
+    return zlib.inflateSync(compressed, { finishFlush: zlib.constants.Z_SYNC_FLUSH });
+}
+
+function isObjectType(type: string | undefined): type is GitObjectType {
+    return type === "commit" || type === "tree" || type === "blob" || type === "tag";
+}
@@ -0,0 +1,85 @@
+import { Buffer } from "node:buffer";
+import { createHash } from "node:crypto";
+import * as fs from "node:fs";
+import path from "node:path";
+import zlib from "node:zlib";
+
+/**
+ * Creates a git repository with a commit for each of the specified versions of its files, without running git.
+ * All objects are written as loose objects, and the branch main points to the last commit.
+ * @param repositoryPath Path of the working tree of the repository, which must exist.
+ * @param versions Contents of all files of each commit by their path, with "/" as separator.
+ * @return The hashes of the commits, oldest first.
+ */
+export function createGitRepository(
+    repositoryPath: string,
+    versions: Array<Record<string, string>>,
+): string[] {
+    const gitDirectory = path.join(repositoryPath, ".git");
+    const writeObject = (type: string, data: Buffer): string => {
+        const object = Buffer.concat([Buffer.from(`${type} ${data.length.toString()}\0`), data]);
+        const hash = createHash("sha1").update(object).digest("hex");
+        const directory = path.join(gitDirectory, "objects", hash.slice(0, 2));
+        fs.mkdirSync(directory, { recursive: true });
+        fs.writeFileSync(path.join(directory, hash.slice(2)), zlib.deflateSync(object));
+        return hash;
+    };
+
+    const writeTree = (files: Map<string, string>): string => {
+        const entries: Array<{ name: string; mode: string; hash: string }> = [];
+        const folders = new Map<string, Map<string, string>>();
+        for (const [filePath, contents] of files) {
+            const separator = filePath.indexOf("/");
+            if (separator === -1) {
+                entries.push({
+                    name: filePath,
+                    mode: "100644",
+                    hash: writeObject("blob", Buffer.from(contents)),
+                });
+            } else {
+                const folder = filePath.slice(0, separator);
+                const folderFiles = folders.get(folder) ?? new Map<string, string>();
+                folderFiles.set(filePath.slice(separator + 1), contents);
+                folders.set(folder, folderFiles);
+            }
+        }
+
+        for (const [name, folderFiles] of folders) {
+            entries.push({ name, mode: "40000", hash: writeTree(folderFiles) });
+        }
+
+        // Git sorts the entries by name, with a slash appended to the names of folders:
+        const sortKey = ({ name, mode }: { name: string; mode: string }): string =>
+            mode === "40000" ? name + "/" : name;
+        entries.sort((first, second) => (sortKey(first) < sortKey(second) ? -1 : 1));
+        return writeObject(
+            "tree",
+            Buffer.concat(
+                entries.map(({ name, mode, hash }) =>
+                    Buffer.concat([Buffer.from(`${mode} ${name}\0`), Buffer.from(hash, "hex")]),
+                ),
+            ),
+        );
+    };
+
+    const commits: string[] = [];
+    for (const [index, files] of versions.entries()) {
+        const tree = writeTree(new Map(Object.entries(files)));
+        const time = 1_700_000_000 + index * 60;
+        const signature = `Test <test@example.com> ${time.toString()} +0000`;
+        const headers = [
+            `tree ${tree}`,
+            ...commits.slice(-1).map((parent) => `parent ${parent}`),
+            `author ${signature}`,
+            `committer ${signature}`,
+        ];
+        const message = `Version ${(index + 1).toString()}`;
+        const commit = headers.join("\n") + "\n\n" + message + "\n";
+        commits.push(writeObject("commit", Buffer.from(commit)));
+    }
+
+    fs.mkdirSync(path.join(gitDirectory, "refs", "heads"), { recursive: true });
+    fs.writeFileSync(path.join(gitDirectory, "refs", "heads", "main"), commits.at(-1)! + "\n");
+    fs.writeFileSync(path.join(gitDirectory, "HEAD"), "ref: refs/heads/main\n");
+    return commits;
+}
@@ -1,5 +1,5 @@
 import fs from "node:fs/promises";
-import { type Dir, type Dirent, type Stats } from "node:fs";
+import { type Dirent, type Stats } from "node:fs";
 import { beforeEach, describe, expect, it, vi } from "vitest";
 import {
     getTestConfiguration,
@@ -15,9 +15,13 @@ import {
     getNodeTypeNamesByCategories,
     getNodeTypesByCategories,
     getQueryStatementsByCategories,
+    isSearchedFile,
+    limitConcurrency,
     lookupLowerCase,
+    readAhead,
 } from "./helper.js";
 import { NodeTypeCategory, type NodeTypeConfig } from "./model.js";
+import { ExclusionMatcher } from "./exclusion-matcher.js";
 
 describe("Helper.ts", () => {
     describe("lookupLowerCase<V>(...)", () => {
@@ -143,6 +147,51 @@ describe("Helper.ts", () => {
             );
         });
 
+        it("should not include files and folders matching glob patterns or paths", async () => {
+            mockFs([
+                "file.js",
+                "file.min.js",
+                { generated: ["file.java"] },
+                { src: ["file.ts", { generated: ["file.ts"] }, { lib: ["file.cs"] }] },
+            ]);
+            await expectFilesWithConfig(
+                { exclusions: "*.min.js, src/generated, /src/lib/" },
+                "/some/path/file.js",
+                "/some/path/generated/file.java",
+                "/some/path/src/file.ts",
+            );
+        });
+
+        it("should not read excluded folders at all", async () => {
+            mockFs(["file1", { excluded: ["file2"] }]);
+            await expectFilesWithConfig({ exclusions: "excluded" }, "/some/path/file1");
+            expect(fs.readdir).not.toHaveBeenCalledWith("/some/path/excluded", expect.anything());
+        });
+
+        it("should only match plain names of folders, not of files", async () => {
+            mockFs(["build", { build: ["file"] }]);
+            await expectFilesWithConfig({ exclusions: "build" }, "/some/path/build");
+        });
+
+        it("should skip files with unsupported file extensions, if configured", async () => {
+            mockFs(["file.java", "image.png", { subdir: ["README", "file.py"] }]);
+            await expectFilesWithConfig(
+                { skipUnsupportedFiles: true },
+                "/some/path/file.java",
+                "/some/path/subdir/file.py",
+            );
+        });
+
+        it("should yield the files depth-first in the order of the folder entries", async () => {
+            mockFs([{ a: [{ b: ["file1"] }, "file2"] }, "file3", { c: ["file4"] }]);
+            await expectFiles(
+                "/some/path/a/b/file1",
+                "/some/path/a/file2",
+                "/some/path/file3",
+                "/some/path/c/file4",
+            );
+        });
+
         it("should throw an error, if the sourcePath is not a file or directory", () => {
             const error = new Error("ENOENT: no such file or directory, lstat '/invalid/path'");
             vi.spyOn(fs, "lstat").mockRejectedValue(error);
@@ -158,27 +207,39 @@ describe("Helper.ts", () => {
         function mockFs(entries?: Entry[]): void {
             if (entries) {
                 vi.spyOn(fs, "lstat").mockResolvedValue({ isFile: () => false } as Stats);
-                mockOpenDirectory(entries);
+                const directories = new Map<string, Array<Partial<Dirent>>>();
+                addDirectory("/some/path", entries, directories);
+                vi.spyOn(fs, "readdir").mockImplementation((async (directory: string) => {
+                    const directoryEntries = directories.get(directory);
+                    if (directoryEntries === undefined) {
+                        throw new Error("Unexpected read of " + directory);
+                    }
+
+                    return directoryEntries;
+                }) as unknown as typeof fs.readdir);
             } else {
                 vi.spyOn(fs, "lstat").mockResolvedValue({ isFile: () => true } as Stats);
             }
         }
 
-        function mockOpenDirectory(entries: Entry[]): void {
-            vi.spyOn(fs, "opendir").mockResolvedValueOnce(
-                (async function* (): AsyncGenerator<Partial<Dirent>> {
-                    for (const entry of entries) {
-                        if (typeof entry === "string") {
-                            yield { name: entry, isDirectory: (): boolean => false };
-                        } else {
-                            for (const [name, children] of Object.entries(entry)) {
-                                mockOpenDirectory(children);
-                                yield { name, isDirectory: (): boolean => true };
-                            }
-                        }
+        function addDirectory(
+            directory: string,
+            entries: Entry[],
+            directories: Map<string, Array<Partial<Dirent>>>,
+        ): void {
+            const directoryEntries: Array<Partial<Dirent>> = [];
+            for (const entry of entries) {
+                if (typeof entry === "string") {
+                    directoryEntries.push({ name: entry, isDirectory: (): boolean => false });
+                } else {
+                    for (const [name, children] of Object.entries(entry)) {
+                        addDirectory(directory + "/" + name, children, directories);
+                        directoryEntries.push({ name, isDirectory: (): boolean => true });
                     }
-                })() as unknown as Dir,
-            );
+                }
+            }
+
+            directories.set(directory, directoryEntries);
         }
 
         async function expectFiles(...files: string[]): Promise<void> {
@@ -200,6 +261,115 @@ describe("Helper.ts", () => {
         }
     });
 
+    describe("isSearchedFile(...)", () => {
+        function isSearched(
+            filePath: string,
+            configOverrides?: Partial<ConfigurationParameters>,
+        ): boolean {
+            mockPosixPath();
+            const config = getTestConfiguration("/some/path", configOverrides);
+            return isSearchedFile(filePath, config, new ExclusionMatcher(config.exclusions));
+        }
+
+        it("should include files inside the sources path only", () => {
+            expect(isSearched("/some/path/folder/file.java")).toBe(true);
+            expect(isSearched("/some/other/file.java")).toBe(false);
+        });
+
+        it("should exclude files inside of excluded folders", () => {
+            const exclusions = { exclusions: "generated" };
+            expect(isSearched("/some/path/generated/file.java", exclusions)).toBe(false);
+            expect(isSearched("/some/path/a/generated/b/file.java", exclusions)).toBe(false);
+            expect(isSearched("/some/path/folder/file.java", exclusions)).toBe(true);
+        });
+
+        it("should exclude unsupported files only if skipUnsupportedFiles is set", () => {
+            expect(isSearched("/some/path/notes.txt")).toBe(true);
+            expect(isSearched("/some/path/notes.txt", { skipUnsupportedFiles: true })).toBe(false);
+        });
+    });
+
+    describe("limitConcurrency(...)", () => {
+        it("should run at most the specified number of calls at once", async () => {
+            let running = 0;
+            let maxRunning = 0;
+            const run = limitConcurrency(async (value: number) => {
+                running++;
+                maxRunning = Math.max(maxRunning, running);
+                await new Promise((resolve) => {
+                    setTimeout(resolve, 1);
+                });
+                running--;
+                return value * 2;
+            }, 2);
+
+            const results = await Promise.all([1, 2, 3, 4, 5].map(async (value) => run(value)));
+
+            expect(results).toEqual([2, 4, 6, 8, 10]);
+            expect(maxRunning).toBe(2);
+        });
+
+        it("should continue with waiting calls after a call has failed", async () => {
+            const run = limitConcurrency(async (value: number) => {
+                if (value === 1) {
+                    throw new Error("failed");
+                }
+
+                return value;
+            }, 1);
+
+            const results = await Promise.allSettled([run(1), run(2)]);
+
+            expect(results).toEqual([
+                { status: "rejected", reason: new Error("failed") },
+                { status: "fulfilled", value: 2 },
+            ]);
+        });
+    });
+
+    describe("readAhead(...)", () => {
+        it("should yield all values of the source in order", async () => {
+            const result: number[] = [];
+            for await (const value of readAhead(generate(5), 2)) {
+                result.push(value);
+            }
+
+            expect(result).toEqual([0, 1, 2, 3, 4]);
+        });
+
+        it("should fetch at most the specified number of values ahead", async () => {
+            const fetched: number[] = [];
+            const iterator = readAhead(generate(10, fetched), 3);
+
+            await iterator.next();
+            await new Promise((resolve) => {
+                setTimeout(resolve, 1);
+            });
+
+            expect(fetched).toEqual([0, 1, 2]);
+            await iterator.return(undefined);
+        });
+
+        it("should throw the errors of the source once the failed value is reached", async () => {
+            async function* failing(): AsyncGenerator<number> {
+                yield 1;
+                throw new Error("failed");
+            }
+
+            const iterator = readAhead(failing(), 5);
+
+            expect(await iterator.next()).toEqual({ value: 1, done: false });
+            await expect(iterator.next()).rejects.toThrowError("failed");
+        });
+
+        async function* generate(count: number, fetched: number[] = []): AsyncGenerator<number> {
+            for (let index = 0; index < count; index++) {
+                fetched.push(index);
+                yield index;
+            }
+        }
+    });
+
     describe("Helper for node types", () => {
         const exampleNodeTypes: NodeTypeConfig[] = [
             {
@@ -1,8 +1,11 @@
+import { type Dirent } from "node:fs";
 import fs from "node:fs/promises";
 import path from "node:path";
 import { type Configuration } from "../parser/configuration.js";
 import { NodeTypeQueryStatement } from "../parser/queries/query-statements.js";
 import { type NodeTypeCategory, type NodeTypeConfig } from "./model.js";
+import { ExclusionMatcher } from "./exclusion-matcher.js";
+import { assumeLanguageFromFilePath } from "./language.js";
 
 /**
  * Looks up the passed string key converted to lower case in the passed map. Returns the retrieved value (if any).
@@ -36,11 +39,30 @@ export function formatPrintPath(filePath: string, config: Configuration): string
     return result;
 }
 
+/**
+ * Maximum number of folders that are read at the same time while searching for files.
+ */
+const maxConcurrentDirectoryReads = 16;
+
+/**
+ * State shared while searching the folders of the sources path for files.
+ */
+type FileSearch = {
+    sourcesPath: string;
+    exclusions: ExclusionMatcher;
+    skipUnsupportedFiles: boolean;
+    config: Configuration;
+    readDirectory: (directory: string) => Promise<Dirent[]>;
+};
+
 /**
  * Finds files recursively in all subdirectories.
  *
  * This is an asynchronous generator function using asynchronous I/O,
  * which means it yields values when available.
+ * The files are yielded in the order in which they are listed in their folders, depth-first.
+ * Multiple folders are read concurrently ahead of this order, so that the files can be yielded without waiting
+ * for each folder to be read one after another.
  *
  * @param config Configuration of this parser run.
  * @return AsyncGenerator yielding found paths to single files.
@@ -52,33 +74,193 @@ export async function* findFilesAsync(config: Configuration): AsyncGenerator<str
         yield config.sourcesPath;
     } else {
         // SourcePath points to a directory, so use recursive function to find all files.
+        const search: FileSearch = {
+            sourcesPath: config.sourcesPath,
+            exclusions: new ExclusionMatcher(config.exclusions),
+            skipUnsupportedFiles: config.skipUnsupportedFiles,
+            config,
+            readDirectory: limitConcurrency(
+                async (directory: string) => fs.readdir(directory, { withFileTypes: true }),
+                maxConcurrentDirectoryReads,
+            ),
+        };
 
         // The folder at sourcePath itself cannot be excluded, so continue using delegating yield* generator call:
-        yield* findFilesAsyncRecursive(config.sourcesPath, config.exclusions);
+        yield* findFilesAsyncRecursive(
+            config.sourcesPath,
+            search.readDirectory(config.sourcesPath),
+            search,
+        );
     }
 }
 
 async function* findFilesAsyncRecursive(
     directory: string,
-    excludedFolders: Set<string>,
+    directoryEntries: Promise<Dirent[]>,
+    search: FileSearch,
 ): AsyncGenerator<string> {
-    const openedDirectory = await fs.opendir(directory);
+    const entries = await directoryEntries;
 
-    for await (const currentEntry of openedDirectory) {
-        const currentPath = path.join(directory, currentEntry.name);
+    // Start reading all subdirectories right away, so that they are read concurrently
+    // while the files of this directory and the previous subdirectories are yielded.
+    const subdirectoryEntries = new Map<string, Promise<Dirent[]>>();
+    for (const entry of entries) {
+        const currentPath = path.join(directory, entry.name);
+        if (entry.isDirectory() && !isExcluded(currentPath, true, search)) {
+            const entriesPromise = search.readDirectory(currentPath);
+            // Errors are thrown once the subdirectory is reached:
+            entriesPromise.catch(() => undefined);
+            subdirectoryEntries.set(entry.name, entriesPromise);
+        }
+    }
 
-        if (currentEntry.isDirectory()) {
-            const isPathExcluded = excludedFolders.has(currentEntry.name);
-            if (!isPathExcluded) {
+    for (const entry of entries) {
+        const currentPath = path.join(directory, entry.name);
+
+        if (entry.isDirectory()) {
+            const entriesPromise = subdirectoryEntries.get(entry.name);
+            if (entriesPromise !== undefined) {
                 // The current directory is not excluded, so recurse into subdirectory,
                 // using delegating yield* generator call:
-                yield* findFilesAsyncRecursive(currentPath, excludedFolders);
+                yield* findFilesAsyncRecursive(currentPath, entriesPromise, search);
             }
-        } // End of if (isDirectory)
-        else {
+        } else if (
+            !isExcluded(currentPath, false, search) &&
+            (!search.skipUnsupportedFiles ||
+                assumeLanguageFromFilePath(currentPath, search.config) !== undefined)
+        ) {
             yield currentPath;
-        } // End of else (isDirectory)
-    } // End of for await (directory entries)
+        }
+    }
+}
+
+/**
+ * Checks whether the search for files would find the specified file, e.g. when it has been changed or created
+ * after the search: whether it is inside the sources path, neither it nor any of the folders above it is excluded,
+ * and it is not skipped as unsupported file.
+ * @param filePath Path of the file.
+ * @param config Configuration of this parser run.
+ * @param exclusions Matcher for the exclusions of the configuration.
+ */
+export function isSearchedFile(
+    filePath: string,
+    config: Configuration,
+    exclusions: ExclusionMatcher,
+): boolean {
+    if (filePath === config.sourcesPath) {
+        return true;
+    }
+
+    const relativePath = path.relative(config.sourcesPath, filePath).split(path.sep).join("/");
+    if (relativePath.startsWith("../") || path.isAbsolute(relativePath)) {
+        return false;
+    }
+
+    const folders = relativePath.split("/").slice(0, -1);
+    for (let i = 1; i <= folders.length; i++) {
+        if (exclusions.isExcluded(folders.slice(0, i).join("/"), true)) {
+            return false;
+        }
+    }
+
+    return (
+        !exclusions.isExcluded(relativePath, false) &&
+        (!config.skipUnsupportedFiles || assumeLanguageFromFilePath(filePath, config) !== undefined)
+    );
+}
+
+function isExcluded(filePath: string, isDirectory: boolean, search: FileSearch): boolean {
+    const relativePath = path.relative(search.sourcesPath, filePath).split(path.sep).join("/");
+    return search.exclusions.isExcluded(relativePath, isDirectory);
+}
+
+/**
+ * Wraps an asynchronous function, so that it runs at most the specified number of times at once.
+ * Further calls wait until one of the running calls has finished.
+ * @param run The function to wrap.
+ * @param concurrency Maximum number of concurrent calls.
+ */
+export function limitConcurrency<TArgument, TResult>(
+    run: (argument: TArgument) => Promise<TResult>,
+    concurrency: number,
+): (argument: TArgument) => Promise<TResult> {
+    let running = 0;
+    const waiting: Array<() => void> = [];
+
+    return async (argument) => {
+        if (running >= concurrency) {
+            await new Promise<void>((resolve) => {
+                waiting.push(resolve);
+            });
+        }
+
+        running++;
+        try {
+            return await run(argument);
+        } finally {
+            running--;
+            waiting.shift()?.();
+        }
+    };
+}
+
+/**
+ * Iterates over the specified source, while fetching up to the specified number of values ahead.
+ * This way, a slow producer like the search for files keeps running while the values are being processed,
+ * but never runs further ahead than the specified number of values.
+ * @param source The source to iterate over.
+ * @param size Maximum number of values to fetch ahead.
+ */
+export async function* readAhead<T>(source: AsyncIterable<T>, size: number): AsyncGenerator<T> {
+    const iterator = source[Symbol.asyncIterator]();
+    const pending: Array<Promise<IteratorResult<T>>> = [];
+
+    try {
+        for (;;) {
+            // Requests to async generators are queued, so the values are still returned in order:
+            while (pending.length < size) {
+                const next = iterator.next();
+                // Errors are thrown once the value is reached:
+                next.catch(() => undefined);
+                pending.push(next);
+            }
+
+            const result = await pending.shift()!; // eslint-disable-line no-await-in-loop
+            if (result.done) {
+                return;
+            }
+
+            yield result.value;
+        }
+    } finally {
+        await iterator.return?.();
+    }
+}
+
+/**
+ * Positions of the node types of each category in lists of node types, so that looking up the node types
+ * of some categories does not go through all node types of all languages again for every metric.
+ * The lists of node types are not modified after loading them, so the positions stay valid.
+ */
+const categoryIndices = new WeakMap<NodeTypeConfig[], Map<NodeTypeCategory, number[]>>();
+
+function getCategoryIndex(allNodeTypes: NodeTypeConfig[]): Map<NodeTypeCategory, number[]> {
+    let categoryIndex = categoryIndices.get(allNodeTypes);
+    if (categoryIndex === undefined) {
+        categoryIndex = new Map();
+        for (const [position, { category }] of allNodeTypes.entries()) {
+            const positions = categoryIndex.get(category);
+            if (positions === undefined) {
+                categoryIndex.set(category, [position]);
+            } else {
+                positions.push(position);
+            }
+        }
+
+        categoryIndices.set(allNodeTypes, categoryIndex);
+    }
+
+    return categoryIndex;
 }
 
 function findNodeTypesByCategories(
@@ -86,10 +268,19 @@ function findNodeTypesByCategories(
     categories: Set<NodeTypeCategory>,
     callback: (nodeTypeConfig: NodeTypeConfig) => void,
 ): void {
-    for (const nodeTypeConfig of allNodeTypes) {
-        if (categories.has(nodeTypeConfig.category)) {
-            callback(nodeTypeConfig);
-        }
+    const categoryIndex = getCategoryIndex(allNodeTypes);
+    const positions: number[] = [];
+    for (const category of categories) {
+        positions.push(...(categoryIndex.get(category) ?? []));
+    }
+
+    // Keep the order of the node types in the list, regardless of the order of the categories:
+    if (categories.size > 1) {
+        positions.sort((a, b) => a - b);
+    }
+
+    for (const position of positions) {
+        callback(allNodeTypes[position]);
     }
 }
 
@@ -0,0 +1,82 @@
+import { describe, expect, it } from "vitest";
+import { KeywordMatcher, parseKeywordSets } from "./keyword-matcher.js";
+
+describe("KeywordMatcher", () => {
+    const matcher = new KeywordMatcher([
+        ["bug", "wtf", "todo", "hack"],
+        ["fixme", "xxx"],
+        ["JIRA-", "PROJ-"],
+    ]);
+
+    function countIn(text: string, start = 0, end = text.length): number[] {
+        const counts = new Uint32Array(matcher.setCount);
+        matcher.countIn(text, start, end, counts);
+        return [...counts];
+    }
+
+    it("should count the keywords of each set in a single pass, ignoring the case of ASCII letters", () => {
+        expect(countIn("TODO: fix this bug, see JIRA-123 and proj-7. FIXME")).toEqual([2, 1, 2]);
+    });
+
+    it("should only count keywords that are not part of a longer word", () => {
+        expect(countIn("todos debug hack_ wtf2 xxxx fixmeNow")).toEqual([0, 0, 0]);
+        expect(countIn("(todo) bug. hack-job wtf?!")).toEqual([4, 0, 0]);
+    });
+
+    it("should count keywords ending with other characters than word characters when followed by anything", () => {
+        expect(countIn("JIRA-1 JIRA- PROJ-x")).toEqual([0, 0, 3]);
+        expect(countIn("MYJIRA-1")).toEqual([0, 0, 0]);
+    });
+
+    it("should only consider the specified range of the text", () => {
+        const text = "// todo\nint todo = bug; /* hack */";
+
+        expect(countIn(text, 0, 7)).toEqual([1, 0, 0]);
+        expect(countIn(text, 24)).toEqual([1, 0, 0]);
+        // The characters around the range do not prevent matches at its start and end:
+        expect(countIn("xtodox", 1, 5)).toEqual([1, 0, 0]);
+    });
+
+    it("should count the same occurrences as a regular expression with word boundaries", () => {
+        const regex = /\b(bug|wtf|todo|hack)\b/gi;
+        const texts = [
+            "A Bug is a BUG is a bug",
+            "todo_todo todo-todo todo.todo",
+            "wtfwtf wtf wtf",
+            "Hackä ähack hack\nhack",
+            "",
+        ];
+
+        for (const text of texts) {
+            expect(countIn(text)[0]).toBe([...text.matchAll(regex)].length);
+        }
+    });
+
+    it("should not count overlapping occurrences of keywords of the same set", () => {
+        const overlappingMatcher = new KeywordMatcher([["a-", "-b"], ["-b"]]);
+        const counts = new Uint32Array(2);
+
+        overlappingMatcher.countIn("a-b", 0, 3, counts);
+
+        expect([...counts]).toEqual([1, 1]);
+    });
+});
+
+describe("parseKeywordSets(...)", () => {
+    it("should parse the keywords of each set by its name", () => {
+        expect(parseKeywordSets("debt = fixme, xxx;ticket=JIRA-;")).toEqual(
+            new Map([
+                ["debt", ["fixme", "xxx"]],
+                ["ticket", ["JIRA-"]],
+            ]),
+        );
+        expect(parseKeywordSets("")).toEqual(new Map());
+    });
+
+    it.each(["fixme", "=fixme", "my-debt=fixme", "debt=", "debt= , ", "a=x;a=y"])(
+        "should reject the invalid keyword sets %j",
+        (value) => {
+            expect(() => parseKeywordSets(value)).toThrowError(/Invalid keyword set/);
+        },
+    );
+});
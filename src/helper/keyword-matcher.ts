@@ -0,0 +1,293 @@
+/**
+ * Word characters as in regular expressions: ASCII letters, digits and the underscore, by their code unit.
+ */
+const isWordCodeUnit = new Uint8Array(128);
+for (let codeUnit = 0; codeUnit < 128; codeUnit++) {
+    isWordCodeUnit[codeUnit] = /\w/.test(String.fromCodePoint(codeUnit)) ? 1 : 0;
+}
+
+function isWordCharacter(codeUnit: number): boolean {
+    return codeUnit < 128 && isWordCodeUnit[codeUnit] === 1;
+}
+
+/**
+ * Flags of a keyword whose first or last character is a word character,
+ * which must not be preceded or followed by a further word character.
+ */
+const startsWithWordCharacter = 1;
+const endsWithWordCharacter = 2;
+
+/**
+ * Counts the occurrences of multiple sets of keywords in ranges of a text, in a single pass over each range.
+ * The keywords are compiled into an Aho-Corasick automaton over UTF-16 code units, whose transitions are stored
+ * in a single table, so that each code unit of the text costs one table lookup regardless of the number of keywords.
+ *
+ * Keywords are matched as whole words, like in the regular expression /\b(keyword|...)\b/gi:
+ * a keyword that starts or ends with a word character is not counted within a longer word.
+ * ASCII letters are matched case-insensitively. Occurrences of keywords of the same set do not overlap.
+ */
+export class KeywordMatcher {
+    /**
+     * Number of keyword sets, which is the length of the counts passed to {@link countIn}.
+     */
+    readonly setCount: number;
+
+    /**
+     * Column of the transition table for each ASCII code unit. Column 0 is for all code units not in any keyword.
+     */
+    readonly #asciiColumns = new Uint16Array(128);
+    readonly #otherColumns = new Map<number, number>();
+    readonly #columnCount: number;
+    /**
+     * Next state for each state and column, at index state * columnCount + column. State 0 is the initial state.
+     */
+    readonly #transitions: Uint32Array;
+
+    /**
+     * Keywords that end in each state, in compressed sparse row form: the keywords ending in state s are
+     * outputs[outputOffsets[s]] up to outputs[outputOffsets[s + 1] - 1].
+     */
+    readonly #outputOffsets: Uint32Array;
+    readonly #outputs: Uint32Array;
+
+    readonly #keywordLengths: number[] = [];
+    readonly #keywordSets: number[] = [];
+    readonly #keywordFlags: number[] = [];
+
+    /**
+     * End of the last counted occurrence of each set, reused for each range.
+     */
+    readonly #lastMatchEnds: Float64Array;
+
+    /**
+     * Compiles the automaton for the specified keyword sets.
+     * @param keywordSets Keywords of each set. Empty keywords are ignored.
+     */
+    constructor(keywordSets: string[][]) {
+        this.setCount = keywordSets.length;
+        this.#lastMatchEnds = new Float64Array(this.setCount);
+
+        const keywords: string[] = [];
+        for (const [set, keywordsOfSet] of keywordSets.entries()) {
+            for (const keyword of keywordsOfSet) {
+                if (keyword.length > 0) {
+                    keywords.push(foldAsciiCase(keyword));
+                    this.#keywordLengths.push(keyword.length);
+                    this.#keywordSets.push(set);
+                    this.#keywordFlags.push(
+                        (isWordCharacter(keyword.charCodeAt(0)) ? startsWithWordCharacter : 0) |
+                            (isWordCharacter(keyword.charCodeAt(keyword.length - 1))
+                                ? endsWithWordCharacter
+                                : 0),
+                    );
+                }
+            }
+        }
+
+        this.#columnCount = this.#assignColumns(keywords);
+
+        const { trie, stateCount, keywordsEndingIn } = this.#buildTrie(keywords);
+        const outputs = this.#addFailureTransitions(trie, stateCount, keywordsEndingIn);
+        this.#transitions = Uint32Array.from(trie);
+
+        this.#outputOffsets = new Uint32Array(stateCount + 1);
+        for (let state = 0; state < stateCount; state++) {
+            this.#outputOffsets[state + 1] = this.#outputOffsets[state] + outputs[state].length;
+        }
+
+        this.#outputs = Uint32Array.from(outputs.flat());
+    }
+
+    /**
+     * Counts the occurrences of the keywords of each set in the specified range of a text.
+     * The range is treated like a text of its own, so the characters around it do not affect the matches.
+     * @param text The text.
+     * @param start Index of the first code unit of the range.
+     * @param end Index after the last code unit of the range.
+     * @param counts Counts of each set, to which the occurrences are added.
+     */
+    countIn(text: string, start: number, end: number, counts: Uint32Array): void {
+        const lastMatchEnds = this.#lastMatchEnds.fill(start);
+        const transitions = this.#transitions;
+        const outputOffsets = this.#outputOffsets;
+        const outputs = this.#outputs;
+
+        let state = 0;
+        for (let index = start; index < end; index++) {
+            const codeUnit = text.charCodeAt(index);
+            const column =
+                codeUnit < 128
+                    ? this.#asciiColumns[codeUnit]
+                    : (this.#otherColumns.get(codeUnit) ?? 0);
+            state = transitions[state * this.#columnCount + column];
+
+            for (let output = outputOffsets[state]; output < outputOffsets[state + 1]; output++) {
+                const keyword = outputs[output];
+                const matchStart = index + 1 - this.#keywordLengths[keyword];
+                const set = this.#keywordSets[keyword];
+                const flags = this.#keywordFlags[keyword];
+                if (
+                    matchStart < lastMatchEnds[set] ||
+                    ((flags & startsWithWordCharacter) !== 0 &&
+                        matchStart > start &&
+                        isWordCharacter(text.charCodeAt(matchStart - 1))) ||
+                    ((flags & endsWithWordCharacter) !== 0 &&
+                        index + 1 < end &&
+                        isWordCharacter(text.charCodeAt(index + 1)))
+                ) {
+                    continue;
+                }
+
+                counts[set]++;
+                lastMatchEnds[set] = index + 1;
+            }
+        }
+    }
+
+    /**
+     * Assigns a column of the transition table to each distinct code unit of the keywords,
+     * and the same column to the upper and lower case of ASCII letters.
+     * @return The number of columns.
+     */
+    #assignColumns(keywords: string[]): number {
+        let columnCount = 1;
+        for (const keyword of keywords) {
+            for (let index = 0; index < keyword.length; index++) {
+                const codeUnit = keyword.charCodeAt(index);
+                if (codeUnit < 128) {
+                    if (this.#asciiColumns[codeUnit] === 0) {
+                        this.#asciiColumns[codeUnit] = columnCount++;
+                    }
+                } else if (!this.#otherColumns.has(codeUnit)) {
+                    this.#otherColumns.set(codeUnit, columnCount++);
+                }
+            }
+        }
+
+        for (let codeUnit = 65; codeUnit <= 90; codeUnit++) {
+            this.#asciiColumns[codeUnit] = this.#asciiColumns[codeUnit + 32];
+        }
+
+        return columnCount;
+    }
+
+    /**
+     * Builds the trie of the keywords, with -1 for missing transitions.
+     */
+    #buildTrie(keywords: string[]): {
+        trie: number[];
+        stateCount: number;
+        keywordsEndingIn: number[][];
+    } {
+        const trie: number[] = new Array<number>(this.#columnCount).fill(-1);
+        const keywordsEndingIn: number[][] = [[]];
+        let stateCount = 1;
+
+        for (const [keywordIndex, keyword] of keywords.entries()) {
+            let state = 0;
+            for (let index = 0; index < keyword.length; index++) {
+                const transition = state * this.#columnCount + this.#getColumn(keyword, index);
+                if (trie[transition] === -1) {
+                    trie[transition] = stateCount++;
+                    trie.push(...new Array<number>(this.#columnCount).fill(-1));
+                    keywordsEndingIn.push([]);
+                }
+
+                state = trie[transition];
+            }
+
+            keywordsEndingIn[state].push(keywordIndex);
+        }
+
+        return { trie, stateCount, keywordsEndingIn };
+    }
+
+    /**
+     * Replaces the missing transitions of the trie by the transitions of the longest suffix that is in the trie,
+     * visiting the states in breadth-first order, so that the automaton never has to fall back at runtime.
+     * @return The keywords ending in each state, including those ending in its suffixes.
+     */
+    #addFailureTransitions(
+        trie: number[],
+        stateCount: number,
+        keywordsEndingIn: number[][],
+    ): number[][] {
+        const columnCount = this.#columnCount;
+        const failureStates = new Uint32Array(stateCount);
+        const outputs = keywordsEndingIn.map((keywords) => [...keywords]);
+
+        const queue: number[] = [];
+        for (let column = 0; column < columnCount; column++) {
+            if (trie[column] === -1) {
+                trie[column] = 0;
+            } else {
+                queue.push(trie[column]);
+            }
+        }
+
+        for (let position = 0; position < queue.length; position++) {
+            const state = queue[position];
+            const failureState = failureStates[state];
+            outputs[state].push(...outputs[failureState]);
+
+            for (let column = 0; column < columnCount; column++) {
+                const transition = state * columnCount + column;
+                const failureTransition = trie[failureState * columnCount + column];
+                if (trie[transition] === -1) {
+                    trie[transition] = failureTransition;
+                } else {
+                    failureStates[trie[transition]] = failureTransition;
+                    queue.push(trie[transition]);
+                }
+            }
+        }
+
+        return outputs;
+    }
+
+    #getColumn(keyword: string, index: number): number {
+        const codeUnit = keyword.charCodeAt(index);
+        return codeUnit < 128 ? this.#asciiColumns[codeUnit] : this.#otherColumns.get(codeUnit)!;
+    }
+}
+
+/**
+ * Converts the ASCII letters of the specified string to lower case, leaving all other characters unchanged.
+ */
+function foldAsciiCase(value: string): string {
+    return value.replaceAll(/[A-Z]/g, (letter) => letter.toLowerCase());
+}
+
+/**
+ * Parses named keyword sets specified as "name=keyword,keyword;name=keyword", e.g. "debt=fixme,xxx;ticket=JIRA-".
+ * @param value The keyword sets to parse.
+ * @return The keywords of each set by its name, in the specified order.
+ * @throws Error If a set has no name, a name with other characters than letters, digits and underscores,
+ * the same name as another set or no keywords.
+ */
+export function parseKeywordSets(value: string): Map<string, string[]> {
+    const keywordSets = new Map<string, string[]>();
+    for (const keywordSet of value.split(";")) {
+        if (keywordSet.trim().length === 0) {
+            continue;
+        }
+
+        const separatorIndex = keywordSet.indexOf("=");
+        const name = keywordSet.slice(0, Math.max(0, separatorIndex)).trim();
+        const keywords = keywordSet
+            .slice(separatorIndex + 1)
+            .split(",")
+            .map((keyword) => keyword.trim())
+            .filter((keyword) => keyword.length > 0);
+        if (!/^\w+$/.test(name) || keywordSets.has(name) || keywords.length === 0) {
+            throw new Error(
+                `Invalid keyword set "${keywordSet.trim()}", expected name=keyword,keyword with a unique name ` +
+                    "of letters, digits and underscores, e.g. debt=fixme,xxx",
+            );
+        }
+
+        keywordSets.set(name, keywords);
+    }
+
+    return keywordSets;
+}
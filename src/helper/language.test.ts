@@ -1,10 +1,11 @@
+import Parser = require("tree-sitter");
 import { describe, expect, it } from "vitest";
 import {
     getTestConfiguration,
     mockPosixPath,
     mockWin32Path,
 } from "../../test/metric-end-results/test-helper.js";
-import { assumeLanguageFromFilePath, Language } from "./language.js";
+import { assumeLanguageFromFilePath, getGrammar, Language } from "./language.js";
 
 describe("assumeLanguageFromFilePath(...)", () => {
     it("should extract the language from a supported file extension in UNIX-Style paths", () => {
@@ -93,3 +94,28 @@ describe("assumeLanguageFromFilePath(...)", () => {
         expect(assumeLanguageFromFilePath(filePath, config)).toBe(Language.C);
     });
 });
+
+describe("getGrammar(...)", () => {
+    it("should load the grammar of each language once", () => {
+        const grammar = getGrammar(Language.Java);
+
+        expect(grammar).toBeDefined();
+        expect(getGrammar(Language.Java)).toBe(grammar);
+    });
+
+    it("should select the grammar of the language from packages with multiple grammars", () => {
+        const typeScript = getGrammar(Language.TypeScript);
+        const tsx = getGrammar(Language.TSX);
+
+        expect(typeScript).toBeDefined();
+        expect(tsx).toBeDefined();
+        expect(tsx).not.toBe(typeScript);
+    });
+
+    it("should load grammars that can be used for parsing", () => {
+        const parser = new Parser();
+        parser.setLanguage(getGrammar(Language.PHP));
+
+        expect(parser.parse("<?php echo 1;").rootNode.type).toBe("program");
+    });
+});
@@ -1,21 +1,9 @@
+import { createRequire } from "node:module";
 import path from "node:path";
-import CSharp from "tree-sitter-c-sharp";
-import CPlusPlus from "tree-sitter-cpp";
-import GO from "tree-sitter-go";
-import Java from "tree-sitter-java";
-import JavaScript from "tree-sitter-javascript";
-import Kotlin from "tree-sitter-kotlin";
-import phpTreesitterConfig from "tree-sitter-php";
-import Python from "tree-sitter-python";
-import TSTreesitterConfig from "tree-sitter-typescript";
-import Ruby from "tree-sitter-ruby";
-import Rust from "tree-sitter-rust";
-import Bash from "tree-sitter-bash";
-import C from "tree-sitter-c";
-import JSON from "tree-sitter-json";
-import YAML from "tree-sitter-yaml";
+import { type LanguageNode } from "tree-sitter-type";
 import { type Configuration } from "../parser/configuration.js";
 import { lookupLowerCase } from "./helper.js";
+import { profiler } from "./profiler.js";
 
 /**
  * Note that this is not necessarily identical to the file extension of a file of the corresponding language,
@@ -44,26 +32,62 @@ export const Language = {
 export type Language = (typeof Language)[keyof typeof Language];
 
 /**
- * Maps from a language to the corresponding tree-sitter grammar.
+ * Packages of the tree-sitter grammars of the languages,
+ * with the name of the export that contains the grammar if the package contains multiple grammars.
  */
-export const languageToGrammar = new Map([
-    [Language.CSharp, CSharp],
-    [Language.CPlusPlus, CPlusPlus],
-    [Language.Go, GO],
-    [Language.Java, Java],
-    [Language.JavaScript, JavaScript],
-    [Language.Kotlin, Kotlin],
-    [Language.PHP, phpTreesitterConfig.php],
-    [Language.TypeScript, TSTreesitterConfig.typescript],
-    [Language.TSX, TSTreesitterConfig.tsx],
-    [Language.Python, Python],
-    [Language.Ruby, Ruby],
-    [Language.Rust, Rust],
-    [Language.Bash, Bash],
-    [Language.C, C],
-    [Language.JSON, JSON],
-    [Language.YAML, YAML],
-]);
+const grammarModules: Record<Language, { packageName: string; exportName?: string }> = {
+    [Language.CSharp]: { packageName: "tree-sitter-c-sharp" },
+    [Language.CPlusPlus]: { packageName: "tree-sitter-cpp" },
+    [Language.Go]: { packageName: "tree-sitter-go" },
+    [Language.Java]: { packageName: "tree-sitter-java" },
+    [Language.JavaScript]: { packageName: "tree-sitter-javascript" },
+    [Language.Kotlin]: { packageName: "tree-sitter-kotlin" },
+    [Language.PHP]: { packageName: "tree-sitter-php", exportName: "php" },
+    [Language.TypeScript]: { packageName: "tree-sitter-typescript", exportName: "typescript" },
+    [Language.TSX]: { packageName: "tree-sitter-typescript", exportName: "tsx" },
+    [Language.Python]: { packageName: "tree-sitter-python" },
+    [Language.Ruby]: { packageName: "tree-sitter-ruby" },
+    [Language.Rust]: { packageName: "tree-sitter-rust" },
+    [Language.Bash]: { packageName: "tree-sitter-bash" },
+    [Language.C]: { packageName: "tree-sitter-c" },
+    [Language.JSON]: { packageName: "tree-sitter-json" },
+    [Language.YAML]: { packageName: "tree-sitter-yaml" },
+};
+
+/**
+ * The grammars are native modules, which can only be loaded synchronously with require().
+ */
+const requireGrammar = createRequire(import.meta.url);
+
+/**
+ * Grammars of the languages that have been used so far.
+ */
+const loadedGrammars = new Map<Language, LanguageNode>();
+
+/**
+ * Returns the tree-sitter grammar of the specified language, for passing it to the parser or to a query.
+ * Each grammar is loaded on its first use, so that only the grammars of the languages that are actually found
+ * are loaded, instead of loading all native grammar modules at startup.
+ * @param language The language.
+ */
+export function getGrammar(language: Language): LanguageNode {
+    let grammar = loadedGrammars.get(language);
+    if (grammar === undefined) {
+        const { packageName, exportName } = grammarModules[language];
+        grammar = profiler.measure(
+            "grammar load",
+            () => {
+                const grammarModule = requireGrammar(packageName) as LanguageNode &
+                    Record<string, LanguageNode>;
+                return exportName === undefined ? grammarModule : grammarModule[exportName];
+            },
+            { language },
+        );
+        loadedGrammars.set(language, grammar);
+    }
+
+    return grammar;
+}
 
 /**
  * Maps supported file extensions to the corresponding programming languages.
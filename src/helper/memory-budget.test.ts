@@ -0,0 +1,43 @@
+import { describe, expect, it } from "vitest";
+import { MemoryBudget } from "./memory-budget.js";
+
+describe("MemoryBudget", () => {
+    it("should not delay files when there is no limit", async () => {
+        const budget = new MemoryBudget(0, () => 1000);
+
+        await budget.acquire();
+        await budget.acquire();
+
+        expect(budget.peak).toBe(1000);
+    });
+
+    it("should delay files while the memory usage exceeds the limit", async () => {
+        let usage = 200;
+        const budget = new MemoryBudget(100, () => usage);
+        await budget.acquire();
+
+        let acquired = false;
+        const waiting = budget.acquire().then(() => {
+            acquired = true;
+        });
+        await Promise.resolve();
+        expect(acquired).toBe(false);
+
+        usage = 50;
+        budget.release();
+        await waiting;
+
+        expect(acquired).toBe(true);
+        expect(budget.peak).toBe(200);
+    });
+
+    it("should not delay a file when no other file is in progress", async () => {
+        const budget = new MemoryBudget(100, () => 200);
+
+        await budget.acquire();
+        budget.release();
+        await budget.acquire();
+
+        expect(budget.peak).toBe(200);
+    });
+});
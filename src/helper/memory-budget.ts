@@ -0,0 +1,81 @@
+import process from "node:process";
+
+/**
+ * Limits the number of files processed at the same time when the memory usage of the process exceeds a budget.
+ * Files that are being processed hold their syntax trees in memory,
+ * so taking in new files only after others have been completed keeps the memory usage flat.
+ *
+ * Also keeps track of the peak memory usage observed.
+ */
+export class MemoryBudget {
+    readonly #limit: number;
+    readonly #measure: () => number;
+
+    #inProgress = 0;
+    #waiting: Array<() => void> = [];
+    #peak = 0;
+
+    /**
+     * Constructs a new {@link MemoryBudget}.
+     * @param limit Maximum memory usage in bytes before taking in new files is delayed. 0 means no limit.
+     * @param measure Function returning the current memory usage in bytes.
+     * Defaults to the resident set size of the process, which includes the memory of native syntax trees
+     * and of all worker threads.
+     */
+    constructor(limit: number, measure: () => number = process.memoryUsage.rss) {
+        this.#limit = limit;
+        this.#measure = measure;
+    }
+
+    /**
+     * Peak memory usage observed so far, in bytes.
+     */
+    get peak(): number {
+        return this.#peak;
+    }
+
+    /**
+     * Waits until there is enough memory left to process another file.
+     * Never waits if no other file is being processed, so that processing cannot get stuck.
+     * Each call must be followed by a call of {@link release} once the file has been processed.
+     */
+    async acquire(): Promise<void> {
+        while (this.#isExceeded() && this.#inProgress > 0) {
+            // eslint-disable-next-line no-await-in-loop
+            await new Promise<void>((resolve) => {
+                this.#waiting.push(resolve);
+            });
+        }
+
+        this.#inProgress++;
+    }
+
+    /**
+     * Marks a file as processed, so that waiting files can be taken in if there is enough memory left.
+     */
+    release(): void {
+        this.#inProgress--;
+        this.#sample();
+
+        // Let all waiting files check the memory usage again:
+        const waiting = this.#waiting;
+        this.#waiting = [];
+        for (const resolve of waiting) {
+            resolve();
+        }
+    }
+
+    #isExceeded(): boolean {
+        const usage = this.#sample();
+        return this.#limit > 0 && usage > this.#limit;
+    }
+
+    #sample(): number {
+        const usage = this.#measure();
+        if (usage > this.#peak) {
+            this.#peak = usage;
+        }
+
+        return usage;
+    }
+}
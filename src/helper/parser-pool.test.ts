@@ -0,0 +1,38 @@
+import Parser = require("tree-sitter");
+import { describe, expect, it, vi } from "vitest";
+import { Language } from "./language.js";
+import { ParserPool, ParseTimeoutError } from "./parser-pool.js";
+
+describe("ParserPool", () => {
+    it("should reuse the parser of a language for further files", () => {
+        const setLanguage = vi.spyOn(Parser.prototype, "setLanguage");
+        const parserPool = new ParserPool();
+
+        const first = parserPool.parse(Language.Python, "a = 1\n");
+        const second = parserPool.parse(Language.Python, "def f():\n    return 2\n");
+        parserPool.parse(Language.JSON, '{"a": 1}');
+
+        expect(setLanguage).toHaveBeenCalledTimes(2);
+        expect(first.rootNode.text).toBe("a = 1\n");
+        expect(second.rootNode.firstChild?.type).toBe("function_definition");
+    });
+
+    it("should cancel parsing a file that takes longer than the timeout", () => {
+        const parserPool = new ParserPool(1);
+        const sourceCode =
+            "class A {\n" + "    int f() { return 1 + 2 * 3; }\n".repeat(100_000) + "}\n";
+
+        expect(() => parserPool.parse(Language.Java, sourceCode)).toThrowError(ParseTimeoutError);
+    });
+
+    it("should parse further files from scratch after a parse has been cancelled", () => {
+        const parserPool = new ParserPool(1);
+        const sourceCode = "class A {\n" + "    int f() { return 1; }\n".repeat(100_000) + "}\n";
+        expect(() => parserPool.parse(Language.Java, sourceCode)).toThrowError(ParseTimeoutError);
+
+        const tree = parserPool.parse(Language.Java, "class B {}\n");
+
+        expect(tree.rootNode.text).toBe("class B {}\n");
+        expect(tree.rootNode.hasError()).toBe(false);
+    });
+});
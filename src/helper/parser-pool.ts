@@ -0,0 +1,138 @@
+import { performance } from "node:perf_hooks";
+import Parser = require("tree-sitter");
+import { getGrammar, type Language } from "./language.js";
+
+/**
+ * Parser with the optional timeout support of the native binding, which is not part of its type declarations.
+ */
+type TimeoutParser = Parser & {
+    setTimeoutMicros?: (timeout: number) => void;
+    reset?: () => void;
+};
+
+/**
+ * Number of characters passed to tree-sitter at once, if the timeout has to be checked while reading the input.
+ */
+const inputChunkSize = 16 * 1024;
+
+/**
+ * Thrown if parsing a file takes longer than the configured timeout.
+ */
+export class ParseTimeoutError extends Error {
+    constructor(timeout: number) {
+        super("Parsing was cancelled after exceeding the timeout of " + timeout.toString() + " ms");
+        this.name = "ParseTimeoutError";
+    }
+}
+
+/**
+ * Keeps the tree-sitter parsers of each language for reuse,
+ * so that the native parser state is not allocated and the language is not loaded again for every file.
+ *
+ * Parsers are taken from the pool for a single parse and returned afterwards.
+ * A parser whose parse was cancelled is reset before it is returned, so that the next file starts from scratch.
+ * There is one pool per thread, as parsers cannot be shared between threads.
+ */
+export class ParserPool {
+    readonly #idleParsers = new Map<Language, TimeoutParser[]>();
+    readonly #timeout: number;
+
+    /**
+     * Constructs a new {@link ParserPool}.
+     * @param timeout Maximum time in milliseconds to parse a single file, after which parsing is cancelled.
+     * 0 means no timeout.
+     */
+    constructor(timeout = 0) {
+        this.#timeout = timeout;
+    }
+
+    /**
+     * Parses the specified source code with a parser of the specified language.
+     * @param language Language of the source code.
+     * @param sourceCode Source code to parse.
+     * @param oldTree Syntax tree of a previous version of the source code, which has been adjusted
+     * to the changes with {@link Parser.Tree.edit}. Unchanged parts of it are reused, so that only the changed parts
+     * have to be parsed again. Must have been parsed with the same language.
+     * @return The syntax tree.
+     * @throws ParseTimeoutError If parsing takes longer than the timeout.
+     */
+    parse(language: Language, sourceCode: string, oldTree?: Parser.Tree): Parser.Tree {
+        const parser = this.#acquire(language);
+        let completed = false;
+        try {
+            const tree = this.#parseWithTimeout(parser, sourceCode, oldTree);
+            completed = true;
+            return tree;
+        } finally {
+            this.#release(language, parser, completed);
+        }
+    }
+
+    #parseWithTimeout(
+        parser: TimeoutParser,
+        sourceCode: string,
+        oldTree: Parser.Tree | undefined,
+    ): Parser.Tree {
+        if (this.#timeout === 0 || parser.setTimeoutMicros !== undefined) {
+            // The native timeout (if any) has been set when the parser was created:
+            const tree = parser.parse(sourceCode, oldTree) as Parser.Tree | null | undefined;
+            if (tree === undefined || tree === null) {
+                throw new ParseTimeoutError(this.#timeout);
+            }
+
+            return tree;
+        }
+
+        // Older bindings without native timeout: check the time whenever tree-sitter reads further input,
+        // and end the input early once the timeout has been exceeded.
+        const deadline = performance.now() + this.#timeout;
+        let timedOut = false;
+        const tree = parser.parse((index: number) => {
+            if (performance.now() > deadline) {
+                timedOut = true;
+                return null;
+            }
+
+            return sourceCode.slice(index, index + inputChunkSize);
+        }, oldTree);
+        if (timedOut) {
+            throw new ParseTimeoutError(this.#timeout);
+        }
+
+        return tree;
+    }
+
+    #acquire(language: Language): TimeoutParser {
+        const parser = this.#idleParsers.get(language)?.pop();
+        if (parser !== undefined) {
+            return parser;
+        }
+
+        const newParser: TimeoutParser = new Parser();
+        newParser.setLanguage(getGrammar(language));
+        if (this.#timeout > 0) {
+            newParser.setTimeoutMicros?.(this.#timeout * 1000);
+        }
+
+        return newParser;
+    }
+
+    #release(language: Language, parser: TimeoutParser, completed: boolean): void {
+        if (!completed) {
+            // A cancelled parse is resumed by the next call of parse() unless the parser is reset.
+            // Parsers that cannot be reset are dropped instead.
+            if (parser.reset === undefined) {
+                return;
+            }
+
+            parser.reset();
+        }
+
+        const idleParsers = this.#idleParsers.get(language);
+        if (idleParsers === undefined) {
+            this.#idleParsers.set(language, [parser]);
+        } else {
+            idleParsers.push(parser);
+        }
+    }
+}
@@ -0,0 +1,134 @@
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import { performance } from "node:perf_hooks";
+import { afterEach, beforeEach, describe, expect, it } from "vitest";
+import { type ProfileSpan, Profiler } from "./profiler.js";
+
+describe("Profiler", () => {
+    it("should only run the measured functions while disabled", async () => {
+        const profiler = new Profiler();
+
+        expect(profiler.measure("parse", () => 42)).toBe(42);
+        expect(await profiler.measureAsync("read", async () => "content")).toBe("content");
+
+        expect(profiler.takeSpans()).toEqual([]);
+    });
+
+    it("should record a span for each measured function while enabled", async () => {
+        const profiler = new Profiler();
+        profiler.enable();
+
+        profiler.measure(
+            "parse",
+            () => "tree",
+            (result) => ({ filePath: "file.java", language: "java", bytes: result.length }),
+        );
+        await profiler.measureAsync("output", async () => undefined);
+
+        const spans = profiler.takeSpans();
+        expect(spans).toHaveLength(2);
+        expect(spans[0]).toMatchObject({
+            stage: "parse",
+            filePath: "file.java",
+            language: "java",
+            bytes: 4,
+        });
+        expect(spans[0].wallTime).toBeGreaterThanOrEqual(0);
+        expect(spans[1]).toMatchObject({ stage: "output", bytes: 0 });
+        expect(profiler.takeSpans()).toEqual([]);
+    });
+
+    it("should record the time since the start of the thread as startup while enabled", () => {
+        const profiler = new Profiler();
+        profiler.measureStartup();
+        expect(profiler.takeSpans()).toEqual([]);
+
+        profiler.enable();
+        profiler.measureStartup();
+
+        const [span] = profiler.takeSpans();
+        expect(span).toMatchObject({ stage: "startup", start: performance.timeOrigin, bytes: 0 });
+        expect(span.wallTime).toBeGreaterThan(0);
+    });
+
+    describe("report", () => {
+        let temporaryDir: string;
+
+        beforeEach(async () => {
+            temporaryDir = await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-"));
+        });
+
+        afterEach(async () => {
+            await fs.rm(temporaryDir, { recursive: true, force: true });
+        });
+
+        const span = (
+            stage: ProfileSpan["stage"],
+            wallTime: number,
+            filePath?: string,
+            language?: string,
+        ): ProfileSpan => ({
+            stage,
+            filePath,
+            language,
+            start: 1000,
+            wallTime,
+            cpuTime: wallTime,
+            bytes: 10,
+            threadId: 0,
+        });
+
+        it("should summarize the stages and languages and list the slowest files", () => {
+            const profiler = new Profiler();
+            profiler.addSpans([
+                span("parse", 1, "fast.java", "java"),
+                span("parse", 5, "slow.cs", "cs"),
+                span("parse", 2, "medium.java", "java"),
+                span("metric:complexity", 4, "slow.cs", "cs"),
+            ]);
+
+            expect(profiler.getReport()).toEqual({
+                stages: [
+                    { stage: "parse", count: 3, wallTime: 8, cpuTime: 8, bytes: 30 },
+                    { stage: "metric:complexity", count: 1, wallTime: 4, cpuTime: 4, bytes: 10 },
+                ],
+                languages: [
+                    { language: "cs", files: 1, parseTime: 5, bytes: 10 },
+                    { language: "java", files: 2, parseTime: 3, bytes: 20 },
+                ],
+                slowestFiles: [
+                    { filePath: "slow.cs", language: "cs", parseTime: 5, bytes: 10 },
+                    { filePath: "medium.java", language: "java", parseTime: 2, bytes: 10 },
+                    { filePath: "fast.java", language: "java", parseTime: 1, bytes: 10 },
+                ],
+            });
+        });
+
+        it("should write the report and a Chrome trace next to it", async () => {
+            const profiler = new Profiler();
+            profiler.addSpans([span("parse", 2, "file.java", "java")]);
+            const reportPath = path.join(temporaryDir, "profile.json");
+
+            const tracePath = await profiler.write(reportPath);
+
+            expect(tracePath).toBe(path.join(temporaryDir, "profile.trace.json"));
+            expect(JSON.parse(await fs.readFile(reportPath, "utf8"))).toEqual(
+                profiler.getReport(),
+            );
+            const trace = JSON.parse(await fs.readFile(tracePath, "utf8")) as {
+                traceEvents: unknown[];
+            };
+            expect(trace.traceEvents).toEqual([
+                expect.objectContaining({
+                    name: "parse",
+                    ph: "X",
+                    ts: 1_000_000,
+                    dur: 2000,
+                    tid: 0,
+                    args: { filePath: "file.java", language: "java", cpuTime: 2, bytes: 10 },
+                }),
+            ]);
+        });
+    });
+});
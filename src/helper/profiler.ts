@@ -0,0 +1,338 @@
+import fs from "node:fs/promises";
+import path from "node:path";
+import process from "node:process";
+import { performance } from "node:perf_hooks";
+import { threadId } from "node:worker_threads";
+
+/**
+ * Stages of a run that are measured while profiling.
+ * Each metric is measured as a separate stage, named "metric:" followed by the name of the metric.
+ */
+export type ProfileStage =
+    | "startup"
+    | "grammar load"
+    | "metric plan"
+    | "discovery"
+    | "read"
+    | "parse"
+    | "metric query"
+    | `metric:${string}`
+    | "coupling collect"
+    | "coupling resolve"
+    | "output";
+
+/**
+ * A single measurement of a stage, possibly for a single file.
+ */
+export type ProfileSpan = {
+    stage: ProfileStage;
+    /**
+     * Path of the processed file, if the stage was run for a single file.
+     */
+    filePath?: string;
+    /**
+     * Language of the processed file, if known.
+     */
+    language?: string;
+    /**
+     * Start of the stage in milliseconds since the Unix epoch, comparable between threads.
+     */
+    start: number;
+    /**
+     * Wall time in milliseconds.
+     */
+    wallTime: number;
+    /**
+     * CPU time of the process in milliseconds. Includes the CPU time of all threads that run at the same time.
+     */
+    cpuTime: number;
+    /**
+     * Number of bytes processed by the stage, e.g. read from a file or written to the output.
+     */
+    bytes: number;
+    /**
+     * Thread the stage was run on.
+     */
+    threadId: number;
+};
+
+/**
+ * Additional information about a measured stage.
+ */
+export type SpanDetails = {
+    filePath?: string;
+    language?: string;
+    bytes?: number;
+};
+
+type StageSummary = {
+    stage: ProfileStage;
+    count: number;
+    wallTime: number;
+    cpuTime: number;
+    bytes: number;
+};
+
+type LanguageSummary = {
+    language: string;
+    files: number;
+    parseTime: number;
+    bytes: number;
+};
+
+type SlowFile = {
+    filePath: string;
+    language: string | undefined;
+    parseTime: number;
+    bytes: number;
+};
+
+/**
+ * Start of a span, returned by {@link Profiler.begin}.
+ */
+export type SpanStart = {
+    time: number;
+    cpu: NodeJS.CpuUsage;
+};
+
+/**
+ * Number of files listed as the slowest in the profiling report.
+ */
+const slowestFilesCount = 20;
+
+/**
+ * Records the wall and CPU time of the stages of a run, if profiling is enabled.
+ * Otherwise, the measured functions are only run, so that profiling costs nothing when disabled.
+ *
+ * Every thread has its own profiler. The spans recorded on worker threads are passed to the main thread
+ * with the results of the files.
+ */
+export class Profiler {
+    #enabled = false;
+    #spans: ProfileSpan[] = [];
+
+    get enabled(): boolean {
+        return this.#enabled;
+    }
+
+    enable(): void {
+        this.#enabled = true;
+    }
+
+    /**
+     * Runs the specified function and records its duration as a span of the specified stage.
+     * @param stage The stage the function belongs to.
+     * @param run The function to measure.
+     * @param details File and number of bytes processed by the stage, if applicable.
+     * May also be a function, which is called with the result of the measured function.
+     * @return The result of the function.
+     */
+    measure<T>(
+        stage: ProfileStage,
+        run: () => T,
+        details?: SpanDetails | ((result: T) => SpanDetails),
+    ): T {
+        const start = this.begin();
+        if (start === undefined) {
+            return run();
+        }
+
+        const result = run();
+        this.end(stage, start, typeof details === "function" ? details(result) : details);
+        return result;
+    }
+
+    /**
+     * Runs the specified asynchronous function and records its duration as a span of the specified stage.
+     * The span includes the time spent waiting, e.g. for I/O.
+     * @see measure
+     */
+    async measureAsync<T>(
+        stage: ProfileStage,
+        run: () => Promise<T>,
+        details?: SpanDetails | ((result: T) => SpanDetails),
+    ): Promise<T> {
+        const start = this.begin();
+        if (start === undefined) {
+            return run();
+        }
+
+        const result = await run();
+        this.end(stage, start, typeof details === "function" ? details(result) : details);
+        return result;
+    }
+
+    /**
+     * Starts a span that cannot be measured by wrapping a function, e.g. because it spans multiple calls.
+     * @return The start of the span, or undefined if profiling is disabled.
+     */
+    begin(): SpanStart | undefined {
+        if (!this.#enabled) {
+            return undefined;
+        }
+
+        return { time: performance.now(), cpu: process.cpuUsage() };
+    }
+
+    /**
+     * Ends a span started by {@link begin} and records it.
+     * @param stage The stage the span belongs to.
+     * @param start The start of the span. Nothing is recorded if this is undefined.
+     * @param details File and number of bytes processed by the stage, if applicable.
+     */
+    end(stage: ProfileStage, start: SpanStart | undefined, details: SpanDetails = {}): void {
+        if (start === undefined) {
+            return;
+        }
+
+        const cpu = process.cpuUsage(start.cpu);
+        this.#spans.push({
+            stage,
+            filePath: details.filePath,
+            language: details.language,
+            start: performance.timeOrigin + start.time,
+            wallTime: performance.now() - start.time,
+            cpuTime: (cpu.user + cpu.system) / 1000,
+            bytes: details.bytes ?? 0,
+            threadId,
+        });
+    }
+
+    /**
+     * Records the time from the start of the thread until now as "startup" span, if profiling is enabled.
+     * Called once the modules are loaded, this measures how long it takes until the run can begin.
+     */
+    measureStartup(): void {
+        if (!this.#enabled) {
+            return;
+        }
+
+        const cpu = process.cpuUsage();
+        this.#spans.push({
+            stage: "startup",
+            start: performance.timeOrigin,
+            wallTime: performance.now(),
+            // On worker threads, this includes the CPU time of the other threads running in the meantime:
+            cpuTime: (cpu.user + cpu.system) / 1000,
+            bytes: 0,
+            threadId,
+        });
+    }
+
+    /**
+     * Removes and returns all spans recorded so far, e.g. for passing them from a worker thread to the main thread.
+     */
+    takeSpans(): ProfileSpan[] {
+        const spans = this.#spans;
+        this.#spans = [];
+        return spans;
+    }
+
+    /**
+     * Adds spans recorded by another profiler, e.g. on a worker thread.
+     */
+    addSpans(spans: ProfileSpan[]): void {
+        this.#spans.push(...spans);
+    }
+
+    /**
+     * Writes the profiling report as JSON to the specified file and the spans in the Chrome trace event format
+     * (which can be opened e.g. in chrome://tracing or https://ui.perfetto.dev) next to it,
+     * with the file extension replaced by ".trace.json".
+     * @param reportPath Path of the report.
+     * @return The path of the trace file.
+     */
+    async write(reportPath: string): Promise<string> {
+        const parsedPath = path.parse(reportPath);
+        const tracePath = path.join(parsedPath.dir, parsedPath.name + ".trace.json");
+
+        await fs.writeFile(reportPath, JSON.stringify(this.getReport(), null, 4));
+        await fs.writeFile(tracePath, JSON.stringify(this.getTrace()));
+
+        return tracePath;
+    }
+
+    /**
+     * Summarizes the recorded spans by stage and language, and lists the files that took the longest to parse.
+     */
+    getReport(): {
+        stages: StageSummary[];
+        languages: LanguageSummary[];
+        slowestFiles: SlowFile[];
+    } {
+        const stages = new Map<ProfileStage, StageSummary>();
+        const languages = new Map<string, LanguageSummary>();
+        const parsedFiles: SlowFile[] = [];
+
+        for (const span of this.#spans) {
+            let stageSummary = stages.get(span.stage);
+            if (stageSummary === undefined) {
+                stageSummary = { stage: span.stage, count: 0, wallTime: 0, cpuTime: 0, bytes: 0 };
+                stages.set(span.stage, stageSummary);
+            }
+
+            stageSummary.count++;
+            stageSummary.wallTime += span.wallTime;
+            stageSummary.cpuTime += span.cpuTime;
+            stageSummary.bytes += span.bytes;
+
+            if (span.stage !== "parse" || span.filePath === undefined) {
+                continue;
+            }
+
+            parsedFiles.push({
+                filePath: span.filePath,
+                language: span.language,
+                parseTime: span.wallTime,
+                bytes: span.bytes,
+            });
+
+            const language = span.language ?? "unknown";
+            let languageSummary = languages.get(language);
+            if (languageSummary === undefined) {
+                languageSummary = { language, files: 0, parseTime: 0, bytes: 0 };
+                languages.set(language, languageSummary);
+            }
+
+            languageSummary.files++;
+            languageSummary.parseTime += span.wallTime;
+            languageSummary.bytes += span.bytes;
+        }
+
+        return {
+            stages: [...stages.values()].sort((a, b) => b.wallTime - a.wallTime),
+            languages: [...languages.values()].sort((a, b) => b.parseTime - a.parseTime),
+            slowestFiles: parsedFiles
+                .sort((a, b) => b.parseTime - a.parseTime)
+                .slice(0, slowestFilesCount),
+        };
+    }
+
+    /**
+     * Returns the recorded spans as complete events in the Chrome trace event format.
+     */
+    getTrace(): { traceEvents: unknown[] } {
+        return {
+            traceEvents: this.#spans.map((span) => ({
+                name: span.stage,
+                cat: "metric-gardener",
+                ph: "X",
+                ts: Math.round(span.start * 1000),
+                dur: Math.round(span.wallTime * 1000),
+                pid: process.pid,
+                tid: span.threadId,
+                args: {
+                    filePath: span.filePath,
+                    language: span.language,
+                    cpuTime: span.cpuTime,
+                    bytes: span.bytes,
+                },
+            })),
+        };
+    }
+}
+
+/**
+ * Profiler of the current thread.
+ */
+export const profiler = new Profiler();
@@ -0,0 +1,67 @@
+import path from "node:path";
+import { describe, expect, it } from "vitest";
+import { isInShard, parseShard } from "./shard.js";
+
+describe("shard", () => {
+    describe("parseShard(...)", () => {
+        it("should parse the index and count of the shard", () => {
+            expect(parseShard("2/4")).toEqual({ index: 2, count: 4 });
+            expect(parseShard(" 1 / 1 ")).toEqual({ index: 1, count: 1 });
+        });
+
+        it.each(["", "2", "0/4", "5/4", "1/0", "-1/4", "a/b", "1.5/4"])(
+            "should reject the invalid shard %j",
+            (value) => {
+                expect(() => parseShard(value)).toThrowError(/Invalid shard/);
+            },
+        );
+    });
+
+    describe("isInShard(...)", () => {
+        const sourcesPath = path.join("/", "repo");
+        const filePaths = Array.from({ length: 200 }, (_, i) =>
+            path.join(sourcesPath, "src", "module" + (i % 7).toString(), `file${i.toString()}.ts`),
+        );
+
+        it("should assign each file to exactly one shard", () => {
+            for (const filePath of filePaths) {
+                const shards = [1, 2, 3].filter((index) =>
+                    isInShard(filePath, sourcesPath, { index, count: 3 }),
+                );
+                expect(shards).toHaveLength(1);
+            }
+        });
+
+        it("should spread the files over all shards", () => {
+            for (const index of [1, 2, 3, 4]) {
+                const filesInShard = filePaths.filter((filePath) =>
+                    isInShard(filePath, sourcesPath, { index, count: 4 }),
+                );
+                expect(filesInShard.length).toBeGreaterThan(20);
+            }
+        });
+
+        it("should assign files independent of the location of the sources path", () => {
+            const otherSourcesPath = path.join("/", "other", "checkout");
+            for (const filePath of filePaths) {
+                const movedFilePath = path.join(
+                    otherSourcesPath,
+                    path.relative(sourcesPath, filePath),
+                );
+                for (const index of [1, 2, 3]) {
+                    expect(isInShard(movedFilePath, otherSourcesPath, { index, count: 3 })).toBe(
+                        isInShard(filePath, sourcesPath, { index, count: 3 }),
+                    );
+                }
+            }
+        });
+
+        it("should assign all files to a single shard", () => {
+            expect(
+                filePaths.every((filePath) =>
+                    isInShard(filePath, sourcesPath, { index: 1, count: 1 }),
+                ),
+            ).toBe(true);
+        });
+    });
+});
@@ -0,0 +1,63 @@
+import path from "node:path";
+
+/**
+ * Part of the files of a run that is analyzed separately, e.g. on another machine.
+ */
+export type Shard = {
+    /**
+     * Number of the shard, from 1 to count.
+     */
+    index: number;
+    /**
+     * Number of shards the files are split into.
+     */
+    count: number;
+};
+
+/**
+ * Parses a shard specified as "index/count", e.g. "2/4" for the second of four shards.
+ * @param value The shard to parse.
+ * @return The parsed shard.
+ * @throws Error If the value does not specify a valid shard.
+ */
+export function parseShard(value: string): Shard {
+    const match = /^\s*(\d+)\s*\/\s*(\d+)\s*$/.exec(value);
+    const index = Number(match?.[1]);
+    const count = Number(match?.[2]);
+    if (match === null || count < 1 || index < 1 || index > count) {
+        throw new Error(
+            `Invalid shard "${value}", expected index/count with 1 <= index <= count, e.g. 2/4`,
+        );
+    }
+
+    return { index, count };
+}
+
+/**
+ * Checks whether a file belongs to the specified shard.
+ *
+ * Files are assigned to shards by a hash of their path relative to the sources path,
+ * so that every run assigns them in the same way, independent of the machine, the absolute location of the sources
+ * and the order in which the files are found.
+ *
+ * @param filePath Path of the file.
+ * @param sourcesPath The sources path of the run.
+ * @param shard The shard.
+ */
+export function isInShard(filePath: string, sourcesPath: string, shard: Shard): boolean {
+    const relativePath = path.relative(sourcesPath, filePath).split(path.sep).join("/");
+    return hashPath(relativePath) % shard.count === shard.index - 1;
+}
+
+/**
+ * Calculates the 32-bit FNV-1a hash of the UTF-16 code units of the specified path.
+ */
+function hashPath(relativePath: string): number {
+    let hash = 0x81_1c_9d_c5;
+    for (let i = 0; i < relativePath.length; i++) {
+        hash ^= relativePath.charCodeAt(i);
+        hash = Math.imul(hash, 0x01_00_01_93);
+    }
+
+    return hash >>> 0;
+}
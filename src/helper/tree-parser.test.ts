@@ -0,0 +1,45 @@
+import { describe, expect, it } from "vitest";
+import { getTestConfiguration } from "../../test/metric-end-results/test-helper.js";
+import { ErrorFile, ParsedFile, UnsupportedFile } from "../parser/metrics/metric.js";
+import { isFlowAnnotated, parse, parseTree } from "./tree-parser.js";
+import { Language } from "./language.js";
+
+describe("tree-parser", () => {
+    const config = getTestConfiguration("");
+
+    describe("parse(...)", () => {
+        it("should not read files with unsupported languages", async () => {
+            expect(await parse("does/not/exist.unsupported", config)).toEqual(
+                new UnsupportedFile("does/not/exist.unsupported"),
+            );
+        });
+
+        it("should return an error file if a file with a supported language cannot be read", async () => {
+            expect(await parse("does/not/exist.java", config)).toBeInstanceOf(ErrorFile);
+        });
+    });
+
+    describe("isFlowAnnotated(...)", () => {
+        it("should recognize the @flow pragma in the first comment", () => {
+            expect(isFlowAnnotated("/* @flow */\nconst a = 1;")).toBe(true);
+            expect(isFlowAnnotated("/**\n * @flow strict\n */\nconst a = 1;")).toBe(true);
+            expect(isFlowAnnotated("// @flow\nconst a = 1;")).toBe(true);
+            expect(isFlowAnnotated("const a = 1;")).toBe(false);
+        });
+
+        it("should only search the start of the file", () => {
+            const code = "const a = 1;\n".repeat(1000);
+
+            expect(isFlowAnnotated(code + "// @flow\n")).toBe(false);
+        });
+    });
+
+    describe("parseTree(...)", () => {
+        it("should parse flow-annotated JavaScript files with the TSX grammar", () => {
+            const sourceFile = parseTree("// @flow\nconst a: number = 1;\n", "flow.js", config);
+
+            expect(sourceFile).toBeInstanceOf(ParsedFile);
+            expect((sourceFile as ParsedFile).language).toBe(Language.TSX);
+        });
+    });
+});
@@ -1,6 +1,6 @@
+import { type Buffer } from "node:buffer";
 import fs from "node:fs/promises";
 import { readFileSync } from "node:fs";
-import Parser = require("tree-sitter");
 import {
     ErrorFile,
     ParsedFile,
@@ -8,71 +8,127 @@ import {
     UnsupportedFile,
 } from "../parser/metrics/metric.js";
 import { type Configuration } from "../parser/configuration.js";
-import { assumeLanguageFromFilePath, Language, languageToGrammar } from "./language.js";
+import { assumeLanguageFromFilePath, Language } from "./language.js";
+import { profiler } from "./profiler.js";
+import { ParserPool } from "./parser-pool.js";
 
-const cache = new Map<string, SourceFile>();
+/**
+ * Parsers of this thread, by timeout, reused for all files.
+ */
+const parserPools = new Map<number, ParserPool>();
+
+/**
+ * Number of characters at the start of a JavaScript file that are searched for the @flow pragma.
+ * Flow only recognizes the pragma in the comments before the first statement, so there is no need
+ * to search the whole file.
+ */
+const flowPragmaSearchLength = 4096;
+
+const flowPragma = /^(\/\*[\s*]*@flow)|(\/\/\s*@flow)/;
 
 export function parseSync(filePath: string, config: Configuration): ParsedFile | UnsupportedFile {
-    const cachedItem = cache.get(filePath);
-    if (cachedItem !== undefined) {
-        return cachedItem;
+    if (assumeLanguageFromFilePath(filePath, config) === undefined) {
+        return new UnsupportedFile(filePath);
     }
 
-    const sourceCode = readFileSync(filePath, { encoding: "utf8" });
+    const sourceCode = readFileSync(filePath).toString("utf8");
     return parseTree(sourceCode, filePath, config);
 }
 
 /**
  * Parses the specified file if it is written in a supported language.
+ * Files in unsupported languages are not read at all, as their language is determined by their path.
  * @param filePath Path of the file.
  * @param config Configuration to apply.
+ * @param contents The contents of the file, if they have already been read, e.g. for looking it up in the cache.
  * @return A {@link ParsedFile} if the language is supported, an {@link UnsupportedFile} otherwise.
  * If an error occurs while reading the file, an {@link ErrorFile} is returned.
  */
-export async function parse(filePath: string, config: Configuration): Promise<SourceFile> {
-    const cachedItem = cache.get(filePath);
-    if (cachedItem !== undefined) {
-        return cachedItem;
+export async function parse(
+    filePath: string,
+    config: Configuration,
+    contents?: Buffer,
+): Promise<SourceFile> {
+    if (assumeLanguageFromFilePath(filePath, config) === undefined) {
+        return new UnsupportedFile(filePath);
     }
 
     try {
-        const sourceCode = await fs.readFile(filePath, { encoding: "utf8" });
-        return parseTree(sourceCode, filePath, config);
+        // Read the raw bytes and decode them once, so that their number is known without encoding the text again:
+        const bytes =
+            contents ??
+            (await profiler.measureAsync(
+                "read",
+                async () => fs.readFile(filePath),
+                (buffer) => ({ filePath, bytes: buffer.length }),
+            ));
+        const sourceCode = bytes.toString("utf8");
+        return profiler.measure(
+            "parse",
+            () => parseTree(sourceCode, filePath, config),
+            (sourceFile) => ({
+                filePath,
+                language: sourceFile instanceof ParsedFile ? sourceFile.language : undefined,
+                bytes: bytes.length,
+            }),
+        );
     } catch (error) {
         return new ErrorFile(filePath, error instanceof Error ? error : new Error(String(error)));
     }
 }
 
-function parseTree(
+/**
+ * Parses the specified source code if it is written in a supported language.
+ * @param sourceCode Contents of the file.
+ * @param filePath Path of the file, used to determine its language.
+ * @param config Configuration to apply.
+ * @param previous The file parsed from a previous version of the source code, whose syntax tree has been adjusted
+ * to the changes with {@link Tree.edit}. Its syntax tree is reused for parsing incrementally,
+ * unless the language of the file has changed in the meantime.
+ * @return A {@link ParsedFile} if the language is supported, an {@link UnsupportedFile} otherwise.
+ * @throws ParseTimeoutError If parsing takes longer than the configured timeout.
+ */
+export function parseTree(
     sourceCode: string,
     filePath: string,
     config: Configuration,
+    previous?: ParsedFile,
 ): ParsedFile | UnsupportedFile {
     let language = assumeLanguageFromFilePath(filePath, config);
 
     if (language === undefined) {
         // Unsupported file language, return
-        const unsupportedFile = new UnsupportedFile(filePath);
-        cache.set(filePath, unsupportedFile);
-        return unsupportedFile;
+        return new UnsupportedFile(filePath);
     }
 
     // Check if this is actually flow-annotated code instead of plain JavaScript. Use the TSX-grammar then.
     // See https://flow.org/en/docs/usage/#toc-prepare-your-code-for-flow on how to identify them.
     // See https://github.com/tree-sitter/tree-sitter-typescript/tree/v0.20.5 on using the TSX-grammar
     // for flow-annotated files.
-    if (
-        language === Language.JavaScript &&
-        /^(\/\*[\s*]*@flow)|(\/\/\s*@flow)/.exec(sourceCode) !== null
-    ) {
+    if (language === Language.JavaScript && isFlowAnnotated(sourceCode)) {
         language = Language.TSX;
     }
 
-    const parser = new Parser();
-    parser.setLanguage(languageToGrammar.get(language));
-    const tree = parser.parse(sourceCode);
+    const oldTree = previous?.language === language ? previous.tree : undefined;
+    const tree = getParserPool(config.parseTimeout).parse(language, sourceCode, oldTree);
+
+    return new ParsedFile(filePath, language, tree, sourceCode);
+}
+
+/**
+ * Checks whether the specified JavaScript source code is flow-annotated,
+ * only looking at its start instead of searching the whole file.
+ */
+export function isFlowAnnotated(sourceCode: string): boolean {
+    return flowPragma.test(sourceCode.slice(0, flowPragmaSearchLength));
+}
+
+function getParserPool(timeout: number): ParserPool {
+    let parserPool = parserPools.get(timeout);
+    if (parserPool === undefined) {
+        parserPool = new ParserPool(timeout);
+        parserPools.set(timeout, parserPool);
+    }
 
-    const parsedFile = new ParsedFile(filePath, language, tree);
-    cache.set(filePath, parsedFile);
-    return parsedFile;
+    return parserPool;
 }
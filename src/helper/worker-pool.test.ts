@@ -0,0 +1,67 @@
+import { afterEach, describe, expect, it } from "vitest";
+import { WorkerPool } from "./worker-pool.js";
+
+/*
+ * Worker scripts evaluated as CommonJS code, implementing the message protocol used by handleWorkerTasks(...).
+ */
+
+const doublingWorker = `
+const { parentPort } = require("node:worker_threads");
+parentPort.on("message", ({ taskId, task }) => {
+    if (task < 0) {
+        parentPort.postMessage({ taskId, error: new Error("Negative number: " + task) });
+    } else {
+        parentPort.postMessage({ taskId, result: task * 2 });
+    }
+});
+`;
+
+const crashingWorker = `
+const { parentPort } = require("node:worker_threads");
+parentPort.on("message", () => {
+    throw new Error("Crashed!");
+});
+`;
+
+describe("WorkerPool", () => {
+    let pool: WorkerPool<number, number> | undefined;
+
+    afterEach(async () => {
+        await pool?.destroy();
+        pool = undefined;
+    });
+
+    it("should return the results of all tasks", async () => {
+        pool = new WorkerPool<number, number>(doublingWorker, 3, { eval: true });
+
+        const results = await Promise.all([1, 2, 3, 4, 5, 6, 7].map(async (n) => pool!.run(n)));
+
+        expect(results).toEqual([2, 4, 6, 8, 10, 12, 14]);
+    });
+
+    it("should reject a task for which the worker returns an error", async () => {
+        pool = new WorkerPool<number, number>(doublingWorker, 1, { eval: true });
+
+        await expect(pool.run(-1)).rejects.toThrowError("Negative number: -1");
+        expect(await pool.run(21)).toBe(42);
+    });
+
+    it("should reject the task and replace the worker thread when the worker thread crashes", async () => {
+        pool = new WorkerPool<number, number>(crashingWorker, 1, { eval: true });
+
+        await expect(pool.run(1)).rejects.toThrowError("Crashed!");
+        await expect(pool.run(2)).rejects.toThrowError("Crashed!");
+    });
+
+    it("should reject all tasks that have not been completed when it is destroyed", async () => {
+        pool = new WorkerPool<number, number>(doublingWorker, 1, { eval: true });
+        const result = pool.run(1);
+
+        await pool.destroy();
+
+        await expect(result).rejects.toThrowError("The worker pool has been destroyed.");
+        await expect(pool.run(2)).rejects.toThrowError(
+            "There is no worker thread left to run the task on.",
+        );
+    });
+});
@@ -0,0 +1,201 @@
+import { parentPort, Worker, type WorkerOptions } from "node:worker_threads";
+
+/**
+ * Message sent from the pool to a worker thread to start a task.
+ */
+type TaskMessage<TTask> = {
+    taskId: number;
+    task: TTask;
+};
+
+/**
+ * Message sent from a worker thread back to the pool when a task is completed.
+ * Contains either the result of the task or the error that occurred while processing it.
+ */
+type ResultMessage<TResult> =
+    | {
+          taskId: number;
+          result: TResult;
+      }
+    | {
+          taskId: number;
+          error: unknown;
+      };
+
+type PendingTask<TTask, TResult> = {
+    taskId: number;
+    task: TTask;
+    resolve: (result: TResult) => void;
+    reject: (error: unknown) => void;
+};
+
+/**
+ * Fixed-size pool of worker threads that process tasks in parallel.
+ * Tasks and results are passed between the threads using the structured clone algorithm,
+ * so they must not contain functions, class instances with behavior or native objects.
+ *
+ * Worker scripts should use {@link handleWorkerTasks} to receive tasks and return their results.
+ */
+export class WorkerPool<TTask, TResult> {
+    readonly #workerFile: URL | string;
+    readonly #workerOptions: WorkerOptions;
+
+    readonly #idleWorkers: Worker[] = [];
+    readonly #busyWorkers = new Map<Worker, PendingTask<TTask, TResult>>();
+    readonly #queue: Array<PendingTask<TTask, TResult>> = [];
+
+    #workerCount = 0;
+    #nextTaskId = 0;
+    #destroyed = false;
+
+    /**
+     * Starts a new pool of worker threads.
+     * @param workerFile Path or URL of the script to run on the worker threads.
+     * @param size Number of worker threads to start.
+     * @param workerOptions Options passed to each worker thread, e.g. the workerData.
+     */
+    constructor(workerFile: URL | string, size: number, workerOptions: WorkerOptions = {}) {
+        this.#workerFile = workerFile;
+        this.#workerOptions = workerOptions;
+
+        for (let i = 0; i < size; i++) {
+            this.#idleWorkers.push(this.#startWorker());
+        }
+    }
+
+    /**
+     * Runs the specified task on the next available worker thread.
+     * @param task The task to run.
+     * @return Promise resolving to the result of the task,
+     * or rejecting with the error that occurred while processing the task.
+     */
+    async run(task: TTask): Promise<TResult> {
+        if (this.#destroyed || this.#workerCount === 0) {
+            throw new Error("There is no worker thread left to run the task on.");
+        }
+
+        return new Promise((resolve, reject) => {
+            this.#queue.push({ taskId: this.#nextTaskId++, task, resolve, reject });
+            this.#dispatch();
+        });
+    }
+
+    /**
+     * Terminates all worker threads. Tasks that have not been completed yet are rejected.
+     */
+    async destroy(): Promise<void> {
+        this.#destroyed = true;
+
+        const error = new Error("The worker pool has been destroyed.");
+        for (const pendingTask of this.#queue) {
+            pendingTask.reject(error);
+        }
+
+        this.#queue.length = 0;
+
+        for (const pendingTask of this.#busyWorkers.values()) {
+            pendingTask.reject(error);
+        }
+
+        const workers = [...this.#idleWorkers, ...this.#busyWorkers.keys()];
+        this.#idleWorkers.length = 0;
+        this.#busyWorkers.clear();
+
+        await Promise.all(workers.map(async (worker) => worker.terminate()));
+    }
+
+    #dispatch(): void {
+        while (this.#queue.length > 0 && this.#idleWorkers.length > 0) {
+            const worker = this.#idleWorkers.pop()!;
+            const pendingTask = this.#queue.shift()!;
+
+            this.#busyWorkers.set(worker, pendingTask);
+            const message: TaskMessage<TTask> = {
+                taskId: pendingTask.taskId,
+                task: pendingTask.task,
+            };
+            worker.postMessage(message);
+        }
+    }
+
+    #startWorker(): Worker {
+        const worker = new Worker(this.#workerFile, this.#workerOptions);
+        this.#workerCount++;
+
+        worker.on("message", (message: ResultMessage<TResult>) => {
+            const pendingTask = this.#busyWorkers.get(worker);
+            this.#busyWorkers.delete(worker);
+            this.#idleWorkers.push(worker);
+
+            if (pendingTask !== undefined && pendingTask.taskId === message.taskId) {
+                if ("error" in message) {
+                    pendingTask.reject(message.error);
+                } else {
+                    pendingTask.resolve(message.result);
+                }
+            }
+
+            this.#dispatch();
+        });
+
+        worker.on("error", (error) => {
+            const pendingTask = this.#busyWorkers.get(worker);
+            this.#busyWorkers.delete(worker);
+            this.#workerCount--;
+
+            if (pendingTask === undefined) {
+                // The worker thread failed without working on a task, e.g. because its script could not be loaded.
+                // Do not replace it, but fail all waiting tasks if there is no worker thread left.
+                const index = this.#idleWorkers.indexOf(worker);
+                if (index >= 0) {
+                    this.#idleWorkers.splice(index, 1);
+                }
+
+                if (this.#workerCount === 0) {
+                    for (const queuedTask of this.#queue) {
+                        queuedTask.reject(error);
+                    }
+
+                    this.#queue.length = 0;
+                }
+
+                return;
+            }
+
+            // The worker thread crashed while working on a task:
+            // fail the task and replace the worker thread by a new one.
+            pendingTask.reject(error);
+            if (!this.#destroyed) {
+                this.#idleWorkers.push(this.#startWorker());
+                this.#dispatch();
+            }
+        });
+
+        return worker;
+    }
+}
+
+/**
+ * Registers the handler for the tasks that are sent to the current worker thread by a {@link WorkerPool}.
+ * Must be called from the script run by the worker threads.
+ * @param handler Function that processes a single task and returns its result.
+ */
+export function handleWorkerTasks<TTask, TResult>(
+    handler: (task: TTask) => Promise<TResult>,
+): void {
+    if (parentPort === null) {
+        throw new Error("handleWorkerTasks(...) must be called from a worker thread.");
+    }
+
+    const port = parentPort;
+    port.on("message", async ({ taskId, task }: TaskMessage<TTask>) => {
+        let message: ResultMessage<TResult>;
+        try {
+            message = { taskId, result: await handler(task) };
+        } catch (error) {
+            message = { taskId, error };
+        }
+
+        port.postMessage(message);
+    });
+}
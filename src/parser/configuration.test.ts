@@ -1,3 +1,4 @@
+import os from "node:os";
 import { describe, expect, it } from "vitest";
 import { getTestConfiguration } from "../../test/metric-end-results/test-helper.js";
 
@@ -85,5 +86,24 @@ describe("Configuration", () => {
             expect(config.parseSomeHAsC.has("folder3")).toBe(true);
             expect(config.parseSomeHAsC.has("folder4")).toBe(true);
         });
+
+        it("should use one thread per available CPU core when 0 threads are given", () => {
+            const config = getTestConfiguration("sourcesPath", { threads: 0 });
+
+            expect(config.threads).toBe(os.availableParallelism());
+        });
+
+        it("should use at least one thread", () => {
+            expect(getTestConfiguration("sourcesPath", { threads: -3 }).threads).toBe(1);
+            expect(getTestConfiguration("sourcesPath", { threads: Number.NaN }).threads).toBe(1);
+            expect(getTestConfiguration("sourcesPath", { threads: 2.5 }).threads).toBe(2);
+        });
+
+        it("should not limit the memory when no valid memory budget is given", () => {
+            expect(getTestConfiguration("sourcesPath").maxMemory).toBe(0);
+            expect(getTestConfiguration("sourcesPath", { maxMemory: -1 }).maxMemory).toBe(0);
+            expect(getTestConfiguration("sourcesPath", { maxMemory: Number.NaN }).maxMemory).toBe(0);
+            expect(getTestConfiguration("sourcesPath", { maxMemory: 512 }).maxMemory).toBe(512);
+        });
     });
 });
@@ -1,3 +1,16 @@
+import os from "node:os";
+import path from "node:path";
+import { parseKeywordSets } from "../helper/keyword-matcher.js";
+import { parseShard, type Shard } from "../helper/shard.js";
+
+/**
+ * Format of the output file:
+ * "json" writes a single object with the arrays nodes, info and relationships.
+ * "ndjson" writes one object per line, with the single property node, info or relationship.
+ * "columnar" writes a binary file with a column of values per metric, described in columnar-output.ts.
+ */
+export type OutputFormat = "json" | "ndjson" | "columnar";
+
 /**
  * Parameters of the constructor of {@link Configuration}.
  * Represents configuration options that can be provided by the user via command line arguments.
@@ -16,7 +29,12 @@ export type ConfigurationParameters = {
      */
     parseDependencies: boolean;
     /**
-     * Folders to exclude from being searched for files to be parsed.
+     * Whether coupling metrics aggregated per directory should be added to the output, if dependencies are analyzed.
+     */
+    directoryCoupling: boolean;
+    /**
+     * Folders and files to exclude from being searched for files to be parsed,
+     * as comma-separated list of names or .gitignore-style patterns.
      */
     exclusions: string;
     /**
@@ -35,6 +53,49 @@ export type ConfigurationParameters = {
      * Whether to include the relative file paths or absolute paths of the analyzed files in the output.
      */
     relativePaths: boolean;
+    /**
+     * Number of worker threads to parse files and calculate metrics on. 0 means one thread per available CPU core.
+     */
+    threads: number;
+    /**
+     * Memory budget in megabytes. Taking in new files is delayed while the process uses more memory.
+     * 0 means no limit.
+     */
+    maxMemory: number;
+    /**
+     * Directory for caching the results of files between runs. No cache is used if this is empty.
+     */
+    cacheDir: string;
+    /**
+     * Format of the output file.
+     */
+    outputFormat: OutputFormat;
+    /**
+     * Path where a profiling report should be stored. No profiling is done if this is empty.
+     */
+    profile: string;
+    /**
+     * Whether files with unsupported file extensions should be skipped while searching for files.
+     */
+    skipUnsupportedFiles: boolean;
+    /**
+     * Maximum time in milliseconds to parse a single file. 0 means no timeout.
+     */
+    parseTimeout: number;
+    /**
+     * Maximum size in megabytes of files with unsupported languages whose lines are counted. 0 means no limit.
+     */
+    maxUnsupportedFileSize: number;
+    /**
+     * Additional sets of keywords to count in comments as "name=keyword,keyword;name=keyword".
+     * No additional sets are counted if this is empty.
+     */
+    commentKeywords: string;
+    /**
+     * Shard of the files to analyze as "index/count", e.g. "2/4" for the second of four shards.
+     * All files are analyzed if this is empty.
+     */
+    shard: string;
 };
 
 /**
@@ -57,7 +118,14 @@ export class Configuration {
     readonly parseDependencies: boolean;
 
     /**
-     * Folders to exclude from being searched for files to be parsed.
+     * Whether coupling metrics aggregated per directory should be added to the output as directory nodes.
+     * Only has an effect if dependencies are analyzed.
+     */
+    readonly directoryCoupling: boolean;
+
+    /**
+     * Names of folders and .gitignore-style patterns of folders and files
+     * to exclude from being searched for files to be parsed.
      */
     readonly exclusions: Set<string>;
 
@@ -81,6 +149,64 @@ export class Configuration {
      */
     readonly relativePaths: boolean;
 
+    /**
+     * Number of worker threads to parse files and calculate metrics on.
+     * If this is 1, all files are processed on the main thread.
+     */
+    readonly threads: number;
+
+    /**
+     * Memory budget in megabytes. Taking in new files is delayed while the process uses more memory.
+     * 0 means no limit.
+     */
+    readonly maxMemory: number;
+
+    /**
+     * Resolved, absolute path of the directory for caching the results of files between runs,
+     * or undefined if no cache should be used.
+     */
+    readonly cacheDir: string | undefined;
+
+    /**
+     * Format of the output file.
+     */
+    readonly outputFormat: OutputFormat;
+
+    /**
+     * Path where a profiling report should be stored, or undefined if the run should not be profiled.
+     */
+    readonly profilePath: string | undefined;
+
+    /**
+     * Whether files with unsupported file extensions should be skipped while searching for files,
+     * instead of being reported as unsupported files.
+     */
+    readonly skipUnsupportedFiles: boolean;
+
+    /**
+     * Maximum time in milliseconds to parse a single file, after which parsing is cancelled
+     * and the file is reported as error file. 0 means no timeout.
+     */
+    readonly parseTimeout: number;
+
+    /**
+     * Maximum size in megabytes of files with unsupported languages whose lines are counted.
+     * No metrics are calculated for larger files. 0 means no limit.
+     */
+    readonly maxUnsupportedFileSize: number;
+
+    /**
+     * Additional sets of keywords to count in comments, by the name of the set.
+     * The occurrences of each set are reported as metric keywords_in_comments_<name>.
+     */
+    readonly commentKeywords: Map<string, string[]>;
+
+    /**
+     * Shard of the files to analyze, or undefined if all files should be analyzed.
+     * The results of a shard are written as partial results, which are merged with those of the other shards later.
+     */
+    readonly shard: Shard | undefined;
+
     /**
      * Constructs a new {@link Configuration} object by specifying the configuration options passed by the user
      * as command line arguments.
@@ -90,6 +216,7 @@ export class Configuration {
         this.sourcesPath = parameters.sourcesPath;
         this.outputPath = parameters.outputPath;
         this.parseDependencies = parameters.parseDependencies;
+        this.directoryCoupling = parameters.directoryCoupling;
 
         this.exclusions = new Set(
             parameters.exclusions.length > 0
@@ -109,5 +236,29 @@ export class Configuration {
 
         this.compress = parameters.compress;
         this.relativePaths = parameters.relativePaths;
+
+        this.threads =
+            parameters.threads === 0
+                ? os.availableParallelism()
+                : Math.max(1, Math.floor(parameters.threads) || 1);
+
+        this.maxMemory = Math.max(0, parameters.maxMemory || 0);
+
+        this.cacheDir =
+            parameters.cacheDir.length > 0 ? path.resolve(parameters.cacheDir) : undefined;
+
+        this.outputFormat = parameters.outputFormat;
+
+        this.profilePath = parameters.profile.length > 0 ? parameters.profile : undefined;
+
+        this.skipUnsupportedFiles = parameters.skipUnsupportedFiles;
+
+        this.parseTimeout = Math.max(0, parameters.parseTimeout || 0);
+
+        this.maxUnsupportedFileSize = Math.max(0, parameters.maxUnsupportedFileSize || 0);
+
+        this.commentKeywords = parseKeywordSets(parameters.commentKeywords);
+
+        this.shard = parameters.shard.length > 0 ? parseShard(parameters.shard) : undefined;
     }
 }
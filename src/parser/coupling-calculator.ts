@@ -1,5 +1,5 @@
 import { type Configuration } from "./configuration.js";
-import { Coupling } from "./metrics/coupling/coupling.js";
+import { Coupling, type FileCouplingData } from "./metrics/coupling/coupling.js";
 import { TypeCollector } from "./resolver/type-collector.js";
 import { UsagesCollector } from "./resolver/usages-collector.js";
 import {
@@ -33,9 +33,28 @@ export class CouplingCalculator {
         ];
     }
 
-    processFile(sourceFile: SourceFile): void {
+    /**
+     * Extracts the data needed for calculating the coupling metrics from the specified file.
+     * The data is only considered once it is passed to {@link addFile},
+     * so that the results do not depend on the order in which files are processed.
+     * @param sourceFile The file to process.
+     * @return The extracted data, or undefined if dependencies are not analyzed or the file could not be parsed.
+     */
+    processFile(sourceFile: SourceFile): FileCouplingData | undefined {
         if (this.config.parseDependencies && sourceFile instanceof ParsedFile) {
-            this.comprisingMetrics[0].processFile(sourceFile);
+            return this.comprisingMetrics[0].extract(sourceFile);
+        }
+
+        return undefined;
+    }
+
+    /**
+     * Adds the data extracted from a file to the data the coupling metrics are calculated on.
+     * @param fileData Data returned by {@link processFile}.
+     */
+    addFile(fileData: FileCouplingData): void {
+        if (this.config.parseDependencies) {
+            this.comprisingMetrics[0].add(fileData);
         }
     }
 
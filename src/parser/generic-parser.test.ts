@@ -8,8 +8,8 @@ import * as TreeParser from "../helper/tree-parser.js";
 import {
     assumeLanguageFromFilePath,
     FileType,
+    getGrammar,
     Language,
-    languageToGrammar,
 } from "../helper/language.js";
 import { GenericParser } from "./generic-parser.js";
 import {
@@ -21,10 +21,20 @@ import {
     type MetricError,
     type MetricResult,
 } from "./metrics/metric.js";
+import { type WorkerResult } from "./metric-worker.js";
 import * as MetricCalculator from "./metric-calculator.js";
 import { CouplingCalculator } from "./coupling-calculator.js";
+import { type FileCouplingData } from "./metrics/coupling/coupling.js";
 import { type Configuration } from "./configuration.js";
 
+const workerPoolRun = vi.hoisted(() => vi.fn<[string], Promise<WorkerResult>>());
+vi.mock("../helper/worker-pool.js", () => ({
+    WorkerPool: class WorkerPool {
+        run = workerPoolRun;
+        destroy = vi.fn();
+    },
+}));
+
 /*
  * Implementation of function mocks:
  */
@@ -52,7 +62,7 @@ async function mockedTreeParserParse(filePath: string, config: Configuration): P
     const language = assumeLanguageFromFilePath(filePath, config);
     return language === undefined
         ? new UnsupportedFile(filePath)
-        : new ParsedFile(filePath, language, tree);
+        : new ParsedFile(filePath, language, tree, sourceCode);
 }
 
 async function mockedMetricsCalculator(file: SourceFile): Promise<[SourceFile, FileMetricResults]> {
@@ -108,11 +118,12 @@ const expectedFileMetricsResults: FileMetricResults = {
     metricErrors: [],
 };
 
+const sourceCode = "int main() { return 0; }";
 let tree: Tree;
 beforeAll(() => {
     const parser = new Parser();
-    parser.setLanguage(languageToGrammar.get(Language.CPlusPlus));
-    tree = parser.parse("int main() { return 0; }");
+    parser.setLanguage(getGrammar(Language.CPlusPlus));
+    tree = parser.parse(sourceCode);
 });
 
 describe("GenericParser.calculateMetrics()", () => {
@@ -179,6 +190,46 @@ describe("GenericParser.calculateMetrics()", () => {
         expect(treeParserSpied).toHaveBeenCalledTimes(2);
     });
 
+    it("should pass the metrics on to the consumer in the order of the files, even if a later file is finished first", async () => {
+        /*
+         * Given:
+         */
+        mockFindFilesAsync(mockedFindTwoFilesAsync);
+        mockTreeParserParse(async (filePath, config) => {
+            if (filePath.endsWith("path1.cc")) {
+                await new Promise((resolve) => {
+                    setTimeout(resolve, 10);
+                });
+            }
+
+            return mockedTreeParserParse(filePath, config);
+        });
+        spyOnMetricCalculator().mockImplementation(mockedMetricsCalculator);
+        spyOnCouplingCalculatorNoOp();
+
+        const consumedFiles: string[] = [];
+        const consumer = vi.fn(async (filePath: string) => {
+            consumedFiles.push(filePath);
+        });
+
+        const parser = new GenericParser(getTestConfiguration("clearly/invalid"));
+
+        /*
+         * When:
+         */
+        const actualResult = await parser.calculateMetrics(consumer);
+
+        /*
+         * Then:
+         */
+        expect(consumedFiles).toEqual(["clearly/invalid/path1.cc", "clearly/invalid/path2.cpp"]);
+        expect(consumer).toHaveBeenCalledWith(
+            "clearly/invalid/path2.cpp",
+            expectedFileMetricsResults,
+        );
+        expect(actualResult.fileMetrics).toEqual(new Map());
+    });
+
     it("should call MetricCalculator.calculateMetrics() and also return an entry in unknownFiles when unsupported files are found", async () => {
         /*
          * Given:
@@ -367,6 +418,94 @@ describe("GenericParser.calculateMetrics()", () => {
         expect(console.error).toHaveBeenCalled();
     });
 
+    it("should calculate the metrics on worker threads and return the results in the order of the files when multiple threads are configured", async () => {
+        /*
+         * Given:
+         */
+        mockFindFilesAsync(mockedFindTwoFilesAsync);
+        const treeParserSpied = mockTreeParserParse();
+        workerPoolRun.mockImplementation(async (filePath) => {
+            // Let the first file take longer than the second one:
+            await new Promise((resolve) => {
+                setTimeout(resolve, filePath.endsWith(".cc") ? 20 : 0);
+            });
+            return {
+                fileResult: {
+                    filePath,
+                    fileType: FileType.SourceCode,
+                    fileMetricResults: expectedFileMetricsResults,
+                },
+                profileSpans: [],
+            };
+        });
+        const { couplingProcessFileSpied, couplingCalculateSpied } = spyOnCouplingCalculatorNoOp();
+
+        const parser = new GenericParser(getTestConfiguration("clearly/invalid", { threads: 4 }));
+
+        /*
+         * When:
+         */
+        const actualResult = await parser.calculateMetrics();
+        /*
+         * Then:
+         */
+        expect([...actualResult.fileMetrics.entries()]).toEqual([
+            ["clearly/invalid/path1.cc", expectedFileMetricsResults],
+            ["clearly/invalid/path2.cpp", expectedFileMetricsResults],
+        ]);
+        expect(workerPoolRun).toHaveBeenCalledTimes(2);
+        expect(treeParserSpied).not.toHaveBeenCalled();
+        expect(couplingProcessFileSpied).not.toHaveBeenCalled();
+        expect(couplingCalculateSpied).toHaveBeenCalledTimes(1);
+    });
+
+    it("should use the coupling data extracted on the worker threads without parsing the files again", async () => {
+        /*
+         * Given:
+         */
+        mockFindFilesAsync(mockedFindTwoFilesAsync);
+        const treeParserSpied = mockTreeParserParse();
+        const couplingData = (filePath: string): FileCouplingData => ({
+            filePath,
+            types: new Map(),
+            accessors: new Map(),
+            usageCandidates: [],
+            callExpressions: [],
+        });
+        workerPoolRun.mockImplementation(async (filePath) => ({
+            fileResult: {
+                filePath,
+                fileType: FileType.SourceCode,
+                fileMetricResults: expectedFileMetricsResults,
+            },
+            couplingData: couplingData(filePath),
+            profileSpans: [],
+        }));
+        const { couplingProcessFileSpied } = spyOnCouplingCalculatorNoOp();
+        const couplingAddFileSpied = vi
+            .spyOn(CouplingCalculator.prototype, "addFile")
+            .mockReturnValue();
+
+        const parser = new GenericParser(
+            getTestConfiguration("clearly/invalid", { threads: 4, parseDependencies: true }),
+        );
+
+        /*
+         * When:
+         */
+        await parser.calculateMetrics();
+
+        /*
+         * Then:
+         */
+        expect(treeParserSpied).not.toHaveBeenCalled();
+        expect(couplingProcessFileSpied).not.toHaveBeenCalled();
+        expect(couplingAddFileSpied.mock.calls).toEqual([
+            [couplingData("clearly/invalid/path1.cc")],
+            [couplingData("clearly/invalid/path2.cpp")],
+        ]);
+    });
+
     it("should fail if findFilesAsync throws an error", () => {
         mockFindFilesAsync(mockedFindFilesAsyncError);
         mockTreeParserParse();
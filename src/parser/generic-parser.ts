@@ -1,17 +1,111 @@
+import { type Buffer } from "node:buffer";
 import process from "node:process";
 import pMap from "p-map";
-import { findFilesAsync, formatPrintPath } from "../helper/helper.js";
+import { findFilesAsync, readAhead } from "../helper/helper.js";
 import { parse } from "../helper/tree-parser.js";
+import { WorkerPool } from "../helper/worker-pool.js";
+import { MemoryBudget } from "../helper/memory-budget.js";
+import { profiler } from "../helper/profiler.js";
+import { isInShard } from "../helper/shard.js";
 import { type Configuration } from "./configuration.js";
 import { calculateMetrics } from "./metric-calculator.js";
 import { CouplingCalculator } from "./coupling-calculator.js";
+import { type ProcessedFile, ResultCache } from "./result-cache.js";
+import {
+    type FileMetricsConsumer,
+    OrderedResultHandler,
+    ResultAggregator,
+    type ResultHandler,
+} from "./result-aggregator.js";
+import { type WorkerResult, type WorkerTask } from "./metric-worker.js";
 import {
-    type SourceFile,
     type FileMetricResults,
-    ErrorFile,
-    UnsupportedFile,
     type CouplingResult,
+    type SourceFile,
+    toFileResult,
 } from "./metrics/metric.js";
+import { type FileCouplingData } from "./metrics/coupling/coupling.js";
+
+/**
+ * Maximum number of found files that wait to be processed, while the search for further files continues.
+ */
+const discoveryReadAhead = 10_000;
+
+/**
+ * Search for files, which runs while the files found so far are processed.
+ * Continues concurrently up to a limited number of files ahead of the processing.
+ *
+ * If the run is sharded, all files are still searched for, so that the index of each file among all files is known,
+ * but only the files of the shard are passed on for processing.
+ */
+class FileDiscovery {
+    /**
+     * The found files to process, in the order in which they were found.
+     */
+    readonly filePaths: AsyncIterable<string>;
+
+    /**
+     * Index of each file to process among the files found in all shards, in the order of {@link filePaths}.
+     * Only filled if the run is sharded.
+     */
+    readonly indicesInAllShards: number[] = [];
+
+    /**
+     * Number of files to process found so far.
+     */
+    found = 0;
+
+    /**
+     * Number of files found so far in all shards. The same as {@link found} if the run is not sharded.
+     */
+    foundInAllShards = 0;
+
+    /**
+     * Whether all files have been found.
+     */
+    finished = false;
+
+    constructor(config: Configuration) {
+        this.filePaths = readAhead(this.#findFiles(config), discoveryReadAhead);
+    }
+
+    async *#findFiles(config: Configuration): AsyncGenerator<string> {
+        const { shard, sourcesPath } = config;
+        const start = profiler.begin();
+        for await (const filePath of findFilesAsync(config)) {
+            const index = this.foundInAllShards++;
+            if (shard !== undefined) {
+                if (!isInShard(filePath, sourcesPath, shard)) {
+                    continue;
+                }
+
+                this.indicesInAllShards.push(index);
+            }
+
+            this.found++;
+            yield filePath;
+        }
+
+        this.finished = true;
+        profiler.end("discovery", start);
+    }
+}
+
+/**
+ * Receives the results of each file of a shard in the order in which the files were found.
+ * Processing further files waits for the returned promise, so that the consumer can apply backpressure.
+ * @param index Index of the file among the files found in all shards.
+ * @param processedFile The results of the file, including the data extracted for the coupling metrics.
+ */
+export type PartialResultConsumer = (index: number, processedFile: ProcessedFile) => Promise<void>;
+
+/**
+ * State shared by the processing of all files in a run.
+ */
+type ProcessingContext = {
+    memoryBudget: MemoryBudget;
+    resultCache: ResultCache | undefined;
+};
 
 /**
  * Arranges the parsing of files and calculation of metrics as specified by the stored configuration.
@@ -34,93 +128,234 @@ export class GenericParser {
 
     /**
      * Parses files and calculates metrics as specified by the configuration of this {@link GenericParser} object.
+     * @param consumer Optional function to which the metrics of each file are passed as soon as they are available,
+     * in the order in which the files were found. If specified, the returned map of file metrics is empty,
+     * so that the metrics of all files do not have to be kept in memory.
      */
-    async calculateMetrics(): Promise<{
+    async calculateMetrics(consumer?: FileMetricsConsumer): Promise<{
         couplingMetrics: CouplingResult;
         fileMetrics: Map<string, FileMetricResults>;
         unsupportedFiles: string[];
         errorFiles: string[];
     }> {
-        const filePaths = await this.loadFilePaths();
+        const discovery = new FileDiscovery(this.config);
+        const couplingParser = new CouplingCalculator(this.config);
+
+        // Handle the results in the order of the files, so that the output does not depend on the processing order:
+        const aggregator = new ResultAggregator(this.config, couplingParser, consumer);
+        await this.processFiles(discovery, couplingParser, aggregator);
+
+        const { fileMetrics, unsupportedFiles, errorFiles } = aggregator;
+        return {
+            fileMetrics,
+            unsupportedFiles,
+            errorFiles,
+            couplingMetrics: profiler.measure("coupling resolve", () =>
+                couplingParser.calculateMetrics(),
+            ),
+        };
+    }
 
+    /**
+     * Parses the files of the shard specified by the configuration and calculates their metrics,
+     * but passes the results of each file on to the consumer instead of calculating the coupling metrics,
+     * so that they can be merged with the results of the other shards later.
+     * @param consumer Function to which the results of each file are passed as soon as they are available,
+     * in the order in which the files were found.
+     * @return The number of files found in all shards.
+     */
+    async calculatePartialResults(consumer: PartialResultConsumer): Promise<number> {
+        const discovery = new FileDiscovery(this.config);
         const couplingParser = new CouplingCalculator(this.config);
 
+        const results = new OrderedResultHandler(async (processedFile, index) =>
+            consumer(discovery.indicesInAllShards[index] ?? index, processedFile),
+        );
+        await this.processFiles(discovery, couplingParser, results);
+
+        return discovery.foundInAllShards;
+    }
+
+    /**
+     * Processes all found files on the main thread or on worker threads, as configured.
+     * @param discovery The search for files.
+     * @param couplingParser Extracts the data for the coupling metrics from the files.
+     * @param results Receives the results of the files.
+     */
+    private async processFiles(
+        discovery: FileDiscovery,
+        couplingParser: CouplingCalculator,
+        results: ResultHandler,
+    ): Promise<void> {
+        const context: ProcessingContext = {
+            memoryBudget: new MemoryBudget(this.config.maxMemory * 1024 * 1024),
+            resultCache:
+                this.config.cacheDir === undefined
+                    ? undefined
+                    : new ResultCache(this.config.cacheDir, this.config),
+        };
+
+        await (this.config.threads > 1
+            ? this.processFilesOnWorkerThreads(discovery, context, results)
+            : this.processFilesOnMainThread(discovery, couplingParser, context, results));
+        clearProgressBar();
+
+        this.printStatistics(context);
+    }
+
+    /**
+     * Parses the files and calculates their metrics on the main thread.
+     * Only plain results are kept, so the syntax tree of a file can be released as soon as it has been processed.
+     */
+    private async processFilesOnMainThread(
+        discovery: FileDiscovery,
+        couplingParser: CouplingCalculator,
+        context: ProcessingContext,
+        results: ResultHandler,
+    ): Promise<void> {
         let parsed = 0;
-        const results = await pMap(
-            filePaths,
-            async (filePath) => {
-                const sourceFile = await parse(filePath, this.config);
-                couplingParser.processFile(sourceFile);
+        await pMap(
+            discovery.filePaths,
+            async (filePath, index) => {
+                const processedFile = await this.processFile(
+                    filePath,
+                    async (contents) => {
+                        const sourceFile = await parse(filePath, this.config, contents);
+                        const couplingData = this.collectCouplingData(couplingParser, sourceFile);
+
+                        const [calculatedFile, fileMetricResults] =
+                            await calculateMetrics(sourceFile, this.config);
+                        return {
+                            fileResult: toFileResult(calculatedFile, fileMetricResults),
+                            couplingData,
+                        };
+                    },
+                    context,
+                );
 
-                const progress = Math.floor((parsed++ / filePaths.length) * 100);
-                showProgressBar(progress);
+                showProgress(parsed++, discovery);
 
-                return calculateMetrics(sourceFile);
+                await results.add(index, processedFile);
             },
             { concurrency: 10 },
         );
-        clearProgressBar();
+    }
+
+    /**
+     * Parses the files and calculates their metrics on a pool of worker threads, so that multiple CPU cores are used.
+     * The results are handled in the same order as on the main thread, so the output is identical.
+     */
+    private async processFilesOnWorkerThreads(
+        discovery: FileDiscovery,
+        context: ProcessingContext,
+        results: ResultHandler,
+    ): Promise<void> {
+        const pool = new WorkerPool<WorkerTask, WorkerResult>(
+            new URL("metric-worker.js", import.meta.url),
+            this.config.threads,
+            { workerData: this.config },
+        );
+
+        let parsed = 0;
+        try {
+            await pMap(
+                discovery.filePaths,
+                async (filePath, index) => {
+                    const processedFile = await this.processFile(
+                        filePath,
+                        async (contents) => {
+                            // The coupling data is extracted on the worker thread while the syntax tree is alive,
+                            // so the file does not need to be parsed again on the main thread:
+                            const { fileResult, couplingData, profileSpans } =
+                                await pool.run({ filePath, contents });
+                            profiler.addSpans(profileSpans);
+
+                            return { fileResult, couplingData };
+                        },
+                        context,
+                    );
+
+                    showProgress(parsed++, discovery);
 
-        const couplingMetrics = couplingParser.calculateMetrics();
-        return { ...this.processResults(results), couplingMetrics };
+                    await results.add(index, processedFile);
+                },
+                // Keep some tasks queued, so that the worker threads do not have to wait for the main thread:
+                { concurrency: this.config.threads * 2 },
+            );
+        } finally {
+            await pool.destroy();
+        }
     }
 
-    private async loadFilePaths(): Promise<string[]> {
-        const filePaths: string[] = [];
+    /**
+     * Processes a single file as soon as the memory budget allows for it.
+     * Reuses the results from the cache if the file has not changed since they were stored.
+     * @param filePath Path of the file.
+     * @param processUncached Function that processes the file if there are no cached results for it.
+     * It receives the contents of the file if they have already been read for looking it up in the cache.
+     * @param context The memory budget and result cache of this run.
+     */
+    private async processFile(
+        filePath: string,
+        processUncached: (contents: Buffer | undefined) => Promise<ProcessedFile>,
+        { memoryBudget, resultCache }: ProcessingContext,
+    ): Promise<ProcessedFile> {
+        await memoryBudget.acquire();
+        try {
+            if (resultCache === undefined) {
+                return await processUncached(undefined);
+            }
 
-        for await (const filePath of findFilesAsync(this.config)) {
-            filePaths.push(filePath);
-            if (filePaths.length % 1000 === 0) {
-                process.stdout.write(`\rfiles: ${filePaths.length.toString()}`);
+            const { key, processedFile: cachedFile, contents } = await resultCache.lookup(filePath);
+            if (cachedFile !== undefined) {
+                return cachedFile;
             }
-        }
 
-        console.log(`\rfiles: ${filePaths.length.toString()}`);
+            const processedFile = await processUncached(contents);
+            await resultCache.store(key, processedFile);
+            return processedFile;
+        } finally {
+            memoryBudget.release();
+        }
+    }
 
-        return filePaths;
+    private collectCouplingData(
+        couplingParser: CouplingCalculator,
+        sourceFile: SourceFile,
+    ): FileCouplingData | undefined {
+        return profiler.measure("coupling collect", () => couplingParser.processFile(sourceFile), {
+            filePath: sourceFile.filePath,
+        });
     }
 
-    private processResults(results: Array<[SourceFile, FileMetricResults]>): {
-        fileMetrics: Map<string, FileMetricResults>;
-        unsupportedFiles: string[];
-        errorFiles: string[];
-    } {
-        const fileMetrics = new Map<string, FileMetricResults>();
-        const unsupportedFiles: string[] = [];
-        const errorFiles: string[] = [];
-
-        for (const [sourceFile, fileMetricResults] of results) {
-            const printPath = formatPrintPath(sourceFile.filePath, this.config);
-
-            if (sourceFile instanceof ErrorFile) {
-                errorFiles.push(printPath);
-                console.error("Error while parsing the syntax tree for the file " + printPath);
-                console.error(sourceFile.error);
-            } else {
-                fileMetrics.set(printPath, fileMetricResults);
-
-                // Inform about errors that occurred while calculating (some) metrics on the syntax tree
-                for (const metricError of fileMetricResults.metricErrors) {
-                    console.error(
-                        "Error while calculating the metric " +
-                            metricError.metricName +
-                            " on the file " +
-                            sourceFile.filePath,
-                    );
-                    console.error(metricError.error);
-                }
+    private printStatistics({ memoryBudget, resultCache }: ProcessingContext): void {
+        console.log(
+            "Peak memory usage: " + Math.ceil(memoryBudget.peak / 1024 / 1024).toString() + " MB",
+        );
 
-                if (sourceFile instanceof UnsupportedFile) {
-                    unsupportedFiles.push(printPath);
-                }
-            }
+        if (resultCache !== undefined) {
+            console.log(
+                "Result cache: " +
+                    resultCache.hits.toString() +
+                    " hits, " +
+                    resultCache.misses.toString() +
+                    " misses",
+            );
         }
+    }
+}
 
-        return {
-            fileMetrics,
-            unsupportedFiles,
-            errorFiles,
-        };
+/**
+ * Shows the number of found and processed files while the search for files is still running,
+ * and the percentage of processed files once all files have been found.
+ */
+function showProgress(processed: number, discovery: FileDiscovery): void {
+    if (discovery.finished) {
+        showProgressBar(Math.floor((processed / discovery.found) * 100));
+    } else if (processed % 100 === 0) {
+        process.stdout.write(
+            `\rfiles: ${discovery.found.toString()} found, ${processed.toString()} processed`,
+        );
     }
 }
 
@@ -0,0 +1,191 @@
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, beforeEach, describe, expect, it, vi } from "vitest";
+import { getTestConfiguration, mockConsole } from "../../test/metric-end-results/test-helper.js";
+import * as TreeParser from "../helper/tree-parser.js";
+import { FileType } from "../helper/language.js";
+import { getEdit, IncrementalAnalysis } from "./incremental-analysis.js";
+import { type FileMetricResults, ParsedFile } from "./metrics/metric.js";
+
+describe("IncrementalAnalysis", () => {
+    let temporaryDir: string;
+
+    beforeEach(async () => {
+        temporaryDir = await fs.realpath(
+            await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-")),
+        );
+    });
+
+    afterEach(async () => {
+        await fs.rm(temporaryDir, { recursive: true, force: true });
+    });
+
+    function getMetric(
+        fileMetricResults: FileMetricResults | undefined,
+        metricName: string,
+    ): number | undefined {
+        return fileMetricResults?.metricResults.find((result) => result.metricName === metricName)
+            ?.metricValue;
+    }
+
+    async function getAllMetrics(
+        analysis: IncrementalAnalysis,
+    ): Promise<Map<string, FileMetricResults>> {
+        const fileMetrics = new Map<string, FileMetricResults>();
+        await analysis.getResults(async (filePath, fileMetricResults) => {
+            fileMetrics.set(filePath, fileMetricResults);
+        });
+        return fileMetrics;
+    }
+
+    it("should analyze all files and keep the results up to date when files change", async () => {
+        const filePath = path.join(temporaryDir, "A.java");
+        await fs.writeFile(filePath, "class A {\n}\n");
+        const analysis = new IncrementalAnalysis(getTestConfiguration(temporaryDir));
+
+        await analysis.analyzeAll();
+        expect(getMetric(await analysis.getFileMetrics(filePath), "classes")).toBe(1);
+
+        await fs.writeFile(filePath, "class A {\n}\nclass B {\n}\n");
+        await analysis.update([filePath]);
+        expect(getMetric(await analysis.getFileMetrics(filePath), "classes")).toBe(2);
+        expect(getMetric(await analysis.getFileMetrics(filePath), "lines_of_code")).toBe(5);
+    });
+
+    it("should parse changed files incrementally, reusing the syntax tree of the previous version", async () => {
+        const filePath = path.join(temporaryDir, "A.java");
+        await fs.writeFile(filePath, "class A {\n    void a() {}\n}\n");
+        const analysis = new IncrementalAnalysis(getTestConfiguration(temporaryDir));
+        await analysis.analyzeAll();
+        const parseTree = vi.spyOn(TreeParser, "parseTree");
+
+        await fs.writeFile(filePath, "class A {\n    void a() {}\n    void b() {}\n}\n");
+        await analysis.update([filePath]);
+
+        expect(parseTree).toHaveBeenCalledTimes(1);
+        expect(parseTree.mock.calls[0][3]).toBeInstanceOf(ParsedFile);
+        expect(getMetric(await analysis.getFileMetrics(filePath), "functions")).toBe(2);
+    });
+
+    it("should not analyze files again whose contents have not changed", async () => {
+        const filePath = path.join(temporaryDir, "A.java");
+        await fs.writeFile(filePath, "class A {}");
+        const analysis = new IncrementalAnalysis(getTestConfiguration(temporaryDir));
+        await analysis.analyzeAll();
+        const parseTree = vi.spyOn(TreeParser, "parseTree");
+
+        await analysis.update([filePath]);
+
+        expect(parseTree).not.toHaveBeenCalled();
+    });
+
+    it("should add new files and remove deleted files and folders", async () => {
+        const folder = path.join(temporaryDir, "folder");
+        await fs.mkdir(folder);
+        const filePath = path.join(temporaryDir, "A.java");
+        const nestedFilePath = path.join(folder, "B.java");
+        await fs.writeFile(filePath, "class A {}");
+        await fs.writeFile(nestedFilePath, "class B {}");
+        const analysis = new IncrementalAnalysis(getTestConfiguration(temporaryDir));
+        await analysis.analyzeAll();
+        expect(analysis.fileCount).toBe(2);
+
+        const newFilePath = path.join(temporaryDir, "C.java");
+        await fs.writeFile(newFilePath, "class C {}");
+        await analysis.update([newFilePath]);
+        expect([...(await getAllMetrics(analysis)).keys()]).toEqual([
+            filePath,
+            newFilePath,
+            nestedFilePath,
+        ]);
+
+        await fs.rm(folder, { recursive: true });
+        await fs.rm(filePath);
+        await analysis.update([folder, filePath]);
+        expect([...(await getAllMetrics(analysis)).keys()]).toEqual([newFilePath]);
+    });
+
+    it("should ignore changes to excluded files", async () => {
+        const excludedFolder = path.join(temporaryDir, "generated");
+        await fs.mkdir(excludedFolder);
+        const excludedFilePath = path.join(excludedFolder, "A.java");
+        await fs.writeFile(excludedFilePath, "class A {}");
+        const analysis = new IncrementalAnalysis(
+            getTestConfiguration(temporaryDir, { exclusions: "generated" }),
+        );
+        await analysis.analyzeAll();
+
+        await analysis.update([excludedFilePath]);
+
+        expect(analysis.fileCount).toBe(0);
+        expect(await analysis.getFileMetrics(excludedFilePath)).toBeUndefined();
+    });
+
+    it("should report files that cannot be parsed as error files and recover once they can be parsed", async () => {
+        mockConsole();
+        const filePath = path.join(temporaryDir, "A.java");
+        await fs.writeFile(filePath, "class A {}");
+        const analysis = new IncrementalAnalysis(getTestConfiguration(temporaryDir));
+        await analysis.analyzeAll();
+        vi.spyOn(TreeParser, "parseTree").mockImplementationOnce(() => {
+            throw new Error("Unable to parse");
+        });
+
+        await fs.writeFile(filePath, "class B {}");
+        await analysis.update([filePath]);
+        expect((await analysis.getResults(async () => undefined)).errorFiles).toEqual([filePath]);
+
+        await fs.writeFile(filePath, "class C {}");
+        const fileMetricResults = await analysis.getFileMetrics(filePath);
+        expect(fileMetricResults?.fileType).toBe(FileType.SourceCode);
+        expect(getMetric(fileMetricResults, "classes")).toBe(1);
+    });
+});
+
+describe("getEdit(...)", () => {
+    it("should return the range between the common beginning and end of both versions", () => {
+        expect(getEdit("class A {\n}\n", "class A {\n  int a;\n}\n")).toEqual({
+            startIndex: 10,
+            oldEndIndex: 10,
+            newEndIndex: 19,
+            startPosition: { row: 1, column: 0 },
+            oldEndPosition: { row: 1, column: 0 },
+            newEndPosition: { row: 2, column: 0 },
+        });
+    });
+
+    it("should cover multiple separate changes with a single range", () => {
+        expect(getEdit("abc\ndef\nghi", "aXc\ndef\ngYi")).toEqual({
+            startIndex: 1,
+            oldEndIndex: 10,
+            newEndIndex: 10,
+            startPosition: { row: 0, column: 1 },
+            oldEndPosition: { row: 2, column: 2 },
+            newEndPosition: { row: 2, column: 2 },
+        });
+    });
+
+    it("should not let the common beginning and end overlap", () => {
+        expect(getEdit("aaa", "aaaa")).toEqual({
+            startIndex: 3,
+            oldEndIndex: 3,
+            newEndIndex: 4,
+            startPosition: { row: 0, column: 3 },
+            oldEndPosition: { row: 0, column: 3 },
+            newEndPosition: { row: 0, column: 4 },
+        });
+    });
+
+    it("should handle removed text", () => {
+        // "two\nt" is replaced by "t", as the beginning of "three" is also the beginning of "two":
+        expect(getEdit("one\ntwo\nthree", "one\nthree")).toEqual({
+            startIndex: 5,
+            oldEndIndex: 9,
+            newEndIndex: 5,
+            startPosition: { row: 1, column: 1 },
+            oldEndPosition: { row: 2, column: 1 },
+            newEndPosition: { row: 1, column: 1 },
+        });
+    });
+});
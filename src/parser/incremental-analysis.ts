@@ -0,0 +1,343 @@
+import * as fs from "node:fs";
+import path from "node:path";
+import { debuglog, type DebugLoggerFunction } from "node:util";
+import { type Edit, type Point } from "tree-sitter";
+import { ExclusionMatcher } from "../helper/exclusion-matcher.js";
+import { findFilesAsync, formatPrintPath, isSearchedFile } from "../helper/helper.js";
+import { assumeLanguageFromFilePath } from "../helper/language.js";
+import { parseTree } from "../helper/tree-parser.js";
+import { type Configuration } from "./configuration.js";
+import { CouplingCalculator } from "./coupling-calculator.js";
+import { calculateMetrics } from "./metric-calculator.js";
+import {
+    type CouplingResult,
+    ErrorFile,
+    type FileMetricResults,
+    ParsedFile,
+    type SourceFile,
+    toFileResult,
+    UnsupportedFile,
+} from "./metrics/metric.js";
+import { type FileMetricsConsumer, ResultAggregator } from "./result-aggregator.js";
+import { type ProcessedFile } from "./result-cache.js";
+
+let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
+    dlog = logger;
+});
+
+/**
+ * Time in milliseconds to wait for further changes after a file has changed, before the changes are analyzed,
+ * so that saving many files at once (e.g. when switching branches) is handled as a single update.
+ */
+const changeDelay = 50;
+
+/**
+ * State of an analyzed file that is kept between updates.
+ */
+type AnalyzedFile = {
+    processedFile: ProcessedFile;
+    /**
+     * The parsed file with its source code, kept for parsing the next version of the file incrementally.
+     * Undefined if the file could not be parsed.
+     */
+    parsedFile?: ParsedFile;
+};
+
+/**
+ * Keeps the syntax trees and results of all files in memory and updates them when files change,
+ * so that a changed file is analyzed again in milliseconds instead of running a complete analysis.
+ *
+ * A changed file is parsed incrementally: the syntax tree of the previous version is adjusted to the changed range
+ * of the source code, so that tree-sitter reuses the unchanged parts of it and only parses the changed parts again.
+ * The coupling metrics are calculated from the stored coupling data of all files when the results are requested.
+ */
+export class IncrementalAnalysis {
+    readonly #config: Configuration;
+    readonly #exclusions: ExclusionMatcher;
+    readonly #couplingParser: CouplingCalculator;
+    readonly #files = new Map<string, AnalyzedFile>();
+
+    /**
+     * Updates that are running or waiting, one after another, so that no file is analyzed twice at the same time.
+     */
+    #updates: Promise<void> = Promise.resolve();
+
+    /**
+     * Constructs a new {@link IncrementalAnalysis}.
+     * @param config Configuration of the analysis.
+     */
+    constructor(config: Configuration) {
+        this.#config = config;
+        this.#exclusions = new ExclusionMatcher(config.exclusions);
+        this.#couplingParser = new CouplingCalculator(config);
+    }
+
+    /**
+     * Number of analyzed files.
+     */
+    get fileCount(): number {
+        return this.#files.size;
+    }
+
+    /**
+     * Searches for all files and analyzes them. Files that no longer exist are removed.
+     */
+    async analyzeAll(): Promise<void> {
+        await this.#enqueue(async () => this.#synchronize());
+    }
+
+    /**
+     * Analyzes the specified files again, if they have changed.
+     * Files that no longer exist are removed, and new files are added.
+     * If one of the paths is a folder, all files are searched for again.
+     * @param filePaths Paths of the changed files.
+     */
+    async update(filePaths: Iterable<string>): Promise<void> {
+        const changedPaths = [...filePaths];
+        await this.#enqueue(async () => {
+            for (const filePath of changedPaths) {
+                // The updates have to be applied in order, parsing a file runs synchronously anyway:
+                await this.#updateFile(filePath); // eslint-disable-line no-await-in-loop
+            }
+        });
+    }
+
+    /**
+     * Returns the metrics of the specified file, after analyzing it again if it has changed.
+     * @param filePath Path of the file.
+     * @return The metrics of the file, or undefined if the file is not analyzed, e.g. because it is excluded.
+     */
+    async getFileMetrics(filePath: string): Promise<FileMetricResults | undefined> {
+        await this.update([filePath]);
+        return this.#files.get(filePath)?.processedFile.fileResult.fileMetricResults;
+    }
+
+    /**
+     * Passes the current results of all files on to the consumer, ordered by path,
+     * and calculates the coupling metrics on them.
+     * @param consumer Function to which the metrics of each file are passed.
+     * @return The coupling metrics and the files that are unsupported or could not be parsed.
+     */
+    async getResults(consumer: FileMetricsConsumer): Promise<{
+        couplingMetrics: CouplingResult;
+        unsupportedFiles: string[];
+        errorFiles: string[];
+    }> {
+        // Wait for running updates, so that the results are consistent:
+        await this.#updates;
+
+        // The coupling metrics are calculated on all files at once, so collect them from scratch:
+        const couplingParser = new CouplingCalculator(this.#config);
+        const aggregator = new ResultAggregator(this.#config, couplingParser, consumer);
+        const filePaths = [...this.#files.keys()].sort();
+        for (const [index, filePath] of filePaths.entries()) {
+            const { processedFile } = this.#files.get(filePath)!;
+            await aggregator.add(index, processedFile); // eslint-disable-line no-await-in-loop
+        }
+
+        return {
+            couplingMetrics: couplingParser.calculateMetrics(),
+            unsupportedFiles: aggregator.unsupportedFiles,
+            errorFiles: aggregator.errorFiles,
+        };
+    }
+
+    /**
+     * Watches the sources path for changes and analyzes the changed files again.
+     * @param onUpdate Called after changed files have been analyzed again, with the paths of the files.
+     * @return Function that stops watching.
+     */
+    watch(onUpdate?: (filePaths: string[]) => void): () => void {
+        const { sourcesPath } = this.#config;
+        const isSingleFile = fs.statSync(sourcesPath).isFile();
+        const changedPaths = new Set<string>();
+        let timeout: NodeJS.Timeout | undefined;
+
+        const watcher = fs.watch(sourcesPath, { recursive: true }, (_, fileName) => {
+            // Without a file name, it is unknown what has changed, so all files are searched for again:
+            changedPaths.add(
+                fileName === null || isSingleFile
+                    ? sourcesPath
+                    : path.join(sourcesPath, fileName.toString()),
+            );
+
+            clearTimeout(timeout);
+            timeout = setTimeout(() => {
+                const filePaths = [...changedPaths];
+                changedPaths.clear();
+                this.update(filePaths).then(
+                    () => onUpdate?.(filePaths),
+                    (error: unknown) => {
+                        console.error("Error while analyzing the changed files:");
+                        console.error(error);
+                    },
+                );
+            }, changeDelay);
+        });
+
+        return () => {
+            clearTimeout(timeout);
+            watcher.close();
+        };
+    }
+
+    async #enqueue(update: () => Promise<void>): Promise<void> {
+        const result = this.#updates.then(update);
+        // A failed update must not prevent further updates:
+        this.#updates = result.catch(() => undefined);
+        return result;
+    }
+
+    /**
+     * Searches for all files, analyzes new and changed files and removes files that no longer exist.
+     */
+    async #synchronize(): Promise<void> {
+        const foundFiles = new Set<string>();
+        for await (const filePath of findFilesAsync(this.#config)) {
+            foundFiles.add(filePath);
+            await this.#analyzeFile(filePath); // eslint-disable-line no-await-in-loop
+        }
+
+        for (const filePath of this.#files.keys()) {
+            if (!foundFiles.has(filePath)) {
+                this.#files.delete(filePath);
+            }
+        }
+    }
+
+    async #updateFile(filePath: string): Promise<void> {
+        let stats: fs.Stats;
+        try {
+            stats = await fs.promises.stat(filePath);
+        } catch {
+            // The file or folder has been removed:
+            this.#removeFiles(filePath);
+            return;
+        }
+
+        if (stats.isDirectory()) {
+            // A folder has been added, removed or renamed, so files may be found or gone anywhere below it:
+            await this.#synchronize();
+        } else if (stats.isFile() && isSearchedFile(filePath, this.#config, this.#exclusions)) {
+            await this.#analyzeFile(filePath);
+        } else {
+            this.#removeFiles(filePath);
+        }
+    }
+
+    #removeFiles(removedPath: string): void {
+        this.#files.delete(removedPath);
+        const folderPrefix = removedPath + path.sep;
+        for (const filePath of this.#files.keys()) {
+            if (filePath.startsWith(folderPrefix)) {
+                this.#files.delete(filePath);
+            }
+        }
+    }
+
+    /**
+     * Analyzes the specified file, unless its contents have not changed since it was analyzed last.
+     */
+    async #analyzeFile(filePath: string): Promise<void> {
+        const previous = this.#files.get(filePath);
+        let sourceFile: SourceFile;
+        let parsedFile: ParsedFile | undefined;
+
+        if (assumeLanguageFromFilePath(filePath, this.#config) === undefined) {
+            sourceFile = new UnsupportedFile(filePath);
+        } else {
+            try {
+                const sourceCode = await fs.promises.readFile(filePath, { encoding: "utf8" });
+                if (previous?.parsedFile?.sourceCode === sourceCode) {
+                    return;
+                }
+
+                sourceFile = this.#parse(filePath, sourceCode, previous?.parsedFile);
+                if (sourceFile instanceof ParsedFile) {
+                    parsedFile = sourceFile;
+                }
+            } catch (error) {
+                sourceFile = new ErrorFile(
+                    filePath,
+                    error instanceof Error ? error : new Error(String(error)),
+                );
+            }
+        }
+
+        const couplingData = this.#couplingParser.processFile(sourceFile);
+        const [calculatedFile, fileMetricResults] = await calculateMetrics(
+            sourceFile,
+            this.#config,
+        );
+        const fileResult = toFileResult(calculatedFile, fileMetricResults);
+        this.#files.set(filePath, { processedFile: { fileResult, couplingData }, parsedFile });
+    }
+
+    #parse(
+        filePath: string,
+        sourceCode: string,
+        previous: ParsedFile | undefined,
+    ): ParsedFile | UnsupportedFile {
+        if (previous === undefined) {
+            return parseTree(sourceCode, filePath, this.#config);
+        }
+
+        previous.tree.edit(getEdit(previous.sourceCode, sourceCode));
+        dlog("Parsing " + formatPrintPath(filePath, this.#config) + " incrementally");
+        return parseTree(sourceCode, filePath, this.#config, previous);
+    }
+}
+
+/**
+ * Determines the range of the source code that differs between two versions of it,
+ * as edit for adjusting the syntax tree of the old version.
+ * The range spans from the first to the last changed character, so it covers all changes,
+ * even if there are multiple separate ones.
+ * @param oldText The previous version of the source code.
+ * @param newText The new version of the source code.
+ */
+export function getEdit(oldText: string, newText: string): Edit {
+    const maxLength = Math.min(oldText.length, newText.length);
+
+    let start = 0;
+    while (start < maxLength && oldText.charCodeAt(start) === newText.charCodeAt(start)) {
+        start++;
+    }
+
+    let suffix = 0;
+    while (
+        suffix < maxLength - start &&
+        oldText.charCodeAt(oldText.length - 1 - suffix) ===
+            newText.charCodeAt(newText.length - 1 - suffix)
+    ) {
+        suffix++;
+    }
+
+    const oldEnd = oldText.length - suffix;
+    const newEnd = newText.length - suffix;
+    return {
+        startIndex: start,
+        oldEndIndex: oldEnd,
+        newEndIndex: newEnd,
+        startPosition: getPoint(oldText, start),
+        oldEndPosition: getPoint(oldText, oldEnd),
+        newEndPosition: getPoint(newText, newEnd),
+    };
+}
+
+/**
+ * Returns the row and column of the character at the specified index, counting columns in UTF-16 code units
+ * like the indices of the syntax nodes.
+ */
+function getPoint(text: string, index: number): Point {
+    let row = 0;
+    let lineStart = 0;
+    let lineBreak = text.indexOf("\n");
+    while (lineBreak !== -1 && lineBreak < index) {
+        row++;
+        lineStart = lineBreak + 1;
+        lineBreak = text.indexOf("\n", lineStart);
+    }
+
+    return { row, column: index - lineStart };
+}
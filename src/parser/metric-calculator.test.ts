@@ -1,8 +1,8 @@
 import fs from "node:fs/promises";
 import { beforeAll, beforeEach, describe, expect, it, vi } from "vitest";
 import Parser = require("tree-sitter");
-import { mockConsole } from "../../test/metric-end-results/test-helper.js";
-import { FileType, Language, languageToGrammar } from "../helper/language.js";
+import { getTestConfiguration, mockConsole } from "../../test/metric-end-results/test-helper.js";
+import { FileType, getGrammar, Language } from "../helper/language.js";
 import { calculateMetrics } from "./metric-calculator.js";
 import {
     ErrorFile,
@@ -49,7 +49,7 @@ function initiateSpies(): void {
         metricName: "real_lines_of_code",
         metricValue: 7,
     });
-    vi.spyOn(LinesOfCodeRawText, "calculateLinesOfCodeRawText").mockReturnValue({
+    vi.spyOn(LinesOfCodeRawText, "calculateLinesOfCodeRawTextOfFile").mockResolvedValue({
         metricName: "lines_of_code",
         metricValue: 8,
     });
@@ -79,7 +79,7 @@ function initiateErrorSpies(): void {
     vi.spyOn(RealLinesOfCode.prototype, "calculate").mockImplementation(() => {
         throw new Error("something went wrong when calculating realLinesOfCode metric");
     });
-    vi.spyOn(LinesOfCodeRawText, "calculateLinesOfCodeRawText").mockReturnValue({
+    vi.spyOn(LinesOfCodeRawText, "calculateLinesOfCodeRawTextOfFile").mockResolvedValue({
         metricName: "lines_of_code",
         metricValue: 8,
     });
@@ -99,9 +99,14 @@ describe("MetricCalculator.calculateMetrics()", () => {
 
     it("should calculate all metrics of type source code for a python file", async () => {
         // Given
-        parser.setLanguage(languageToGrammar.get(Language.Python));
-        const tree = parser.parse("sum(range(4))");
-        const parsedFile = new ParsedFile("test.py", Language.Python, tree);
+        parser.setLanguage(getGrammar(Language.Python));
+        const sourceCode = "sum(range(4))";
+        const parsedFile = new ParsedFile(
+            "test.py",
+            Language.Python,
+            parser.parse(sourceCode),
+            sourceCode,
+        );
         const parsedFilePromise = parsedFile;
 
         initiateSpies();
@@ -114,11 +119,45 @@ describe("MetricCalculator.calculateMetrics()", () => {
         expect(fileMetricResults).toMatchSnapshot();
     });
 
+    it("should count the configured keyword sets in comments in addition to the default keywords", async () => {
+        // Given
+        parser.setLanguage(getGrammar(Language.Python));
+        const sourceCode = "# TODO: FIXME, see JIRA-12\nprint('todo xxx')  # xxx\n";
+        const parsedFile = new ParsedFile(
+            "test.py",
+            Language.Python,
+            parser.parse(sourceCode),
+            sourceCode,
+        );
+        const config = getTestConfiguration("", {
+            commentKeywords: "debt=fixme,xxx;ticket=JIRA-",
+        });
+
+        // When
+        const [, fileMetricResults] = await calculateMetrics(parsedFile, config);
+
+        // Then
+        expect(
+            fileMetricResults.metricResults.filter(({ metricName }) =>
+                metricName.startsWith("keywords_in_comments"),
+            ),
+        ).toEqual([
+            { metricName: "keywords_in_comments", metricValue: 1 },
+            { metricName: "keywords_in_comments_debt", metricValue: 2 },
+            { metricName: "keywords_in_comments_ticket", metricValue: 1 },
+        ]);
+    });
+
     it("should calculate lines of code and maximum nesting level for a JSON file", async () => {
         // Given
-        parser.setLanguage(languageToGrammar.get(Language.JSON));
-        const tree = parser.parse('{ "a": { "b": "c" } }');
-        const parsedFile = new ParsedFile("test.json", Language.JSON, tree);
+        parser.setLanguage(getGrammar(Language.JSON));
+        const sourceCode = '{ "a": { "b": "c" } }';
+        const parsedFile = new ParsedFile(
+            "test.json",
+            Language.JSON,
+            parser.parse(sourceCode),
+            sourceCode,
+        );
         const parsedFilePromise = parsedFile;
 
         initiateSpies();
@@ -170,9 +209,14 @@ describe("MetricCalculator.calculateMetrics()", () => {
 
     it("should include an error object in the result when an error is thrown while calculating any metric on a source file", async () => {
         // Given
-        parser.setLanguage(languageToGrammar.get(Language.Python));
-        const tree = parser.parse("sum(range(4))");
-        const parsedFile = new ParsedFile("test.py", Language.Python, tree);
+        parser.setLanguage(getGrammar(Language.Python));
+        const sourceCode = "sum(range(4))";
+        const parsedFile = new ParsedFile(
+            "test.py",
+            Language.Python,
+            parser.parse(sourceCode),
+            sourceCode,
+        );
         const parsedFilePromise = parsedFile;
 
         initiateErrorSpies();
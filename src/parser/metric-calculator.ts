@@ -1,6 +1,6 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
-import fs from "node:fs/promises";
 import { type NodeTypeConfig } from "../helper/model.js";
+import { profiler } from "../helper/profiler.js";
 import { FileType } from "../helper/language.js";
 import { Complexity } from "./metrics/complexity.js";
 import { Functions } from "./metrics/functions.js";
@@ -11,6 +11,7 @@ import { RealLinesOfCode } from "./metrics/real-lines-of-code.js";
 import {
     ErrorFile,
     type FileMetricResults,
+    type Metric,
     type MetricError,
     type MetricResult,
     ParsedFile,
@@ -18,33 +19,94 @@ import {
 } from "./metrics/metric.js";
 import nodeTypesConfig from "./config/node-types-config.json" with { type: "json" };
 import { MaxNestingLevel } from "./metrics/max-nesting-level.js";
-import { calculateLinesOfCodeRawText } from "./metrics/lines-of-code-raw-text.js";
-import { KeywordsInComments } from "./metrics/keywords-in-comments.js";
+import { calculateLinesOfCodeRawTextOfFile } from "./metrics/lines-of-code-raw-text.js";
+import { type Configuration } from "./configuration.js";
+import {
+    createKeywordsInCommentsMetrics,
+    type KeywordsInComments,
+} from "./metrics/keywords-in-comments.js";
+import {
+    isQueryMetric,
+    MetricQueryEngine,
+    type MetricQueryResult,
+} from "./queries/metric-query-engine.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
 });
 
-const allNodeTypes = nodeTypesConfig as NodeTypeConfig[];
-const sourceFileMetrics = [
-    new Complexity(allNodeTypes),
-    new Functions(allNodeTypes),
-    new Classes(allNodeTypes),
-    new LinesOfCode(),
-    new CommentLines(allNodeTypes),
-    new RealLinesOfCode(allNodeTypes),
-    new KeywordsInComments(allNodeTypes),
-];
-const structuredTextFileMetrics = [new LinesOfCode(), new MaxNestingLevel(allNodeTypes)];
+type Metrics = {
+    sourceFileMetrics: Metric[];
+    structuredTextFileMetrics: Metric[];
+    sourceFileQueryEngine: MetricQueryEngine;
+    commentLines: CommentLines;
+};
+
+let metrics: Metrics | undefined;
+
+/**
+ * Keywords in comments metrics by the configured keyword sets, as all runs in a process share the other metrics.
+ */
+const keywordsInCommentsMetrics = new Map<string, KeywordsInComments[]>();
+
+/**
+ * Returns the metrics, which are created on first use instead of when loading this module,
+ * so that starting a run does not wait for the node types of all languages to be processed.
+ * The queries of the metrics are combined and compiled for each language on first use of that language.
+ */
+function getMetrics(): Metrics {
+    if (metrics === undefined) {
+        const allNodeTypes = nodeTypesConfig as NodeTypeConfig[];
+        const commentLines = new CommentLines(allNodeTypes);
+        const sourceFileMetrics = [
+            new Complexity(allNodeTypes),
+            new Functions(allNodeTypes),
+            new Classes(allNodeTypes),
+            new LinesOfCode(),
+            commentLines,
+            new RealLinesOfCode(allNodeTypes),
+        ];
+        metrics = {
+            sourceFileMetrics,
+            structuredTextFileMetrics: [new LinesOfCode(), new MaxNestingLevel(allNodeTypes)],
+            sourceFileQueryEngine: new MetricQueryEngine(sourceFileMetrics.filter(isQueryMetric)),
+            commentLines,
+        };
+    }
+
+    return metrics;
+}
+
+/**
+ * Returns the keywords in comments metrics for the keyword sets of the specified configuration.
+ * They count the keywords in the comments captured by the combined query, so they do not add a query of their own.
+ */
+function getKeywordsInCommentsMetrics(
+    commentLines: CommentLines,
+    config?: Configuration,
+): KeywordsInComments[] {
+    const keywordSets = config?.commentKeywords ?? new Map<string, string[]>();
+    const key = JSON.stringify([...keywordSets]);
+    let keywordMetrics = keywordsInCommentsMetrics.get(key);
+    if (keywordMetrics === undefined) {
+        keywordMetrics = createKeywordsInCommentsMetrics(commentLines, keywordSets);
+        keywordsInCommentsMetrics.set(key, keywordMetrics);
+    }
+
+    return keywordMetrics;
+}
 
 /**
  * Calculates file metrics on the specified file.
  * @param sourceFile Source file for which the metric should be calculated.
+ * @param config Configuration of this parser run, which limits the size of unsupported files to count
+ * and specifies additional keywords to count in comments.
  * @return A tuple that contains the representation of the file and
  * the calculated metrics.
  */
 export async function calculateMetrics(
     sourceFile: SourceFile,
+    config?: Configuration,
 ): Promise<[SourceFile, FileMetricResults]> {
     if (sourceFile instanceof ErrorFile) {
         return [sourceFile, { fileType: sourceFile.fileType, metricResults: [], metricErrors: [] }];
@@ -60,14 +122,45 @@ export async function calculateMetrics(
                 ":  ------------ ",
         );
 
+        const {
+            sourceFileMetrics,
+            structuredTextFileMetrics,
+            sourceFileQueryEngine,
+            commentLines,
+        } = getMetrics();
         const metricsToCalculate =
             sourceFile.fileType === FileType.SourceCode
-                ? sourceFileMetrics
+                ? [...sourceFileMetrics, ...getKeywordsInCommentsMetrics(commentLines, config)]
                 : structuredTextFileMetrics;
 
+        let queryResult: MetricQueryResult | undefined;
+        if (sourceFile.fileType === FileType.SourceCode) {
+            try {
+                queryResult = profiler.measure(
+                    "metric query",
+                    () => sourceFileQueryEngine.execute(sourceFile),
+                    { filePath: sourceFile.filePath, language: sourceFile.language },
+                );
+            } catch (error) {
+                // Let each metric run its own query, so that the error only affects the metrics concerned:
+                dlog(
+                    "Combined metric query failed for " +
+                        sourceFile.filePath +
+                        ": " +
+                        String(error),
+                );
+            }
+        }
+
         for (const metric of metricsToCalculate) {
             try {
-                metricResults.push(metric.calculate(sourceFile));
+                metricResults.push(
+                    profiler.measure(
+                        `metric:${metric.getName()}`,
+                        () => metric.calculate(sourceFile, queryResult),
+                        { filePath: sourceFile.filePath, language: sourceFile.language },
+                    ),
+                );
             } catch (error_) {
                 const error = error_ instanceof Error ? error_ : new Error(String(error_));
                 metricErrors.push({ metricName: metric.getName(), error });
@@ -77,8 +170,13 @@ export async function calculateMetrics(
         // Unsupported file: only calculate metrics based on the raw source code
         try {
             // Reading a file might fail, catch that
-            const sourceCode = await fs.readFile(sourceFile.filePath, { encoding: "utf8" });
-            metricResults.push(calculateLinesOfCodeRawText(sourceCode)); // Should never throw
+            const linesOfCode = await calculateLinesOfCodeRawTextOfFile(
+                sourceFile.filePath,
+                (config?.maxUnsupportedFileSize ?? 0) * 1024 * 1024,
+            );
+            if (linesOfCode !== undefined) {
+                metricResults.push(linesOfCode);
+            }
         } catch (error_) {
             const error = error_ instanceof Error ? error_ : new Error(String(error_));
             metricErrors.push({ metricName: "lines_of_code", error });
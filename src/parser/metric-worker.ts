@@ -0,0 +1,75 @@
+import { Buffer } from "node:buffer";
+import { workerData } from "node:worker_threads";
+import { handleWorkerTasks } from "../helper/worker-pool.js";
+import { parse } from "../helper/tree-parser.js";
+import { type ProfileSpan, profiler } from "../helper/profiler.js";
+import { type Configuration } from "./configuration.js";
+import { calculateMetrics } from "./metric-calculator.js";
+import { CouplingCalculator } from "./coupling-calculator.js";
+import { type FileCouplingData } from "./metrics/coupling/coupling.js";
+import { type FileResult, toFileResult } from "./metrics/metric.js";
+
+/*
+ * Script run by the worker threads started by the GenericParser if multiple threads are configured.
+ * Each worker thread has its own tree-sitter parsers and compiled queries.
+ * It receives the paths of the files to process, along with their contents if they have already been read,
+ * and returns the calculated metrics and the data extracted for the coupling metrics,
+ * which are calculated on the main thread.
+ */
+
+/**
+ * File to process on a worker thread.
+ */
+export type WorkerTask = {
+    filePath: string;
+    /**
+     * The contents of the file, if they have already been read on the main thread.
+     * They arrive as a plain Uint8Array, as the structured clone does not keep the Buffer prototype.
+     */
+    contents?: Uint8Array;
+};
+
+/**
+ * Result of processing a file on a worker thread.
+ */
+export type WorkerResult = {
+    fileResult: FileResult;
+    /**
+     * Data for the coupling metrics, if dependencies are analyzed and the file could be parsed.
+     */
+    couplingData?: FileCouplingData;
+    /**
+     * Spans recorded while processing the file, if profiling is enabled.
+     */
+    profileSpans: ProfileSpan[];
+};
+
+// The configuration is passed as structured clone, so it is a plain object without the prototype.
+const config = workerData as Configuration;
+const couplingParser = new CouplingCalculator(config);
+
+if (config.profilePath !== undefined) {
+    profiler.enable();
+    profiler.measureStartup();
+}
+
+handleWorkerTasks(async ({ filePath, contents }: WorkerTask): Promise<WorkerResult> => {
+    const sourceFile = await parse(
+        filePath,
+        config,
+        contents === undefined
+            ? undefined
+            : Buffer.from(contents.buffer, contents.byteOffset, contents.byteLength),
+    );
+    const couplingData = profiler.measure(
+        "coupling collect",
+        () => couplingParser.processFile(sourceFile),
+        { filePath },
+    );
+    const [processedFile, fileMetricResults] = await calculateMetrics(sourceFile, config);
+    return {
+        fileResult: toFileResult(processedFile, fileMetricResults),
+        couplingData,
+        profileSpans: profiler.takeSpans(),
+    };
+});
@@ -0,0 +1,106 @@
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, beforeEach, describe, expect, it } from "vitest";
+import { getTestConfiguration } from "../../test/metric-end-results/test-helper.js";
+import { GitObjectStore } from "../helper/git-object-store.js";
+import { createGitRepository } from "../helper/git-repository.test-helper.js";
+import { type ConfigurationParameters } from "./configuration.js";
+import { type CommitMetrics, MetricsHistory } from "./metrics-history.js";
+
+const classWithOneMethod = "class A {\n    void first() {}\n}\n";
+const classWithTwoMethods = "class A {\n    void first() {}\n\n    void second() {}\n}\n";
+
+describe("MetricsHistory", () => {
+    let repositoryPath: string;
+    let commits: string[];
+
+    beforeEach(async () => {
+        repositoryPath = await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-"));
+        commits = createGitRepository(repositoryPath, [
+            { "src/A.java": classWithOneMethod, "notes.txt": "first\nsecond\n" },
+            { "src/A.java": classWithTwoMethods, "notes.txt": "first\nsecond\n" },
+            {
+                "src/A.java": classWithTwoMethods,
+                "src/B.java": "class B {\n    void third() {}\n}\n",
+                "notes.txt": "first\nsecond\n",
+                "node_modules/x.js": "function x() {}\n",
+            },
+        ]);
+    });
+
+    afterEach(async () => {
+        await fs.rm(repositoryPath, { recursive: true, force: true });
+    });
+
+    async function analyze(
+        overrides: Partial<ConfigurationParameters> = {},
+        maxCommits = 0,
+    ): Promise<CommitMetrics[]> {
+        const config = getTestConfiguration(repositoryPath, {
+            exclusions: "node_modules",
+            ...overrides,
+        });
+        const store = await GitObjectStore.open(repositoryPath);
+        const results: CommitMetrics[] = [];
+        for await (const commitMetrics of new MetricsHistory(config, store).analyze(
+            "HEAD",
+            maxCommits,
+        )) {
+            results.push(commitMetrics);
+        }
+
+        await store.close();
+        return results;
+    }
+
+    it("should calculate the metrics of each commit, oldest first, analyzing each file version only once", async () => {
+        const results = await analyze();
+
+        expect(results.map(({ commit, subject }) => [commit, subject])).toEqual([
+            [commits[0], "Version 1"],
+            [commits[1], "Version 2"],
+            [commits[2], "Version 3"],
+        ]);
+        const fileCounts = results.map(({ files, unsupportedFiles, errorFiles }) => ({
+            files,
+            unsupportedFiles,
+            errorFiles,
+        }));
+        expect(fileCounts).toEqual([
+            { files: 1, unsupportedFiles: 1, errorFiles: 0 },
+            { files: 1, unsupportedFiles: 1, errorFiles: 0 },
+            { files: 2, unsupportedFiles: 1, errorFiles: 0 },
+        ]);
+        expect(results.map(({ analyzedFiles }) => analyzedFiles)).toEqual([2, 1, 1]);
+        expect(results.map(({ metrics }) => metrics.functions)).toEqual([1, 2, 3]);
+        expect(results[0].time).toBe(1_700_000_000);
+    });
+
+    it("should skip unsupported files if configured", async () => {
+        const results = await analyze({ skipUnsupportedFiles: true });
+
+        expect(results.map(({ unsupportedFiles }) => unsupportedFiles)).toEqual([0, 0, 0]);
+        expect(results.map(({ analyzedFiles }) => analyzedFiles)).toEqual([1, 1, 1]);
+    });
+
+    it("should not read unsupported files larger than the maximum size", async () => {
+        createGitRepository(repositoryPath, [
+            { "small.txt": "first\nsecond\n", "large.txt": "line\n".repeat(300_000) },
+        ]);
+
+        const [withLimit] = await analyze({ maxUnsupportedFileSize: 1 });
+        const [withoutLimit] = await analyze();
+
+        expect(withLimit.unsupportedFiles).toBe(2);
+        expect(withLimit.metrics.lines_of_code).toBe(3);
+        expect(withoutLimit.metrics.lines_of_code).toBe(300_004);
+    });
+
+    it("should only analyze the specified number of newest commits", async () => {
+        const results = await analyze({}, 2);
+
+        expect(results.map(({ commit }) => commit)).toEqual([commits[1], commits[2]]);
+        expect(results.map(({ analyzedFiles }) => analyzedFiles)).toEqual([2, 1]);
+    });
+});
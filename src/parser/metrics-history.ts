@@ -0,0 +1,261 @@
+import path from "node:path";
+import { debuglog, type DebugLoggerFunction } from "node:util";
+import { ExclusionMatcher } from "../helper/exclusion-matcher.js";
+import { type GitCommit, type GitObjectStore } from "../helper/git-object-store.js";
+import { assumeLanguageFromFilePath } from "../helper/language.js";
+import { parseTree } from "../helper/tree-parser.js";
+import { type Configuration } from "./configuration.js";
+import { calculateMetrics } from "./metric-calculator.js";
+import { calculateLinesOfCodeRawTextOfBuffer } from "./metrics/lines-of-code-raw-text.js";
+import { type MetricName, type MetricResult, ParsedFile } from "./metrics/metric.js";
+
+let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
+    dlog = logger;
+});
+
+/**
+ * Metrics of all files of a commit.
+ */
+export type CommitMetrics = {
+    commit: string;
+    /**
+     * Time of the commit in seconds since the epoch.
+     */
+    time: number;
+    subject: string;
+    /**
+     * Number of files in a supported language.
+     */
+    files: number;
+    unsupportedFiles: number;
+    errorFiles: number;
+    /**
+     * Number of file versions that were analyzed for this commit, as they did not occur in any previous commit.
+     */
+    analyzedFiles: number;
+    /**
+     * Sum of each metric over all files, or the maximum for metrics named max_...
+     */
+    metrics: Partial<Record<MetricName, number>>;
+};
+
+/**
+ * Aggregated metrics of the files in a tree.
+ */
+type Totals = {
+    files: number;
+    unsupportedFiles: number;
+    errorFiles: number;
+    metrics: Map<MetricName, number>;
+};
+
+/**
+ * Results of a file version. Unsupported files only have the number of lines, unless they are binary files.
+ */
+type BlobResult = {
+    kind: "files" | "unsupportedFiles" | "errorFiles";
+    metricResults: MetricResult[];
+};
+
+const fileModes = new Set(["100644", "100755"]);
+const directoryMode = "40000";
+
+/**
+ * Calculates the metrics of all files for each commit in the history of a git repository,
+ * reading the files directly from its object store instead of checking out each commit.
+ *
+ * Each file version (blob) is analyzed only once, no matter in how many commits and under how many paths it occurs,
+ * and the aggregated metrics of each folder (tree) are reused as long as the folder does not change.
+ * So only the folders along the paths to changed files are visited again for each commit,
+ * and the time grows with the number of changed files instead of the number of commits times the number of files.
+ * The coupling metrics are not calculated, as they require all files of a commit to be analyzed together.
+ */
+export class MetricsHistory {
+    readonly #config: Configuration;
+    readonly #store: GitObjectStore;
+    readonly #exclusions: ExclusionMatcher;
+
+    /**
+     * Results of each blob by language and hash, as the language is determined by the path of the file.
+     */
+    readonly #blobResults = new Map<string, BlobResult>();
+    /**
+     * Totals of each tree by path and hash, as the exclusions and languages depend on the paths of the files.
+     */
+    readonly #treeTotals = new Map<string, Totals>();
+    #analyzedFiles = 0;
+
+    /**
+     * Constructs a new {@link MetricsHistory}.
+     * @param config Configuration of the analysis. Its sources path is the root of the repository.
+     * @param store Object store of the repository.
+     */
+    constructor(config: Configuration, store: GitObjectStore) {
+        this.#config = config;
+        this.#store = store;
+        this.#exclusions = new ExclusionMatcher(config.exclusions);
+    }
+
+    /**
+     * Calculates the metrics of the commits that lead to the specified commit, following the first parent of each commit,
+     * and passes them on from the oldest to the newest commit.
+     * @param reference The newest commit, e.g. "HEAD", a branch or tag name or a commit hash.
+     * @param maxCommits Maximum number of commits to analyze, counted from the newest one. 0 means no limit.
+     */
+    async *analyze(reference: string, maxCommits = 0): AsyncGenerator<CommitMetrics> {
+        const commits: GitCommit[] = [];
+        let hash: string | undefined = await this.#store.resolveCommit(reference);
+        while (hash !== undefined && (maxCommits === 0 || commits.length < maxCommits)) {
+            const commit = await this.#store.readCommit(hash); // eslint-disable-line no-await-in-loop
+            commits.push(commit);
+            hash = commit.parents[0];
+        }
+
+        for (const commit of commits.reverse()) {
+            const analyzedFilesBefore = this.#analyzedFiles;
+            const totals = await this.#analyzeTree(commit.tree, ""); // eslint-disable-line no-await-in-loop
+            dlog("Analyzed commit " + commit.hash);
+
+            yield {
+                commit: commit.hash,
+                time: commit.time,
+                subject: commit.subject,
+                files: totals.files,
+                unsupportedFiles: totals.unsupportedFiles,
+                errorFiles: totals.errorFiles,
+                analyzedFiles: this.#analyzedFiles - analyzedFilesBefore,
+                metrics: Object.fromEntries(totals.metrics),
+            };
+        }
+    }
+
+    /**
+     * Returns the totals of the files in the specified tree, analyzing only the trees and blobs not seen before.
+     * @param hash Hash of the tree.
+     * @param treePath Path of the tree relative to the root of the repository, with "/" as separator.
+     */
+    async #analyzeTree(hash: string, treePath: string): Promise<Totals> {
+        const key = treePath + ":" + hash;
+        const cached = this.#treeTotals.get(key);
+        if (cached !== undefined) {
+            return cached;
+        }
+
+        const totals: Totals = { files: 0, unsupportedFiles: 0, errorFiles: 0, metrics: new Map() };
+        for (const entry of await this.#store.readTree(hash)) {
+            const entryPath = treePath === "" ? entry.name : treePath + "/" + entry.name;
+            const isDirectory = entry.mode === directoryMode;
+            // Symbolic links and submodules are skipped, as they are not followed when searching for files either:
+            if (
+                (!isDirectory && !fileModes.has(entry.mode)) ||
+                this.#exclusions.isExcluded(entryPath, isDirectory)
+            ) {
+                continue;
+            }
+
+            if (isDirectory) {
+                addTotals(totals, await this.#analyzeTree(entry.hash, entryPath)); // eslint-disable-line no-await-in-loop
+                continue;
+            }
+
+            const result = await this.#analyzeBlob(entry.hash, entryPath); // eslint-disable-line no-await-in-loop
+            if (result !== undefined) {
+                totals[result.kind]++;
+                addMetrics(totals.metrics, result.metricResults);
+            }
+        }
+
+        this.#treeTotals.set(key, totals);
+        return totals;
+    }
+
+    /**
+     * Returns the results of the specified file version, analyzing it only if it has not been seen before.
+     * @return The results, or undefined if the file is skipped as unsupported file.
+     */
+    async #analyzeBlob(hash: string, filePath: string): Promise<BlobResult | undefined> {
+        const absolutePath = path.join(this.#config.sourcesPath, filePath);
+        const language = assumeLanguageFromFilePath(absolutePath, this.#config);
+        if (language === undefined && this.#config.skipUnsupportedFiles) {
+            return undefined;
+        }
+
+        const key = (language ?? "unsupported") + ":" + hash;
+        let result = this.#blobResults.get(key);
+        if (result === undefined) {
+            result =
+                language === undefined
+                    ? await this.#calculateUnsupportedBlobMetrics(hash, absolutePath)
+                    : await this.#calculateBlobMetrics(hash, absolutePath);
+            this.#blobResults.set(key, result);
+            this.#analyzedFiles++;
+        }
+
+        return result;
+    }
+
+    async #calculateBlobMetrics(hash: string, filePath: string): Promise<BlobResult> {
+        try {
+            const contents = await this.#store.readBlob(hash);
+            const sourceFile = parseTree(contents.toString("utf8"), filePath, this.#config);
+            if (!(sourceFile instanceof ParsedFile)) {
+                return { kind: "unsupportedFiles", metricResults: [] };
+            }
+
+            const [, { metricResults }] = await calculateMetrics(sourceFile, this.#config);
+            return { kind: "files", metricResults };
+        } catch (error) {
+            dlog("Analyzing " + filePath + " in blob " + hash + " failed: " + String(error));
+            return { kind: "errorFiles", metricResults: [] };
+        }
+    }
+
+    /**
+     * Counts the lines of a file in an unsupported language on its bytes, without decoding or parsing it.
+     * Files larger than the configured maximum size are not read at all.
+     */
+    async #calculateUnsupportedBlobMetrics(hash: string, filePath: string): Promise<BlobResult> {
+        try {
+            const maxSize = this.#config.maxUnsupportedFileSize * 1024 * 1024;
+            if (maxSize > 0 && (await this.#store.readObjectSize(hash)) > maxSize) {
+                return { kind: "unsupportedFiles", metricResults: [] };
+            }
+
+            const linesOfCode = calculateLinesOfCodeRawTextOfBuffer(await this.#store.readBlob(hash));
+            return {
+                kind: "unsupportedFiles",
+                metricResults: linesOfCode === undefined ? [] : [linesOfCode],
+            };
+        } catch (error) {
+            dlog("Analyzing " + filePath + " in blob " + hash + " failed: " + String(error));
+            return { kind: "errorFiles", metricResults: [] };
+        }
+    }
+}
+
+function addTotals(target: Totals, source: Totals): void {
+    target.files += source.files;
+    target.unsupportedFiles += source.unsupportedFiles;
+    target.errorFiles += source.errorFiles;
+    for (const [metricName, metricValue] of source.metrics) {
+        addMetric(target.metrics, metricName, metricValue);
+    }
+}
+
+function addMetrics(target: Map<MetricName, number>, metricResults: MetricResult[]): void {
+    for (const { metricName, metricValue } of metricResults) {
+        addMetric(target, metricName, metricValue);
+    }
+}
+
+function addMetric(target: Map<MetricName, number>, metricName: MetricName, value: number): void {
+    const previous = target.get(metricName);
+    if (previous === undefined) {
+        target.set(metricName, value);
+    } else {
+        target.set(
+            metricName,
+            metricName.startsWith("max_") ? Math.max(previous, value) : previous + value,
+        );
+    }
+}
@@ -1,20 +1,25 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
-import { type QueryMatch } from "tree-sitter";
 import { NodeTypeCategory, type NodeTypeConfig } from "../../helper/model.js";
-import { QueryBuilder } from "../queries/query-builder.js";
+import {
+    getQueryMatchCount,
+    type MetricQueryResult,
+    type QueryMetric,
+} from "../queries/metric-query-engine.js";
 import {
     type QueryStatement,
     SimpleLanguageSpecificQueryStatement,
 } from "../queries/query-statements.js";
 import { getQueryStatementsByCategories } from "../../helper/helper.js";
 import { Language } from "../../helper/language.js";
-import { type Metric, type MetricName, type MetricResult, type ParsedFile } from "./metric.js";
+import { type MetricName, type MetricResult, type ParsedFile } from "./metric.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
 });
 
-export class Classes implements Metric {
+export class Classes implements QueryMetric {
+    readonly countsMatchesOnly = true;
+
     private readonly statementsSuperSet: QueryStatement[] = [];
 
     private readonly nodeTypeCategories = new Set([
@@ -103,22 +108,18 @@ export class Classes implements Metric {
         );
     }
 
-    calculate(parsedFile: ParsedFile): MetricResult {
-        const { language, tree } = parsedFile;
-        const queryBuilder = new QueryBuilder(language);
-        queryBuilder.addStatements(this.statementsSuperSet);
+    getQueryStatements(): QueryStatement[] {
+        return this.statementsSuperSet;
+    }
 
-        const query = queryBuilder.build();
-        let matches: QueryMatch[] = [];
-        if (query !== undefined) {
-            matches = query.matches(tree.rootNode);
-        }
+    calculate(parsedFile: ParsedFile, queryResult?: MetricQueryResult): MetricResult {
+        const matchCount = getQueryMatchCount(this, parsedFile, queryResult);
 
-        dlog(this.getName() + " - " + matches.length.toString());
+        dlog(this.getName() + " - " + matchCount.toString());
 
         return {
             metricName: this.getName(),
-            metricValue: matches.length,
+            metricValue: matchCount,
         };
     }
 
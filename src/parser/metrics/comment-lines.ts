@@ -1,6 +1,5 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
-import { type QueryCapture } from "tree-sitter";
-import { QueryBuilder } from "../queries/query-builder.js";
+import { type QueryMatch, type SyntaxNode } from "tree-sitter";
 import { NodeTypeCategory, type NodeTypeConfig } from "../../helper/model.js";
 import { getQueryStatementsByCategories } from "../../helper/helper.js";
 import {
@@ -8,7 +7,12 @@ import {
     SimpleLanguageSpecificQueryStatement,
 } from "../queries/query-statements.js";
 import { Language } from "../../helper/language.js";
-import { type MetricName, type Metric, type MetricResult, type ParsedFile } from "./metric.js";
+import {
+    getQueryMatches,
+    type MetricQueryResult,
+    type QueryMetric,
+} from "../queries/metric-query-engine.js";
+import { type MetricName, type MetricResult, type ParsedFile } from "./metric.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
@@ -18,7 +22,7 @@ let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
  * Calculates the number of comment lines.
  * Includes also empty comment lines, etc.
  */
-export class CommentLines implements Metric {
+export class CommentLines implements QueryMetric {
     readonly #statementsSuperSet: QueryStatement[] = [];
 
     /**
@@ -33,14 +37,17 @@ export class CommentLines implements Metric {
         this.#addQueriesForPython();
     }
 
-    calculate(parsedFile: ParsedFile): MetricResult {
-        const captures = this.getQueryCapturesFrom(parsedFile);
+    getQueryStatements(): QueryStatement[] {
+        return this.#statementsSuperSet;
+    }
+
+    calculate(parsedFile: ParsedFile, queryResult?: MetricQueryResult): MetricResult {
+        const commentNodes = getCommentNodes(getQueryMatches(this, parsedFile, queryResult));
 
         let numberOfLines = 0;
         let lastCommentLine = -1;
 
-        for (const capture of captures) {
-            const captureNode = capture.node;
+        for (const captureNode of commentNodes) {
             const startRow = captureNode.startPosition.row;
             const endRow = captureNode.endPosition.row;
             // If we have not already counted for a comment on the same line:
@@ -63,21 +70,6 @@ export class CommentLines implements Metric {
         };
     }
 
-    getQueryCapturesFrom(parsedFile: ParsedFile): QueryCapture[] {
-        const { language, tree } = parsedFile;
-        const queryBuilder = new QueryBuilder(language);
-
-        queryBuilder.addStatements(this.#statementsSuperSet);
-
-        const query = queryBuilder.build();
-        let queryCaptures: QueryCapture[] = [];
-        if (query !== undefined) {
-            queryCaptures = query.captures(tree.rootNode);
-        }
-
-        return queryCaptures;
-    }
-
     getName(): MetricName {
         return "comment_lines";
     }
@@ -91,3 +83,20 @@ export class CommentLines implements Metric {
         );
     }
 }
+
+/**
+ * Returns the comment nodes captured by the specified matches of the comment query statements,
+ * in the order of their position in the file.
+ * @param matches Matches of the comment query statements.
+ */
+export function getCommentNodes(matches: QueryMatch[]): SyntaxNode[] {
+    const nodes: SyntaxNode[] = [];
+    for (const match of matches) {
+        for (const capture of match.captures) {
+            nodes.push(capture.node);
+        }
+    }
+
+    // Matches are not necessarily ordered by the position of their captures:
+    return nodes.sort((a, b) => a.startIndex - b.startIndex);
+}
@@ -1,7 +1,10 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
-import { type QueryMatch } from "tree-sitter";
 import { type NodeTypeConfig, NodeTypeCategory } from "../../helper/model.js";
-import { QueryBuilder } from "../queries/query-builder.js";
+import {
+    getQueryMatchCount,
+    type MetricQueryResult,
+    type QueryMetric,
+} from "../queries/metric-query-engine.js";
 import {
     NodeTypeQueryStatement,
     OperatorQueryStatement,
@@ -10,15 +13,19 @@ import {
     SimpleQueryStatement,
 } from "../queries/query-statements.js";
 import { Language } from "../../helper/language.js";
-import { type MetricName, type Metric, type MetricResult, type ParsedFile } from "./metric.js";
+import { type MetricName, type MetricResult, type ParsedFile } from "./metric.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
 });
 
-export class Complexity implements Metric {
+export class Complexity implements QueryMetric {
+    readonly countsMatchesOnly = true;
+
     private readonly complexityStatementsSuperSet: QueryStatement[] = [];
 
+    private readonly javaStatements: QueryStatement[];
+
     private readonly nodeTypeCategories = new Set([
         NodeTypeCategory.If,
         NodeTypeCategory.Loop,
@@ -60,6 +67,12 @@ export class Complexity implements Metric {
 
         this.addCaseLabelQueryStatements(caseNodeTypes, languagesWithDefaultLabel);
         this.addQueriesForCSharp();
+
+        this.javaStatements = [
+            ...this.complexityStatementsSuperSet,
+            // Add query for instance init block in Java
+            new SimpleQueryStatement("(class_body (block)) @initBlock"),
+        ];
     }
 
     addBinaryExpressionQueryStatement(nodeType: NodeTypeConfig): void {
@@ -193,31 +206,18 @@ export class Complexity implements Metric {
         );
     }
 
-    calculate(parsedFile: ParsedFile): MetricResult {
-        const { language, tree } = parsedFile;
-        const queryBuilder = new QueryBuilder(language);
-
-        if (language === Language.Java) {
-            // Add query for instance init block in Java
-            queryBuilder.addStatements([
-                ...this.complexityStatementsSuperSet,
-                new SimpleQueryStatement("(class_body (block)) @initBlock"),
-            ]);
-        } else {
-            queryBuilder.addStatements(this.complexityStatementsSuperSet);
-        }
+    getQueryStatements(language: Language): QueryStatement[] {
+        return language === Language.Java ? this.javaStatements : this.complexityStatementsSuperSet;
+    }
 
-        const query = queryBuilder.build();
-        let matches: QueryMatch[] = [];
-        if (query !== undefined) {
-            matches = query.matches(tree.rootNode);
-        }
+    calculate(parsedFile: ParsedFile, queryResult?: MetricQueryResult): MetricResult {
+        const matchCount = getQueryMatchCount(this, parsedFile, queryResult);
 
-        dlog(this.getName() + " - " + matches.length.toString());
+        dlog(this.getName() + " - " + matchCount.toString());
 
         return {
             metricName: this.getName(),
-            metricValue: matches.length,
+            metricValue: matchCount,
         };
     }
 
@@ -2,9 +2,36 @@ import { describe, expect, it } from "vitest";
 import { type Relationship } from "../metric.js";
 import { type CallExpression } from "../../resolver/call-expressions/abstract-collector.js";
 import { type Accessor } from "../../resolver/accessors/abstract-collector.js";
-import { getRelationshipsFromCallExpressions } from "./call-expression-resolver.js";
+import { type TypeInfo } from "../../resolver/types/abstract-collector.js";
+import { getRelationshipsFromCallExpressions, getTypeNames } from "./call-expression-resolver.js";
+import { SymbolTable } from "./symbol-table.js";
+import { IdPairSet, type InternedRelationship } from "./interning.js";
 
 describe("CallExpressionResolver", () => {
+    function intern(relationship: Relationship, symbolTable: SymbolTable): InternedRelationship {
+        return {
+            fromType: symbolTable.typeNames.intern(relationship.fromFQTN),
+            toType: symbolTable.typeNames.intern(relationship.toFQTN),
+            fromFile: symbolTable.files.intern(relationship.fromFile),
+            toFile: symbolTable.files.intern(relationship.toFile),
+            fromTypeName: relationship.fromTypeName,
+            toTypeName: relationship.toTypeName,
+            usageType: relationship.usageType,
+        };
+    }
+
+    function resolve(relationship: InternedRelationship, symbolTable: SymbolTable): Relationship {
+        return {
+            fromFQTN: symbolTable.typeNames.get(relationship.fromType),
+            toFQTN: symbolTable.typeNames.get(relationship.toType),
+            fromFile: symbolTable.files.get(relationship.fromFile),
+            toFile: symbolTable.files.get(relationship.toFile),
+            fromTypeName: relationship.fromTypeName,
+            toTypeName: relationship.toTypeName,
+            usageType: relationship.usageType,
+        };
+    }
+
     describe("resolves call expressions and retrieves additional and transitive relationships", () => {
         it("when call expressions with save calls, public accessors and the right dependencies are given", () => {
             const firstItem: Relationship = {
@@ -37,11 +64,14 @@ describe("CallExpressionResolver", () => {
                 usageType: "usage",
             };
 
-            const dependencyTree = new Map<string, Relationship[]>();
-            dependencyTree.set(firstItem.fromFile, [firstItem]);
-            dependencyTree.set(secondItem.fromFile, [secondItem]);
-            dependencyTree.set(thirdItem.fromFile, [thirdItem]);
-            dependencyTree.set(thirdItem.toFile, []);
+            const symbolTable = new SymbolTable();
+            const dependencyTree = new Map<number, InternedRelationship[]>();
+            for (const relationship of [firstItem, secondItem, thirdItem]) {
+                const internedRelationship = intern(relationship, symbolTable);
+                dependencyTree.set(internedRelationship.fromFile, [internedRelationship]);
+            }
+
+            dependencyTree.set(symbolTable.files.intern(thirdItem.toFile), []);
 
             const callExpression1: CallExpression = {
                 qualifiedName:
@@ -56,8 +86,11 @@ describe("CallExpressionResolver", () => {
                 variableNameIncluded: true,
             };
 
-            const unresolvedCallExpressions = new Map<string, CallExpression[]>();
-            unresolvedCallExpressions.set(firstItem.fromFile, [callExpression1, callExpression2]);
+            const unresolvedCallExpressions = new Map<number, CallExpression[]>();
+            unresolvedCallExpressions.set(symbolTable.files.intern(firstItem.fromFile), [
+                callExpression1,
+                callExpression2,
+            ]);
 
             const accessor1: Accessor = {
                 FullyQualifiedAccessorName: "SecondItemNamespace.SecondItem",
@@ -92,15 +125,120 @@ describe("CallExpressionResolver", () => {
             const publicAccessors = new Map<string, Accessor[]>();
             publicAccessors.set(accessor1.name, [accessor1]);
             publicAccessors.set(accessor2.name, [accessor2]);
+            symbolTable.addAccessors(publicAccessors);
 
             const additionalRelationships = getRelationshipsFromCallExpressions(
                 dependencyTree,
                 unresolvedCallExpressions,
-                publicAccessors,
-                new Set<string>(),
+                symbolTable,
+                new IdPairSet(),
             );
 
-            expect(additionalRelationships).toMatchSnapshot();
+            expect(
+                additionalRelationships.map((relationship) => resolve(relationship, symbolTable)),
+            ).toMatchSnapshot();
+        });
+
+        it("when the return type of an accessor contains a type name only as part of a longer name", () => {
+            const symbolTable = new SymbolTable();
+            const relationship = (
+                fromFile: string,
+                from: string,
+                toFile: string,
+                to: string,
+            ): InternedRelationship =>
+                intern(
+                    {
+                        fromFQTN: "App." + from,
+                        toFQTN: "App." + to,
+                        fromFile,
+                        toFile,
+                        fromTypeName: from,
+                        toTypeName: to,
+                        usageType: "usage",
+                    },
+                    symbolTable,
+                );
+
+            const dependencyTree = new Map<number, InternedRelationship[]>();
+            const usage = relationship("Caller.cs", "Caller", "Service.cs", "Service");
+            dependencyTree.set(usage.fromFile, [usage]);
+            const serviceDependencies = [
+                relationship("Service.cs", "Service", "MyType.cs", "MyType"),
+                relationship("Service.cs", "Service", "MyTypeNumberOne.cs", "MyTypeNumberOne"),
+            ];
+            dependencyTree.set(serviceDependencies[0].fromFile, serviceDependencies);
+
+            const service: TypeInfo = {
+                namespace: "App",
+                typeName: "Service",
+                classType: "class",
+                sourceFile: "Service.cs",
+                namespaceDelimiter: ".",
+                implementedFrom: [],
+            };
+            symbolTable.addAccessors(
+                new Map([
+                    [
+                        "GetItems",
+                        [
+                            {
+                                name: "GetItems",
+                                FullyQualifiedAccessorName: "App.Service.GetItems",
+                                fromType: service,
+                                filePath: "Service.cs",
+                                returnType: "List<MyTypeNumberOne>",
+                            },
+                        ],
+                    ],
+                ]),
+            );
+
+            const additionalRelationships = getRelationshipsFromCallExpressions(
+                dependencyTree,
+                new Map([
+                    [
+                        usage.fromFile,
+                        [
+                            {
+                                qualifiedName: "service.GetItems",
+                                namespaceDelimiter: ".",
+                                variableNameIncluded: true,
+                            },
+                        ],
+                    ],
+                ]),
+                symbolTable,
+                new IdPairSet(),
+            );
+
+            expect(
+                additionalRelationships.map((relationship) => resolve(relationship, symbolTable)),
+            ).toEqual([
+                {
+                    fromFQTN: "App.Caller",
+                    toFQTN: "App.MyTypeNumberOne",
+                    fromFile: "Caller.cs",
+                    toFile: "MyTypeNumberOne.cs",
+                    fromTypeName: "Caller",
+                    toTypeName: "MyTypeNumberOne",
+                    usageType: "usage",
+                },
+            ]);
+        });
+    });
+
+    describe("getTypeNames()", () => {
+        it("should return the distinct names in a type expression", () => {
+            expect(getTypeNames("Map<string, Collection<MyType>>")).toEqual([
+                "Map",
+                "string",
+                "Collection",
+                "MyType",
+            ]);
+            expect(getTypeNames("?\\App\\Models\\User")).toEqual(["App", "Models", "User"]);
+            expect(getTypeNames("Pair<Item, Item>[]")).toEqual(["Pair", "Item"]);
+            expect(getTypeNames("")).toEqual([]);
         });
     });
 });
@@ -1,29 +1,109 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
-import { type Relationship } from "../metric.js";
 import { type Accessor } from "../../resolver/accessors/abstract-collector.js";
 import { type CallExpression } from "../../resolver/call-expressions/abstract-collector.js";
-import { type TypeInfo } from "../../resolver/types/abstract-collector.js";
+import { getFullyQualifiedTypeName, type SymbolTable } from "./symbol-table.js";
+import { type FileId, type IdPairSet, type InternedRelationship, type TypeId } from "./interning.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
 });
 
+type IndexedRelationship = {
+    relationship: InternedRelationship;
+    position: number;
+};
+
+/**
+ * Relationships originating from one file, indexed by the type they point to
+ * and by the simple name of that type, so that they can be looked up in constant time.
+ */
+class FileRelationshipIndex {
+    readonly #firstByToType = new Map<TypeId, InternedRelationship>();
+    readonly #byToTypeName = new Map<string, IndexedRelationship[]>();
+    #size = 0;
+
+    constructor(relationships: Iterable<InternedRelationship> = []) {
+        for (const relationship of relationships) {
+            this.add(relationship);
+        }
+    }
+
+    add(relationship: InternedRelationship): void {
+        if (!this.#firstByToType.has(relationship.toType)) {
+            this.#firstByToType.set(relationship.toType, relationship);
+        }
+
+        const entry = { relationship, position: this.#size++ };
+        const withName = this.#byToTypeName.get(relationship.toTypeName);
+        if (withName === undefined) {
+            this.#byToTypeName.set(relationship.toTypeName, [entry]);
+        } else {
+            withName.push(entry);
+        }
+    }
+
+    /**
+     * Returns the first added relationship to the specified type.
+     */
+    getFirstTo(toType: TypeId): InternedRelationship | undefined {
+        return this.#firstByToType.get(toType);
+    }
+
+    /**
+     * Returns the relationships to types with any of the specified simple names, in the order they were added.
+     */
+    getToTypeNames(typeNames: readonly string[]): InternedRelationship[] {
+        const entries = typeNames.flatMap((typeName) => this.#byToTypeName.get(typeName) ?? []);
+        if (typeNames.length > 1) {
+            entries.sort((first, second) => first.position - second.position);
+        }
+
+        return entries.map(({ relationship }) => relationship);
+    }
+}
+
+/**
+ * Resolves the types returned by the accessors in the call expressions of each file
+ * and returns the relationships to these types that are not already known.
+ * @param fileToRelations Known relationships, by the id of the file they originate from.
+ * @param fileToCallExpressions Call expressions, by the id of the file they are found in.
+ * @param symbolTable Table of all types and accessors, with the interned file paths and type names.
+ * @param alreadyAddedRelationships Pairs of the ids of the target and the source type of all known relationships.
+ * Updated with the returned relationships.
+ */
 export function getRelationshipsFromCallExpressions(
-    fileToRelations: Map<string, Relationship[]>,
-    fileToCallExpressions: Map<string, CallExpression[]>,
-    accessorNameToAccessors: Map<string, Accessor[]>,
-    alreadyAddedRelationships: Set<string>,
-): Relationship[] {
-    const additionalRelationships: Relationship[] = [];
+    fileToRelations: Map<FileId, InternedRelationship[]>,
+    fileToCallExpressions: Map<FileId, CallExpression[]>,
+    symbolTable: SymbolTable,
+    alreadyAddedRelationships: IdPairSet,
+): InternedRelationship[] {
+    const additionalRelationships: InternedRelationship[] = [];
+
+    // The known relationships do not change while resolving, so each file is only indexed once, when needed:
+    const fileIndexes = new Map<FileId, FileRelationshipIndex>();
+    const getFileIndex = (fileId: FileId): FileRelationshipIndex => {
+        let fileIndex = fileIndexes.get(fileId);
+        if (fileIndex === undefined) {
+            fileIndex = new FileRelationshipIndex(fileToRelations.get(fileId));
+            fileIndexes.set(fileId, fileIndex);
+        }
+
+        return fileIndex;
+    };
+
+    // The same accessors are looked up again and again, so their type ids and return type names are cached:
+    const accessorTypeIds = new Map<Accessor, TypeId | undefined>();
+    const returnTypeNamesCache = new Map<string, string[]>();
 
-    for (const [filePath, callExpressions] of fileToCallExpressions) {
-        const fileDependencies = fileToRelations.get(filePath) ?? [];
+    for (const [fileId, callExpressions] of fileToCallExpressions) {
+        const fileDependencies = getFileIndex(fileId);
 
-        dlog("RESOLVING:", fileDependencies);
+        dlog("RESOLVING:", fileToRelations.get(fileId));
 
         const processedCallExpressions = new Set<string>();
 
-        const fileAdditionalRelationships: Relationship[] = [];
+        const fileAdditionalRelationships: InternedRelationship[] = [];
+        const fileAdditionalRelationshipIndex = new FileRelationshipIndex();
 
         for (const callExpression of callExpressions) {
             if (processedCallExpressions.has(callExpression.qualifiedName)) {
@@ -45,21 +125,16 @@ export function getRelationshipsFromCallExpressions(
                     namePart = namePart.slice(0, Math.max(0, namePart.length - 1));
                 }
 
-                const allAccessorsByNamePart = getAccessorsByName(
-                    namePart,
-                    accessorNameToAccessors,
-                );
+                const allAccessorsByNamePart = symbolTable.getAccessors(namePart);
 
                 if (allAccessorsByNamePart === undefined) continue;
 
                 dlog(
-                    "CLONED_ACCESSORS",
+                    "ACCESSORS",
                     namePart,
-                    filePath,
+                    symbolTable.files.get(fileId),
                     allAccessorsByNamePart.length,
-                    fileDependencies,
                 );
-                dlog(allAccessorsByNamePart.toString());
 
                 let added;
 
@@ -67,47 +142,49 @@ export function getRelationshipsFromCallExpressions(
                     const type = accessor.fromType;
                     if (!type) continue;
 
-                    const typeCandidateFQN =
-                        type.namespace + type.namespaceDelimiter + type.typeName;
+                    if (!accessorTypeIds.has(accessor)) {
+                        // Types that were never interned are not part of any relationship:
+                        accessorTypeIds.set(
+                            accessor,
+                            symbolTable.typeNames.getId(getFullyQualifiedTypeName(type)),
+                        );
+                    }
 
-                    dlog("\n\n", accessor, " -- ", typeCandidateFQN);
+                    const typeCandidateId = accessorTypeIds.get(accessor);
+                    if (typeCandidateId === undefined) continue;
+
+                    dlog("\n\n", accessor, " -- ", symbolTable.typeNames.get(typeCandidateId));
 
                     // FirstAccessor is a property or method
-                    // The type of myVariable must be an already added dependency of the current base type/class (filePath),
+                    // The type of myVariable must be an already added dependency of the current base type/class (fileId),
                     // so that subsequent method calls or attribute accesses can be resolved.
                     // Example:
                     // myVariable.FirstAccessor.SecondAccessor.ThirdAccessor
-                    const baseDependency = fileDependencies.find((relationship) => {
-                        return relationship.toFQTN === typeCandidateFQN;
-                    });
-
                     // In case of chained accesses, look in dependencies added for previous chain elements:
                     // e.g. look up already added dependency of return type of FirstAccessor to resolve SecondAccessor
-                    // myVariable.FirstAccessor.SecondAccessor.ThirdAccessor
-                    const callExpressionDependency = fileAdditionalRelationships.find(
-                        (dependency) => {
-                            return dependency.toFQTN === typeCandidateFQN;
-                        },
-                    );
-
-                    if (baseDependency !== undefined) {
-                        added = resolveAccessorReturnType(
-                            baseDependency,
+                    const matchingDependency =
+                        fileDependencies.getFirstTo(typeCandidateId) ??
+                        fileAdditionalRelationshipIndex.getFirstTo(typeCandidateId);
+
+                    if (matchingDependency !== undefined) {
+                        let returnTypeNames = returnTypeNamesCache.get(accessor.returnType);
+                        if (returnTypeNames === undefined) {
+                            returnTypeNames = getTypeNames(accessor.returnType);
+                            returnTypeNamesCache.set(accessor.returnType, returnTypeNames);
+                        }
+
+                        const addedRelationship = resolveAccessorReturnType(
+                            matchingDependency,
                             accessor,
-                            accessor.filePath,
-                            fileToRelations,
-                            fileAdditionalRelationships,
-                            alreadyAddedRelationships,
-                        );
-                    } else if (callExpressionDependency !== undefined) {
-                        added = resolveAccessorReturnType(
-                            callExpressionDependency,
-                            accessor,
-                            accessor.filePath,
-                            fileToRelations,
-                            fileAdditionalRelationships,
+                            returnTypeNames,
+                            getFileIndex(symbolTable.files.getId(accessor.filePath)!),
                             alreadyAddedRelationships,
                         );
+                        if (addedRelationship !== undefined) {
+                            fileAdditionalRelationships.push(addedRelationship);
+                            fileAdditionalRelationshipIndex.add(addedRelationship);
+                            added = true;
+                        }
                     }
 
                     if (added) {
@@ -127,25 +204,23 @@ export function getRelationshipsFromCallExpressions(
     return additionalRelationships;
 }
 
-function getAccessorsByName(
-    name: FullyQualifiedName,
-    fromAccessors: Map<string, Accessor[]>,
-): Accessor[] | undefined {
-    const accessorForNamePart = fromAccessors.get(name);
-
-    if (accessorForNamePart === undefined) return undefined;
-
-    return [...accessorForNamePart];
+/**
+ * Splits a type expression into the names it consists of, without duplicates.
+ * E.g. the names in "Map<string, Collection<MyType>>" are Map, string, Collection and MyType.
+ */
+export function getTypeNames(typeExpression: string): string[] {
+    const typeNames = new Set(typeExpression.split(/[^\p{L}\p{N}_]+/u));
+    typeNames.delete("");
+    return [...typeNames];
 }
 
 function resolveAccessorReturnType(
-    matchingDependency: Relationship,
+    matchingDependency: InternedRelationship,
     accessor: Accessor,
-    accessorFilePath: FilePath,
-    fileToRelationships: Map<string, Relationship[]>,
-    additionalRelationships: Relationship[],
-    alreadyAddedRelationships: Set<string>,
-): number {
+    returnTypeNames: readonly string[],
+    accessorFileRelationships: FileRelationshipIndex,
+    alreadyAddedRelationships: IdPairSet,
+): InternedRelationship | undefined {
     // TODO resolve return type (generics, etc.)
     dlog(
         "Lookup Status: ",
@@ -156,52 +231,40 @@ function resolveAccessorReturnType(
         "\n\n",
     );
 
-    const relationshipsFromAccessorFile = fileToRelationships.get(accessorFilePath) ?? [];
-    dlog("namespace.source", accessorFilePath);
-    dlog("accessorFileDependencies", relationshipsFromAccessorFile);
-    for (const relationship of relationshipsFromAccessorFile) {
-        // TODO Imagine that returnType is MyTypeNumberOne
-        //  and toTypeName MyType
-        //  This would lead to a wrong dependency
-        // Substring search using includes() is used because Return Types can look very differently:
-        // Collection<MyTypeNumberOne>
-        // Map<string, MyTypeNumberOne>
-        // etc.
-        if (accessor.returnType.includes(relationship.toTypeName)) {
-            const uniqueId = relationship.toFQTN + matchingDependency.fromFQTN;
-
-            if (alreadyAddedRelationships.has(uniqueId)) {
-                dlog(
-                    "SKIP ADDING RETURN TYPE: ",
-                    accessor.returnType,
-                    "already added: ",
-                    relationship,
-                    alreadyAddedRelationships.has(uniqueId),
-                    "\n\n",
-                );
-                continue;
-            }
-
-            if (matchingDependency.fromFQTN !== relationship.toFQTN) {
-                alreadyAddedRelationships.add(uniqueId);
-
-                const dependencyClone: Relationship = {
-                    fromFQTN: matchingDependency.fromFQTN,
-                    fromFile: matchingDependency.fromFile,
-                    fromTypeName: matchingDependency.fromTypeName,
-                    toTypeName: relationship.toTypeName,
-                    toFQTN: relationship.toFQTN,
-                    toFile: relationship.toFile,
-                    usageType: "usage",
-                };
-
-                dlog("ADD RETURN TYPE: ", accessor.returnType, dependencyClone, "\n\n");
-                return additionalRelationships.push(dependencyClone);
-            }
+    dlog("namespace.source", accessor.filePath);
+    // Return types can look very differently, e.g. Collection<MyTypeNumberOne> or Map<string, MyTypeNumberOne>.
+    // So the relationships to all types named in the return type are considered, in the order they were found.
+    for (const relationship of accessorFileRelationships.getToTypeNames(returnTypeNames)) {
+        if (alreadyAddedRelationships.has(relationship.toType, matchingDependency.fromType)) {
+            dlog(
+                "SKIP ADDING RETURN TYPE: ",
+                accessor.returnType,
+                "already added: ",
+                relationship,
+                "\n\n",
+            );
+            continue;
+        }
 
-            return 0;
+        if (matchingDependency.fromType !== relationship.toType) {
+            alreadyAddedRelationships.add(relationship.toType, matchingDependency.fromType);
+
+            const dependencyClone: InternedRelationship = {
+                fromType: matchingDependency.fromType,
+                fromFile: matchingDependency.fromFile,
+                fromTypeName: matchingDependency.fromTypeName,
+                toTypeName: relationship.toTypeName,
+                toType: relationship.toType,
+                toFile: relationship.toFile,
+                usageType: "usage",
+            };
+
+            dlog("ADD RETURN TYPE: ", accessor.returnType, dependencyClone, "\n\n");
+            return dependencyClone;
         }
+
+        return undefined;
     }
 
-    return 0;
+    return undefined;
 }
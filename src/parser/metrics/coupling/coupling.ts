@@ -1,3 +1,4 @@
+import path from "node:path";
 import { debuglog, type DebugLoggerFunction } from "node:util";
 import { type TypeInfo } from "../../resolver/types/abstract-collector.js";
 import {
@@ -8,7 +9,6 @@ import { type TypeCollector } from "../../resolver/type-collector.js";
 import { type UsagesCollector } from "../../resolver/usages-collector.js";
 import {
     type CouplingMetric,
-    type Relationship,
     type ParsedFile,
     type CouplingMetrics,
     type CouplingResult,
@@ -19,17 +19,41 @@ import { type PublicAccessorCollector } from "../../resolver/public-accessor-col
 import { type Accessor } from "../../resolver/accessors/abstract-collector.js";
 import { type Configuration } from "../../configuration.js";
 import { getRelationshipsFromCallExpressions } from "./call-expression-resolver.js";
+import { getFullyQualifiedTypeName, SymbolTable } from "./symbol-table.js";
+import {
+    type FileId,
+    IdPairSet,
+    type InternedRelationship,
+    InterningTable,
+} from "./interning.js";
+import { DependencyGraph } from "./dependency-graph.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
 });
+/**
+ * Types declared in a single file, their public accessors and the usages of other types in the file.
+ * Extracted from the syntax tree of the file, but does not reference it.
+ * Consists of plain data only, so it can be cached and passed between threads.
+ * The imports of the file are already resolved into the usage candidates.
+ */
+export type FileCouplingData = {
+    filePath: string;
+    types: Map<FullyQualifiedName, TypeInfo>;
+    accessors: Map<string, Accessor[]>;
+    usageCandidates: UsageCandidate[];
+    callExpressions: CallExpression[];
+};
+
 export class Coupling implements CouplingMetric {
-    private readonly alreadyAddedRelationships = new Set<string>();
+    /**
+     * Pairs of the ids of the target and the source type of all relationships found so far.
+     */
+    private readonly alreadyAddedRelationships = new IdPairSet();
 
-    private typesMap = new Map<FullyQualifiedName, TypeInfo>();
-    private readonly accessorsMap = new Map<string, Accessor[]>();
-    private readonly usageCandidates: UsageCandidate[] = [];
-    private readonly callExpressions = new Map<string, CallExpression[]>();
+    private readonly symbolTable = new SymbolTable();
+    private readonly usageCandidates = new Map<FileId, UsageCandidate[]>();
+    private readonly callExpressions = new Map<FileId, CallExpression[]>();
 
     constructor(
         private readonly config: Configuration,
@@ -38,43 +62,53 @@ export class Coupling implements CouplingMetric {
         private readonly accessorCollector: PublicAccessorCollector,
     ) {}
 
-    processFile(parsedFile: ParsedFile): void {
-        const typesFromFile: Map<FullyQualifiedName, TypeInfo> =
-            this.typeCollector.getTypesFromFile(parsedFile);
-        this.typesMap = new Map([...this.typesMap, ...typesFromFile]);
-
-        const accessorsFromFile = this.accessorCollector.getAccessorsFromFile(
+    extract(parsedFile: ParsedFile): FileCouplingData {
+        const typeDeclarations = this.typeCollector.getTypesFromFile(parsedFile);
+        const accessors = this.accessorCollector.getAccessorsFromFile(parsedFile, typeDeclarations);
+        const { usageCandidates, callExpressions } = this.usageCollector.getUsageCandidates(
             parsedFile,
-            typesFromFile,
+            typeDeclarations,
         );
-        for (const [accessorName, accessors] of accessorsFromFile) {
-            if (this.accessorsMap.get(accessorName) === undefined) {
-                this.accessorsMap.set(accessorName, accessors);
-            } else {
-                this.accessorsMap.get(accessorName)!.push(...accessors);
-            }
+
+        // The syntax nodes of the types are only needed to collect the accessors and usages from this file.
+        // Keep only the plain type information, so that the data does not reference the syntax tree of the file:
+        const types = new Map<FullyQualifiedName, TypeInfo>();
+        for (const [fqtn, { typeInfo }] of typeDeclarations) {
+            types.set(fqtn, typeInfo);
         }
 
-        const { usageCandidates, callExpressions } = this.usageCollector.getUsageCandidates(
-            parsedFile,
-            typesFromFile,
-        );
-        this.usageCandidates.push(...usageCandidates);
-        this.callExpressions.set(parsedFile.filePath, callExpressions);
+        return {
+            filePath: parsedFile.filePath,
+            types,
+            accessors,
+            usageCandidates,
+            callExpressions,
+        };
+    }
+
+    add(fileData: FileCouplingData): void {
+        this.symbolTable.addTypes(fileData.types);
+        this.symbolTable.addAccessors(fileData.accessors);
+
+        // All usages in a file originate from the file, so they are stored by its id:
+        const fileId = this.symbolTable.files.intern(fileData.filePath);
+        const filePath = this.symbolTable.files.get(fileId);
+        for (const usageCandidate of fileData.usageCandidates) {
+            usageCandidate.sourceOfUsing = filePath;
+        }
+
+        this.usageCandidates.set(fileId, fileData.usageCandidates);
+        this.callExpressions.set(fileId, fileData.callExpressions);
     }
 
     calculate(): CouplingResult {
         dlog("\n\n");
-        dlog("namespaces", this.typesMap, "\n\n");
+        dlog("namespaces", this.symbolTable.types, "\n\n");
         dlog("usages", this.usageCandidates);
         dlog("\n\n", "unresolved call expressions", this.callExpressions, "\n\n");
-        dlog("\n\n", "publicAccessors", this.accessorsMap, "\n\n");
+        dlog("\n\n", "publicAccessors", this.symbolTable.accessors, "\n\n");
 
-        const relationships = this.getRelationships(
-            this.typesMap,
-            this.usageCandidates,
-            this.accessorsMap,
-        );
+        const relationships = this.getRelationships();
         dlog("\n\n", relationships);
 
         const tree = this.buildDependencyTree(relationships);
@@ -82,94 +116,109 @@ export class Coupling implements CouplingMetric {
         const additionalRelationships = getRelationshipsFromCallExpressions(
             tree,
             this.callExpressions,
-            this.accessorsMap,
+            this.symbolTable,
             this.alreadyAddedRelationships,
         );
         relationships.push(...additionalRelationships);
         dlog("\n\n", "additionalRelationships", additionalRelationships, "\n\n");
 
-        const couplingMetrics = this.calculateCouplingMetrics(relationships);
+        const { graph, files } = this.buildFileDependencyGraph(relationships);
+        const couplingMetrics = this.calculateCouplingMetrics(graph, files);
+        const directoryMetrics = this.config.directoryCoupling
+            ? this.calculateDirectoryCouplingMetrics(graph, files)
+            : undefined;
 
-        return this.formatPrintedPaths(relationships, couplingMetrics);
+        return this.formatPrintedPaths(relationships, couplingMetrics, directoryMetrics);
     }
 
     getName(): MetricName {
         return "coupling";
     }
 
-    private getRelationships(
-        types: Map<FullyQualifiedName, TypeInfo>,
-        usageCandidates: UsageCandidate[],
-        accessorNameToAccessor: Map<string, Accessor[]>,
-    ): Relationship[] {
-        return usageCandidates.flatMap((usageCandidate) => {
-            const usedNamespaceSource = types.get(usageCandidate.usedNamespace);
-            const fromNamespaceSource = types.get(usageCandidate.fromNamespace);
-            const uniqueId = usageCandidate.usedNamespace + usageCandidate.fromNamespace;
-
-            const matchingPublicAccessors = accessorNameToAccessor.get(usageCandidate.usedName);
-
-            if (
-                usedNamespaceSource !== undefined &&
-                fromNamespaceSource !== undefined &&
-                !this.alreadyAddedRelationships.has(uniqueId) &&
-                usageCandidate.fromNamespace !== usageCandidate.usedNamespace
-            ) {
-                this.alreadyAddedRelationships.add(uniqueId);
-
-                // In C# we do not know if a base class is implemented or just extended
-                // But if class type is interface, then it must be implemented instead of extended
-                const fixedUsageType =
-                    usageCandidate.usageType === "implements" &&
-                    usedNamespaceSource.classType !== "interface"
-                        ? "extends"
-                        : usageCandidate.usageType;
-
-                return [
-                    {
-                        fromFQTN: usageCandidate.fromNamespace,
-                        toFQTN: usageCandidate.usedNamespace,
-                        fromFile: usageCandidate.sourceOfUsing,
-                        toFile: usedNamespaceSource.sourceFile,
-                        fromTypeName: fromNamespaceSource.typeName,
-                        toTypeName: usedNamespaceSource.typeName,
-                        usageType: fixedUsageType,
-                    },
-                ];
+    private getRelationships(): InternedRelationship[] {
+        const relationships: InternedRelationship[] = [];
+        for (const [fileId, usageCandidates] of this.usageCandidates) {
+            for (const usageCandidate of usageCandidates) {
+                const relationship = this.getRelationship(fileId, usageCandidate);
+                if (relationship !== undefined) {
+                    relationships.push(relationship);
+                }
             }
+        }
 
-            if (
-                matchingPublicAccessors !== undefined &&
-                fromNamespaceSource !== undefined &&
-                !this.alreadyAddedRelationships.has(uniqueId)
-            ) {
-                for (const accessor of matchingPublicAccessors) {
-                    if (usageCandidate.usedNamespace === accessor.FullyQualifiedAccessorName) {
-                        this.alreadyAddedRelationships.add(uniqueId);
-                        return [
-                            {
-                                fromFQTN: usageCandidate.fromNamespace,
-                                toFQTN:
-                                    accessor.fromType.namespace +
-                                    accessor.fromType.namespaceDelimiter +
-                                    accessor.fromType.typeName,
-                                fromFile: usageCandidate.sourceOfUsing,
-                                toFile: accessor.filePath,
-                                fromTypeName: fromNamespaceSource.typeName,
-                                toTypeName: accessor.name,
-                                usageType: "usage",
-                            },
-                        ];
-                    }
-                }
+        return relationships;
+    }
+
+    private getRelationship(
+        fileId: FileId,
+        usageCandidate: UsageCandidate,
+    ): InternedRelationship | undefined {
+        const { files, typeNames } = this.symbolTable;
+
+        const fromNamespaceSource = this.symbolTable.getType(usageCandidate.fromNamespace);
+        if (fromNamespaceSource === undefined) {
+            return undefined;
+        }
+
+        // Declared types are interned when they are added to the symbol table:
+        const fromType = typeNames.getId(usageCandidate.fromNamespace)!;
+        const usedNamespaceId = typeNames.getId(usageCandidate.usedNamespace);
+        if (
+            usedNamespaceId !== undefined &&
+            this.alreadyAddedRelationships.has(usedNamespaceId, fromType)
+        ) {
+            return undefined;
+        }
+
+        const usedNamespaceSource = this.symbolTable.getType(usageCandidate.usedNamespace);
+        if (usedNamespaceSource !== undefined && usedNamespaceId !== fromType) {
+            this.alreadyAddedRelationships.add(usedNamespaceId!, fromType);
+
+            // In C# we do not know if a base class is implemented or just extended
+            // But if class type is interface, then it must be implemented instead of extended
+            const fixedUsageType =
+                usageCandidate.usageType === "implements" &&
+                usedNamespaceSource.classType !== "interface"
+                    ? "extends"
+                    : usageCandidate.usageType;
+
+            return {
+                fromType,
+                toType: usedNamespaceId!,
+                fromFile: fileId,
+                toFile: files.getId(usedNamespaceSource.sourceFile)!,
+                fromTypeName: fromNamespaceSource.typeName,
+                toTypeName: usedNamespaceSource.typeName,
+                usageType: fixedUsageType,
+            };
+        }
+
+        const matchingPublicAccessors = this.symbolTable.getAccessors(usageCandidate.usedName);
+        for (const accessor of matchingPublicAccessors ?? []) {
+            if (usageCandidate.usedNamespace === accessor.FullyQualifiedAccessorName) {
+                this.alreadyAddedRelationships.add(
+                    typeNames.intern(usageCandidate.usedNamespace),
+                    fromType,
+                );
+                return {
+                    fromType,
+                    toType: typeNames.intern(getFullyQualifiedTypeName(accessor.fromType)),
+                    fromFile: fileId,
+                    toFile: files.getId(accessor.filePath)!,
+                    fromTypeName: fromNamespaceSource.typeName,
+                    toTypeName: accessor.name,
+                    usageType: "usage",
+                };
             }
+        }
 
-            return [];
-        });
+        return undefined;
     }
 
-    private buildDependencyTree(relationships: Relationship[]): Map<string, Relationship[]> {
-        const tree = new Map<string, Relationship[]>();
+    private buildDependencyTree(
+        relationships: InternedRelationship[],
+    ): Map<FileId, InternedRelationship[]> {
+        const tree = new Map<FileId, InternedRelationship[]>();
         for (const relation of relationships) {
             const treeItem = tree.get(relation.fromFile);
             if (treeItem === undefined) {
@@ -182,108 +231,167 @@ export class Coupling implements CouplingMetric {
         return tree;
     }
 
-    private calculateCouplingMetrics(
-        relationships: Relationship[],
-    ): Map<FilePath, CouplingMetrics> {
-        const couplingValues = new Map<FilePath, CouplingMetrics>();
-        const outgoingDependenciesByFile = new Map<FilePath, Set<FullyQualifiedName>>();
-        const incomingDependenciesByFile = new Map<FilePath, Set<FullyQualifiedName>>();
-
-        for (const relationship of relationships) {
-            const { fromFile, toFile } = relationship;
-
-            this.addNewCouplingMetricIfNotExists(couplingValues, fromFile);
-            this.addNewCouplingMetricIfNotExists(couplingValues, toFile);
-
-            this.updateDependency(outgoingDependenciesByFile, fromFile, toFile);
-            this.updateDependency(incomingDependenciesByFile, toFile, fromFile);
-        }
+    /**
+     * Builds the graph of the dependencies between the files, with the file ids as node ids.
+     * @return The graph and the files involved in any relationship, in the order of their first relationship.
+     */
+    private buildFileDependencyGraph(relationships: InternedRelationship[]): {
+        graph: DependencyGraph;
+        files: FileId[];
+    } {
+        const fileCount = this.symbolTable.files.size;
+        const sources = new Uint32Array(relationships.length);
+        const targets = new Uint32Array(relationships.length);
+        const isInvolved = new Uint8Array(fileCount);
+        const files: FileId[] = [];
+        const addInvolvedFile = (file: FileId): void => {
+            if (isInvolved[file] === 0) {
+                isInvolved[file] = 1;
+                files.push(file);
+            }
+        };
 
-        for (const [file, dependencies] of outgoingDependenciesByFile) {
-            couplingValues.get(file)!.outgoing_dependencies = dependencies.size;
+        for (const [index, { fromFile, toFile }] of relationships.entries()) {
+            sources[index] = fromFile;
+            targets[index] = toFile;
+            addInvolvedFile(fromFile);
+            addInvolvedFile(toFile);
         }
 
-        for (const [file, dependencies] of incomingDependenciesByFile) {
-            couplingValues.get(file)!.incoming_dependencies = dependencies.size;
-        }
+        return { graph: DependencyGraph.fromEdges(fileCount, sources, targets), files };
+    }
 
-        for (const couplingValue of couplingValues.values()) {
-            couplingValue.coupling_between_objects =
-                couplingValue.incoming_dependencies + couplingValue.outgoing_dependencies;
-            this.calculateInstability(couplingValue);
+    /**
+     * Calculates the coupling metrics of the specified files.
+     * Files that only have relationships within themselves are included, but have no dependencies.
+     */
+    private calculateCouplingMetrics(
+        graph: DependencyGraph,
+        files: FileId[],
+    ): Map<FileId, CouplingMetrics> {
+        const { componentOfNode, componentSizes } = graph.getStronglyConnectedComponents();
+
+        const couplingValues = new Map<FileId, CouplingMetrics>();
+        for (const file of files) {
+            couplingValues.set(
+                file,
+                getCouplingMetrics(graph, file, componentSizes[componentOfNode[file]]),
+            );
         }
 
         dlog("\n\n", couplingValues);
         return couplingValues;
     }
 
-    private addNewCouplingMetricIfNotExists(
-        couplingValues: Map<string, CouplingMetrics>,
-        filePath: FilePath,
-    ): void {
-        if (!couplingValues.has(filePath)) {
-            couplingValues.set(filePath, {
-                outgoing_dependencies: 0,
-                incoming_dependencies: 0,
-                coupling_between_objects: 0,
-                instability: 0,
-            });
-        }
-    }
-
-    private updateDependency(
-        dependencyByFile: Map<FilePath, Set<FullyQualifiedName>>,
-        thisFile: string,
-        relationFile: string,
-    ): void {
-        if (!dependencyByFile.has(thisFile)) {
-            dependencyByFile.set(thisFile, new Set());
+    /**
+     * Calculates the coupling metrics of the directories containing the specified files,
+     * with the dependencies of all files in a directory combined.
+     * Only the files directly in a directory are counted for it, not those in its subdirectories.
+     */
+    private calculateDirectoryCouplingMetrics(
+        graph: DependencyGraph,
+        files: FileId[],
+    ): Map<string, CouplingMetrics> {
+        const filePaths = this.symbolTable.files;
+        const directories = new InterningTable();
+        const directoryOfFile = new Uint32Array(graph.nodeCount);
+        for (let file = 0; file < graph.nodeCount; file++) {
+            directoryOfFile[file] = directories.intern(path.dirname(filePaths.get(file)));
         }
 
-        if (thisFile !== relationFile) {
-            dependencyByFile.get(thisFile)!.add(relationFile);
+        const directoryGraph = graph.aggregate(directoryOfFile, directories.size);
+        const { componentOfNode, componentSizes } = directoryGraph.getStronglyConnectedComponents();
+
+        const couplingValues = new Map<string, CouplingMetrics>();
+        for (const file of files) {
+            const directory = directoryOfFile[file];
+            const directoryPath = directories.get(directory);
+            if (!couplingValues.has(directoryPath)) {
+                couplingValues.set(
+                    directoryPath,
+                    getCouplingMetrics(
+                        directoryGraph,
+                        directory,
+                        componentSizes[componentOfNode[directory]],
+                    ),
+                );
+            }
         }
-    }
 
-    private calculateInstability(couplingMetrics: CouplingMetrics): void {
-        if (
-            couplingMetrics.outgoing_dependencies === 0 &&
-            couplingMetrics.incoming_dependencies === 0
-        ) {
-            couplingMetrics.instability = 1;
-        } else {
-            couplingMetrics.instability =
-                couplingMetrics.outgoing_dependencies /
-                (couplingMetrics.outgoing_dependencies + couplingMetrics.incoming_dependencies);
-        }
+        return couplingValues;
     }
 
     /**
-     * If specified in the configuration, this replaces all file paths with the correctly formatted file paths
-     * for the json output.
+     * Replaces the ids of the files and types by the file paths and type names for the output.
+     * If specified in the configuration, the file paths are formatted, which is done only once per file.
      * @param relationships Relationships to include in the output.
-     * @param couplingMetrics Coupling metrics to include in the output.
+     * @param couplingMetrics Coupling metrics to include in the output, by file id.
+     * @param directoryMetrics Coupling metrics of the directories to include in the output, by directory path.
      * @return A CouplingResult including the formatted relationships and coupling metrics.
      * @private
      */
     private formatPrintedPaths(
-        relationships: Relationship[],
-        couplingMetrics: Map<string, CouplingMetrics>,
+        relationships: InternedRelationship[],
+        couplingMetrics: Map<FileId, CouplingMetrics>,
+        directoryMetrics: Map<string, CouplingMetrics> | undefined,
     ): CouplingResult {
-        if (this.config.relativePaths) {
-            for (const relationship of relationships) {
-                relationship.fromFile = formatPrintPath(relationship.fromFile, this.config);
-                relationship.toFile = formatPrintPath(relationship.toFile, this.config);
-            }
-
-            const metrics = new Map<string, CouplingMetrics>();
-            for (const [absolutePath, metricValues] of couplingMetrics) {
-                metrics.set(formatPrintPath(absolutePath, this.config), metricValues);
-            }
+        const { files, typeNames } = this.symbolTable;
+        const printedPaths: Array<string | undefined> = [];
+        const getPrintedPath = (fileId: FileId): string =>
+            (printedPaths[fileId] ??= formatPrintPath(files.get(fileId), this.config));
+
+        const metrics = new Map<string, CouplingMetrics>();
+        for (const [fileId, metricValues] of couplingMetrics) {
+            metrics.set(getPrintedPath(fileId), metricValues);
+        }
 
-            couplingMetrics = metrics;
+        const result: CouplingResult = {
+            relationships: relationships.map((relationship) => ({
+                fromFQTN: typeNames.get(relationship.fromType),
+                toFQTN: typeNames.get(relationship.toType),
+                fromFile: getPrintedPath(relationship.fromFile),
+                toFile: getPrintedPath(relationship.toFile),
+                fromTypeName: relationship.fromTypeName,
+                toTypeName: relationship.toTypeName,
+                usageType: relationship.usageType,
+            })),
+            metrics,
+        };
+
+        if (directoryMetrics !== undefined) {
+            result.directoryMetrics = new Map(
+                [...directoryMetrics].map(([directoryPath, metricValues]) => [
+                    formatPrintPath(directoryPath, this.config),
+                    metricValues,
+                ]),
+            );
         }
 
-        return { relationships, metrics: couplingMetrics };
+        return result;
     }
 }
+
+/**
+ * Calculates the coupling metrics of a node of a dependency graph.
+ * @param graph The dependency graph.
+ * @param node The node.
+ * @param componentSize Number of nodes of the strongly connected component of the node.
+ */
+function getCouplingMetrics(
+    graph: DependencyGraph,
+    node: number,
+    componentSize: number,
+): CouplingMetrics {
+    const outgoingDependencies = graph.getOutDegree(node);
+    const incomingDependencies = graph.getInDegree(node);
+    const couplingBetweenObjects = outgoingDependencies + incomingDependencies;
+
+    return {
+        outgoing_dependencies: outgoingDependencies,
+        incoming_dependencies: incomingDependencies,
+        coupling_between_objects: couplingBetweenObjects,
+        instability:
+            couplingBetweenObjects === 0 ? 1 : outgoingDependencies / couplingBetweenObjects,
+        dependency_cycle_size: componentSize > 1 ? componentSize : 0,
+    };
+}
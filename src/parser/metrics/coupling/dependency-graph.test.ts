@@ -0,0 +1,116 @@
+import { describe, expect, it } from "vitest";
+import { DependencyGraph } from "./dependency-graph.js";
+
+function fromEdges(nodeCount: number, edges: Array<[number, number]>): DependencyGraph {
+    return DependencyGraph.fromEdges(
+        nodeCount,
+        edges.map(([source]) => source),
+        edges.map(([, target]) => target),
+    );
+}
+
+/**
+ * Returns the nodes of each component with more than one node, so that the result
+ * does not depend on the order in which the components are found.
+ */
+function getCycles(graph: DependencyGraph): number[][] {
+    const { componentOfNode, componentSizes } = graph.getStronglyConnectedComponents();
+    const nodesOfComponent = new Map<number, number[]>();
+    for (const [node, component] of componentOfNode.entries()) {
+        if (componentSizes[component] > 1) {
+            nodesOfComponent.set(component, [...(nodesOfComponent.get(component) ?? []), node]);
+        }
+    }
+
+    return [...nodesOfComponent.values()].sort((first, second) => first[0] - second[0]);
+}
+
+describe("DependencyGraph", () => {
+    it("should store the dependencies and dependents of each node without duplicates and self-references", () => {
+        const graph = fromEdges(4, [
+            [0, 1],
+            [0, 2],
+            [2, 1],
+            [0, 1],
+            [3, 3],
+            [2, 0],
+        ]);
+
+        expect(graph.edgeCount).toBe(4);
+        expect([...graph.getDependencies(0)]).toEqual([1, 2]);
+        expect([...graph.getDependencies(2)]).toEqual([1, 0]);
+        expect([...graph.getDependents(1)]).toEqual([0, 2]);
+        expect([...graph.getDependents(0)]).toEqual([2]);
+        expect([...graph.getDependencies(3)]).toEqual([]);
+
+        expect(graph.getOutDegree(0)).toBe(2);
+        expect(graph.getInDegree(0)).toBe(1);
+        expect(graph.getOutDegree(1)).toBe(0);
+        expect(graph.getInDegree(1)).toBe(2);
+        expect(graph.getInDegree(3)).toBe(0);
+    });
+
+    it("should reject edges to nodes that do not exist", () => {
+        expect(() => fromEdges(2, [[0, 2]])).toThrow(RangeError);
+    });
+
+    it("should find the strongly connected components", () => {
+        // Two cycles connected by an edge, a chain and a node without any edges:
+        const graph = fromEdges(9, [
+            [0, 1],
+            [1, 2],
+            [2, 0],
+            [2, 3],
+            [3, 4],
+            [4, 3],
+            [5, 6],
+            [6, 7],
+        ]);
+
+        const { componentOfNode, componentSizes } = graph.getStronglyConnectedComponents();
+
+        expect(componentSizes).toHaveLength(6);
+        expect(componentSizes[componentOfNode[0]]).toBe(3);
+        expect(componentSizes[componentOfNode[4]]).toBe(2);
+        expect(componentSizes[componentOfNode[5]]).toBe(1);
+        expect(componentSizes[componentOfNode[8]]).toBe(1);
+        expect(getCycles(graph)).toEqual([
+            [0, 1, 2],
+            [3, 4],
+        ]);
+    });
+
+    it("should find the strongly connected components of long dependency chains without recursing", () => {
+        const nodeCount = 200_000;
+        const edges: Array<[number, number]> = [];
+        for (let node = 0; node + 1 < nodeCount; node++) {
+            edges.push([node, node + 1]);
+        }
+
+        expect(getCycles(fromEdges(nodeCount, edges))).toEqual([]);
+
+        edges.push([nodeCount - 1, 0]);
+        const { componentSizes } = fromEdges(nodeCount, edges).getStronglyConnectedComponents();
+
+        expect([...componentSizes]).toEqual([nodeCount]);
+    });
+
+    it("should aggregate the dependencies of groups of nodes", () => {
+        // Nodes 0 and 1 in group 0, nodes 2 and 3 in group 1, node 4 in group 2:
+        const graph = fromEdges(5, [
+            [0, 1],
+            [0, 2],
+            [1, 3],
+            [3, 4],
+            [4, 0],
+        ]);
+
+        const groupGraph = graph.aggregate([0, 0, 1, 1, 2], 3);
+
+        expect(groupGraph.nodeCount).toBe(3);
+        expect([...groupGraph.getDependencies(0)]).toEqual([1]);
+        expect([...groupGraph.getDependencies(1)]).toEqual([2]);
+        expect([...groupGraph.getDependencies(2)]).toEqual([0]);
+        expect(getCycles(groupGraph)).toEqual([[0, 1, 2]]);
+    });
+});
@@ -0,0 +1,275 @@
+/**
+ * Strongly connected components of a {@link DependencyGraph}.
+ * Nodes that are not part of a cycle form a component of their own.
+ */
+export type StronglyConnectedComponents = {
+    /**
+     * Index of the component of each node.
+     */
+    componentOfNode: Uint32Array;
+    /**
+     * Number of nodes of each component.
+     */
+    componentSizes: Uint32Array;
+};
+
+/**
+ * Marks nodes that are not visited yet, or not assigned to a component yet.
+ */
+const unassigned = 0xff_ff_ff_ff;
+
+/**
+ * Directed graph of the dependencies between nodes identified by the integers from 0 to nodeCount - 1.
+ * The edges are stored in compressed sparse row form in both directions:
+ * the dependencies of node n are dependencies[dependencyOffsets[n]] up to dependencies[dependencyOffsets[n + 1] - 1],
+ * and the dependents are stored the same way. This takes 8 bytes per edge and node, without any per-node objects.
+ * Parallel edges and edges from a node to itself are dropped, so the degrees count distinct other nodes.
+ */
+export class DependencyGraph {
+    readonly nodeCount: number;
+
+    readonly #dependencyOffsets: Uint32Array;
+    readonly #dependencies: Uint32Array;
+    readonly #dependentOffsets: Uint32Array;
+    readonly #dependents: Uint32Array;
+
+    private constructor(nodeCount: number, dependencies: Adjacency, dependents: Adjacency) {
+        this.nodeCount = nodeCount;
+        this.#dependencyOffsets = dependencies.offsets;
+        this.#dependencies = dependencies.neighbours;
+        this.#dependentOffsets = dependents.offsets;
+        this.#dependents = dependents.neighbours;
+    }
+
+    /**
+     * Builds the graph in time linear in the number of nodes and edges.
+     * @param nodeCount Number of nodes.
+     * @param sources Source node of each edge.
+     * @param targets Target node of each edge, at the same position as its source.
+     */
+    static fromEdges(
+        nodeCount: number,
+        sources: ArrayLike<number>,
+        targets: ArrayLike<number>,
+    ): DependencyGraph {
+        const dependencies = buildAdjacency(nodeCount, sources, targets);
+
+        // The dependents are built from the reversed edges that remain after the deduplication:
+        const { offsets, neighbours } = dependencies;
+        const reversedTargets = new Uint32Array(neighbours.length);
+        for (let node = 0; node < nodeCount; node++) {
+            reversedTargets.fill(node, offsets[node], offsets[node + 1]);
+        }
+
+        return new DependencyGraph(
+            nodeCount,
+            dependencies,
+            buildAdjacency(nodeCount, neighbours, reversedTargets),
+        );
+    }
+
+    /**
+     * Number of distinct edges.
+     */
+    get edgeCount(): number {
+        return this.#dependencies.length;
+    }
+
+    /**
+     * Returns the nodes the specified node depends on, as a view on the adjacency array.
+     */
+    getDependencies(node: number): Uint32Array {
+        return this.#dependencies.subarray(
+            this.#dependencyOffsets[node],
+            this.#dependencyOffsets[node + 1],
+        );
+    }
+
+    /**
+     * Returns the nodes that depend on the specified node, as a view on the adjacency array.
+     */
+    getDependents(node: number): Uint32Array {
+        return this.#dependents.subarray(
+            this.#dependentOffsets[node],
+            this.#dependentOffsets[node + 1],
+        );
+    }
+
+    /**
+     * Number of nodes the specified node depends on (fan-out).
+     */
+    getOutDegree(node: number): number {
+        return this.#dependencyOffsets[node + 1] - this.#dependencyOffsets[node];
+    }
+
+    /**
+     * Number of nodes that depend on the specified node (fan-in).
+     */
+    getInDegree(node: number): number {
+        return this.#dependentOffsets[node + 1] - this.#dependentOffsets[node];
+    }
+
+    /**
+     * Finds the strongly connected components with Tarjan's algorithm, in time linear in the number of nodes and edges.
+     * The depth-first search keeps its own stack instead of recursing, so that long dependency chains
+     * do not exceed the call stack.
+     */
+    getStronglyConnectedComponents(): StronglyConnectedComponents {
+        const { nodeCount } = this;
+        const offsets = this.#dependencyOffsets;
+        const dependencies = this.#dependencies;
+
+        const visitIndex = new Uint32Array(nodeCount).fill(unassigned);
+        const lowLink = new Uint32Array(nodeCount);
+        const componentOfNode = new Uint32Array(nodeCount).fill(unassigned);
+        const componentSizes = new Uint32Array(nodeCount);
+
+        // Visited nodes that are not assigned to a component yet:
+        const openNodes = new Uint32Array(nodeCount);
+        let openNodeCount = 0;
+        // Nodes of the current path of the search, with the position of the next dependency to follow:
+        const path = new Uint32Array(nodeCount);
+        const nextEdge = new Uint32Array(nodeCount);
+        let pathLength = 0;
+
+        let visitCount = 0;
+        let componentCount = 0;
+
+        const visit = (node: number): void => {
+            visitIndex[node] = visitCount;
+            lowLink[node] = visitCount;
+            visitCount++;
+            openNodes[openNodeCount++] = node;
+            path[pathLength] = node;
+            nextEdge[pathLength] = offsets[node];
+            pathLength++;
+        };
+
+        for (let root = 0; root < nodeCount; root++) {
+            if (visitIndex[root] !== unassigned) {
+                continue;
+            }
+
+            visit(root);
+            while (pathLength > 0) {
+                const node = path[pathLength - 1];
+                const edge = nextEdge[pathLength - 1];
+
+                if (edge < offsets[node + 1]) {
+                    nextEdge[pathLength - 1] = edge + 1;
+                    const dependency = dependencies[edge];
+                    if (visitIndex[dependency] === unassigned) {
+                        visit(dependency);
+                    } else if (componentOfNode[dependency] === unassigned) {
+                        lowLink[node] = Math.min(lowLink[node], visitIndex[dependency]);
+                    }
+
+                    continue;
+                }
+
+                pathLength--;
+                if (lowLink[node] === visitIndex[node]) {
+                    // The node is the first visited node of its component, which consists of all nodes opened since:
+                    let member: number;
+                    do {
+                        member = openNodes[--openNodeCount];
+                        componentOfNode[member] = componentCount;
+                        componentSizes[componentCount]++;
+                    } while (member !== node);
+
+                    componentCount++;
+                }
+
+                if (pathLength > 0) {
+                    const parent = path[pathLength - 1];
+                    lowLink[parent] = Math.min(lowLink[parent], lowLink[node]);
+                }
+            }
+        }
+
+        return { componentOfNode, componentSizes: componentSizes.slice(0, componentCount) };
+    }
+
+    /**
+     * Builds the graph of the dependencies between groups of nodes, e.g. between the directories of files.
+     * A group depends on another group if any of its nodes depends on a node of the other group.
+     * @param groupOfNode Index of the group of each node.
+     * @param groupCount Number of groups.
+     */
+    aggregate(groupOfNode: ArrayLike<number>, groupCount: number): DependencyGraph {
+        const offsets = this.#dependencyOffsets;
+        const sources = new Uint32Array(this.edgeCount);
+        const targets = new Uint32Array(this.edgeCount);
+        for (let node = 0; node < this.nodeCount; node++) {
+            sources.fill(groupOfNode[node], offsets[node], offsets[node + 1]);
+        }
+
+        for (let edge = 0; edge < this.edgeCount; edge++) {
+            targets[edge] = groupOfNode[this.#dependencies[edge]];
+        }
+
+        return DependencyGraph.fromEdges(groupCount, sources, targets);
+    }
+}
+
+/**
+ * Adjacency lists of all nodes in compressed sparse row form.
+ */
+type Adjacency = {
+    offsets: Uint32Array;
+    neighbours: Uint32Array;
+};
+
+/**
+ * Sorts the edges by their source with a counting sort,
+ * then drops edges from a node to itself and all but the first of parallel edges.
+ */
+function buildAdjacency(
+    nodeCount: number,
+    sources: ArrayLike<number>,
+    targets: ArrayLike<number>,
+): Adjacency {
+    const offsets = new Uint32Array(nodeCount + 1);
+    for (let edge = 0; edge < sources.length; edge++) {
+        const source = sources[edge];
+        const target = targets[edge];
+        if (source >= nodeCount || target >= nodeCount) {
+            throw new RangeError(
+                `Edge from ${source.toString()} to ${target.toString()} references a node that does not exist.`,
+            );
+        }
+
+        offsets[source + 1]++;
+    }
+
+    for (let node = 0; node < nodeCount; node++) {
+        offsets[node + 1] += offsets[node];
+    }
+
+    const neighbours = new Uint32Array(sources.length);
+    const nextPosition = offsets.slice(0, nodeCount);
+    for (let edge = 0; edge < sources.length; edge++) {
+        neighbours[nextPosition[sources[edge]]++] = targets[edge];
+    }
+
+    // Compact the neighbours in place, remembering from which node each neighbour was last added:
+    const lastAddedFrom = new Int32Array(nodeCount).fill(-1);
+    let length = 0;
+    let start = 0;
+    for (let node = 0; node < nodeCount; node++) {
+        const end = offsets[node + 1];
+        offsets[node] = length;
+        for (let position = start; position < end; position++) {
+            const neighbour = neighbours[position];
+            if (neighbour !== node && lastAddedFrom[neighbour] !== node) {
+                lastAddedFrom[neighbour] = node;
+                neighbours[length++] = neighbour;
+            }
+        }
+
+        start = end;
+    }
+
+    offsets[nodeCount] = length;
+    return { offsets, neighbours: neighbours.slice(0, length) };
+}
@@ -0,0 +1,29 @@
+import { describe, expect, it } from "vitest";
+import { IdPairSet, InterningTable } from "./interning.js";
+
+describe("InterningTable", () => {
+    it("should assign consecutive ids to distinct strings and return them again", () => {
+        const table = new InterningTable();
+
+        expect(table.intern("/src/a.cs")).toBe(0);
+        expect(table.intern("/src/b.cs")).toBe(1);
+        expect(table.intern("/src/" + "a.cs")).toBe(0);
+
+        expect(table.size).toBe(2);
+        expect(table.get(1)).toBe("/src/b.cs");
+        expect(table.getId("/src/a.cs")).toBe(0);
+        expect(table.getId("/src/c.cs")).toBeUndefined();
+        expect(table.size).toBe(2);
+    });
+});
+
+describe("IdPairSet", () => {
+    it("should distinguish the order of the ids in a pair", () => {
+        const pairs = new IdPairSet();
+        pairs.add(1, 2);
+
+        expect(pairs.has(1, 2)).toBe(true);
+        expect(pairs.has(2, 1)).toBe(false);
+        expect(pairs.has(1, 3)).toBe(false);
+    });
+});
@@ -0,0 +1,89 @@
+import { type UsageType } from "../metric.js";
+
+/**
+ * Id of an interned file path.
+ */
+export type FileId = number;
+
+/**
+ * Id of an interned fully qualified type name.
+ */
+export type TypeId = number;
+
+/**
+ * Assigns consecutive integer ids to strings, so that each distinct string is only stored once
+ * and can be referenced, compared and hashed as a small integer.
+ */
+export class InterningTable {
+    readonly #ids = new Map<string, number>();
+    readonly #values: string[] = [];
+
+    /**
+     * Number of interned strings.
+     */
+    get size(): number {
+        return this.#values.length;
+    }
+
+    /**
+     * Returns the id of the specified string, assigning the next free id if it was not interned before.
+     */
+    intern(value: string): number {
+        let id = this.#ids.get(value);
+        if (id === undefined) {
+            id = this.#values.length;
+            this.#ids.set(value, id);
+            this.#values.push(value);
+        }
+
+        return id;
+    }
+
+    /**
+     * Returns the id of the specified string, or undefined if it was not interned.
+     */
+    getId(value: string): number | undefined {
+        return this.#ids.get(value);
+    }
+
+    /**
+     * Returns the interned string with the specified id.
+     */
+    get(id: number): string {
+        return this.#values[id];
+    }
+}
+
+/**
+ * Set of ordered pairs of ids.
+ */
+export class IdPairSet {
+    readonly #pairs = new Map<number, Set<number>>();
+
+    has(first: number, second: number): boolean {
+        return this.#pairs.get(first)?.has(second) ?? false;
+    }
+
+    add(first: number, second: number): void {
+        const seconds = this.#pairs.get(first);
+        if (seconds === undefined) {
+            this.#pairs.set(first, new Set([second]));
+        } else {
+            seconds.add(second);
+        }
+    }
+}
+
+/**
+ * Relationship between two types while the coupling metrics are calculated,
+ * with the files and fully qualified type names replaced by their ids.
+ */
+export type InternedRelationship = {
+    fromType: TypeId;
+    toType: TypeId;
+    fromFile: FileId;
+    toFile: FileId;
+    fromTypeName: string;
+    toTypeName: string;
+    usageType: UsageType;
+};
@@ -0,0 +1,101 @@
+import { describe, expect, it } from "vitest";
+import { type TypeInfo } from "../../resolver/types/abstract-collector.js";
+import { type Accessor } from "../../resolver/accessors/abstract-collector.js";
+import { getFullyQualifiedTypeName, SymbolTable } from "./symbol-table.js";
+
+function type(namespace: string, typeName: string, sourceFile = typeName + ".cs"): TypeInfo {
+    return {
+        namespace,
+        typeName,
+        classType: "class",
+        sourceFile,
+        namespaceDelimiter: ".",
+        implementedFrom: [],
+    };
+}
+
+function types(...typeInfos: TypeInfo[]): Map<FullyQualifiedName, TypeInfo> {
+    return new Map(typeInfos.map((typeInfo) => [getFullyQualifiedTypeName(typeInfo), typeInfo]));
+}
+
+describe("SymbolTable", () => {
+    it("should find types by their fully qualified name, simple name and namespace", () => {
+        const symbolTable = new SymbolTable();
+        const first = type("App.Models", "User");
+        const second = type("App.Models", "Order");
+        const third = type("App.Views", "User");
+
+        symbolTable.addTypes(types(first, second));
+        symbolTable.addTypes(types(third));
+
+        expect(symbolTable.size).toBe(3);
+        expect(symbolTable.getType("App.Models.User")).toBe(first);
+        expect(symbolTable.getType("App.Unknown")).toBeUndefined();
+        expect(symbolTable.getTypesByName("User")).toEqual([first, third]);
+        expect(symbolTable.getTypesInNamespace("App.Models")).toEqual([first, second]);
+        expect(symbolTable.getTypesInNamespace("App")).toEqual([]);
+    });
+
+    it("should replace a type that is declared again in a later file", () => {
+        const symbolTable = new SymbolTable();
+        const first = type("App", "User", "first.cs");
+        const second = type("App", "User", "second.cs");
+
+        symbolTable.addTypes(types(first));
+        symbolTable.addTypes(types(second));
+
+        expect(symbolTable.size).toBe(1);
+        expect(symbolTable.getType("App.User")).toBe(second);
+        expect(symbolTable.getTypesByName("User")).toEqual([second]);
+        expect(symbolTable.getTypesInNamespace("App")).toEqual([second]);
+    });
+
+    it("should collect the accessors with the same name from all files", () => {
+        const symbolTable = new SymbolTable();
+        const accessor = (fromType: TypeInfo): Accessor => ({
+            name: "Name",
+            FullyQualifiedAccessorName: getFullyQualifiedTypeName(fromType) + ".Name",
+            fromType,
+            filePath: fromType.sourceFile,
+            returnType: "string",
+        });
+        const first = accessor(type("App", "User"));
+        const second = accessor(type("App", "Order"));
+
+        symbolTable.addAccessors(new Map([["Name", [first]]]));
+        symbolTable.addAccessors(new Map([["Name", [second]]]));
+
+        expect(symbolTable.getAccessors("Name")).toEqual([first, second]);
+        expect(symbolTable.getAccessors("Unknown")).toBeUndefined();
+    });
+
+    it("should intern the files and fully qualified names of the added types and accessors", () => {
+        const symbolTable = new SymbolTable();
+        const user = type("App", "User", "/src/User.cs");
+        const order = type("App", "Order", "/src/User.cs");
+
+        symbolTable.addTypes(types(user, order));
+        symbolTable.addAccessors(
+            new Map([
+                [
+                    "Name",
+                    [
+                        {
+                            name: "Name",
+                            FullyQualifiedAccessorName: "App.User.Name",
+                            fromType: user,
+                            filePath: "/src/Order.cs",
+                            returnType: "string",
+                        },
+                    ],
+                ],
+            ]),
+        );
+
+        expect(symbolTable.files.getId("/src/User.cs")).toBe(0);
+        expect(symbolTable.files.getId("/src/Order.cs")).toBe(1);
+        expect(symbolTable.typeNames.getId("App.User")).toBe(0);
+        expect(symbolTable.typeNames.getId("App.Order")).toBe(1);
+        expect(symbolTable.typeNames.getId("App.User.Name")).toBeUndefined();
+    });
+});
@@ -0,0 +1,143 @@
+import { type TypeInfo } from "../../resolver/types/abstract-collector.js";
+import { type Accessor } from "../../resolver/accessors/abstract-collector.js";
+import { InterningTable } from "./interning.js";
+
+/**
+ * Returns the fully qualified name of the specified type.
+ */
+export function getFullyQualifiedTypeName(type: TypeInfo): FullyQualifiedName {
+    return type.namespace + type.namespaceDelimiter + type.typeName;
+}
+
+/**
+ * Global table of the types and public accessors declared in all analyzed files.
+ * Files are added one after another in amortized constant time per declared type or accessor.
+ *
+ * Types are indexed by their fully qualified name, their simple type name and their namespace.
+ * If a type with the same fully qualified name is declared again, the later declaration replaces the earlier one.
+ *
+ * The paths of the files and the fully qualified names of the types are interned run-wide,
+ * so that the coupling metrics can be calculated on integer ids.
+ * The paths stored in the added types and accessors are replaced by the interned strings,
+ * so that each path is only kept in memory once.
+ */
+export class SymbolTable {
+    /**
+     * Paths of all files that declare types or accessors, plus those interned while calculating the metrics.
+     */
+    readonly files = new InterningTable();
+
+    /**
+     * Fully qualified names of all types, plus those interned while calculating the metrics.
+     */
+    readonly typeNames = new InterningTable();
+
+    readonly #typesByFqtn = new Map<FullyQualifiedName, TypeInfo>();
+    readonly #typesByName = new Map<string, TypeInfo[]>();
+    readonly #typesByNamespace = new Map<string, TypeInfo[]>();
+    readonly #accessorsByName = new Map<string, Accessor[]>();
+
+    /**
+     * Number of types in the table.
+     */
+    get size(): number {
+        return this.#typesByFqtn.size;
+    }
+
+    /**
+     * All types, by their fully qualified name.
+     */
+    get types(): ReadonlyMap<FullyQualifiedName, TypeInfo> {
+        return this.#typesByFqtn;
+    }
+
+    /**
+     * All public accessors, by their name.
+     */
+    get accessors(): ReadonlyMap<string, readonly Accessor[]> {
+        return this.#accessorsByName;
+    }
+
+    /**
+     * Adds the types declared in a file.
+     * @param types The types, by their fully qualified name.
+     */
+    addTypes(types: Map<FullyQualifiedName, TypeInfo>): void {
+        for (const [fqtn, type] of types) {
+            this.typeNames.intern(fqtn);
+            type.sourceFile = this.#internFile(type.sourceFile);
+
+            const replacedType = this.#typesByFqtn.get(fqtn);
+            if (replacedType !== undefined) {
+                removeFromIndex(this.#typesByName, replacedType.typeName, replacedType);
+                removeFromIndex(this.#typesByNamespace, replacedType.namespace, replacedType);
+            }
+
+            this.#typesByFqtn.set(fqtn, type);
+            addToIndex(this.#typesByName, type.typeName, type);
+            addToIndex(this.#typesByNamespace, type.namespace, type);
+        }
+    }
+
+    /**
+     * Adds the public accessors declared in a file.
+     * @param accessors The accessors, by their name.
+     */
+    addAccessors(accessors: Map<string, Accessor[]>): void {
+        for (const [accessorName, accessorsWithName] of accessors) {
+            for (const accessor of accessorsWithName) {
+                accessor.filePath = this.#internFile(accessor.filePath);
+                addToIndex(this.#accessorsByName, accessorName, accessor);
+            }
+        }
+    }
+
+    /**
+     * Returns the type with the specified fully qualified name.
+     */
+    getType(fqtn: FullyQualifiedName): TypeInfo | undefined {
+        return this.#typesByFqtn.get(fqtn);
+    }
+
+    /**
+     * Returns all types with the specified simple name, in any namespace.
+     */
+    getTypesByName(typeName: string): readonly TypeInfo[] {
+        return this.#typesByName.get(typeName) ?? [];
+    }
+
+    /**
+     * Returns all types declared directly in the specified namespace.
+     */
+    getTypesInNamespace(namespace: string): readonly TypeInfo[] {
+        return this.#typesByNamespace.get(namespace) ?? [];
+    }
+
+    /**
+     * Returns all public accessors with the specified name, or undefined if there are none.
+     */
+    getAccessors(accessorName: string): readonly Accessor[] | undefined {
+        return this.#accessorsByName.get(accessorName);
+    }
+
+    #internFile(filePath: FilePath): FilePath {
+        return this.files.get(this.files.intern(filePath));
+    }
+}
+
+function addToIndex<T>(index: Map<string, T[]>, key: string, value: T): void {
+    const values = index.get(key);
+    if (values === undefined) {
+        index.set(key, [value]);
+    } else {
+        values.push(value);
+    }
+}
+
+function removeFromIndex<T>(index: Map<string, T[]>, key: string, value: T): void {
+    const values = index.get(key);
+    const position = values?.indexOf(value) ?? -1;
+    if (position !== -1) {
+        values!.splice(position, 1);
+    }
+}
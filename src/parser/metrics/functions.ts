@@ -1,50 +1,50 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
-import { type QueryMatch } from "tree-sitter";
-import { QueryBuilder } from "../queries/query-builder.js";
+import {
+    getQueryMatchCount,
+    type MetricQueryResult,
+    type QueryMetric,
+} from "../queries/metric-query-engine.js";
 import { NodeTypeCategory, type NodeTypeConfig } from "../../helper/model.js";
 import { getQueryStatementsByCategories } from "../../helper/helper.js";
 import { Language } from "../../helper/language.js";
 import { type QueryStatement, SimpleQueryStatement } from "../queries/query-statements.js";
-import { type MetricName, type Metric, type MetricResult, type ParsedFile } from "./metric.js";
+import { type MetricName, type MetricResult, type ParsedFile } from "./metric.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
 });
 
-export class Functions implements Metric {
+export class Functions implements QueryMetric {
+    readonly countsMatchesOnly = true;
+
     private readonly statementsSuperSet: QueryStatement[] = [];
 
+    private readonly javaStatements: QueryStatement[];
+
     constructor(allNodeTypes: NodeTypeConfig[]) {
         this.statementsSuperSet = getQueryStatementsByCategories(
             allNodeTypes,
             NodeTypeCategory.Function,
         );
+        this.javaStatements = [
+            ...this.statementsSuperSet,
+            // Add query for instance init block in Java
+            new SimpleQueryStatement("(class_body (block)) @initBlock"),
+        ];
     }
 
-    calculate(parsedFile: ParsedFile): MetricResult {
-        const { language, tree } = parsedFile;
-        const queryBuilder = new QueryBuilder(language);
-        if (language === Language.Java) {
-            // Add query for instance init block in Java
-            queryBuilder.addStatements([
-                ...this.statementsSuperSet,
-                new SimpleQueryStatement("(class_body (block)) @initBlock"),
-            ]);
-        } else {
-            queryBuilder.addStatements(this.statementsSuperSet);
-        }
-
-        const query = queryBuilder.build();
-        let matches: QueryMatch[] = [];
-        if (query !== undefined) {
-            matches = query.matches(tree.rootNode);
-        }
-
-        dlog(this.getName() + " - " + matches.length.toString());
+    getQueryStatements(language: Language): QueryStatement[] {
+        return language === Language.Java ? this.javaStatements : this.statementsSuperSet;
+    }
+
+    calculate(parsedFile: ParsedFile, queryResult?: MetricQueryResult): MetricResult {
+        const matchCount = getQueryMatchCount(this, parsedFile, queryResult);
+
+        dlog(this.getName() + " - " + matchCount.toString());
 
         return {
             metricName: this.getName(),
-            metricValue: matches.length,
+            metricValue: matchCount,
         };
     }
 
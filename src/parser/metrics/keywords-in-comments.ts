@@ -1,31 +1,91 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
-import { type NodeTypeConfig } from "../../helper/model.js";
-import { createRegexFor } from "../../helper/helper.js";
+import { KeywordMatcher } from "../../helper/keyword-matcher.js";
+import { getQueryMatches, type MetricQueryResult } from "../queries/metric-query-engine.js";
 import { type Metric, type MetricName, type MetricResult, type ParsedFile } from "./metric.js";
-import { CommentLines } from "./comment-lines.js";
+import { type CommentLines } from "./comment-lines.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
 });
 
-export class KeywordsInComments implements Metric {
-    readonly #commentLinesCalculator: CommentLines;
-    readonly #regex: RegExp;
+/**
+ * Keywords counted by the keywords_in_comments metric.
+ */
+export const defaultCommentKeywords = ["bug", "wtf", "todo", "hack"];
+
+/**
+ * Counts the keywords of multiple sets in the comments of a file.
+ * The comments are the captures of the comment query statements of the {@link CommentLines} metric,
+ * so they are not queried again. The keywords of all sets are counted in a single pass
+ * over the range of each comment in the source code of the file, without copying the comments.
+ */
+export class CommentKeywordCounter {
+    readonly #commentLines: CommentLines;
+    readonly #matcher: KeywordMatcher;
 
-    constructor(allNodeTypes: NodeTypeConfig[]) {
-        this.#commentLinesCalculator = new CommentLines(allNodeTypes);
-        this.#regex = createRegexFor(["bug", "wtf", "todo", "hack"]);
+    /**
+     * Counts of the files the counter was used for, as the metrics of all sets ask for them in turn.
+     * Weakly referenced, so that the syntax tree of a file can be released once the file has been processed.
+     */
+    readonly #countsByFile = new WeakMap<ParsedFile, Uint32Array>();
+
+    /**
+     * Constructor of the class {@link CommentKeywordCounter}.
+     * @param commentLines The comment lines metric, whose comment captures are scanned for the keywords.
+     * @param keywordSets Keywords of each set.
+     */
+    constructor(commentLines: CommentLines, keywordSets: string[][]) {
+        this.#commentLines = commentLines;
+        this.#matcher = new KeywordMatcher(keywordSets);
     }
 
-    calculate(parsedFile: ParsedFile): MetricResult {
-        const comments = this.#commentLinesCalculator.getQueryCapturesFrom(parsedFile);
-        let metricValue = 0;
+    /**
+     * Returns the number of keywords of each set in the comments of the specified file.
+     * @param parsedFile The file.
+     * @param queryResult Result of the combined query on the file, including the matches of the comment query,
+     * if available.
+     */
+    getCounts(parsedFile: ParsedFile, queryResult?: MetricQueryResult): Uint32Array {
+        let counts = this.#countsByFile.get(parsedFile);
+        if (counts === undefined) {
+            counts = new Uint32Array(this.#matcher.setCount);
+            const { sourceCode } = parsedFile;
+            for (const match of getQueryMatches(this.#commentLines, parsedFile, queryResult)) {
+                for (const { node } of match.captures) {
+                    this.#matcher.countIn(sourceCode, node.startIndex, node.endIndex, counts);
+                }
+            }
 
-        for (const comment of comments) {
-            const regexMatchArrays = comment.node.text.matchAll(this.#regex);
-            metricValue += [...regexMatchArrays].length;
+            this.#countsByFile.set(parsedFile, counts);
         }
 
+        return counts;
+    }
+}
+
+/**
+ * Number of keywords of a set in the comments of a file.
+ */
+export class KeywordsInComments implements Metric {
+    readonly #counter: CommentKeywordCounter;
+    readonly #setIndex: number;
+    readonly #name: MetricName;
+
+    /**
+     * Constructor of the class {@link KeywordsInComments}.
+     * @param counter Counter of the keywords of all sets.
+     * @param setIndex Index of the keyword set of this metric among the sets of the counter.
+     * @param name Name of the metric.
+     */
+    constructor(counter: CommentKeywordCounter, setIndex: number, name: MetricName) {
+        this.#counter = counter;
+        this.#setIndex = setIndex;
+        this.#name = name;
+    }
+
+    calculate(parsedFile: ParsedFile, queryResult?: MetricQueryResult): MetricResult {
+        const metricValue = this.#counter.getCounts(parsedFile, queryResult)[this.#setIndex];
+
         dlog(this.getName() + " - " + metricValue.toString());
 
         return {
@@ -35,6 +95,28 @@ export class KeywordsInComments implements Metric {
     }
 
     getName(): MetricName {
-        return "keywords_in_comments";
+        return this.#name;
     }
 }
+
+/**
+ * Creates the keywords_in_comments metric for the default keywords,
+ * and a metric named keywords_in_comments_<name> for each additional keyword set.
+ * All of them share a single {@link CommentKeywordCounter}.
+ * @param commentLines The comment lines metric, whose comment captures are scanned for the keywords.
+ * @param keywordSets Additional keyword sets by their name.
+ */
+export function createKeywordsInCommentsMetrics(
+    commentLines: CommentLines,
+    keywordSets = new Map<string, string[]>(),
+): KeywordsInComments[] {
+    const names: MetricName[] = ["keywords_in_comments"];
+    const keywords = [defaultCommentKeywords];
+    for (const [name, keywordsOfSet] of keywordSets) {
+        names.push(`keywords_in_comments_${name}`);
+        keywords.push(keywordsOfSet);
+    }
+
+    const counter = new CommentKeywordCounter(commentLines, keywords);
+    return names.map((name, setIndex) => new KeywordsInComments(counter, setIndex, name));
+}
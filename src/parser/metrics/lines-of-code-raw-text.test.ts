@@ -1,5 +1,14 @@
-import { describe, expect, it } from "vitest";
-import { calculateLinesOfCodeRawText } from "./lines-of-code-raw-text.js";
+import { Buffer } from "node:buffer";
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, beforeEach, describe, expect, it } from "vitest";
+import {
+    calculateLinesOfCodeRawText,
+    calculateLinesOfCodeRawTextOfBuffer,
+    calculateLinesOfCodeRawTextOfFile,
+    LineCounter,
+} from "./lines-of-code-raw-text.js";
 
 describe("LinesOfCodeRawText.calculate(...)", () => {
     it("should calculate lines of code correctly for a file with multiple lines", () => {
@@ -59,3 +68,101 @@ May add line six as friend, it would be quite near.`;
         });
     }
 });
+
+describe("LineCounter", () => {
+    const texts = [
+        "",
+        "one-line",
+        "First line\nSecond line\nThird line",
+        "First line\n\nThird line\nFourth line\n",
+        "First line\r\n\r\nThird line\r\nFourth line\r\n",
+        "First line\r\rThird line\rFourth line\r",
+        "\r\n\r\r\n\n\r",
+    ];
+
+    it("should count the same lines as calculateLinesOfCodeRawText(...)", () => {
+        for (const text of texts) {
+            const lineCounter = new LineCounter();
+            lineCounter.add(Buffer.from(text));
+
+            expect(lineCounter.lines).toBe(calculateLinesOfCodeRawText(text).metricValue);
+        }
+    });
+
+    it("should count line breaks that are split between chunks only once", () => {
+        for (const text of texts) {
+            const bytes = Buffer.from(text);
+            for (let split = 0; split <= bytes.length; split++) {
+                const lineCounter = new LineCounter();
+                lineCounter.add(bytes.subarray(0, split));
+                lineCounter.add(bytes.subarray(split));
+
+                expect(lineCounter.lines).toBe(calculateLinesOfCodeRawText(text).metricValue);
+            }
+        }
+    });
+});
+
+describe("calculateLinesOfCodeRawTextOfFile(...)", () => {
+    let temporaryDir: string;
+
+    beforeEach(async () => {
+        temporaryDir = await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-"));
+    });
+
+    afterEach(async () => {
+        await fs.rm(temporaryDir, { recursive: true, force: true });
+    });
+
+    async function writeFile(name: string, contents: string | Buffer): Promise<string> {
+        const filePath = path.join(temporaryDir, name);
+        await fs.writeFile(filePath, contents);
+        return filePath;
+    }
+
+    it("should count the lines of a file that is larger than a single chunk", async () => {
+        const filePath = await writeFile("large.txt", "line\r\n".repeat(300_000));
+
+        expect(await calculateLinesOfCodeRawTextOfFile(filePath)).toEqual({
+            metricName: "lines_of_code",
+            metricValue: 300_001,
+        });
+    });
+
+    it("should not count the lines of binary files", async () => {
+        const filePath = await writeFile("image.bin", Buffer.from([0x89, 0x50, 0x0a, 0x00, 0x0a]));
+
+        expect(await calculateLinesOfCodeRawTextOfFile(filePath)).toBeUndefined();
+    });
+
+    it("should not count the lines of files that are larger than the maximum size", async () => {
+        const filePath = await writeFile("dump.txt", "line\n".repeat(100));
+
+        expect(await calculateLinesOfCodeRawTextOfFile(filePath, 499)).toBeUndefined();
+        expect(await calculateLinesOfCodeRawTextOfFile(filePath, 500)).toEqual({
+            metricName: "lines_of_code",
+            metricValue: 101,
+        });
+    });
+
+    it("should throw an error if the file cannot be read", async () => {
+        await expect(
+            calculateLinesOfCodeRawTextOfFile(path.join(temporaryDir, "missing.txt")),
+        ).rejects.toThrowError();
+    });
+});
+
+describe("calculateLinesOfCodeRawTextOfBuffer(...)", () => {
+    it("should count the lines of the raw bytes", () => {
+        expect(calculateLinesOfCodeRawTextOfBuffer(Buffer.from("a\r\nb\rc\n"))).toEqual({
+            metricName: "lines_of_code",
+            metricValue: 4,
+        });
+    });
+
+    it("should not count the lines of binary contents", () => {
+        expect(
+            calculateLinesOfCodeRawTextOfBuffer(Buffer.from([0x89, 0x50, 0x0a, 0x00, 0x0a])),
+        ).toBeUndefined();
+    });
+});
@@ -1,3 +1,5 @@
+import { Buffer } from "node:buffer";
+import fs from "node:fs/promises";
 import { debuglog, type DebugLoggerFunction } from "node:util";
 import { type MetricResult } from "./metric.js";
 
@@ -5,6 +7,20 @@ let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
 });
 
+/**
+ * Size of the chunks in which files are read for counting their lines.
+ */
+const chunkSize = 1024 * 1024;
+
+/**
+ * Number of bytes at the beginning of a file that are checked for null bytes, which indicate a binary file.
+ * This is the same heuristic as used by git.
+ */
+const binaryCheckSize = 8000;
+
+const lineFeed = 0x0a;
+const carriageReturn = 0x0d;
+
 /**
  * Counts the number of lines in a file, including empty lines, without the need to use a language grammar.
  */
@@ -18,3 +34,133 @@ export function calculateLinesOfCodeRawText(sourceCode: string): MetricResult {
         metricValue: loc,
     };
 }
+
+/**
+ * Counts the number of lines in a file like {@link calculateLinesOfCodeRawText},
+ * but reads the file in chunks and counts the line breaks in the raw bytes,
+ * so that even very large files are neither decoded nor held in memory as a whole.
+ *
+ * Binary files, which are recognized by a null byte at their beginning, are not counted.
+ * @param filePath Path of the file.
+ * @param maxFileSize Maximum size of the file in bytes. Larger files are not counted. 0 means no limit.
+ * @return The number of lines, or undefined if the file is binary or too large.
+ */
+export async function calculateLinesOfCodeRawTextOfFile(
+    filePath: string,
+    maxFileSize = 0,
+): Promise<MetricResult | undefined> {
+    const file = await fs.open(filePath, "r");
+    try {
+        const { size } = await file.stat();
+        if (maxFileSize > 0 && size > maxFileSize) {
+            dlog("lines_of_code - raw text - skipped, as the file is too large: " + filePath);
+            return undefined;
+        }
+
+        const buffer = Buffer.allocUnsafe(Math.min(chunkSize, Math.max(size, binaryCheckSize)));
+        const lineCounter = new LineCounter();
+        let isFirstChunk = true;
+
+        for (;;) {
+            const { bytesRead } = await file.read(buffer, 0, buffer.length); // eslint-disable-line no-await-in-loop
+            if (bytesRead === 0) {
+                break;
+            }
+
+            const chunk = buffer.subarray(0, bytesRead);
+            if (isFirstChunk && chunk.subarray(0, binaryCheckSize).includes(0)) {
+                dlog("lines_of_code - raw text - skipped, as the file is binary: " + filePath);
+                return undefined;
+            }
+
+            isFirstChunk = false;
+            lineCounter.add(chunk);
+        }
+
+        dlog("lines_of_code - raw text - " + lineCounter.lines.toString());
+
+        return {
+            metricName: "lines_of_code",
+            metricValue: lineCounter.lines,
+        };
+    } finally {
+        await file.close();
+    }
+}
+
+/**
+ * Counts the number of lines in the raw bytes of a file like {@link calculateLinesOfCodeRawTextOfFile},
+ * for files that are already in memory, e.g. because they have been read from a git repository.
+ * @param contents The raw bytes of the file.
+ * @return The number of lines, or undefined if the file is binary.
+ */
+export function calculateLinesOfCodeRawTextOfBuffer(contents: Buffer): MetricResult | undefined {
+    if (contents.subarray(0, binaryCheckSize).includes(0)) {
+        return undefined;
+    }
+
+    const lineCounter = new LineCounter();
+    lineCounter.add(contents);
+    return {
+        metricName: "lines_of_code",
+        metricValue: lineCounter.lines,
+    };
+}
+
+/**
+ * Counts the lines of a text that is passed in chunks of raw bytes.
+ * Line feeds, carriage returns and carriage returns followed by a line feed are counted as line breaks,
+ * also if they are split between two chunks.
+ *
+ * The line breaks are searched with {@link Buffer.indexOf}, which scans the bytes natively (using memchr),
+ * instead of looking at each byte in JavaScript.
+ */
+export class LineCounter {
+    #lineBreaks = 0;
+    #endsWithCarriageReturn = false;
+
+    /**
+     * Number of lines in the text passed so far. An empty text has one line.
+     */
+    get lines(): number {
+        return this.#lineBreaks + (this.#endsWithCarriageReturn ? 1 : 0) + 1;
+    }
+
+    /**
+     * Counts the line breaks in the next chunk of the text.
+     * @param chunk The next chunk. May be reused by the caller after this returns.
+     */
+    add(chunk: Buffer): void {
+        if (chunk.length === 0) {
+            return;
+        }
+
+        // A carriage return at the end of the previous chunk only counts on its own if no line feed follows:
+        if (this.#endsWithCarriageReturn && chunk[0] !== lineFeed) {
+            this.#lineBreaks++;
+        }
+
+        this.#endsWithCarriageReturn = false;
+
+        for (
+            let index = chunk.indexOf(lineFeed);
+            index !== -1;
+            index = chunk.indexOf(lineFeed, index + 1)
+        ) {
+            this.#lineBreaks++;
+        }
+
+        // Carriage returns followed by a line feed have already been counted with the line feed:
+        for (
+            let index = chunk.indexOf(carriageReturn);
+            index !== -1;
+            index = chunk.indexOf(carriageReturn, index + 1)
+        ) {
+            if (index === chunk.length - 1) {
+                this.#endsWithCarriageReturn = true;
+            } else if (chunk[index + 1] !== lineFeed) {
+                this.#lineBreaks++;
+            }
+        }
+    }
+}
@@ -1,6 +1,6 @@
 import { beforeAll, describe, expect, it } from "vitest";
 import Parser = require("tree-sitter");
-import { Language, languageToGrammar } from "../../helper/language.js";
+import { getGrammar, Language } from "../../helper/language.js";
 import { type NodeTypeConfig, NodeTypeCategory } from "../../helper/model.js";
 import { ParsedFile } from "./metric.js";
 import { MaxNestingLevel } from "./max-nesting-level.js";
@@ -44,10 +44,10 @@ describe("MaxNestingLevel.calculate(...)", () => {
     });
 
     function expectMaxNestingLevel(input: string, language: Language, expected: number): void {
-        parser.setLanguage(languageToGrammar.get(language));
+        parser.setLanguage(getGrammar(language));
         const tree = parser.parse(input);
 
-        const parsedFile = new ParsedFile("filename", language, tree);
+        const parsedFile = new ParsedFile("filename", language, tree, input);
 
         expect(maxNestingLevel.calculate(parsedFile)).toEqual({
             metricName: "max_nesting_level",
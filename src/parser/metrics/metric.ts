@@ -1,5 +1,7 @@
 import { type Tree } from "tree-sitter";
 import { FileType, type Language, languageToFileType } from "../../helper/language.js";
+import { type MetricQueryResult } from "../queries/metric-query-engine.js";
+import { type FileCouplingData } from "./coupling/coupling.js";
 
 /**
  * Names of all available file metrics.
@@ -13,6 +15,7 @@ export type MetricName =
     | "real_lines_of_code"
     | "max_nesting_level"
     | "keywords_in_comments"
+    | `keywords_in_comments_${string}`
     | "coupling";
 
 /**
@@ -64,11 +67,21 @@ export type CouplingMetrics = {
     incoming_dependencies: number;
     coupling_between_objects: number;
     instability: number;
+    /**
+     * Number of files in the dependency cycle the file is part of, i.e. its strongly connected component,
+     * or 0 if the file is not part of any cycle.
+     */
+    dependency_cycle_size: number;
 };
 
 export type CouplingResult = {
     relationships: Relationship[];
     metrics: Map<string, CouplingMetrics>;
+    /**
+     * Coupling metrics of the directories, with the dependencies of the files in a directory combined.
+     * Only calculated if enabled in the configuration.
+     */
+    directoryMetrics?: Map<string, CouplingMetrics>;
 };
 
 /**
@@ -78,9 +91,11 @@ export type Metric = {
     /**
      * Calculates the metric value for the specified file.
      * @param parsedFile Parsed source code file for which the metric value should be calculated.
+     * @param queryResult Matches of the combined query of all metrics on the file, if available.
+     * Metrics calculated on query matches run their own query if these are not passed.
      * @return A MetricResult containing the calculated metric value.
      */
-    calculate(parsedFile: ParsedFile): MetricResult;
+    calculate(parsedFile: ParsedFile, queryResult?: MetricQueryResult): MetricResult;
 
     /**
      * Returns the name of this metric.
@@ -90,7 +105,19 @@ export type Metric = {
 };
 
 export type CouplingMetric = {
-    processFile(file: ParsedFile): void;
+    /**
+     * Extracts the data needed for calculating the metric from a single file.
+     * The extracted data does not depend on other files and does not reference the syntax tree,
+     * so it can be stored and added again later.
+     * @param file The file to extract the data from.
+     */
+    extract(file: ParsedFile): FileCouplingData;
+
+    /**
+     * Adds the data extracted from a file to the data the metric is calculated on.
+     * @param fileData Data extracted from a file by {@link extract}.
+     */
+    add(fileData: FileCouplingData): void;
 
     calculate(): CouplingResult;
 
@@ -127,11 +154,17 @@ export class ParsedFile extends SourceFile {
      */
     tree: Tree;
 
-    constructor(filePath: string, language: Language, tree: Tree) {
+    /**
+     * Source code the syntax tree was parsed from. The start and end indices of its nodes refer to this string.
+     */
+    sourceCode: string;
+
+    constructor(filePath: string, language: Language, tree: Tree, sourceCode: string) {
         const fileType = languageToFileType(language);
         super(filePath, fileType);
         this.language = language;
         this.tree = tree;
+        this.sourceCode = sourceCode;
     }
 }
 
@@ -146,3 +179,32 @@ export class ErrorFile extends SourceFile {
         this.error = error;
     }
 }
+
+/**
+ * Result of processing a single file, consisting of plain data only.
+ * Unlike a {@link SourceFile}, this can be passed between threads.
+ */
+export type FileResult = {
+    filePath: string;
+    fileType: FileType;
+    fileMetricResults: FileMetricResults;
+    /**
+     * Error that occurred while reading or parsing the file, if any.
+     */
+    parseError?: Error;
+};
+
+/**
+ * Combines the specified source file and the metrics calculated on it to a {@link FileResult}.
+ * @param sourceFile The processed file.
+ * @param fileMetricResults The metrics calculated on the file.
+ */
+export function toFileResult(
+    sourceFile: SourceFile,
+    fileMetricResults: FileMetricResults,
+): FileResult {
+    const { filePath, fileType } = sourceFile;
+    return sourceFile instanceof ErrorFile
+        ? { filePath, fileType, fileMetricResults, parseError: sourceFile.error }
+        : { filePath, fileType, fileMetricResults };
+}
@@ -0,0 +1,108 @@
+import { describe, expect, it } from "vitest";
+import Parser = require("tree-sitter");
+import { getGrammar, Language } from "../../helper/language.js";
+import { type RealLinesOfCodeRules, walkTree } from "./tree-walk.js";
+
+function parse(sourceCode: string, language: Language): Parser.Tree {
+    const parser = new Parser();
+    parser.setLanguage(getGrammar(language));
+    return parser.parse(sourceCode);
+}
+
+function rules(overrides: Partial<RealLinesOfCodeRules> = {}): RealLinesOfCodeRules {
+    return {
+        commentNodeTypes: new Set(["comment"]),
+        stringStatementsAreComments: false,
+        countAllHeredocLines: false,
+        ...overrides,
+    };
+}
+
+describe("walkTree(...)", () => {
+    it("should count the real lines of code, not counting comments and empty lines", () => {
+        const tree = parse("a = 1\n\n# comment\nb = [\n    1,\n    2,\n]\n", Language.Python);
+
+        expect(walkTree(tree, { realLinesOfCode: rules() })).toEqual({
+            linesOfCode: tree.rootNode.endPosition.row + 1,
+            realLinesOfCode: 5,
+            maxNestingLevel: 0,
+        });
+    });
+
+    it("should not count strings that form a statement on their own, if configured", () => {
+        const sourceCode = 'x = 1\n"""\nDocstring.\n"""\ny = 2\n';
+        const tree = parse(sourceCode, Language.Python);
+
+        expect(walkTree(tree, { realLinesOfCode: rules() }).realLinesOfCode).toBeGreaterThan(2);
+        expect(
+            walkTree(tree, { realLinesOfCode: rules({ stringStatementsAreComments: true }) })
+                .realLinesOfCode,
+        ).toBe(2);
+    });
+
+    it("should count all lines of heredoc bodies, if configured", () => {
+        const sourceCode = "cat <<EOF\nplain\ntext\n$HOME\nEOF\n";
+        const tree = parse(sourceCode, Language.Bash);
+
+        const withoutHeredocRule = walkTree(tree, { realLinesOfCode: rules() }).realLinesOfCode;
+        const withHeredocRule = walkTree(tree, {
+            realLinesOfCode: rules({ countAllHeredocLines: true }),
+        }).realLinesOfCode;
+
+        // Plain text lines before the substitution are only counted with the rule:
+        expect(withHeredocRule).toBeGreaterThan(withoutHeredocRule);
+    });
+
+    it("should calculate the nesting level inside the first top-level node", () => {
+        const tree = parse('{ "a": { "b": [1, { "c": 2 }] } }', Language.JSON);
+
+        expect(walkTree(tree, { nestingNodeTypes: new Set(["object", "array"]) })).toEqual({
+            linesOfCode: 1,
+            realLinesOfCode: 0,
+            maxNestingLevel: 3,
+        });
+    });
+
+    it("should calculate all metrics in a single pass with the same results as separately", () => {
+        const tree = parse('{\n  // comment\n  "a": {\n    "b": [1, 2]\n  }\n}\n', Language.JSON);
+        const options = {
+            realLinesOfCode: rules(),
+            nestingNodeTypes: new Set(["object", "array"]),
+        };
+
+        const combined = walkTree(tree, options);
+
+        expect(combined).toEqual({
+            linesOfCode: tree.rootNode.endPosition.row + 1,
+            realLinesOfCode: walkTree(tree, { realLinesOfCode: options.realLinesOfCode })
+                .realLinesOfCode,
+            maxNestingLevel: walkTree(tree, { nestingNodeTypes: options.nestingNodeTypes })
+                .maxNestingLevel,
+        });
+        expect(combined.realLinesOfCode).toBe(5);
+        expect(combined.maxNestingLevel).toBe(2);
+    });
+
+    it("should handle files with very many siblings without overflowing the stack", () => {
+        const sourceCode = "[\n" + "1,\n".repeat(200_000) + "1\n]\n";
+        const tree = parse(sourceCode, Language.JSON);
+
+        const result = walkTree(tree, {
+            realLinesOfCode: rules(),
+            nestingNodeTypes: new Set(["array"]),
+        });
+
+        expect(result.realLinesOfCode).toBe(200_003);
+        expect(result.maxNestingLevel).toBe(0);
+    });
+
+    it("should return only the lines of code for an empty file", () => {
+        const tree = parse("", Language.Python);
+
+        expect(walkTree(tree, { realLinesOfCode: rules() })).toEqual({
+            linesOfCode: 1,
+            realLinesOfCode: 0,
+            maxNestingLevel: 0,
+        });
+    });
+});
@@ -0,0 +1,186 @@
+import { type Tree, type TreeCursor } from "tree-sitter";
+
+/**
+ * Rules for counting the real lines of code of a file in a {@link walkTree} pass.
+ */
+export type RealLinesOfCodeRules = {
+    /**
+     * Types of the syntax nodes that are comments and thus not counted, including all nodes inside of them.
+     */
+    commentNodeTypes: Set<string>;
+    /**
+     * Whether strings that form a statement on their own are comments as well, like the docstrings in Python.
+     */
+    stringStatementsAreComments: boolean;
+    /**
+     * Whether all lines of heredoc bodies are counted, like in Bash,
+     * where the plain text lines of a heredoc are not represented by syntax nodes of their own.
+     */
+    countAllHeredocLines: boolean;
+};
+
+/**
+ * Metrics to calculate in a {@link walkTree} pass. Metrics that are not specified are not calculated.
+ */
+export type TreeWalkOptions = {
+    realLinesOfCode?: RealLinesOfCodeRules;
+    /**
+     * Types of the syntax nodes that increase the nesting level.
+     */
+    nestingNodeTypes?: Set<string>;
+};
+
+export type TreeWalkResult = {
+    linesOfCode: number;
+    /**
+     * Lines that contain code, not counting comments and empty lines. 0 if not calculated.
+     */
+    realLinesOfCode: number;
+    /**
+     * Maximum nesting level inside the first top-level node, not counting the top-level node itself.
+     * 0 if not calculated.
+     */
+    maxNestingLevel: number;
+};
+
+/**
+ * Calculates the line and nesting metrics of a syntax tree in a single pass.
+ *
+ * The tree is traversed with a single {@link TreeCursor}, iteratively instead of recursively,
+ * so that deep trees and long chains of siblings cannot overflow the stack.
+ * Only the type and position of the current node are read from the cursor,
+ * without creating an object for each node.
+ * Subtrees that do not affect any of the requested metrics (like comments, when counting real lines of code)
+ * are skipped.
+ *
+ * @param tree The syntax tree.
+ * @param options The metrics to calculate and the rules for them.
+ */
+export function walkTree(tree: Tree, options: TreeWalkOptions): TreeWalkResult {
+    const { realLinesOfCode: realLinesRules, nestingNodeTypes } = options;
+    const cursor = tree.walk();
+    const result: TreeWalkResult = {
+        linesOfCode: cursor.endPosition.row + 1,
+        realLinesOfCode: 0,
+        maxNestingLevel: 0,
+    };
+
+    // Assume the root node is always some kind of program/file/compilation_unit stuff.
+    // So if there are no child nodes, the file is empty.
+    if (!cursor.gotoFirstChild()) {
+        return result;
+    }
+
+    let lastCountedLine = -1;
+    // Depth of the current node, with the top-level nodes at depth 1:
+    let depth = 1;
+    // Real lines of code are not counted for nodes below this depth, e.g. inside comments:
+    let realLinesDepthLimit = realLinesRules === undefined ? 0 : Number.POSITIVE_INFINITY;
+    // Nesting levels by depth, counted only inside the first top-level node:
+    const nestingLevels = [0];
+    let countNesting = nestingNodeTypes !== undefined;
+
+    while (depth > 0) {
+        const type = cursor.nodeType;
+        let descend = false;
+
+        if (countNesting) {
+            const nestingLevel = nestingLevels[depth - 1] + (nestingNodeTypes!.has(type) ? 1 : 0);
+            nestingLevels[depth] = nestingLevel;
+            result.maxNestingLevel = Math.max(result.maxNestingLevel, nestingLevel - 1);
+            descend = true;
+        }
+
+        if (depth <= realLinesDepthLimit) {
+            realLinesDepthLimit = Number.POSITIVE_INFINITY;
+
+            if (isComment(type, cursor, realLinesRules!)) {
+                realLinesDepthLimit = depth;
+            } else {
+                const startRow = cursor.startPosition.row;
+                const endRow = cursor.endPosition.row;
+                if (startRow > lastCountedLine) {
+                    lastCountedLine = startRow;
+                    result.realLinesOfCode++;
+                }
+
+                // Add further lines of leaf nodes that span over multiple lines and are no line ending:
+                if (
+                    (type === "heredoc_body" && realLinesRules!.countAllHeredocLines) ||
+                    (!hasChildren(cursor) && !isLineBreak(type))
+                ) {
+                    if (endRow > lastCountedLine) {
+                        result.realLinesOfCode += endRow - startRow;
+                        lastCountedLine = endRow;
+                    }
+
+                    realLinesDepthLimit = depth;
+                } else if (endRow > startRow) {
+                    descend = true;
+                } else {
+                    // Single-line nodes do not add further lines:
+                    realLinesDepthLimit = depth;
+                }
+            }
+        }
+
+        if (descend && cursor.gotoFirstChild()) {
+            depth++;
+            continue;
+        }
+
+        // Go to the next sibling, or up until there is a next sibling:
+        while (depth > 0 && !cursor.gotoNextSibling()) {
+            cursor.gotoParent();
+            depth--;
+        }
+
+        if (depth === 1) {
+            // The nesting level is only calculated for the first top-level node:
+            countNesting = false;
+            if (realLinesRules === undefined) {
+                return result;
+            }
+        }
+    }
+
+    return result;
+}
+
+function isComment(type: string, cursor: TreeCursor, rules: RealLinesOfCodeRules): boolean {
+    return (
+        rules.commentNodeTypes.has(type) ||
+        (rules.stringStatementsAreComments && isStringStatement(type, cursor))
+    );
+}
+
+/**
+ * Checks whether the current node is a statement that consists of a single string,
+ * i.e. a string that is neither assigned to a variable nor used as a call parameter.
+ * Leaves the cursor at the current node.
+ */
+function isStringStatement(type: string, cursor: TreeCursor): boolean {
+    if (type !== "expression_statement" || !cursor.gotoFirstChild()) {
+        return false;
+    }
+
+    const isString = cursor.nodeType === "string" && !cursor.gotoNextSibling();
+    cursor.gotoParent();
+    return isString;
+}
+
+/**
+ * Checks whether the current node has child nodes. Leaves the cursor at the current node.
+ */
+function hasChildren(cursor: TreeCursor): boolean {
+    if (!cursor.gotoFirstChild()) {
+        return false;
+    }
+
+    cursor.gotoParent();
+    return true;
+}
+
+function isLineBreak(type: string): boolean {
+    return "\r\n".includes(type);
+}
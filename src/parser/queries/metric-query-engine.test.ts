@@ -0,0 +1,221 @@
+import { beforeAll, describe, expect, it, vi } from "vitest";
+import Parser = require("tree-sitter");
+import { getGrammar, Language } from "../../helper/language.js";
+import { type NodeTypeConfig } from "../../helper/model.js";
+import nodeTypesConfig from "../config/node-types-config.json" with { type: "json" };
+import { type MetricName, type MetricResult, ParsedFile } from "../metrics/metric.js";
+import { Complexity } from "../metrics/complexity.js";
+import { Functions } from "../metrics/functions.js";
+import { Classes } from "../metrics/classes.js";
+import { CommentLines } from "../metrics/comment-lines.js";
+import { createKeywordsInCommentsMetrics } from "../metrics/keywords-in-comments.js";
+import { type QueryStatement, SimpleQueryStatement } from "./query-statements.js";
+import {
+    countQueryPatterns,
+    getQueryMatchCount,
+    getQueryMatches,
+    MetricQueryEngine,
+    type MetricQueryResult,
+    type QueryMetric,
+    removeQueryCaptures,
+} from "./metric-query-engine.js";
+
+const javaSourceCode = `
+// TODO: document this class
+public class Example {
+    { System.out.println("init"); }
+
+    /* Returns the sign,
+       or zero (hack) */
+    int sign(int x) {
+        if (x > 0 && x != 1 || x == 1) {
+            return 1;
+        }
+        return x < 0 ? -1 : 0;
+    }
+
+    enum Color { RED, GREEN }
+}
+`;
+
+/**
+ * Metric counting the matches of fixed query statements.
+ */
+class StatementCounter implements QueryMetric {
+    constructor(readonly statements: QueryStatement[]) {}
+
+    getQueryStatements(): QueryStatement[] {
+        return this.statements;
+    }
+
+    calculate(parsedFile: ParsedFile, queryResult?: MetricQueryResult): MetricResult {
+        return {
+            metricName: this.getName(),
+            metricValue: getQueryMatches(this, parsedFile, queryResult).length,
+        };
+    }
+
+    getName(): MetricName {
+        return "functions";
+    }
+}
+
+describe("countQueryPatterns(...)", () => {
+    it("should count the top-level patterns", () => {
+        expect(countQueryPatterns("(if_statement) @if")).toBe(1);
+        expect(countQueryPatterns("(a (b) @b) (c)\n[(d) (e)] @de")).toBe(3);
+        expect(countQueryPatterns(`(assignment_operator "??=")`)).toBe(1);
+    });
+
+    it("should count top-level strings as patterns", () => {
+        expect(countQueryPatterns(`"&&" @and "||"`)).toBe(2);
+    });
+
+    it("should ignore parentheses in strings and comments", () => {
+        expect(countQueryPatterns(`(a "(") ; (b)\n")" "\\"("`)).toBe(3);
+    });
+
+    it("should count the patterns of an empty string as zero", () => {
+        expect(countQueryPatterns("")).toBe(0);
+    });
+});
+
+/**
+ * Metric counting the matches of fixed query statements, without needing the matches themselves.
+ */
+class MatchCounter extends StatementCounter {
+    readonly countsMatchesOnly = true;
+
+    override calculate(parsedFile: ParsedFile, queryResult?: MetricQueryResult): MetricResult {
+        return {
+            metricName: this.getName(),
+            metricValue: getQueryMatchCount(this, parsedFile, queryResult),
+        };
+    }
+}
+
+describe("removeQueryCaptures(...)", () => {
+    it("should remove all captures", () => {
+        expect(removeQueryCaptures("(if_statement) @if")).toBe("(if_statement) ");
+        expect(removeQueryCaptures("(a (b) @b.name) @a-b\n[(d) (e)] @de")).toBe(
+            "(a (b) ) \n[(d) (e)] ",
+        );
+    });
+
+    it("should keep @ in strings and comments", () => {
+        expect(removeQueryCaptures(`(decorator "@") @decorator ; @comment\n(a) @a`)).toBe(
+            `(decorator "@")  ; @comment\n(a) `,
+        );
+        expect(removeQueryCaptures(`("\\"@") @quote`)).toBe(`("\\"@") `);
+    });
+});
+
+describe("MetricQueryEngine", () => {
+    let parsedFile: ParsedFile;
+    const allNodeTypes = nodeTypesConfig as NodeTypeConfig[];
+
+    beforeAll(() => {
+        const parser = new Parser();
+        parser.setLanguage(getGrammar(Language.Java));
+        parsedFile = new ParsedFile(
+            "Example.java",
+            Language.Java,
+            parser.parse(javaSourceCode),
+            javaSourceCode,
+        );
+    });
+
+    it("should calculate the same metric values as separate queries for each metric", () => {
+        const commentLines = new CommentLines(allNodeTypes);
+        const queryMetrics = [
+            new Complexity(allNodeTypes),
+            new Functions(allNodeTypes),
+            new Classes(allNodeTypes),
+            commentLines,
+        ];
+        // Counts the keywords in the comments captured for the comment lines, without a query of its own:
+        const [keywordsInComments] = createKeywordsInCommentsMetrics(commentLines);
+        const metrics = [...queryMetrics, keywordsInComments];
+        const engine = new MetricQueryEngine(queryMetrics);
+
+        const queryResult = engine.execute(parsedFile);
+
+        const combinedResults = metrics.map((metric) => metric.calculate(parsedFile, queryResult));
+        const separateResults = metrics.map((metric) => metric.calculate(parsedFile));
+        expect(combinedResults).toEqual(separateResults);
+        expect(combinedResults.map((result) => result.metricValue)).toEqual([6, 2, 2, 3, 2]);
+    });
+
+    it("should pass matches of a statement to all metrics that registered it", () => {
+        const methods = new SimpleQueryStatement("(method_declaration) @method");
+        const classes = new SimpleQueryStatement("(class_declaration) @class");
+        const first = new StatementCounter([methods, classes]);
+        const second = new StatementCounter([classes]);
+        const engine = new MetricQueryEngine([first, second]);
+
+        const queryResult = engine.execute(parsedFile);
+
+        expect(queryResult.getMatches(first)).toHaveLength(2);
+        expect(queryResult.getMatches(second)).toHaveLength(1);
+        expect(queryResult.getMatches(second)![0].captures[0].name).toBe("class");
+    });
+
+    it("should count matches multiple times if a metric registers a statement multiple times", () => {
+        const methods = new SimpleQueryStatement("(method_declaration) @method");
+        const metric = new StatementCounter([methods, methods]);
+        const engine = new MetricQueryEngine([metric, new StatementCounter([methods])]);
+
+        expect(metric.calculate(parsedFile, engine.execute(parsedFile)).metricValue).toBe(2);
+        expect(metric.calculate(parsedFile).metricValue).toBe(2);
+    });
+
+    it("should only count the matches of metrics that only need the number of matches", () => {
+        const methods = new SimpleQueryStatement("(method_declaration) @method");
+        const classes = new SimpleQueryStatement("(class_declaration) @class");
+        const counter = new MatchCounter([methods, classes]);
+        const collector = new StatementCounter([classes]);
+        const engine = new MetricQueryEngine([counter, collector]);
+
+        const queryResult = engine.execute(parsedFile);
+
+        expect(queryResult.getMatches(counter)).toBeUndefined();
+        expect(queryResult.getMatchCount(counter)).toBe(2);
+        expect(counter.calculate(parsedFile, queryResult)).toEqual(counter.calculate(parsedFile));
+        // The statement shared with a metric that needs the matches keeps its captures:
+        expect(queryResult.getMatchCount(collector)).toBe(1);
+        expect(queryResult.getMatches(collector)![0].captures[0].name).toBe("class");
+    });
+
+    it("should keep the captures of count-only statements with predicates", () => {
+        const statement = new SimpleQueryStatement('((identifier) @name (#eq? @name "x"))');
+        const counter = new MatchCounter([statement]);
+        const engine = new MetricQueryEngine([counter]);
+
+        expect(counter.calculate(parsedFile, engine.execute(parsedFile))).toEqual(
+            counter.calculate(parsedFile),
+        );
+    });
+
+    it("should return no matches for metrics without statements for the language", () => {
+        const metric = new StatementCounter([]);
+        const engine = new MetricQueryEngine([metric]);
+
+        expect(engine.execute(parsedFile).getMatches(metric)).toEqual([]);
+    });
+
+    it("should only try to build the combined query once per language if it cannot be built", () => {
+        const metric = new StatementCounter([new SimpleQueryStatement("(no_such_node) @node")]);
+        const getQueryStatementsSpied = vi.spyOn(metric, "getQueryStatements");
+        const engine = new MetricQueryEngine([metric]);
+
+        expect(() => engine.execute(parsedFile)).toThrowError();
+        expect(() => engine.execute(parsedFile)).toThrowError();
+        expect(getQueryStatementsSpied).toHaveBeenCalledTimes(1);
+    });
+
+    it("should return undefined for metrics that are not part of the query", () => {
+        const engine = new MetricQueryEngine([]);
+
+        expect(engine.execute(parsedFile).getMatches(new StatementCounter([]))).toBeUndefined();
+    });
+});
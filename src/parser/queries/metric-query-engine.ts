@@ -0,0 +1,394 @@
+import { debuglog, type DebugLoggerFunction } from "node:util";
+import { type Query, type QueryMatch } from "tree-sitter";
+import { type Language } from "../../helper/language.js";
+import { profiler } from "../../helper/profiler.js";
+import { type Metric, type ParsedFile } from "../metrics/metric.js";
+import { QueryBuilder } from "./query-builder.js";
+import { type QueryStatement, SimpleQueryStatement } from "./query-statements.js";
+
+let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
+    dlog = logger;
+});
+
+/**
+ * Metric that is calculated on the matches of tree-sitter query statements.
+ * Instead of running its own query, such a metric registers its query statements,
+ * so that the {@link MetricQueryEngine} can combine the statements of all metrics to a single query per language.
+ */
+export type QueryMetric = Metric & {
+    /**
+     * Returns the query statements on whose matches the metric is calculated.
+     * Statements that are not applicable or not activated for the language are ignored.
+     * @param language Language of the file the query is run on.
+     */
+    getQueryStatements(language: Language): QueryStatement[];
+
+    /**
+     * Whether the metric only needs the number of matches of its query statements.
+     * The matches of such a metric are only counted, and the captures are removed from its query statements
+     * when they are not shared with other metrics, so that no objects are created for the matches
+     * and their captured nodes.
+     */
+    readonly countsMatchesOnly?: boolean;
+};
+
+export function isQueryMetric(metric: Metric): metric is QueryMetric {
+    return "getQueryStatements" in metric;
+}
+
+/**
+ * Combined query of all metrics for one language,
+ * with a mapping from the pattern index to the metrics that registered the pattern.
+ */
+type MetricQueryPlan = {
+    query: Query | undefined;
+    patternOwners: QueryMetric[][];
+};
+
+/**
+ * Matches of the combined query on a single file, grouped by the metrics that registered the matching patterns.
+ * For metrics that only count matches, only the number of matches is kept.
+ */
+export class MetricQueryResult {
+    readonly #matchesByMetric: Map<QueryMetric, QueryMatch[]>;
+    readonly #matchCountsByMetric: Map<QueryMetric, number>;
+
+    constructor(
+        matchesByMetric: Map<QueryMetric, QueryMatch[]>,
+        matchCountsByMetric = new Map<QueryMetric, number>(),
+    ) {
+        this.#matchesByMetric = matchesByMetric;
+        this.#matchCountsByMetric = matchCountsByMetric;
+    }
+
+    /**
+     * Returns the matches of the query statements registered by the specified metric.
+     * @param metric The metric.
+     * @return The matches in the order they were found, or undefined if the metric is not part of the query
+     * or only counts matches.
+     */
+    getMatches(metric: QueryMetric): QueryMatch[] | undefined {
+        return this.#matchesByMetric.get(metric);
+    }
+
+    /**
+     * Returns the number of matches of the query statements registered by the specified metric.
+     * @param metric The metric.
+     * @return The number of matches, or undefined if the metric is not part of the query.
+     */
+    getMatchCount(metric: QueryMetric): number | undefined {
+        return this.#matchCountsByMetric.get(metric) ?? this.#matchesByMetric.get(metric)?.length;
+    }
+}
+
+/**
+ * Runs the query statements of multiple metrics as one tree-sitter query,
+ * so that the syntax tree of a file is only traversed once for all of these metrics.
+ *
+ * Identical query statements of different metrics are only included once in the combined query.
+ * Each match is passed to all metrics that registered the pattern that matched.
+ */
+export class MetricQueryEngine {
+    readonly #metrics: QueryMetric[];
+    /**
+     * Plans by language, or the error that occurred while building the plan for the language.
+     */
+    readonly #plans = new Map<Language, MetricQueryPlan | Error>();
+
+    /**
+     * Constructs a new {@link MetricQueryEngine} for the specified metrics.
+     * @param metrics Metrics whose query statements should be combined.
+     */
+    constructor(metrics: QueryMetric[]) {
+        this.#metrics = metrics;
+    }
+
+    /**
+     * Runs the combined query of all metrics on the syntax tree of the specified file.
+     * @param parsedFile The file to run the query on.
+     * @return The matches, grouped by the metrics they belong to.
+     * @throws Error If the combined query cannot be built for the language of the file.
+     * The error is kept, so the query is only built once per language and each further file of the language
+     * fails immediately, so that the metrics can fall back to their own queries.
+     */
+    execute(parsedFile: ParsedFile): MetricQueryResult {
+        const { query, patternOwners } = this.#getPlan(parsedFile.language);
+
+        const matchesByMetric = new Map<QueryMetric, QueryMatch[]>();
+        const matchCountsByMetric = new Map<QueryMetric, number>();
+        for (const metric of this.#metrics) {
+            if (metric.countsMatchesOnly === true) {
+                matchCountsByMetric.set(metric, 0);
+            } else {
+                matchesByMetric.set(metric, []);
+            }
+        }
+
+        if (query !== undefined) {
+            for (const match of query.matches(parsedFile.tree.rootNode)) {
+                for (const metric of patternOwners[match.pattern]) {
+                    const matches = matchesByMetric.get(metric);
+                    if (matches === undefined) {
+                        matchCountsByMetric.set(metric, matchCountsByMetric.get(metric)! + 1);
+                    } else {
+                        matches.push(match);
+                    }
+                }
+            }
+        }
+
+        return new MetricQueryResult(matchesByMetric, matchCountsByMetric);
+    }
+
+    #getPlan(language: Language): MetricQueryPlan {
+        let plan = this.#plans.get(language);
+        if (plan === undefined) {
+            try {
+                plan = profiler.measure("metric plan", () => this.#buildPlan(language), {
+                    language,
+                });
+            } catch (error) {
+                plan = error instanceof Error ? error : new Error(String(error));
+            }
+
+            this.#plans.set(language, plan);
+        }
+
+        if (plan instanceof Error) {
+            throw plan;
+        }
+
+        return plan;
+    }
+
+    #buildPlan(language: Language): MetricQueryPlan {
+        const statements: string[] = [];
+        const statementOwners: QueryMetric[][] = [];
+        const statementIndices = new Map<string, number>();
+
+        for (const metric of this.#metrics) {
+            // A metric can register the same statement multiple times, which counts its matches multiple times.
+            // So only share statements between metrics, but not within the statements of one metric.
+            const occurrences = new Map<string, number>();
+
+            for (const statement of metric.getQueryStatements(language)) {
+                if (!statement.applicableFor(language) || !statement.activatedFor(language)) {
+                    continue;
+                }
+
+                const statementString = statement.toString();
+                const occurrence = occurrences.get(statementString) ?? 0;
+                occurrences.set(statementString, occurrence + 1);
+
+                const key = occurrence.toString() + ":" + statementString;
+                let index = statementIndices.get(key);
+                if (index === undefined) {
+                    index = statements.length;
+                    statementIndices.set(key, index);
+                    statements.push(statementString);
+                    statementOwners.push([]);
+                }
+
+                statementOwners[index].push(metric);
+            }
+        }
+
+        if (statements.length === 0) {
+            return { query: undefined, patternOwners: [] };
+        }
+
+        for (const [index, statement] of statements.entries()) {
+            // Without captures, matches of count-only statements do not create any node objects.
+            // Statements with predicates keep their captures, as the predicates refer to them.
+            if (
+                statementOwners[index].every((metric) => metric.countsMatchesOnly === true) &&
+                !statement.includes("#")
+            ) {
+                statements[index] = removeQueryCaptures(statement);
+            }
+        }
+
+        const patternOwners: QueryMetric[][] = [];
+        for (const [index, statement] of statements.entries()) {
+            const patternCount = countQueryPatterns(statement);
+            for (let i = 0; i < patternCount; i++) {
+                patternOwners.push(statementOwners[index]);
+            }
+        }
+
+        const queryBuilder = new QueryBuilder(language);
+        queryBuilder.addStatements(
+            statements.map((statement) => new SimpleQueryStatement(statement)),
+        );
+        const query = queryBuilder.build();
+
+        if (query.predicates.length !== patternOwners.length) {
+            throw new Error(
+                "Unable to assign the patterns of the combined metric query for language " +
+                    language +
+                    " to the metrics: expected " +
+                    patternOwners.length.toString() +
+                    " patterns, but the query has " +
+                    query.predicates.length.toString(),
+            );
+        }
+
+        dlog(
+            "Combined metric query for " +
+                language +
+                ": " +
+                patternOwners.length.toString() +
+                " patterns",
+        );
+
+        return { query, patternOwners };
+    }
+}
+
+/**
+ * Runs the query statements of the specified metric on a file and returns the matches.
+ * Reuses the matches of a combined query if they are available.
+ * @param metric The metric.
+ * @param parsedFile The file to run the query on.
+ * @param queryResult Result of the combined query on the file, if available.
+ */
+export function getQueryMatches(
+    metric: QueryMetric,
+    parsedFile: ParsedFile,
+    queryResult?: MetricQueryResult,
+): QueryMatch[] {
+    const matches = queryResult?.getMatches(metric);
+    if (matches !== undefined) {
+        return matches;
+    }
+
+    const { language, tree } = parsedFile;
+    const queryBuilder = new QueryBuilder(language);
+    queryBuilder.addStatements([...metric.getQueryStatements(language)]);
+    return queryBuilder.build().matches(tree.rootNode);
+}
+
+/**
+ * Returns the number of matches of the query statements of the specified metric on a file.
+ * Reuses the result of a combined query if it is available.
+ * @param metric The metric.
+ * @param parsedFile The file to run the query on.
+ * @param queryResult Result of the combined query on the file, if available.
+ */
+export function getQueryMatchCount(
+    metric: QueryMetric,
+    parsedFile: ParsedFile,
+    queryResult?: MetricQueryResult,
+): number {
+    return queryResult?.getMatchCount(metric) ?? getQueryMatches(metric, parsedFile).length;
+}
+
+/**
+ * Removes all captures like "@name" from a tree-sitter query string, ignoring comments and the contents of strings.
+ * Matches of the patterns are still found, but without any captured nodes.
+ * @param queryString The query string, which must not contain predicates.
+ * @return The query string without captures.
+ */
+export function removeQueryCaptures(queryString: string): string {
+    let result = "";
+    let i = 0;
+
+    while (i < queryString.length) {
+        const char = queryString[i];
+        if (char === '"') {
+            // Copy the string, including escaped quotes:
+            const start = i++;
+            while (i < queryString.length && queryString[i] !== '"') {
+                if (queryString[i] === "\\") {
+                    i++;
+                }
+
+                i++;
+            }
+
+            result += queryString.slice(start, ++i);
+        } else if (char === ";") {
+            // Copy the comment until the end of the line:
+            const end = queryString.indexOf("\n", i);
+            result += queryString.slice(i, end === -1 ? queryString.length : end);
+            i = end === -1 ? queryString.length : end;
+        } else if (char === "@") {
+            // Skip the capture name:
+            i++;
+            while (i < queryString.length && /[\w.-]/.test(queryString[i])) {
+                i++;
+            }
+        } else {
+            result += char;
+            i++;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Counts the top-level patterns of a tree-sitter query string.
+ * These are the parenthesized or bracketed expressions and the strings on the top level of the query,
+ * ignoring comments and the contents of strings.
+ * @param queryString The query string.
+ * @return The number of patterns, which is equal to the number of pattern indices the query string
+ * occupies when it is compiled as part of a larger query.
+ */
+export function countQueryPatterns(queryString: string): number {
+    let patterns = 0;
+    let depth = 0;
+
+    for (let i = 0; i < queryString.length; i++) {
+        switch (queryString[i]) {
+            case '"': {
+                if (depth === 0) {
+                    patterns++;
+                }
+
+                // Skip the string, including escaped quotes:
+                i++;
+                while (i < queryString.length && queryString[i] !== '"') {
+                    if (queryString[i] === "\\") {
+                        i++;
+                    }
+
+                    i++;
+                }
+
+                break;
+            }
+
+            case ";": {
+                // Skip the comment until the end of the line:
+                while (i < queryString.length && queryString[i] !== "\n") {
+                    i++;
+                }
+
+                break;
+            }
+
+            case "(":
+            case "[": {
+                if (depth === 0) {
+                    patterns++;
+                }
+
+                depth++;
+                break;
+            }
+
+            case ")":
+            case "]": {
+                depth--;
+                break;
+            }
+
+            default: {
+                break;
+            }
+        }
+    }
+
+    return patterns;
+}
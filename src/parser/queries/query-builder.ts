@@ -1,6 +1,6 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
 import { Query } from "tree-sitter";
-import { type Language, languageToGrammar } from "../../helper/language.js";
+import { getGrammar, type Language } from "../../helper/language.js";
 import { type QueryStatement } from "./query-statements.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
@@ -69,7 +69,7 @@ export class QueryBuilder {
             }
         }
 
-        const newQuery = new Query(languageToGrammar.get(this.#language), queryString);
+        const newQuery = new Query(getGrammar(this.#language), queryString);
         treeSitterQueryCache.get(this.#language)?.set(queryString, newQuery);
 
         return newQuery;
@@ -1,6 +1,6 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
 import { type Query, type QueryCapture, type QueryMatch } from "tree-sitter";
-import { type TypeInfo } from "../types/abstract-collector.js";
+import { type TypeDeclaration, type TypeInfo } from "../types/abstract-collector.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
@@ -14,18 +14,23 @@ export type Accessor = {
 };
 
 export abstract class AbstractCollector {
+    /**
+     * The query is the same for all files, so it is only built and compiled once per collector.
+     */
+    #accessorsQuery: Query | undefined;
+
     getAccessorsFromFile(
         filePath: string,
-        typesFromFile: Map<FullyQualifiedName, TypeInfo>,
+        typesFromFile: Map<FullyQualifiedName, TypeDeclaration>,
     ): Map<string, Accessor[]> {
         const accessorsMap = new Map<string, Accessor[]>();
 
-        const accessorsQuery = this.getAccessorsQuery();
+        const accessorsQuery = (this.#accessorsQuery ??= this.getAccessorsQuery());
 
-        for (const [fullyQualifiedTypeName, typeInfo] of typesFromFile) {
+        for (const [fullyQualifiedTypeName, { typeInfo, node }] of typesFromFile) {
             let accessorMatches: QueryMatch[] = [];
             if (accessorsQuery !== undefined) {
-                accessorMatches = accessorsQuery.matches(typeInfo.node!);
+                accessorMatches = accessorsQuery.matches(node!);
             }
 
             for (const match of accessorMatches) {
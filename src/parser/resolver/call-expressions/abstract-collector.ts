@@ -1,8 +1,9 @@
 import { debuglog, type DebugLoggerFunction } from "node:util";
 import { type Query, type QueryCapture, type QueryMatch, type Tree } from "tree-sitter";
 import { type ParsedFile, type UsageType } from "../../metrics/metric.js";
-import { type TypeInfo } from "../types/abstract-collector.js";
+import { type TypeDeclaration, type TypeInfo } from "../types/abstract-collector.js";
 import { GroupedImportMatch, type ImportMatch, SimpleImportMatch } from "./import-match.js";
+import { type TypeRange, TypeRangeIndex } from "./type-range-index.js";
 
 let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
     dlog = logger;
@@ -14,6 +15,11 @@ export type Import = {
     alias: string;
 };
 
+type TypeDeclarationRange = TypeRange & {
+    FQTN: FullyQualifiedName;
+    captures: QueryCapture[];
+};
+
 type UsageCapture = {
     name: string;
     text: string;
@@ -38,14 +44,20 @@ export type CallExpression = {
 export abstract class AbstractCollector {
     private readonly fileToTypeNameToImportReference = new Map<string, Map<string, Import>>();
 
+    /**
+     * The queries are the same for all files, so they are only built and compiled once per collector.
+     */
+    #importsQuery: Query | undefined;
+    #usagesQuery: Query | undefined;
+
     getUsageCandidates(
         parsedFile: ParsedFile,
-        typesFromFile: Map<FullyQualifiedName, TypeInfo>,
+        typesFromFile: Map<FullyQualifiedName, TypeDeclaration>,
     ): {
         usageCandidates: UsageCandidate[];
         callExpressions: CallExpression[];
     } {
-        const { filePath } = parsedFile;
+        const { filePath, tree } = parsedFile;
         this.fileToTypeNameToImportReference.set(filePath, new Map());
 
         const importReferences = this.getImports(parsedFile);
@@ -55,11 +67,15 @@ export abstract class AbstractCollector {
 
         const { usageCandidates, callExpressions } = this.getUsages(
             filePath,
+            tree,
             typesFromFile,
             importReferences,
         );
         dlog("UsagesAndCandidates", filePath, usageCandidates);
 
+        // The imports are only needed to resolve the usages in this file:
+        this.fileToTypeNameToImportReference.delete(filePath);
+
         return {
             usageCandidates,
             callExpressions,
@@ -83,7 +99,10 @@ export abstract class AbstractCollector {
     private getImports(parsedFile: ParsedFile): Import[] {
         const { filePath, tree } = parsedFile;
 
-        const queryMatches = this.getQueryMatchesFromTree(tree, this.getImportsQuery());
+        const queryMatches = this.getQueryMatchesFromTree(
+            tree,
+            (this.#importsQuery ??= this.getImportsQuery()),
+        );
 
         const importReferences = queryMatches.map((queryMatch): Import => {
             return this.buildImportReference(queryMatch, filePath);
@@ -127,7 +146,8 @@ export abstract class AbstractCollector {
 
     private getUsages(
         filePath: FilePath,
-        typesFromFile: Map<FullyQualifiedName, TypeInfo>,
+        tree: Tree,
+        typesFromFile: Map<FullyQualifiedName, TypeDeclaration>,
         importReferences: Import[],
     ): {
         usageCandidates: UsageCandidate[];
@@ -136,8 +156,14 @@ export abstract class AbstractCollector {
         const usagesAndCandidates: UsageCandidate[] = [];
         const callExpressions: CallExpression[] = [];
 
-        for (const [FQTN, typeInfo] of typesFromFile.entries()) {
-            const usageCaptures: UsageCapture[] = this.getUsageCaptures(FQTN, typeInfo);
+        const capturesByType = this.getQueryCapturesByType(tree, typesFromFile);
+
+        for (const [FQTN, { typeInfo }] of typesFromFile.entries()) {
+            const usageCaptures: UsageCapture[] = this.getUsageCaptures(
+                FQTN,
+                typeInfo,
+                capturesByType.get(FQTN) ?? [],
+            );
 
             // Resolve usages against import statements and build concrete usages or usage candidates
 
@@ -456,18 +482,55 @@ export abstract class AbstractCollector {
         }
     }
 
-    private getUsageCaptures(FQTN: FullyQualifiedName, typeDeclaration: TypeInfo): UsageCapture[] {
+    /**
+     * Runs the usages query once on the whole file and assigns each capture to the innermost type declaration
+     * containing it, as well as to all declarations enclosing that one.
+     * This yields the same captures for each type as running the query on the node of each declaration,
+     * without scanning the body of a nested type again for every type it is nested in.
+     */
+    private getQueryCapturesByType(
+        tree: Tree,
+        typesFromFile: Map<FullyQualifiedName, TypeDeclaration>,
+    ): Map<FullyQualifiedName, QueryCapture[]> {
+        const declarations: TypeDeclarationRange[] = [];
+        for (const [FQTN, { node }] of typesFromFile) {
+            if (node !== undefined) {
+                const { startIndex, endIndex } = node;
+                declarations.push({ FQTN, startIndex, endIndex, captures: [] });
+            }
+        }
+
+        const capturesByType = new Map<FullyQualifiedName, QueryCapture[]>();
+        const usagesQuery = (this.#usagesQuery ??= this.getUsagesQuery());
+        if (declarations.length === 0 || usagesQuery === undefined) {
+            return capturesByType;
+        }
+
+        const declarationIndex = new TypeRangeIndex(declarations);
+        for (const capture of usagesQuery.captures(tree.rootNode)) {
+            const { startIndex, endIndex } = capture.node;
+            for (const declaration of declarationIndex.getEnclosing(startIndex, endIndex)) {
+                declaration.captures.push(capture);
+            }
+        }
+
+        for (const { FQTN, captures } of declarations) {
+            capturesByType.set(FQTN, captures);
+        }
+
+        return capturesByType;
+    }
+
+    private getUsageCaptures(
+        FQTN: FullyQualifiedName,
+        typeInfo: TypeInfo,
+        captures: QueryCapture[],
+    ): UsageCapture[] {
         const usageCaptures: UsageCapture[] = this.getBaseClassAndInterfaceUsageCaptures(
             FQTN,
-            typeDeclaration,
+            typeInfo,
         );
 
-        const usagesQuery = this.getUsagesQuery();
-        let captures: QueryCapture[] = [];
-        if (usagesQuery !== undefined) {
-            captures = usagesQuery.captures(typeDeclaration.node!);
-        }
-
         for (const capture of captures) {
             usageCaptures.push({
                 name: capture.name,
@@ -0,0 +1,42 @@
+import { describe, expect, it } from "vitest";
+import { TypeRangeIndex } from "./type-range-index.js";
+
+describe("TypeRangeIndex", () => {
+    const outer = { name: "Outer", startIndex: 10, endIndex: 100 };
+    const first = { name: "First", startIndex: 20, endIndex: 40 };
+    const nested = { name: "Nested", startIndex: 25, endIndex: 35 };
+    const second = { name: "Second", startIndex: 50, endIndex: 90 };
+    const other = { name: "Other", startIndex: 120, endIndex: 150 };
+
+    const index = new TypeRangeIndex([other, second, nested, outer, first]);
+    const getEnclosing = (startIndex: number, endIndex: number): string[] =>
+        index.getEnclosing(startIndex, endIndex).map(({ name }) => name);
+
+    it("should return the innermost declaration containing a range, followed by the enclosing ones", () => {
+        expect(getEnclosing(27, 30)).toEqual(["Nested", "First", "Outer"]);
+        expect(getEnclosing(21, 24)).toEqual(["First", "Outer"]);
+        expect(getEnclosing(60, 70)).toEqual(["Second", "Outer"]);
+        expect(getEnclosing(130, 150)).toEqual(["Other"]);
+    });
+
+    it("should skip declarations that end before the range", () => {
+        expect(getEnclosing(36, 39)).toEqual(["First", "Outer"]);
+        expect(getEnclosing(45, 48)).toEqual(["Outer"]);
+        expect(getEnclosing(95, 99)).toEqual(["Outer"]);
+    });
+
+    it("should return no declarations for ranges outside of all declarations or overlapping their end", () => {
+        expect(getEnclosing(0, 5)).toEqual([]);
+        expect(getEnclosing(100, 110)).toEqual([]);
+        expect(getEnclosing(140, 160)).toEqual([]);
+    });
+
+    it("should treat declarations with the same range as nested in each other", () => {
+        const duplicateIndex = new TypeRangeIndex([outer, { ...outer, name: "Duplicate" }]);
+
+        expect(duplicateIndex.getEnclosing(20, 30).map(({ name }) => name)).toEqual([
+            "Duplicate",
+            "Outer",
+        ]);
+    });
+});
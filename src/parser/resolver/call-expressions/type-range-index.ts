@@ -0,0 +1,77 @@
+/**
+ * Byte range of a type declaration in a file, end exclusive.
+ */
+export type TypeRange = {
+    startIndex: number;
+    endIndex: number;
+};
+
+/**
+ * Finds the type declarations of a file that contain a given byte range, e.g. of a query capture.
+ * Like the syntax nodes they are taken from, any two declarations are either disjoint or nested.
+ */
+export class TypeRangeIndex<T extends TypeRange> {
+    /**
+     * The declarations, by their start. Enclosing declarations come before the declarations nested in them.
+     */
+    readonly #ranges: T[];
+    /**
+     * Position of the innermost declaration enclosing each declaration in #ranges, or -1 for none.
+     */
+    readonly #parents: number[] = [];
+
+    constructor(ranges: Iterable<T>) {
+        this.#ranges = [...ranges].sort(
+            (first, second) =>
+                first.startIndex - second.startIndex || second.endIndex - first.endIndex,
+        );
+
+        const open: number[] = [];
+        for (const [position, range] of this.#ranges.entries()) {
+            while (open.length > 0 && this.#ranges[open.at(-1)!].endIndex <= range.startIndex) {
+                open.pop();
+            }
+
+            this.#parents.push(open.at(-1) ?? -1);
+            open.push(position);
+        }
+    }
+
+    /**
+     * Returns the innermost declaration containing the specified byte range,
+     * followed by all declarations enclosing it, from the inside out.
+     */
+    getEnclosing(startIndex: number, endIndex: number): T[] {
+        const enclosing: T[] = [];
+        let position = this.#findLastStartingAt(startIndex);
+        while (position !== -1) {
+            const range = this.#ranges[position];
+            if (endIndex <= range.endIndex) {
+                enclosing.push(range);
+            }
+
+            position = this.#parents[position];
+        }
+
+        return enclosing;
+    }
+
+    /**
+     * Binary search for the last declaration that starts at or before the specified byte.
+     * Only this declaration and the ones enclosing it can contain a range starting at the byte.
+     */
+    #findLastStartingAt(startIndex: number): number {
+        let low = 0;
+        let high = this.#ranges.length;
+        while (low < high) {
+            const middle = Math.floor((low + high) / 2);
+            if (this.#ranges[middle].startIndex <= startIndex) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        return low - 1;
+    }
+}
@@ -5,7 +5,6 @@ import { FileNameStrategy } from "./resolver-strategy/filename-resolver.js";
 
 type TypeName = string;
 export type TypeInfo = {
-    node?: SyntaxNode;
     namespace: string;
     typeName: string;
     classType: ClassType;
@@ -14,16 +13,31 @@ export type TypeInfo = {
     extendedFrom?: string;
     implementedFrom: string[];
 };
+
+/**
+ * A type declared in a parsed file, together with the syntax node of its declaration.
+ * The node is only valid while the syntax tree of the file is alive,
+ * so only the plain type information is kept once the file has been processed.
+ */
+export type TypeDeclaration = {
+    typeInfo: TypeInfo;
+    node: SyntaxNode | undefined;
+};
 export type ClassType = "interface" | "class";
 export type TypesResolvingStrategy = "Query" | "Filename";
 
 export abstract class AbstractCollector {
-    getTypesFromFile(parsedFile: ParsedFile): Map<TypeName, TypeInfo> {
+    /**
+     * The query is the same for all files, so it is only built and compiled once per collector.
+     */
+    #typesQuery: Query | undefined;
+
+    getTypesFromFile(parsedFile: ParsedFile): Map<TypeName, TypeDeclaration> {
         if (this.getTypesResolvingStrategy() === "Query") {
             return new TypesQueryStrategy().getTypesFromFile(
                 parsedFile,
                 this.getNamespaceDelimiter(),
-                this.getTypesQuery(),
+                (this.#typesQuery ??= this.getTypesQuery()),
             );
         }
 
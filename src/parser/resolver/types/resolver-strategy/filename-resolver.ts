@@ -1,7 +1,7 @@
-import { type TypeInfo } from "../abstract-collector.js";
+import { type TypeDeclaration } from "../abstract-collector.js";
 
 export class FileNameStrategy {
-    getTypes(): Map<string, TypeInfo> {
+    getTypes(): Map<string, TypeDeclaration> {
         return new Map();
     }
 }
@@ -4,7 +4,11 @@ import { parse } from "../../../../helper/tree-parser.js";
 import { Configuration } from "../../../configuration.js";
 import { type ParsedFile } from "../../../metrics/metric.js";
 import { CSharpCollector } from "../c-sharp-collector.js";
-import { type AbstractCollector, type TypeInfo } from "../abstract-collector.js";
+import {
+    type AbstractCollector,
+    type TypeDeclaration,
+    type TypeInfo,
+} from "../abstract-collector.js";
 import { PHPCollector } from "../php-collector.js";
 import { TypesQueryStrategy } from "./types-query-strategy.js";
 
@@ -13,11 +17,22 @@ async function getConfiguration(filePath: string): Promise<Configuration> {
         sourcesPath: await fs.realpath(filePath),
         outputPath: "hello.json",
         parseDependencies: true,
+        directoryCoupling: false,
         exclusions: "",
         parseAllHAsC: false,
         parseSomeHAsC: "",
         compress: false,
         relativePaths: true,
+        threads: 1,
+        maxMemory: 0,
+        cacheDir: "",
+        outputFormat: "json",
+        profile: "",
+        skipUnsupportedFiles: false,
+        parseTimeout: 0,
+        maxUnsupportedFileSize: 0,
+        commentKeywords: "",
+        shard: "",
     });
 }
 
@@ -59,7 +74,7 @@ describe("Types Query strategy", () => {
                 implementedFrom: [],
             });
             // When
-            const typesFromFile: Map<FullyQualifiedName, TypeInfo> =
+            const typesFromFile: Map<FullyQualifiedName, TypeDeclaration> =
                 new TypesQueryStrategy().getTypesFromFile(
                     parsedFile,
                     ".",
@@ -67,7 +82,8 @@ describe("Types Query strategy", () => {
                 );
             // Then
             for (const [key, value] of typesFromFile.entries()) {
-                expect(value).toEqual(expect.objectContaining(result.get(key)));
+                expect(value.typeInfo).toEqual(expect.objectContaining(result.get(key)));
+                expect(value.node).toBeDefined();
             }
         });
 
@@ -122,7 +138,8 @@ describe("Types Query strategy", () => {
             );
             // Then
             for (const [key, value] of typesFromFile.entries()) {
-                expect(value).toEqual(expect.objectContaining(result.get(key)));
+                expect(value.typeInfo).toEqual(expect.objectContaining(result.get(key)));
+                expect(value.node).toBeDefined();
             }
         });
 
@@ -171,7 +188,8 @@ describe("Types Query strategy", () => {
             );
             // Then
             for (const [key, value] of typesFromFile.entries()) {
-                expect(value).toEqual(expect.objectContaining(result.get(key)));
+                expect(value.typeInfo).toEqual(expect.objectContaining(result.get(key)));
+                expect(value.node).toBeDefined();
             }
         });
     });
@@ -1,23 +1,16 @@
 import { type Query, type QueryMatch } from "tree-sitter";
-import { type ClassType, type TypeInfo } from "../abstract-collector.js";
+import { type ClassType, type TypeDeclaration } from "../abstract-collector.js";
 import { type ParsedFile } from "../../../metrics/metric.js";
 
 export class TypesQueryStrategy {
-    protected fileToTypesMapCache = new Map<FilePath, Map<FullyQualifiedName, TypeInfo>>();
-
     getTypesFromFile(
         parsedFile: ParsedFile,
         namespaceDelimiter: string,
         typesQuery: Query,
-    ): Map<FullyQualifiedName, TypeInfo> {
+    ): Map<FullyQualifiedName, TypeDeclaration> {
         const { filePath, tree } = parsedFile;
 
-        let typesMap = this.fileToTypesMapCache.get(filePath);
-        if (typesMap !== undefined) {
-            return typesMap;
-        }
-
-        typesMap = new Map<FullyQualifiedName, TypeInfo>();
+        const typesMap = new Map<FullyQualifiedName, TypeDeclaration>();
 
         let matches: QueryMatch[] = [];
         if (typesQuery !== undefined) {
@@ -28,8 +21,6 @@ export class TypesQueryStrategy {
             this.buildTypeInfos(match, filePath, namespaceDelimiter, typesMap);
         }
 
-        this.fileToTypesMapCache.set(filePath, typesMap);
-
         return typesMap;
     }
 
@@ -37,7 +28,7 @@ export class TypesQueryStrategy {
         match: QueryMatch,
         filePath: string,
         namespaceDelimiter: string,
-        typesMap: Map<FullyQualifiedName, TypeInfo>,
+        typesMap: Map<FullyQualifiedName, TypeDeclaration>,
     ): void {
         let namespace = "";
         let classType: ClassType = "class";
@@ -75,20 +66,18 @@ export class TypesQueryStrategy {
 
                 case "type_node": {
                     if (node !== undefined) {
-                        const typeInfo: TypeInfo = {
+                        typesMap.set(namespace + namespaceDelimiter + typeName, {
+                            typeInfo: {
+                                namespace,
+                                typeName,
+                                classType,
+                                sourceFile: filePath,
+                                namespaceDelimiter,
+                                implementedFrom,
+                                extendedFrom,
+                            },
                             node,
-                            namespace,
-                            typeName,
-                            classType,
-                            sourceFile: filePath,
-                            namespaceDelimiter,
-                            implementedFrom,
-                            extendedFrom,
-                        };
-                        typesMap.set(
-                            typeInfo.namespace + namespaceDelimiter + typeInfo.typeName,
-                            typeInfo,
-                        );
+                        });
 
                         classType = "class";
                         extendedFrom = undefined;
@@ -106,16 +95,17 @@ export class TypesQueryStrategy {
             }
         }
 
-        const typeInfo: TypeInfo = {
+        typesMap.set(namespace + namespaceDelimiter + typeName, {
+            typeInfo: {
+                namespace,
+                typeName,
+                classType,
+                sourceFile: filePath,
+                namespaceDelimiter,
+                implementedFrom,
+                extendedFrom,
+            },
             node,
-            namespace,
-            typeName,
-            classType,
-            sourceFile: filePath,
-            namespaceDelimiter,
-            implementedFrom,
-            extendedFrom,
-        };
-        typesMap.set(typeInfo.namespace + namespaceDelimiter + typeInfo.typeName, typeInfo);
+        });
     }
 }
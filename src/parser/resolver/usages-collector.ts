@@ -1,14 +1,14 @@
 import { type ParsedFile } from "../metrics/metric.js";
 import { Factory as UsageCollectorFactory } from "./call-expressions/factory.js";
 import { type UsageCandidate, type CallExpression } from "./call-expressions/abstract-collector.js";
-import type { TypeInfo } from "./types/abstract-collector.js";
+import type { TypeDeclaration } from "./types/abstract-collector.js";
 
 export class UsagesCollector {
     private readonly usageCollectorFactory = new UsageCollectorFactory();
 
     getUsageCandidates(
         parsedFile: ParsedFile,
-        typesFromFile: Map<FullyQualifiedName, TypeInfo>,
+        typesFromFile: Map<FullyQualifiedName, TypeDeclaration>,
     ): {
         usageCandidates: UsageCandidate[];
         callExpressions: CallExpression[];
@@ -0,0 +1,158 @@
+import { formatPrintPath } from "../helper/helper.js";
+import { FileType } from "../helper/language.js";
+import { type Configuration } from "./configuration.js";
+import { type CouplingCalculator } from "./coupling-calculator.js";
+import { type FileMetricResults } from "./metrics/metric.js";
+import { type ProcessedFile } from "./result-cache.js";
+
+/**
+ * Receives the metrics of each file as soon as they are available, in the order in which the files were found.
+ * Processing further files waits for the returned promise, so that the consumer can apply backpressure.
+ * @param filePath Path of the file, formatted for the output.
+ * @param fileMetricResults The metrics calculated on the file.
+ */
+export type FileMetricsConsumer = (
+    filePath: string,
+    fileMetricResults: FileMetricResults,
+) => Promise<void>;
+
+/**
+ * Receives the results of processed files, possibly in a different order than the files were found.
+ */
+export type ResultHandler = {
+    /**
+     * Adds the results of a processed file.
+     * @param index Index of the file in the order in which the files were found.
+     * @param processedFile The results of the file.
+     * @return Promise that resolves as soon as the results of further files can be added.
+     */
+    add(index: number, processedFile: ProcessedFile): Promise<void>;
+};
+
+/**
+ * Handles the results of processed files in the order in which the files were found,
+ * regardless of the order in which their processing completes.
+ * Only the results of files that are waiting for a previous file are kept in the meantime.
+ */
+export class OrderedResultHandler implements ResultHandler {
+    readonly #handle: (processedFile: ProcessedFile, index: number) => Promise<void>;
+
+    readonly #waiting = new Map<number, ProcessedFile>();
+    #next = 0;
+    #handled: Promise<void> = Promise.resolve();
+
+    /**
+     * Constructs a new {@link OrderedResultHandler}.
+     * @param handle Function that handles the results of a file, called in the order of the files.
+     */
+    constructor(handle: (processedFile: ProcessedFile, index: number) => Promise<void>) {
+        this.#handle = handle;
+    }
+
+    /**
+     * Adds the results of a processed file.
+     * @param index Index of the file in the order in which the files were found.
+     * @param processedFile The results of the file.
+     * @return Promise that resolves once the results of the file and all previous files
+     * that are already available have been handled.
+     */
+    async add(index: number, processedFile: ProcessedFile): Promise<void> {
+        this.#waiting.set(index, processedFile);
+        this.#handled = this.#handled.then(async () => this.#handleAvailable());
+        return this.#handled;
+    }
+
+    async #handleAvailable(): Promise<void> {
+        let processedFile = this.#waiting.get(this.#next);
+        while (processedFile !== undefined) {
+            this.#waiting.delete(this.#next);
+            const index = this.#next++;
+
+            await this.#handle(processedFile, index); // eslint-disable-line no-await-in-loop
+            processedFile = this.#waiting.get(this.#next);
+        }
+    }
+}
+
+/**
+ * Collects the results of processed files in the order in which the files were found,
+ * regardless of the order in which their processing completes.
+ *
+ * Passes the coupling data of the files on to the coupling calculation and the file metrics on to the consumer,
+ * or collects them if there is no consumer. Only the results of files that are waiting for a previous file
+ * are kept in the meantime.
+ */
+export class ResultAggregator implements ResultHandler {
+    /**
+     * The metrics of the files, if there is no consumer for them.
+     */
+    readonly fileMetrics = new Map<string, FileMetricResults>();
+    readonly unsupportedFiles: string[] = [];
+    readonly errorFiles: string[] = [];
+
+    readonly #config: Configuration;
+    readonly #couplingParser: CouplingCalculator;
+    readonly #consumer: FileMetricsConsumer | undefined;
+
+    readonly #ordered = new OrderedResultHandler(async (processedFile) =>
+        this.#handle(processedFile),
+    );
+
+    constructor(
+        config: Configuration,
+        couplingParser: CouplingCalculator,
+        consumer: FileMetricsConsumer | undefined,
+    ) {
+        this.#config = config;
+        this.#couplingParser = couplingParser;
+        this.#consumer = consumer;
+    }
+
+    /**
+     * Adds the results of a processed file.
+     * @param index Index of the file in the order in which the files were found.
+     * @param processedFile The results of the file.
+     * @return Promise that resolves once the results of the file and all previous files
+     * that are already available have been handled.
+     */
+    async add(index: number, processedFile: ProcessedFile): Promise<void> {
+        return this.#ordered.add(index, processedFile);
+    }
+
+    async #handle({ fileResult, couplingData }: ProcessedFile): Promise<void> {
+        const { filePath, fileType, fileMetricResults, parseError } = fileResult;
+        const printPath = formatPrintPath(filePath, this.#config);
+
+        if (couplingData !== undefined) {
+            this.#couplingParser.addFile(couplingData);
+        }
+
+        if (fileType === FileType.Error) {
+            this.errorFiles.push(printPath);
+            console.error("Error while parsing the syntax tree for the file " + printPath);
+            console.error(parseError);
+            return;
+        }
+
+        // Inform about errors that occurred while calculating (some) metrics on the syntax tree
+        for (const metricError of fileMetricResults.metricErrors) {
+            console.error(
+                "Error while calculating the metric " +
+                    metricError.metricName +
+                    " on the file " +
+                    filePath,
+            );
+            console.error(metricError.error);
+        }
+
+        if (fileType === FileType.Unsupported) {
+            this.unsupportedFiles.push(printPath);
+        }
+
+        if (this.#consumer === undefined) {
+            this.fileMetrics.set(printPath, fileMetricResults);
+        } else {
+            await this.#consumer(printPath, fileMetricResults);
+        }
+    }
+}
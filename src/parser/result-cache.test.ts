@@ -0,0 +1,132 @@
+import fs from "node:fs/promises";
+import os from "node:os";
+import path from "node:path";
+import { afterEach, beforeEach, describe, expect, it } from "vitest";
+import { getTestConfiguration } from "../../test/metric-end-results/test-helper.js";
+import { FileType } from "../helper/language.js";
+import { type FileResult } from "./metrics/metric.js";
+import { type ProcessedFile, ResultCache } from "./result-cache.js";
+
+describe("ResultCache", () => {
+    let temporaryDir: string;
+    let filePath: string;
+    let resultCache: ResultCache;
+
+    const fileResult = (filePath: string): FileResult => ({
+        filePath,
+        fileType: FileType.SourceCode,
+        fileMetricResults: {
+            fileType: FileType.SourceCode,
+            metricResults: [{ metricName: "lines_of_code", metricValue: 1 }],
+            metricErrors: [],
+        },
+    });
+
+    beforeEach(async () => {
+        temporaryDir = await fs.mkdtemp(path.join(os.tmpdir(), "metric-gardener-"));
+        filePath = path.join(temporaryDir, "file.java");
+        await fs.writeFile(filePath, "class A {}");
+        resultCache = new ResultCache(
+            path.join(temporaryDir, "cache"),
+            getTestConfiguration(temporaryDir),
+        );
+    });
+
+    afterEach(async () => {
+        await fs.rm(temporaryDir, { recursive: true, force: true });
+    });
+
+    it("should return the stored results while the file is unchanged", async () => {
+        const processedFile: ProcessedFile = {
+            fileResult: fileResult(filePath),
+            couplingData: {
+                filePath,
+                types: new Map([
+                    [
+                        "A",
+                        {
+                            namespace: "",
+                            typeName: "A",
+                            classType: "class",
+                            sourceFile: filePath,
+                            namespaceDelimiter: ".",
+                            implementedFrom: [],
+                        },
+                    ],
+                ]),
+                accessors: new Map(),
+                usageCandidates: [],
+                callExpressions: [],
+            },
+        };
+
+        const { key, processedFile: cachedFile } = await resultCache.lookup(filePath);
+        expect(cachedFile).toBeUndefined();
+        await resultCache.store(key, processedFile);
+
+        expect(await resultCache.lookup(filePath)).toEqual({ key, processedFile });
+        expect(resultCache.hits).toBe(1);
+        expect(resultCache.misses).toBe(1);
+    });
+
+    it("should not return the stored results when the file has changed", async () => {
+        const { key } = await resultCache.lookup(filePath);
+        await resultCache.store(key, { fileResult: fileResult(filePath) });
+
+        await fs.writeFile(filePath, "class B {}");
+
+        const lookup = await resultCache.lookup(filePath);
+        expect(lookup.key).not.toBe(key);
+        expect(lookup.processedFile).toBeUndefined();
+        expect(resultCache.misses).toBe(2);
+    });
+
+    it("should return the contents of a supported file that is not cached, so that it is read only once", async () => {
+        const lookup = await resultCache.lookup(filePath);
+
+        expect(lookup.processedFile).toBeUndefined();
+        expect(lookup.contents?.toString()).toBe("class A {}");
+    });
+
+    it("should not read unsupported files larger than the maximum size, but address them by size and modification time", async () => {
+        const largeFilePath = path.join(temporaryDir, "large.txt");
+        await fs.writeFile(largeFilePath, "a".repeat(2 * 1024 * 1024));
+        await fs.utimes(largeFilePath, 1_700_000_000, 1_700_000_000);
+        resultCache = new ResultCache(
+            path.join(temporaryDir, "cache"),
+            getTestConfiguration(temporaryDir, { maxUnsupportedFileSize: 1 }),
+        );
+
+        const { key, contents } = await resultCache.lookup(largeFilePath);
+        expect(contents).toBeUndefined();
+        await resultCache.store(key, { fileResult: fileResult(largeFilePath) });
+
+        // Same size and modification time:
+        await fs.writeFile(largeFilePath, "b".repeat(2 * 1024 * 1024));
+        await fs.utimes(largeFilePath, 1_700_000_000, 1_700_000_000);
+        expect((await resultCache.lookup(largeFilePath)).key).toBe(key);
+
+        await fs.appendFile(largeFilePath, "b");
+        expect((await resultCache.lookup(largeFilePath)).key).not.toBe(key);
+    });
+
+    it("should not store results including errors", async () => {
+        const { key } = await resultCache.lookup(filePath);
+        const result = fileResult(filePath);
+        result.fileMetricResults.metricErrors.push({
+            metricName: "complexity",
+            error: new Error("Failed"),
+        });
+
+        await resultCache.store(key, { fileResult: result });
+
+        expect((await resultCache.lookup(filePath)).processedFile).toBeUndefined();
+    });
+
+    it("should return no key for a file that cannot be read", async () => {
+        const lookup = await resultCache.lookup(path.join(temporaryDir, "missing.java"));
+
+        expect(lookup).toEqual({ key: undefined, processedFile: undefined, contents: undefined });
+        expect(resultCache.misses).toBe(1);
+    });
+});
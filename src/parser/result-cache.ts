@@ -0,0 +1,379 @@
+import { Buffer } from "node:buffer";
+import { createHash, type Hash } from "node:crypto";
+import { createReadStream, existsSync, readFileSync } from "node:fs";
+import fs from "node:fs/promises";
+import { createRequire } from "node:module";
+import path from "node:path";
+import process from "node:process";
+import { fileURLToPath } from "node:url";
+import { debuglog, type DebugLoggerFunction } from "node:util";
+import { assumeLanguageFromFilePath } from "../helper/language.js";
+import { type Configuration } from "./configuration.js";
+import { type FileCouplingData } from "./metrics/coupling/coupling.js";
+import { type FileMetricResults, type FileResult, type MetricName } from "./metrics/metric.js";
+import nodeTypesConfig from "./config/node-types-config.json" with { type: "json" };
+
+let dlog: DebugLoggerFunction = debuglog("metric-gardener", (logger) => {
+    dlog = logger;
+});
+
+/**
+ * Version of the format of the cache entries. Increase it when the format changes.
+ */
+const cacheFormatVersion = "1";
+
+/**
+ * Packages whose versions affect the calculated metrics, in addition to metric-gardener itself.
+ */
+const parserPackages = [
+    "tree-sitter",
+    "tree-sitter-bash",
+    "tree-sitter-c",
+    "tree-sitter-c-sharp",
+    "tree-sitter-cpp",
+    "tree-sitter-go",
+    "tree-sitter-java",
+    "tree-sitter-javascript",
+    "tree-sitter-json",
+    "tree-sitter-kotlin",
+    "tree-sitter-php",
+    "tree-sitter-python",
+    "tree-sitter-ruby",
+    "tree-sitter-rust",
+    "tree-sitter-typescript",
+    "tree-sitter-yaml",
+];
+
+/**
+ * Results of processing a single file: the calculated metrics
+ * and the data extracted for calculating the coupling metrics, if dependencies are analyzed.
+ */
+export type ProcessedFile = {
+    fileResult: FileResult;
+    couplingData?: FileCouplingData;
+};
+
+/**
+ * Error as stored on disk, which is restored as {@link Error} object with the same name, message and stack.
+ */
+type SerializedError = {
+    name: string;
+    message: string;
+    stack?: string;
+};
+
+/**
+ * Format of a {@link ProcessedFile} on disk, e.g. in the cache or in partial results.
+ * Maps are stored as arrays of entries and errors as plain objects.
+ */
+export type SerializedProcessedFile = {
+    fileResult: Omit<FileResult, "fileMetricResults" | "parseError"> & {
+        fileMetricResults: Omit<FileMetricResults, "metricErrors"> & {
+            metricErrors: Array<{ metricName: MetricName; error: SerializedError }>;
+        };
+        parseError?: SerializedError;
+    };
+    couplingData?: Omit<FileCouplingData, "types" | "accessors"> & {
+        types: Array<[string, unknown]>;
+        accessors: Array<[string, unknown]>;
+    };
+};
+
+/**
+ * Result of looking up a file in the cache.
+ */
+export type CacheLookup = {
+    /**
+     * Key under which the results of the file are stored, or undefined if the file could not be read.
+     */
+    key: string | undefined;
+    /**
+     * The cached results, or undefined if there are none for the current contents of the file.
+     */
+    processedFile: ProcessedFile | undefined;
+    /**
+     * The contents of the file if its language is supported, so that they do not have to be read again for parsing.
+     */
+    contents: Buffer | undefined;
+};
+
+/**
+ * On-disk cache for the results of processing files, so that unchanged files do not have to be parsed again.
+ *
+ * Entries are addressed by a hash of the contents and path of the file, its language and a fingerprint
+ * of everything else the results depend on: the versions of metric-gardener and the tree-sitter grammars,
+ * the node types configuration and whether dependencies are analyzed.
+ * Unsupported files larger than the maximum size are not read, so they are addressed by their size
+ * and modification time instead of their contents.
+ * Results including errors are not cached.
+ */
+export class ResultCache {
+    readonly #cacheDir: string;
+    readonly #config: Configuration;
+    readonly #fingerprint: string;
+
+    #hits = 0;
+    #misses = 0;
+
+    /**
+     * Constructs a new {@link ResultCache}.
+     * @param cacheDir Directory in which the cache entries are stored. Created when the first entry is stored.
+     * @param config Configuration of the current run.
+     */
+    constructor(cacheDir: string, config: Configuration) {
+        this.#cacheDir = cacheDir;
+        this.#config = config;
+        this.#fingerprint = getFingerprint(config);
+    }
+
+    /**
+     * Number of files whose results were found in the cache.
+     */
+    get hits(): number {
+        return this.#hits;
+    }
+
+    /**
+     * Number of files whose results were not found in the cache.
+     */
+    get misses(): number {
+        return this.#misses;
+    }
+
+    /**
+     * Looks up the results for the current contents of the specified file.
+     * @param filePath Path of the file.
+     */
+    async lookup(filePath: string): Promise<CacheLookup> {
+        const language = assumeLanguageFromFilePath(filePath, this.#config);
+        const hash = createHash("sha256")
+            .update(this.#fingerprint)
+            .update("\0" + filePath + "\0" + (language ?? "") + "\0");
+        let contents: Buffer | undefined;
+        try {
+            if (language === undefined) {
+                await this.#hashUnsupportedFile(filePath, hash);
+            } else {
+                contents = await hashFile(filePath, hash, true);
+            }
+        } catch {
+            // Let the file be processed normally, which reports the error:
+            this.#misses++;
+            return { key: undefined, processedFile: undefined, contents: undefined };
+        }
+
+        const key = hash.digest("hex");
+        try {
+            const entryFile = await fs.readFile(this.#getEntryPath(key), "utf8");
+            const entry = JSON.parse(entryFile) as SerializedProcessedFile;
+            this.#hits++;
+            return { key, processedFile: deserializeProcessedFile(entry), contents: undefined };
+        } catch {
+            // There is no entry for this key or it cannot be read, e.g. because it has been removed in the meantime.
+            this.#misses++;
+            return { key, processedFile: undefined, contents };
+        }
+    }
+
+    /**
+     * Stores the results of processing a file in the cache, unless they include errors.
+     * @param key Key returned by {@link lookup} for the file.
+     * @param processedFile The results of processing the file.
+     */
+    async store(key: string | undefined, processedFile: ProcessedFile): Promise<void> {
+        const { fileResult } = processedFile;
+        if (
+            key === undefined ||
+            fileResult.parseError !== undefined ||
+            fileResult.fileMetricResults.metricErrors.length > 0
+        ) {
+            return;
+        }
+
+        const entryPath = this.#getEntryPath(key);
+        try {
+            await fs.mkdir(path.dirname(entryPath), { recursive: true });
+
+            // Write to a temporary file first, so that other runs never read incomplete entries:
+            const temporaryPath = entryPath + "." + process.pid.toString() + ".tmp";
+            await fs.writeFile(temporaryPath, JSON.stringify(serializeProcessedFile(processedFile)));
+            await fs.rename(temporaryPath, entryPath);
+        } catch (error) {
+            // The results are still valid, they are only not cached:
+            dlog("Unable to store cache entry " + entryPath + ": " + String(error));
+        }
+    }
+
+    async #hashUnsupportedFile(filePath: string, hash: Hash): Promise<void> {
+        const maxSize = this.#config.maxUnsupportedFileSize * 1024 * 1024;
+        const { size, mtimeMs } = await fs.stat(filePath);
+        if (maxSize > 0 && size > maxSize) {
+            // The lines of the file are not counted, so there is no need to read it:
+            hash.update("stat\0" + size.toString() + "\0" + mtimeMs.toString());
+        } else {
+            hash.update("contents\0");
+            await hashFile(filePath, hash, false);
+        }
+    }
+
+    #getEntryPath(key: string): string {
+        return path.join(this.#cacheDir, key.slice(0, 2), key.slice(2) + ".json");
+    }
+}
+
+/**
+ * Reads the specified file in chunks and adds them to the hash, so that the file is not held in memory as a whole
+ * unless its contents are requested.
+ * @param filePath Path of the file.
+ * @param hash Hash to update.
+ * @param keepContents Whether to return the contents of the file.
+ * @return The contents of the file if requested, undefined otherwise.
+ */
+async function hashFile(
+    filePath: string,
+    hash: Hash,
+    keepContents: boolean,
+): Promise<Buffer | undefined> {
+    const chunks: Buffer[] = [];
+    for await (const chunk of createReadStream(filePath)) {
+        hash.update(chunk as Buffer);
+        if (keepContents) {
+            chunks.push(chunk as Buffer);
+        }
+    }
+
+    return keepContents ? Buffer.concat(chunks) : undefined;
+}
+
+/**
+ * Converts the results of processing a file to a form that can be stored as JSON.
+ * @param processedFile The results of processing the file.
+ * @return The results in a form that can be passed to JSON.stringify.
+ */
+export function serializeProcessedFile({
+    fileResult,
+    couplingData,
+}: ProcessedFile): SerializedProcessedFile {
+    const { parseError, fileMetricResults, ...fileInfo } = fileResult;
+    const serializedFileResult: SerializedProcessedFile["fileResult"] = {
+        ...fileInfo,
+        fileMetricResults: {
+            ...fileMetricResults,
+            metricErrors: fileMetricResults.metricErrors.map(({ metricName, error }) => ({
+                metricName,
+                error: serializeError(error),
+            })),
+        },
+    };
+    if (parseError !== undefined) {
+        serializedFileResult.parseError = serializeError(parseError);
+    }
+
+    if (couplingData === undefined) {
+        return { fileResult: serializedFileResult };
+    }
+
+    return {
+        fileResult: serializedFileResult,
+        couplingData: {
+            ...couplingData,
+            types: [...couplingData.types],
+            accessors: [...couplingData.accessors],
+        },
+    };
+}
+
+/**
+ * Restores the results of processing a file from the form returned by {@link serializeProcessedFile}.
+ * @param serializedFile The results as parsed from JSON.
+ * @return The restored results.
+ */
+export function deserializeProcessedFile({
+    fileResult,
+    couplingData,
+}: SerializedProcessedFile): ProcessedFile {
+    const { parseError, fileMetricResults, ...fileInfo } = fileResult;
+    const deserializedFileResult: FileResult = {
+        ...fileInfo,
+        fileMetricResults: {
+            ...fileMetricResults,
+            metricErrors: fileMetricResults.metricErrors.map(({ metricName, error }) => ({
+                metricName,
+                error: deserializeError(error),
+            })),
+        },
+    };
+    if (parseError !== undefined) {
+        deserializedFileResult.parseError = deserializeError(parseError);
+    }
+
+    if (couplingData === undefined) {
+        return { fileResult: deserializedFileResult };
+    }
+
+    return {
+        fileResult: deserializedFileResult,
+        couplingData: {
+            ...couplingData,
+            types: new Map(couplingData.types) as FileCouplingData["types"],
+            accessors: new Map(couplingData.accessors) as FileCouplingData["accessors"],
+        },
+    };
+}
+
+function serializeError({ name, message, stack }: Error): SerializedError {
+    return { name, message, stack };
+}
+
+function deserializeError({ name, message, stack }: SerializedError): Error {
+    const error = new Error(message);
+    error.name = name;
+    error.stack = stack;
+    return error;
+}
+
+function getFingerprint(config: Configuration): string {
+    const require = createRequire(import.meta.url);
+    const versions = [getOwnVersion()];
+    for (const packageName of parserPackages) {
+        try {
+            versions.push((require(packageName + "/package.json") as { version: string }).version);
+        } catch {
+            versions.push("unknown");
+        }
+    }
+
+    return createHash("sha256")
+        .update(
+            JSON.stringify({
+                cacheFormatVersion,
+                versions,
+                nodeTypesConfig,
+                parseDependencies: config.parseDependencies,
+                maxUnsupportedFileSize: config.maxUnsupportedFileSize,
+                commentKeywords: [...config.commentKeywords],
+            }),
+        )
+        .digest("hex");
+}
+
+/**
+ * Returns the version of metric-gardener from the closest package.json above this module,
+ * which is at different levels depending on whether it is run from the sources or the build output.
+ */
+function getOwnVersion(): string {
+    let directory = path.dirname(fileURLToPath(import.meta.url));
+    while (directory !== path.dirname(directory)) {
+        const packageJsonPath = path.join(directory, "package.json");
+        if (existsSync(packageJsonPath)) {
+            const packageJson = JSON.parse(readFileSync(packageJsonPath, "utf8")) as {
+                version?: string;
+            };
+            return packageJson.version ?? "unknown";
+        }
+
+        directory = path.dirname(directory);
+    }
+
+    return "unknown";
+}
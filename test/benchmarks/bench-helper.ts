@@ -0,0 +1,147 @@
+import fs from "node:fs";
+import path from "node:path";
+import process from "node:process";
+import { fileURLToPath } from "node:url";
+import { afterAll, bench } from "vitest";
+import { getTestConfiguration } from "../metric-end-results/test-helper.js";
+import { assumeLanguageFromFilePath, type Language } from "../../src/helper/language.js";
+import { parseTree } from "../../src/helper/tree-parser.js";
+import { ParsedFile } from "../../src/parser/metrics/metric.js";
+
+export const resourcesPath = fileURLToPath(new URL("../../resources", import.meta.url));
+
+export const benchConfiguration = getTestConfiguration(resourcesPath);
+
+/**
+ * A file of the benchmark corpus, with its contents already read.
+ */
+export type CorpusFile = {
+    filePath: string;
+    language: Language;
+    sourceCode: string;
+};
+
+/**
+ * Reads all files of the supported languages from the resources folder, grouped by language.
+ */
+export function loadCorpus(): Map<Language, CorpusFile[]> {
+    const corpus = new Map<Language, CorpusFile[]>();
+
+    for (const filePath of listFiles(resourcesPath)) {
+        const language = assumeLanguageFromFilePath(filePath, benchConfiguration);
+        if (language === undefined) {
+            continue;
+        }
+
+        const sourceCode = fs.readFileSync(filePath, "utf8");
+        const files = corpus.get(language);
+        if (files === undefined) {
+            corpus.set(language, [{ filePath, language, sourceCode }]);
+        } else {
+            files.push({ filePath, language, sourceCode });
+        }
+    }
+
+    return corpus;
+}
+
+function listFiles(directory: string): string[] {
+    return fs.readdirSync(directory, { withFileTypes: true }).flatMap((entry) => {
+        const entryPath = path.join(directory, entry.name);
+        if (entry.isDirectory()) {
+            return listFiles(entryPath);
+        }
+
+        return entry.isFile() ? [entryPath] : [];
+    });
+}
+
+/**
+ * Parses a file of the corpus or synthetic source code.
+ * @param filePath Path of the file, which is only used to determine the language.
+ * @param sourceCode Source code to parse.
+ */
+export function parseSource(filePath: string, sourceCode: string): ParsedFile {
+    const sourceFile = parseTree(sourceCode, filePath, benchConfiguration);
+    if (!(sourceFile instanceof ParsedFile)) {
+        throw new TypeError("Unsupported language of " + filePath);
+    }
+
+    return sourceFile;
+}
+
+/**
+ * Generates a Java class with the specified number of methods,
+ * each of them with comments, branches, loops and nested blocks.
+ */
+export function generateJavaClass(methodCount: number): string {
+    let sourceCode =
+        "package com.example.generated;\n\n" +
+        "/**\n * Generated class.\n */\n" +
+        "public class Generated {\n";
+    for (let index = 0; index < methodCount; index++) {
+        const name = "method" + index.toString();
+        sourceCode +=
+            `    // TODO: check ${name}\n` +
+            `    public int ${name}(int value) {\n` +
+            "        int sum = 0;\n" +
+            "        for (int i = 0; i < value; i++) {\n" +
+            "            if (i % 2 == 0 && value > 10 || value < 0) {\n" +
+            "                sum += i;\n" +
+            "            } else {\n" +
+            "                sum -= i; /* odd */\n" +
+            "            }\n" +
+            "        }\n" +
+            "        return sum > 0 ? sum : -sum;\n" +
+            "    }\n\n";
+    }
+
+    return sourceCode + "}\n";
+}
+
+/**
+ * Sizes of synthetic inputs, to check that the time per element stays constant when scaling up.
+ */
+export const syntheticSizes = [100, 1000, 10_000];
+
+/**
+ * Registers a benchmark and reports the memory allocated by a single run of it once the suite has finished.
+ * Allocations can only be measured approximately, by the growth of the heap between two garbage collections.
+ * The garbage collector is exposed to the benchmarks by the vitest configuration.
+ * @param name Name of the benchmark.
+ * @param run Function to benchmark.
+ */
+export function benchWithAllocations(name: string, run: () => unknown): void {
+    bench(name, run);
+
+    afterAll(() => {
+        console.log(name + ": " + formatBytes(measureAllocations(run)) + " allocated per run");
+    });
+}
+
+function measureAllocations(run: () => unknown, repetitions = 5): number {
+    const { gc } = globalThis as { gc?: () => void };
+    const measurements: number[] = [];
+
+    for (let index = 0; index < repetitions; index++) {
+        gc?.();
+        const before = process.memoryUsage().heapUsed;
+        run();
+        measurements.push(Math.max(0, process.memoryUsage().heapUsed - before));
+    }
+
+    measurements.sort((a, b) => a - b);
+    return measurements[Math.floor(repetitions / 2)];
+}
+
+function formatBytes(bytes: number): string {
+    if (bytes < 1024) {
+        return bytes.toString() + " B";
+    }
+
+    if (bytes < 1024 * 1024) {
+        return (bytes / 1024).toFixed(1) + " KB";
+    }
+
+    return (bytes / 1024 / 1024).toFixed(1) + " MB";
+}
@@ -0,0 +1,136 @@
+import { describe } from "vitest";
+import { type TypeInfo } from "../../src/parser/resolver/types/abstract-collector.js";
+import { type Accessor } from "../../src/parser/resolver/accessors/abstract-collector.js";
+import { type CallExpression } from "../../src/parser/resolver/call-expressions/abstract-collector.js";
+import { getRelationshipsFromCallExpressions } from "../../src/parser/metrics/coupling/call-expression-resolver.js";
+import {
+    getFullyQualifiedTypeName,
+    SymbolTable,
+} from "../../src/parser/metrics/coupling/symbol-table.js";
+import {
+    type FileId,
+    IdPairSet,
+    type InternedRelationship,
+} from "../../src/parser/metrics/coupling/interning.js";
+import { benchWithAllocations, syntheticSizes } from "./bench-helper.js";
+
+const accessorsPerType = 5;
+const callExpressionsPerFile = 20;
+
+type SyntheticCodeBase = {
+    fileToRelations: Map<FileId, InternedRelationship[]>;
+    fileToCallExpressions: Map<FileId, CallExpression[]>;
+    symbolTable: SymbolTable;
+};
+
+/**
+ * Generates a code base with one type per file. Each type depends on some of the following types,
+ * declares public accessors that return the type after it and calls chains of accessors of its dependencies.
+ */
+function generateCodeBase(fileCount: number, dependenciesPerFile = 5): SyntheticCodeBase {
+    const types: TypeInfo[] = [];
+    for (let index = 0; index < fileCount; index++) {
+        types.push({
+            namespace: "Company.Module" + (index % 50).toString(),
+            typeName: "Type" + index.toString(),
+            classType: "class",
+            sourceFile: "/src/Type" + index.toString() + ".cs",
+            namespaceDelimiter: ".",
+            implementedFrom: [],
+        });
+    }
+
+    const symbolTable = new SymbolTable();
+    const fileToRelations = new Map<FileId, InternedRelationship[]>();
+    const fileToCallExpressions = new Map<FileId, CallExpression[]>();
+
+    for (const [index, type] of types.entries()) {
+        const accessors = new Map<string, Accessor[]>();
+        for (let accessorIndex = 0; accessorIndex < accessorsPerType; accessorIndex++) {
+            const name = "Accessor" + accessorIndex.toString();
+            accessors.set(name, [
+                {
+                    name,
+                    FullyQualifiedAccessorName: getFullyQualifiedTypeName(type) + "." + name,
+                    fromType: type,
+                    filePath: type.sourceFile,
+                    returnType: types[(index + 1) % fileCount].typeName,
+                },
+            ]);
+        }
+
+        symbolTable.addAccessors(accessors);
+
+        const { files, typeNames } = symbolTable;
+        const relationships: InternedRelationship[] = [];
+        for (let offset = 1; offset <= dependenciesPerFile; offset++) {
+            const dependency = types[(index + offset) % fileCount];
+            relationships.push({
+                fromType: typeNames.intern(getFullyQualifiedTypeName(type)),
+                toType: typeNames.intern(getFullyQualifiedTypeName(dependency)),
+                fromFile: files.intern(type.sourceFile),
+                toFile: files.intern(dependency.sourceFile),
+                fromTypeName: type.typeName,
+                toTypeName: dependency.typeName,
+                usageType: "usage",
+            });
+        }
+
+        fileToRelations.set(files.intern(type.sourceFile), relationships);
+
+        const callExpressions: CallExpression[] = [];
+        for (let callIndex = 0; callIndex < callExpressionsPerFile; callIndex++) {
+            callExpressions.push({
+                qualifiedName:
+                    "variable" +
+                    callIndex.toString() +
+                    ".Accessor" +
+                    (callIndex % accessorsPerType).toString() +
+                    ".Accessor" +
+                    ((callIndex + 1) % accessorsPerType).toString(),
+                variableNameIncluded: true,
+                namespaceDelimiter: ".",
+            });
+        }
+
+        fileToCallExpressions.set(files.intern(type.sourceFile), callExpressions);
+    }
+
+    return { fileToRelations, fileToCallExpressions, symbolTable };
+}
+
+describe("getRelationshipsFromCallExpressions(), by number of files", () => {
+    // The time per file should stay the same for all sizes, i.e. the time per run should grow linearly:
+    for (const fileCount of syntheticSizes) {
+        const { fileToRelations, fileToCallExpressions, symbolTable } =
+            generateCodeBase(fileCount);
+
+        benchWithAllocations(fileCount.toString() + " files", () => {
+            getRelationshipsFromCallExpressions(
+                fileToRelations,
+                fileToCallExpressions,
+                symbolTable,
+                new IdPairSet(),
+            );
+        });
+    }
+});
+
+describe("getRelationshipsFromCallExpressions(), by number of dependencies per file", () => {
+    // Dependencies and return types are looked up by hash, so the time per run should hardly grow:
+    for (const dependencyCount of [5, 50, 500]) {
+        const { fileToRelations, fileToCallExpressions, symbolTable } = generateCodeBase(
+            1000,
+            dependencyCount,
+        );
+
+        benchWithAllocations(dependencyCount.toString() + " dependencies", () => {
+            getRelationshipsFromCallExpressions(
+                fileToRelations,
+                fileToCallExpressions,
+                symbolTable,
+                new IdPairSet(),
+            );
+        });
+    }
+});
@@ -0,0 +1,57 @@
+import { describe } from "vitest";
+import { DependencyGraph } from "../../src/parser/metrics/coupling/dependency-graph.js";
+import { benchWithAllocations } from "./bench-helper.js";
+
+const dependenciesPerFile = 10;
+const filesPerDirectory = 100;
+
+type SyntheticEdges = {
+    sources: Uint32Array;
+    targets: Uint32Array;
+};
+
+/**
+ * Generates the dependencies of a code base in which each file depends on some of the following files,
+ * and every hundredth file depends on a previous file, so that there are cycles of various sizes as well.
+ */
+function generateEdges(fileCount: number): SyntheticEdges {
+    const edgeCount = fileCount * dependenciesPerFile;
+    const sources = new Uint32Array(edgeCount);
+    const targets = new Uint32Array(edgeCount);
+    for (let file = 0; file < fileCount; file++) {
+        for (let offset = 1; offset <= dependenciesPerFile; offset++) {
+            const edge = file * dependenciesPerFile + offset - 1;
+            sources[edge] = file;
+            targets[edge] =
+                offset === dependenciesPerFile && file % 100 === 0
+                    ? Math.max(0, file - 50)
+                    : Math.min(fileCount - 1, file + offset * offset);
+        }
+    }
+
+    return { sources, targets };
+}
+
+describe("DependencyGraph, by number of files", () => {
+    // Everything is linear in the number of files and dependencies, up to millions of dependencies:
+    for (const fileCount of [1000, 10_000, 100_000]) {
+        const { sources, targets } = generateEdges(fileCount);
+        const graph = DependencyGraph.fromEdges(fileCount, sources, targets);
+        const directoryOfFile = new Uint32Array(fileCount).map((_, file) =>
+            Math.floor(file / filesPerDirectory),
+        );
+        const directoryCount = Math.ceil(fileCount / filesPerDirectory);
+
+        benchWithAllocations("build, " + fileCount.toString() + " files", () => {
+            DependencyGraph.fromEdges(fileCount, sources, targets);
+        });
+
+        benchWithAllocations("cycles, " + fileCount.toString() + " files", () => {
+            graph.getStronglyConnectedComponents();
+        });
+
+        benchWithAllocations("aggregate by directory, " + fileCount.toString() + " files", () => {
+            graph.aggregate(directoryOfFile, directoryCount);
+        });
+    }
+});
@@ -0,0 +1,118 @@
+import { describe } from "vitest";
+import { type NodeTypeConfig } from "../../src/helper/model.js";
+import { FileType } from "../../src/helper/language.js";
+import { Complexity } from "../../src/parser/metrics/complexity.js";
+import { Functions } from "../../src/parser/metrics/functions.js";
+import { Classes } from "../../src/parser/metrics/classes.js";
+import { LinesOfCode } from "../../src/parser/metrics/lines-of-code.js";
+import { CommentLines } from "../../src/parser/metrics/comment-lines.js";
+import { RealLinesOfCode } from "../../src/parser/metrics/real-lines-of-code.js";
+import { createKeywordsInCommentsMetrics } from "../../src/parser/metrics/keywords-in-comments.js";
+import { MaxNestingLevel } from "../../src/parser/metrics/max-nesting-level.js";
+import { type Metric } from "../../src/parser/metrics/metric.js";
+import { isQueryMetric, MetricQueryEngine } from "../../src/parser/queries/metric-query-engine.js";
+import nodeTypesConfig from "../../src/parser/config/node-types-config.json" with { type: "json" };
+import {
+    benchWithAllocations,
+    generateJavaClass,
+    loadCorpus,
+    parseSource,
+    syntheticSizes,
+} from "./bench-helper.js";
+
+const allNodeTypes = nodeTypesConfig as NodeTypeConfig[];
+const commentLines = new CommentLines(allNodeTypes);
+const sourceFileMetrics: Metric[] = [
+    new Complexity(allNodeTypes),
+    new Functions(allNodeTypes),
+    new Classes(allNodeTypes),
+    new LinesOfCode(),
+    commentLines,
+    new RealLinesOfCode(allNodeTypes),
+];
+const commentKeywords = new Map([["debt", ["fixme", "xxx", "deprecated"]]]);
+
+/**
+ * Creates the keywords in comments metrics for each iteration,
+ * as they keep the counts of a file for the metrics of all keyword sets.
+ */
+function createKeywordMetrics(): Metric[] {
+    return createKeywordsInCommentsMetrics(commentLines, commentKeywords);
+}
+const structuredTextFileMetrics: Metric[] = [new LinesOfCode(), new MaxNestingLevel(allNodeTypes)];
+const queryEngine = new MetricQueryEngine(sourceFileMetrics.filter(isQueryMetric));
+
+const corpusFiles = [...loadCorpus().values()]
+    .flat()
+    .map(({ filePath, sourceCode }) => parseSource(filePath, sourceCode));
+const corpusSourceFiles = corpusFiles.filter(({ fileType }) => fileType === FileType.SourceCode);
+const corpusStructuredTextFiles = corpusFiles.filter(
+    ({ fileType }) => fileType === FileType.StructuredText,
+);
+
+describe("Metric.calculate() on all source code files of the resources corpus", () => {
+    for (const metric of sourceFileMetrics) {
+        benchWithAllocations(metric.getName(), () => {
+            for (const parsedFile of corpusSourceFiles) {
+                metric.calculate(parsedFile);
+            }
+        });
+    }
+
+    benchWithAllocations("keywords in comments, default and one additional keyword set", () => {
+        const keywordMetrics = createKeywordMetrics();
+        for (const parsedFile of corpusSourceFiles) {
+            for (const metric of keywordMetrics) {
+                metric.calculate(parsedFile);
+            }
+        }
+    });
+
+    benchWithAllocations("combined query of all query-based metrics", () => {
+        for (const parsedFile of corpusSourceFiles) {
+            queryEngine.execute(parsedFile);
+        }
+    });
+});
+
+describe("Metric.calculate() on all structured text files of the resources corpus", () => {
+    for (const metric of structuredTextFileMetrics) {
+        benchWithAllocations(metric.getName(), () => {
+            for (const parsedFile of corpusStructuredTextFiles) {
+                metric.calculate(parsedFile);
+            }
+        });
+    }
+});
+
+for (const methodCount of syntheticSizes) {
+    describe(`Metric.calculate() on a Java class with ${methodCount.toString()} methods`, () => {
+        const parsedFile = parseSource("Generated.java", generateJavaClass(methodCount));
+
+        for (const metric of sourceFileMetrics) {
+            benchWithAllocations(metric.getName(), () => {
+                metric.calculate(parsedFile);
+            });
+        }
+
+        benchWithAllocations("all metrics with the combined query", () => {
+            const queryResult = queryEngine.execute(parsedFile);
+            for (const metric of [...sourceFileMetrics, ...createKeywordMetrics()]) {
+                metric.calculate(parsedFile, queryResult);
+            }
+        });
+    });
+}
+
+describe("Metric.calculate() on a generated JSON file with 100000 array elements", () => {
+    const parsedFile = parseSource(
+        "generated.json",
+        "[\n" + '  { "a": [1, 2] },\n'.repeat(100_000) + "  {}\n]\n",
+    );
+
+    for (const metric of structuredTextFileMetrics) {
+        benchWithAllocations(metric.getName(), () => {
+            metric.calculate(parsedFile);
+        });
+    }
+});
@@ -0,0 +1,34 @@
+import { describe } from "vitest";
+import { Language } from "../../src/helper/language.js";
+import { QueryBuilder } from "../../src/parser/queries/query-builder.js";
+import { SimpleQueryStatement } from "../../src/parser/queries/query-statements.js";
+import { benchWithAllocations } from "./bench-helper.js";
+
+const statements = [
+    new SimpleQueryStatement("(method_declaration) @function"),
+    new SimpleQueryStatement("(constructor_declaration) @function"),
+    new SimpleQueryStatement("(lambda_expression) @function"),
+    new SimpleQueryStatement("(if_statement) @complexity"),
+    new SimpleQueryStatement("(for_statement) @complexity"),
+    new SimpleQueryStatement("(while_statement) @complexity"),
+    new SimpleQueryStatement("(catch_clause) @complexity"),
+    new SimpleQueryStatement("(line_comment) @comment"),
+    new SimpleQueryStatement("(block_comment) @comment"),
+];
+
+describe("QueryBuilder.build()", () => {
+    benchWithAllocations("cache hit", () => {
+        const queryBuilder = new QueryBuilder(Language.Java);
+        queryBuilder.addStatements([...statements]);
+        queryBuilder.build();
+    });
+
+    // Each build is made unique by a comment, so that the query has to be compiled by tree-sitter:
+    let buildCount = 0;
+    benchWithAllocations("cache miss", () => {
+        const queryBuilder = new QueryBuilder(Language.Java);
+        queryBuilder.addStatements([...statements]);
+        queryBuilder.addStatement(new SimpleQueryStatement("; " + (buildCount++).toString()));
+        queryBuilder.build();
+    });
+});
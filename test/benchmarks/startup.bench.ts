@@ -0,0 +1,46 @@
+import { describe } from "vitest";
+import { type NodeTypeConfig } from "../../src/helper/model.js";
+import { Complexity } from "../../src/parser/metrics/complexity.js";
+import { Functions } from "../../src/parser/metrics/functions.js";
+import { Classes } from "../../src/parser/metrics/classes.js";
+import { LinesOfCode } from "../../src/parser/metrics/lines-of-code.js";
+import { CommentLines } from "../../src/parser/metrics/comment-lines.js";
+import { RealLinesOfCode } from "../../src/parser/metrics/real-lines-of-code.js";
+import { createKeywordsInCommentsMetrics } from "../../src/parser/metrics/keywords-in-comments.js";
+import { type Metric } from "../../src/parser/metrics/metric.js";
+import { isQueryMetric, MetricQueryEngine } from "../../src/parser/queries/metric-query-engine.js";
+import nodeTypesConfig from "../../src/parser/config/node-types-config.json" with { type: "json" };
+import { benchWithAllocations, parseSource } from "./bench-helper.js";
+
+/*
+ * Work that is done once per run before the first file of a language can be analyzed.
+ * Grammars and compiled queries are kept for the whole process, so loading and compiling them is not measured here.
+ * Run the parse command with --profile to see the time spent on startup, loading grammars and building metric plans.
+ */
+
+const allNodeTypes = nodeTypesConfig as NodeTypeConfig[];
+
+function createSourceFileMetrics(): Metric[] {
+    const commentLines = new CommentLines(allNodeTypes);
+    return [
+        new Complexity(allNodeTypes),
+        new Functions(allNodeTypes),
+        new Classes(allNodeTypes),
+        new LinesOfCode(),
+        commentLines,
+        new RealLinesOfCode(allNodeTypes),
+        ...createKeywordsInCommentsMetrics(commentLines),
+    ];
+}
+
+describe("Startup", () => {
+    benchWithAllocations("creating the metrics", () => {
+        createSourceFileMetrics();
+    });
+
+    const metrics = createSourceFileMetrics().filter(isQueryMetric);
+    const javaFile = parseSource("Example.java", "class Example {}\n");
+    benchWithAllocations("building the metric plan of a language", () => {
+        new MetricQueryEngine(metrics).execute(javaFile);
+    });
+});
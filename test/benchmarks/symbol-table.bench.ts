@@ -0,0 +1,68 @@
+import { describe } from "vitest";
+import { type TypeInfo } from "../../src/parser/resolver/types/abstract-collector.js";
+import { SymbolTable } from "../../src/parser/metrics/coupling/symbol-table.js";
+import { benchWithAllocations } from "./bench-helper.js";
+
+const typesPerFile = 10;
+
+/**
+ * Creates the types of a synthetic code base, spread over files with the same number of types each.
+ */
+function createFiles(typeCount: number): Array<Map<FullyQualifiedName, TypeInfo>> {
+    const files: Array<Map<FullyQualifiedName, TypeInfo>> = [];
+    for (let fileIndex = 0; fileIndex * typesPerFile < typeCount; fileIndex++) {
+        const types = new Map<FullyQualifiedName, TypeInfo>();
+        const namespace = "Company.Product.Module" + (fileIndex % 100).toString();
+        for (let typeIndex = 0; typeIndex < typesPerFile; typeIndex++) {
+            const typeName = "Type" + (fileIndex * typesPerFile + typeIndex).toString();
+            types.set(namespace + "." + typeName, {
+                namespace,
+                typeName,
+                classType: "class",
+                sourceFile: "/src/File" + fileIndex.toString() + ".cs",
+                namespaceDelimiter: ".",
+                implementedFrom: [],
+            });
+        }
+
+        files.push(types);
+    }
+
+    return files;
+}
+
+// The time per type should stay the same for all sizes, i.e. the time per run should grow linearly:
+for (const typeCount of [1000, 10_000, 100_000]) {
+    describe(`add and look up ${typeCount.toString()} types`, () => {
+        const files = createFiles(typeCount);
+
+        benchWithAllocations("SymbolTable", () => {
+            const symbolTable = new SymbolTable();
+            for (const types of files) {
+                symbolTable.addTypes(types);
+            }
+
+            for (const types of files) {
+                for (const fqtn of types.keys()) {
+                    symbolTable.getType(fqtn);
+                }
+            }
+        });
+
+        // Previous approach of copying all types for each file, which grows quadratically:
+        if (typeCount <= 10_000) {
+            benchWithAllocations("copying Map", () => {
+                let typesMap = new Map<FullyQualifiedName, TypeInfo>();
+                for (const types of files) {
+                    typesMap = new Map([...typesMap, ...types]);
+                }
+
+                for (const types of files) {
+                    for (const fqtn of types.keys()) {
+                        typesMap.get(fqtn);
+                    }
+                }
+            });
+        }
+    });
+}
@@ -0,0 +1,58 @@
+import Parser = require("tree-sitter");
+import { describe } from "vitest";
+import { getGrammar, Language } from "../../src/helper/language.js";
+import { ParserPool } from "../../src/helper/parser-pool.js";
+import { parseTree } from "../../src/helper/tree-parser.js";
+import {
+    benchConfiguration,
+    benchWithAllocations,
+    generateJavaClass,
+    loadCorpus,
+    syntheticSizes,
+} from "./bench-helper.js";
+
+describe("parseTree() on the files of the resources corpus, per language", () => {
+    for (const [language, files] of loadCorpus()) {
+        benchWithAllocations(language, () => {
+            for (const { filePath, sourceCode } of files) {
+                parseTree(sourceCode, filePath, benchConfiguration);
+            }
+        });
+    }
+});
+
+describe("parseTree() on a Java class, by number of methods", () => {
+    for (const methodCount of syntheticSizes) {
+        const sourceCode = generateJavaClass(methodCount);
+
+        benchWithAllocations(methodCount.toString() + " methods", () => {
+            parseTree(sourceCode, "Generated.java", benchConfiguration);
+        });
+    }
+});
+
+describe("Parsing many small files, with a new parser per file or reused parsers", () => {
+    const smallFiles = [
+        { language: Language.JSON, sourceCode: '{"name": "metric-gardener", "version": 1}\n' },
+        { language: Language.YAML, sourceCode: "name: metric-gardener\nversion: 1\n" },
+        { language: Language.Bash, sourceCode: '#!/bin/sh\necho "$1"\n' },
+    ];
+    const fileCount = 1000;
+
+    benchWithAllocations("new parser per file", () => {
+        for (let index = 0; index < fileCount; index++) {
+            const { language, sourceCode } = smallFiles[index % smallFiles.length];
+            const parser = new Parser();
+            parser.setLanguage(getGrammar(language));
+            parser.parse(sourceCode);
+        }
+    });
+
+    const parserPool = new ParserPool();
+    benchWithAllocations("parser pool", () => {
+        for (let index = 0; index < fileCount; index++) {
+            const { language, sourceCode } = smallFiles[index % smallFiles.length];
+            parserPool.parse(language, sourceCode);
+        }
+    });
+});
@@ -0,0 +1,44 @@
+import { describe } from "vitest";
+import { TypeCollector } from "../../src/parser/resolver/type-collector.js";
+import { UsagesCollector } from "../../src/parser/resolver/usages-collector.js";
+import { benchWithAllocations, parseSource } from "./bench-helper.js";
+
+const typesPerFile = 20;
+const methodsPerType = 5;
+
+/**
+ * Generates a C# file with types that each contain a chain of nested classes of the specified depth.
+ * Every class declares methods that use other types, so there are usages on every nesting level.
+ */
+function generateNestedCSharpFile(depth: number): string {
+    let sourceCode = "using System.Collections.Generic;\n\nnamespace Company.Generated\n{\n";
+    for (let typeIndex = 0; typeIndex < typesPerFile; typeIndex++) {
+        for (let level = 0; level < depth; level++) {
+            const name = "Type" + typeIndex.toString() + "Level" + level.toString();
+            sourceCode += `public class ${name} : IComparable<${name}>\n{\n`;
+            for (let methodIndex = 0; methodIndex < methodsPerType; methodIndex++) {
+                sourceCode +=
+                    `public List<Dependency${methodIndex.toString()}> Method${methodIndex.toString()}(Argument value)\n{\n` +
+                    `var result = new Result${level.toString()}(value);\n` +
+                    "return result.Items.ToList();\n}\n";
+            }
+        }
+
+        sourceCode += "}\n".repeat(depth);
+    }
+
+    return sourceCode + "}\n";
+}
+
+describe("UsagesCollector.getUsageCandidates(), by nesting depth of the types", () => {
+    // The time per run should grow linearly with the size of the file, regardless of how deeply the types are nested:
+    for (const depth of [1, 4, 16]) {
+        const parsedFile = parseSource("Generated.cs", generateNestedCSharpFile(depth));
+        const types = new TypeCollector().getTypesFromFile(parsedFile);
+        const usagesCollector = new UsagesCollector();
+
+        benchWithAllocations("depth " + depth.toString(), () => {
+            usagesCollector.getUsageCandidates(parsedFile, types);
+        });
+    }
+});
@@ -25,11 +25,22 @@ export function getTestConfiguration(
         sourcesPath,
         outputPath: "invalid/output/path",
         parseDependencies: false,
+        directoryCoupling: false,
         exclusions: "",
         parseAllHAsC: false,
         parseSomeHAsC: "",
         compress: false,
         relativePaths: false,
+        threads: 1,
+        maxMemory: 0,
+        cacheDir: "",
+        outputFormat: "json",
+        profile: "",
+        skipUnsupportedFiles: false,
+        parseTimeout: 0,
+        maxUnsupportedFileSize: 0,
+        commentKeywords: "",
+        shard: "",
     };
     return new Configuration({ ...defaultParameters, ...customOverrides });
 }
@@ -16,6 +16,12 @@ export default defineConfig({
         },
         isolate: false,
         pool: "forks",
+        poolOptions: {
+            forks: {
+                // Lets the benchmarks measure allocations between garbage collections:
+                execArgv: ["--expose-gc"],
+            },
+        },
         restoreMocks: true,
     },
 });